@@ -0,0 +1,55 @@
+/**
+ * Benchmarks associative_map (flat sorted arrays) against std::map, including batched versus one-at-a-time
+ *   insertion.
+ *
+ * Usage: bench_associative_map [element count]
+ **/
+
+#include "benchmark.h"
+#include <abstracts/map/associative_map.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t n = benchmark::size_arg(argc, argv, 200000);
+
+    std::mt19937 rng(1);
+    std::vector<std::pair<int, int>> batch(n);
+    for(auto& kv : batch)
+        kv = std::make_pair(static_cast<int>(rng()), 1);
+
+    associative_map<int, int> flat, single;
+    std::map<int, int> tree;
+
+    report("batched insert", "associative_map", time_ms([&] {
+        flat.insert_range(batch.begin(), batch.end());
+    }), n);
+    size_t singles = std::min<size_t>(n, 50000);
+    report("single inserts", "associative_map", time_ms([&] {
+        for(size_t i = 0; i < singles; i++)
+            single.insert(batch[i].first, batch[i].second);
+    }), singles);
+    report("single inserts", "std::map", time_ms([&] {
+        for(auto& kv : batch)
+            tree.insert(kv);
+    }), n);
+
+    long long sum = 0;
+    report("random lookup", "associative_map", time_ms([&] {
+        for(auto& kv : batch)
+            sum += flat.find(kv.first).value();
+    }), n);
+    report("random lookup", "std::map", time_ms([&] {
+        for(auto& kv : batch)
+            sum += tree.find(kv.first)->second;
+    }), n);
+
+    benchmark::do_not_optimize(sum);
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * Benchmarks avl_tree against std::map on random, sorted and Zipfian key streams.
+ *
+ * Each stream is inserted into an empty tree, then replayed as lookups and finally as erasures. The Zipfian stream
+ *   repeats popular keys, so most of its insertions find the key already present.
+ *
+ * Usage: bench_avl_tree [stream length]
+ **/
+
+#include "benchmark.h"
+#include <trees/avl_tree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<uint64_t> zipf_stream(size_t events, size_t distinct, double skew, unsigned seed) {
+    std::vector<double> cdf(distinct);
+    double sum = 0;
+    for(size_t i = 0; i < distinct; i++)
+        cdf[i] = sum += 1.0 / std::pow(double(i + 1), skew);
+
+    // Scatter the ranks over the key space so popular keys are not also the smallest
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> key_of(distinct);
+    for(uint64_t& key : key_of)
+        key = rng();
+
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<uint64_t> stream(events);
+    for(uint64_t& event : stream)
+        event = key_of[std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()];
+    return stream;
+}
+
+void run(const std::string& name, const std::vector<uint64_t>& keys) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    avl_tree<uint64_t, uint64_t> avl;
+    std::map<uint64_t, uint64_t> map;
+
+    report(name + " insert", "avl_tree", time_ms([&] {
+        for(uint64_t key : keys)
+            avl.insert(key, key);
+    }), keys.size());
+    report(name + " insert", "std::map", time_ms([&] {
+        for(uint64_t key : keys)
+            map.emplace(key, key);
+    }), keys.size());
+    std::printf("%-28s %-24s %zu keys, height %zu\n", "", "", avl.size(), avl.height());
+
+    uint64_t sum = 0;
+    report(name + " lookup", "avl_tree", time_ms([&] {
+        for(uint64_t key : keys)
+            sum += avl.find(key).value();
+    }), keys.size());
+    report(name + " lookup", "std::map", time_ms([&] {
+        for(uint64_t key : keys)
+            sum += map.find(key)->second;
+    }), keys.size());
+
+    size_t positions = std::min<size_t>(keys.size(), 1000000);
+    report(name + " select", "avl_tree", time_ms([&] {
+        for(size_t i = 0; i < positions; i++)
+            sum += avl.select(keys[i] % avl.size()).key();
+    }), positions);
+    report(name + " rank", "avl_tree", time_ms([&] {
+        for(size_t i = 0; i < positions; i++)
+            sum += avl.rank(keys[i]);
+    }), positions);
+    report(name + " select", "std::map (advance)", time_ms([&] {
+        // std::map has no order statistics: walking to a position is linear
+        for(size_t i = 0; i < std::min<size_t>(positions, 20); i++)
+            sum += std::next(map.begin(), keys[i] % map.size())->first;
+    }), std::min<size_t>(positions, 20));
+
+    report(name + " erase", "avl_tree", time_ms([&] {
+        for(uint64_t key : keys)
+            avl.erase(key);
+    }), keys.size());
+    report(name + " erase", "std::map", time_ms([&] {
+        for(uint64_t key : keys)
+            map.erase(key);
+    }), keys.size());
+    benchmark::do_not_optimize(sum);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+
+    std::vector<uint64_t> keys(n);
+    std::mt19937_64 rng(1);
+    for(uint64_t& key : keys)
+        key = rng();
+    run("random", keys);
+
+    for(size_t i = 0; i < n; i++)
+        keys[i] = i;
+    run("sorted", keys);
+
+    run("zipf s=1.1", zipf_stream(n, n, 1.1, 2));
+}
@@ -0,0 +1,155 @@
+/**
+ * Streams log records from producer threads to a consumer thread through circular_buffer, in plain and magic mode,
+ *   with one and with several producers, and through a mutex-protected std::deque of bytes that copies every record
+ *   in and out.
+ *
+ * Usage: bench_circular_buffer [record count]
+ **/
+
+#include "benchmark.h"
+#include <linear/arrays/circular_buffer.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const size_t RECORD = 64;
+const size_t RING = 1 << 16;
+
+/**
+ * Writes a record of `RECORD` bytes into `out`, as a logger formatting a line would.
+ */
+void format(uint8_t *out, uint64_t sequence) {
+    for(size_t i = 0; i < RECORD; i += sizeof(sequence))
+        std::memcpy(out + i, &sequence, sizeof(sequence));
+}
+
+class locked_queue {
+public:
+    bool push(const uint8_t *record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(bytes.size() + RECORD > RING)
+            return false;
+        bytes.insert(bytes.end(), record, record + RECORD);
+        return true;
+    }
+
+    size_t pop(uint8_t *out, size_t n) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t taken = std::min(n, bytes.size());
+        std::copy(bytes.begin(), bytes.begin() + taken, out);
+        bytes.erase(bytes.begin(), bytes.begin() + taken);
+        return taken;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<uint8_t> bytes;
+};
+
+/**
+ * Times `producers` threads each calling `produce(sequence)` until it accepts `records` records, against a consumer
+ *   calling `consume()`, which returns the number of bytes it took, until everything has arrived.
+ */
+template <typename Produce, typename Consume>
+double run(size_t producers, size_t records, Produce&& produce, Consume&& consume) {
+    return benchmark::time_ms([&] {
+        std::vector<std::thread> threads;
+        for(size_t p = 0; p < producers; p++) {
+            threads.emplace_back([&, p] {
+                for(uint64_t sequence = p; sequence < records; sequence += producers) {
+                    while(!produce(sequence))
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        for(size_t received = 0; received < records * RECORD;) {
+            size_t taken = consume();
+            if(taken == 0)
+                std::this_thread::yield();
+            received += taken;
+        }
+        for(std::thread& thread : threads)
+            thread.join();
+    });
+}
+
+void ring(const std::string& subject, size_t producers, circular_buffer::mapping memory, size_t records) {
+    circular_buffer buffer(RING, producers > 1 ? circular_buffer::producers::multiple
+                                               : circular_buffer::producers::single, memory);
+    uint64_t checksum = 0;
+
+    double ms = run(producers, records, [&](uint64_t sequence) {
+        circular_buffer::region space = buffer.reserve(RECORD);
+        if(space.size < RECORD) {
+            // A plain ring stops reservations at its end; skip it with padding like a real log writer would
+            if(space.size > 0) {
+                std::memset(space.data, 0, space.size);
+                buffer.commit(space);
+            }
+            return false;
+        }
+        format(space.data, sequence);
+        buffer.commit(space);
+        return true;
+    }, [&]() -> size_t {
+        circular_buffer::region data = buffer.peek();
+        for(size_t i = 0; i + sizeof(uint64_t) <= data.size; i += RECORD) {
+            uint64_t word;
+            std::memcpy(&word, data.data + i, sizeof(word));
+            checksum += word;
+        }
+        buffer.consume(data.size);
+        return data.size;
+    });
+
+    benchmark::do_not_optimize(checksum);
+    benchmark::report("stream x" + std::to_string(producers), subject, ms, records);
+    std::printf("%-28s %-24s %10.2f GB/s\n", "", "", records * RECORD / ms / 1e6);
+}
+
+void locked(size_t producers, size_t records) {
+    locked_queue queue;
+    std::vector<uint8_t> scratch(RING);
+    uint64_t checksum = 0;
+
+    double ms = run(producers, records, [&](uint64_t sequence) {
+        uint8_t record[RECORD];
+        format(record, sequence);
+        return queue.push(record);
+    }, [&]() -> size_t {
+        size_t taken = queue.pop(scratch.data(), scratch.size());
+        for(size_t i = 0; i + sizeof(uint64_t) <= taken; i += RECORD) {
+            uint64_t word;
+            std::memcpy(&word, scratch.data() + i, sizeof(word));
+            checksum += word;
+        }
+        return taken;
+    });
+
+    benchmark::do_not_optimize(checksum);
+    benchmark::report("stream x" + std::to_string(producers), "mutex + std::deque", ms, records);
+    std::printf("%-28s %-24s %10.2f GB/s\n", "", "", records * RECORD / ms / 1e6);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t records = benchmark::size_arg(argc, argv, 4000000);
+    std::printf("%zu records of %zu bytes through a %zu byte ring, %u hardware threads\n",
+                records, RECORD, RING, std::thread::hardware_concurrency());
+
+    for(size_t producers : {1, 4}) {
+        locked(producers, records);
+        ring("circular_buffer", producers, circular_buffer::mapping::plain, records);
+        ring("circular_buffer (magic)", producers, circular_buffer::mapping::magic, records);
+    }
+}
@@ -0,0 +1,61 @@
+/**
+ * Benchmarks connected components with disjoint_set and with concurrent_disjoint_set on 1 to 64 threads.
+ *
+ * Usage: bench_disjoint_set [vertex count]
+ *   Twice as many random edges as vertices are united.
+ **/
+
+#include "benchmark.h"
+#include <abstracts/set/disjoint_set.h>
+
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t n = benchmark::size_arg(argc, argv, 4000000);
+    size_t m = 2 * n;
+
+    std::vector<uint32_t> edges(2 * m);
+    std::mt19937 rng(1);
+    for(uint32_t& endpoint : edges)
+        endpoint = static_cast<uint32_t>(rng() % n);
+
+    std::printf("%zu vertices, %zu edges, %u hardware threads\n", n, m, std::thread::hardware_concurrency());
+
+    size_t components = 0;
+    report("unite all edges", "disjoint_set", time_ms([&] {
+        disjoint_set sets(n);
+        for(size_t i = 0; i < m; i++)
+            sets.unite(edges[2 * i], edges[2 * i + 1]);
+        components = sets.count();
+    }), m);
+
+    for(size_t threads = 1; threads <= 64; threads *= 2) {
+        concurrent_disjoint_set sets(n);
+
+        double ms = time_ms([&] {
+            std::vector<std::thread> workers;
+            for(size_t t = 0; t < threads; t++) {
+                workers.emplace_back([&, t] {
+                    // Contiguous slices keep each thread's reads of the edge list sequential
+                    size_t first = m * t / threads, last = m * (t + 1) / threads;
+                    for(size_t i = first; i < last; i++)
+                        sets.unite(edges[2 * i], edges[2 * i + 1]);
+                });
+            }
+            for(auto& worker : workers)
+                worker.join();
+        });
+
+        report("unite all edges", "concurrent x" + std::to_string(threads), ms, m);
+        if(sets.count() != components)
+            std::printf("component count mismatch: %zu vs %zu\n", sets.count(), components);
+    }
+
+    return 0;
+}
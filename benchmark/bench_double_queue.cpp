@@ -0,0 +1,153 @@
+/**
+ * Benchmarks double_queue against std::deque, and work_stealing_deque against a mutex protected std::deque used
+ *   the same way.
+ *
+ * Usage: bench_double_queue [element count]
+ **/
+
+#include "benchmark.h"
+#include <abstracts/queue/double_queue.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename Deque>
+void run_sequential(const std::string& subject, size_t n) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    Deque deque;
+    report("push_back", subject, time_ms([&] {
+        for(size_t i = 0; i < n; i++)
+            deque.push_back(i);
+    }), n);
+
+    size_t sum = 0;
+    report("indexed scan", subject, time_ms([&] {
+        for(size_t i = 0; i < n; i++)
+            sum += deque[i];
+    }), n);
+    benchmark::do_not_optimize(sum);
+
+    report("pop_front", subject, time_ms([&] {
+        for(size_t i = 0; i < n; i++)
+            deque.pop_front();
+    }), n);
+
+    // A FIFO hovering around 1000 elements: allocation free for double_queue once its pool is warm
+    for(size_t i = 0; i < 1000; i++)
+        deque.push_back(i);
+    report("steady-state FIFO", subject, time_ms([&] {
+        for(size_t i = 0; i < n; i++) {
+            deque.push_back(i);
+            deque.pop_front();
+        }
+    }), 2 * n);
+
+    report("push_front + pop_back", subject, time_ms([&] {
+        for(size_t i = 0; i < n; i++)
+            deque.push_front(i);
+        for(size_t i = 0; i < n; i++)
+            deque.pop_back();
+    }), 2 * n);
+}
+
+class locked_deque {
+public:
+    void push(size_t item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(item);
+    }
+
+    bool pop(size_t& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(items.empty())
+            return false;
+        out = items.back();
+        items.pop_back();
+        return true;
+    }
+
+    bool steal(size_t& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(items.empty())
+            return false;
+        out = items.front();
+        items.pop_front();
+        return true;
+    }
+
+    bool empty() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.empty();
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<size_t> items;
+};
+
+/**
+ * The owner pushes `n` tasks and pops one after every push of a multiple of 4, while `thieves` threads steal.
+ */
+template <typename Deque>
+void run_stealing(const std::string& subject, size_t n, size_t thieves) {
+    Deque deque;
+    std::atomic<bool> done(false);
+    std::atomic<size_t> stolen(0);
+
+    double ms = benchmark::time_ms([&] {
+        std::vector<std::thread> workers;
+        for(size_t t = 0; t < thieves; t++) {
+            workers.emplace_back([&] {
+                size_t task, mine = 0;
+                while(!done.load(std::memory_order_relaxed)) {
+                    if(deque.steal(task))
+                        mine++;
+                    else
+                        std::this_thread::yield();
+                }
+                stolen += mine;
+            });
+        }
+
+        size_t task;
+        for(size_t i = 0; i < n; i++) {
+            deque.push(i);
+            if(i % 4 == 0)
+                deque.pop(task);
+        }
+        while(deque.pop(task)) {}
+        while(!deque.empty())
+            std::this_thread::yield();
+
+        done = true;
+        for(auto& worker : workers)
+            worker.join();
+    });
+
+    benchmark::report("owner + " + std::to_string(thieves) + " thieves", subject, ms, n);
+    std::printf("%-28s %-24s %zu stolen\n", "", "", stolen.load());
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t n = benchmark::size_arg(argc, argv, 10000000);
+    std::printf("%zu elements, %u hardware threads\n", n, std::thread::hardware_concurrency());
+
+    run_sequential<std::deque<size_t>>("std::deque", n);
+    run_sequential<double_queue<size_t>>("double_queue", n);
+
+    for(size_t thieves : {0, 1, 3, 7}) {
+        run_stealing<locked_deque>("mutex + std::deque", n, thieves);
+        run_stealing<work_stealing_deque<size_t>>("work_stealing_deque", n, thieves);
+    }
+}
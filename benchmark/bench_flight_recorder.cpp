@@ -0,0 +1,112 @@
+/**
+ * Times threads appending trace records to a flight_recorder, and to the ad-hoc alternative, a mutex-protected
+ *   std::deque of records that drops the oldest one when full. Also times taking a snapshot while writers append.
+ *
+ * Usage: bench_flight_recorder [records per thread]
+ **/
+
+#include "benchmark.h"
+#include <linear/arrays/circular_buffer.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const size_t CAPACITY = 1 << 20;
+const size_t RECORD = 40;
+
+/**
+ * A trace record: a timestamp, a thread id and some arguments.
+ */
+void format(uint8_t *out, uint64_t sequence, uint64_t thread) {
+    uint64_t words[RECORD / 8] = {sequence * 1000, thread, sequence, sequence ^ thread, 42};
+    std::memcpy(out, words, RECORD);
+}
+
+class locked_recorder {
+public:
+    void append(const uint8_t *record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(records.size() == CAPACITY / RECORD)
+            records.pop_front();
+        records.emplace_back(record, record + RECORD);
+    }
+
+    size_t snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::deque<std::vector<uint8_t>> copy(records);
+        return copy.size();
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<std::vector<uint8_t>> records;
+};
+
+template <typename Recorder>
+void run(const std::string& subject, Recorder& recorder, size_t threads, size_t per_thread) {
+    double ms = benchmark::time_ms([&] {
+        std::vector<std::thread> workers;
+        for(size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&recorder, t, per_thread] {
+                uint8_t record[RECORD];
+                for(uint64_t i = 0; i < per_thread; i++) {
+                    format(record, i, t);
+                    recorder.append(record);
+                }
+            });
+        }
+        for(std::thread& worker : workers)
+            worker.join();
+    });
+    benchmark::report("append x" + std::to_string(threads), subject, ms, threads * per_thread);
+
+    // Snapshots taken while one thread keeps appending
+    std::atomic<bool> done(false);
+    std::thread writer([&] {
+        uint8_t record[RECORD];
+        for(uint64_t i = 0; !done.load(std::memory_order_relaxed); i++) {
+            format(record, i, 0);
+            recorder.append(record);
+        }
+    });
+    size_t copied = 0;
+    const size_t snapshots = 20;
+    ms = benchmark::time_ms([&] {
+        for(size_t i = 0; i < snapshots; i++)
+            copied += recorder.snapshot();
+    });
+    done = true;
+    writer.join();
+    benchmark::report("snapshot while appending", subject, ms, copied);
+    std::printf("%-28s %-24s %zu records per snapshot\n", "", "", copied / snapshots);
+}
+
+struct lock_free_recorder {
+    flight_recorder recorder{CAPACITY};
+
+    void append(const uint8_t *record) { recorder.append(record, RECORD); }
+    size_t snapshot() { return recorder.snapshot().size(); }
+};
+
+}
+
+int main(int argc, char **argv) {
+    size_t per_thread = benchmark::size_arg(argc, argv, 2000000);
+    std::printf("%zu records of %zu bytes per thread, %zu byte ring, %u hardware threads\n",
+                per_thread, RECORD, CAPACITY, std::thread::hardware_concurrency());
+
+    for(size_t threads : {1, 2, 4}) {
+        locked_recorder locked;
+        run("mutex + std::deque", locked, threads, per_thread);
+        lock_free_recorder lock_free;
+        run("flight_recorder", lock_free, threads, per_thread);
+    }
+}
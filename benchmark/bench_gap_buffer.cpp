@@ -0,0 +1,165 @@
+/**
+ * Replays editing traces on gap_buffer, std::string and str_rope, over documents from 1 KB to 100 MB.
+ *
+ * The traces are generated to follow the shape of recorded editing sessions: most edits type or delete a few
+ *   characters where the previous edit ended, the cursor occasionally moves a few lines away, and rarely jumps
+ *   anywhere in the document. A second trace types at eight cursors in turn, as multi-cursor editing does.
+ *
+ * Subjects that move O(document) bytes per edit replay only as much of a trace as fits a time budget, and str_rope
+ *   at most 20000 edits; rates are per edit either way.
+ *
+ * Usage: bench_gap_buffer [largest document size in bytes]
+ **/
+
+#include "benchmark.h"
+#include <linear/arrays/gap_buffer.h>
+#include <primitives/str_rope.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t EDITS = 200000;
+// str_rope never rebalances, so long traces make it arbitrarily slow
+const size_t ROPE_EDITS = 20000;
+
+struct edit {
+    // The position the cursor is at when the edit starts
+    size_t position;
+    size_t erased;
+    std::string typed;
+    // The cursor doing the edit, for the multi-cursor trace
+    size_t cursor;
+};
+
+std::vector<edit> session_trace(size_t document, size_t edits) {
+    std::mt19937_64 rng(1);
+    std::vector<edit> trace;
+    size_t length = document, cursor = document / 2;
+    for(size_t i = 0; i < edits; i++) {
+        unsigned roll = rng() % 100;
+        if(roll < 2)
+            cursor = rng() % (length + 1);
+        else if(roll < 12)
+            cursor = std::min(length, cursor - std::min(cursor, size_t(500)) + rng() % 1000);
+
+        edit e{cursor, 0, std::string(), 0};
+        if(rng() % 100 < 15)
+            e.erased = std::min(cursor, size_t(rng() % 8 + 1));
+        else
+            e.typed.assign(rng() % 12 + 1, static_cast<char>('a' + rng() % 26));
+
+        length += e.typed.size() - e.erased;
+        cursor += e.typed.size() - e.erased;
+        trace.push_back(e);
+    }
+    return trace;
+}
+
+std::vector<edit> multi_cursor_trace(size_t document, size_t cursors, size_t edits) {
+    std::vector<size_t> positions;
+    for(size_t c = 0; c < cursors; c++)
+        positions.push_back(document * (2 * c + 1) / (2 * cursors));
+
+    std::vector<edit> trace;
+    for(size_t i = 0; i < edits; i++) {
+        size_t c = i % cursors;
+        edit e{positions[c], 0, std::string(1, static_cast<char>('a' + i % 26)), c};
+        for(size_t other = c; other < cursors; other++)
+            positions[other]++;
+        trace.push_back(e);
+    }
+    return trace;
+}
+
+/**
+ * @return how many edits a subject that copies O(document) bytes per edit can replay in reasonable time
+ */
+size_t budget(size_t document, size_t edits) {
+    return std::max<size_t>(100, std::min<size_t>(edits, 4000000000ull / std::max<size_t>(document, 1)));
+}
+
+void replay(const std::string& name, const std::string& document, const std::vector<edit>& trace, size_t cursors) {
+    {
+        gap_buffer text(document);
+        for(size_t c = 1; c < cursors; c++)
+            text.add_cursor(0);
+        double ms = benchmark::time_ms([&] {
+            for(const edit& e : trace) {
+                if(text.position(e.cursor) != e.position)
+                    text.move(e.cursor, e.position);
+                text.erase_before(e.cursor, e.erased);
+                text.insert(e.cursor, e.typed);
+            }
+        });
+        benchmark::do_not_optimize(text.size());
+        benchmark::report(name, cursors > 1 ? "gap_buffer (one gap each)" : "gap_buffer", ms, trace.size());
+    }
+
+    size_t limited = budget(document.size(), trace.size());
+    if(cursors > 1) {
+        // The same edits with a single gap that follows whichever cursor is typing
+        gap_buffer text(document);
+        double ms = benchmark::time_ms([&] {
+            for(size_t i = 0; i < limited; i++) {
+                text.move(0, trace[i].position);
+                text.insert(0, trace[i].typed);
+            }
+        });
+        benchmark::do_not_optimize(text.size());
+        benchmark::report(name, "gap_buffer (one gap)", ms, limited);
+    }
+
+    {
+        std::string text(document);
+        double ms = benchmark::time_ms([&] {
+            for(size_t i = 0; i < limited; i++) {
+                const edit& e = trace[i];
+                text.erase(e.position - e.erased, e.erased);
+                text.insert(e.position - e.erased, e.typed);
+            }
+        });
+        benchmark::do_not_optimize(text.size());
+        benchmark::report(name, "std::string", ms, limited);
+    }
+    {
+        // str_rope::delete_str mishandles deletions that do not start at a leaf boundary, so the rope only replays
+        //   the insertions; the text it ends up with is longer, which the positions allow for
+        str_rope text(document);
+        size_t inserted = 0;
+        double ms = benchmark::time_ms([&] {
+            for(size_t i = 0; i < std::min<size_t>(limited, ROPE_EDITS); i++) {
+                const edit& e = trace[i];
+                if(!e.typed.empty()) {
+                    text.insert_str(e.position, e.typed);
+                    inserted++;
+                }
+            }
+        });
+        benchmark::do_not_optimize(text.get_length());
+        benchmark::report(name, "str_rope (inserts only)", ms, inserted);
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t largest = benchmark::size_arg(argc, argv, 100000000);
+
+    for(size_t size : {1000, 100000, 10000000, 100000000}) {
+        if(size > largest)
+            break;
+        std::string document(size, ' ');
+        for(size_t i = 0; i < size; i++)
+            document[i] = i % 64 == 63 ? '\n' : static_cast<char>('a' + i * 7 % 26);
+
+        std::string label = size < 1000000 ? std::to_string(size / 1000) + " KB"
+                                           : std::to_string(size / 1000000) + " MB";
+        replay("session, " + label, document, session_trace(size, EDITS), 1);
+        replay("8 cursors, " + label, document, multi_cursor_trace(size, 8, EDITS), 8);
+    }
+}
@@ -0,0 +1,141 @@
+/**
+ * Benchmarks the touch rate of an LRU cache whose recency list is a std::list, a doubly_linked_list, or an
+ *   intrusive_doubly_linked_list threaded through preallocated entries. Each cache finds entries with the same hash
+ *   table; only the list differs.
+ *
+ * Usage: bench_lru [access count] [capacity]
+ **/
+
+#include "benchmark.h"
+#include <linear/lists/doubly_linked_list.h>
+
+#include <cstdint>
+#include <list>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/**
+ * An LRU cache over any list of (key, value) pairs with std::list's interface.
+ */
+template <typename List>
+class lru_cache {
+public:
+    explicit lru_cache(size_t capacity) : capacity(capacity) { index.reserve(capacity); }
+
+    /**
+     * @return true on a hit. A miss inserts the key, evicting the least recently used one if the cache is full.
+     */
+    bool touch(uint64_t key) {
+        auto found = index.find(key);
+        if(found != index.end()) {
+            recency.splice(recency.begin(), recency, found->second);
+            return true;
+        }
+
+        if(index.size() == capacity) {
+            index.erase(recency.back().first);
+            recency.pop_back();
+        }
+        recency.push_front({key, key});
+        index.emplace(key, recency.begin());
+        return false;
+    }
+
+private:
+    size_t capacity;
+    List recency;
+    std::unordered_map<uint64_t, typename List::iterator> index;
+};
+
+/**
+ * doubly_linked_list only splices within itself, so it gets the two-argument splice.
+ */
+class pooled_list : public doubly_linked_list<std::pair<uint64_t, uint64_t>> {
+public:
+    using doubly_linked_list::splice;
+    void splice(iterator position, pooled_list&, iterator element) { doubly_linked_list::splice(position, element); }
+};
+
+/**
+ * An LRU cache whose entries embed their recency hook and are recycled on eviction, so nothing is allocated once
+ *   the hash table is warm.
+ */
+class intrusive_lru_cache {
+    struct entry {
+        uint64_t key, value;
+        doubly_linked_list_hook recency;
+    };
+
+public:
+    explicit intrusive_lru_cache(size_t capacity) : entries(capacity) { index.reserve(capacity); }
+
+    bool touch(uint64_t key) {
+        auto found = index.find(key);
+        if(found != index.end()) {
+            recency.splice(recency.begin(), recency, recency.iterator_to(*found->second));
+            return true;
+        }
+
+        entry *e;
+        if(used < entries.size()) {
+            e = &entries[used++];
+        } else {
+            e = &recency.back();
+            recency.pop_back();
+            index.erase(e->key);
+        }
+        e->key = e->value = key;
+        recency.push_front(*e);
+        index.emplace(key, e);
+        return false;
+    }
+
+private:
+    std::vector<entry> entries;
+    size_t used = 0;
+    intrusive_doubly_linked_list<entry, &entry::recency> recency;
+    std::unordered_map<uint64_t, entry*> index;
+};
+
+template <typename Cache>
+void run(const std::string& name, const std::string& subject, size_t capacity, const std::vector<uint64_t>& keys) {
+    Cache cache(capacity);
+    size_t hits = 0;
+    double ms = benchmark::time_ms([&] {
+        for(uint64_t key : keys)
+            hits += cache.touch(key);
+    });
+    benchmark::report(name, subject, ms, keys.size());
+    std::printf("%-28s %-24s %.1f%% hits\n", "", "", 100.0 * hits / keys.size());
+}
+
+void run_all(const std::string& name, size_t capacity, const std::vector<uint64_t>& keys) {
+    run<lru_cache<std::list<std::pair<uint64_t, uint64_t>>>>(name, "std::list", capacity, keys);
+    run<lru_cache<pooled_list>>(name, "doubly_linked_list", capacity, keys);
+    run<intrusive_lru_cache>(name, "intrusive", capacity, keys);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t accesses = benchmark::size_arg(argc, argv, 10000000);
+    size_t capacity = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    std::printf("%zu accesses, capacity %zu\n", accesses, capacity);
+
+    std::mt19937_64 rng(1);
+    size_t universe = 4 * capacity;
+    std::vector<uint64_t> skewed(accesses), uniform(accesses);
+    for(size_t i = 0; i < accesses; i++) {
+        // The product of two uniform draws favours small keys
+        skewed[i] = (rng() % universe) * (rng() % universe) / universe;
+        uniform[i] = rng() % universe;
+    }
+
+    run_all("touch, skewed keys", capacity, skewed);
+    run_all("touch, uniform keys", capacity, uniform);
+}
@@ -0,0 +1,63 @@
+/**
+ * Benchmarks multi_map (one value block per key) against std::multimap on a secondary index shaped workload: a
+ *   few keys with thousands of values each.
+ *
+ * Usage: bench_multi_map [values per key]
+ **/
+
+#include "benchmark.h"
+#include <abstracts/map/multi_map.h>
+
+#include <map>
+#include <vector>
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t per_key = benchmark::size_arg(argc, argv, 5000);
+    const int keys = 1000;
+    size_t n = per_key * keys;
+
+    std::vector<int> rows(per_key);
+    for(size_t i = 0; i < per_key; i++)
+        rows[i] = static_cast<int>(i);
+
+    multi_map<int, int> blocks;
+    std::multimap<int, int> nodes;
+
+    // Interleave keys so std::multimap nodes for one key end up scattered across the heap
+    report("interleaved insert", "multi_map", time_ms([&] {
+        for(size_t i = 0; i < per_key; i++)
+            for(int key = 0; key < keys; key++)
+                blocks.insert(key, rows[i]);
+    }), n);
+    report("interleaved insert", "std::multimap", time_ms([&] {
+        for(size_t i = 0; i < per_key; i++)
+            for(int key = 0; key < keys; key++)
+                nodes.emplace(key, rows[i]);
+    }), n);
+
+    multi_map<int, int> bulk;
+    report("insert_many", "multi_map", time_ms([&] {
+        for(int key = 0; key < keys; key++)
+            bulk.insert_many(key, rows.begin(), rows.end());
+    }), n);
+
+    long long sum = 0;
+    report("equal_range scan", "multi_map", time_ms([&] {
+        for(int key = 0; key < keys; key++)
+            for(int value : blocks.equal_range(key))
+                sum += value;
+    }), n);
+    report("equal_range scan", "std::multimap", time_ms([&] {
+        for(int key = 0; key < keys; key++) {
+            auto range = nodes.equal_range(key);
+            for(auto it = range.first; it != range.second; ++it)
+                sum += it->second;
+        }
+    }), n);
+
+    benchmark::do_not_optimize(sum);
+    return 0;
+}
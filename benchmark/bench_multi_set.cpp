@@ -0,0 +1,84 @@
+/**
+ * Benchmarks exact counting (multi_set, std::unordered_map) against approximate counting (count-min sketch plus
+ *   SpaceSaving) on a Zipfian event stream.
+ *
+ * Usage: bench_multi_set [event count]
+ **/
+
+#include "benchmark.h"
+#include <abstracts/set/multi_set.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+std::vector<uint64_t> zipf_stream(size_t events, size_t distinct, double skew, unsigned seed) {
+    std::vector<double> cdf(distinct);
+    double sum = 0;
+    for(size_t i = 0; i < distinct; i++)
+        cdf[i] = sum += 1.0 / std::pow(double(i + 1), skew);
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<uint64_t> stream(events);
+    for(uint64_t& event : stream)
+        event = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+    return stream;
+}
+
+}
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t events = benchmark::size_arg(argc, argv, 10000000);
+    size_t distinct = events / 10;
+    std::vector<uint64_t> stream = zipf_stream(events, distinct, 1.1, 1);
+
+    multi_set<uint64_t> exact;
+    std::unordered_map<uint64_t, uint64_t> baseline;
+    approximate_multi_set<uint64_t> sketch_only(1 << 16, 4);
+    approximate_multi_set<uint64_t> approximate(1 << 16, 4, 1000);
+
+    report("count events", "multi_set", time_ms([&] {
+        for(uint64_t event : stream)
+            exact.insert(event);
+    }), events);
+    report("count events", "std::unordered_map", time_ms([&] {
+        for(uint64_t event : stream)
+            baseline[event]++;
+    }), events);
+    report("count events", "count-min only", time_ms([&] {
+        for(uint64_t event : stream)
+            sketch_only.insert(event);
+    }), events);
+    report("count events", "count-min + top 1000", time_ms([&] {
+        for(uint64_t event : stream)
+            approximate.insert(event);
+    }), events);
+
+    std::printf("%-28s %-24s %10.2f MB (%zu distinct)\n", "memory", "multi_set",
+                exact.memory_usage() / 1e6, exact.distinct_size());
+    std::printf("%-28s %-24s %10.2f MB\n", "memory", "count-min + top 1000", approximate.memory_usage() / 1e6);
+
+    // Accuracy of the approximate counts for the 100 most frequent elements
+    double worst = 0;
+    for(uint64_t value = 0; value < 100; value++) {
+        double truth = double(exact.count(value));
+        worst = std::max(worst, (approximate.count(value) - truth) / truth);
+    }
+    auto top = approximate.heavy_hitters();
+    size_t found = 0;
+    for(size_t i = 0; i < 100 && i < top.size(); i++)
+        found += top[i].value < 100 ? 1 : 0;
+    std::printf("approximate: worst relative error in top 100 = %.4f, %zu/100 true top elements recovered\n",
+                worst, found);
+
+    benchmark::do_not_optimize(baseline.size());
+    return 0;
+}
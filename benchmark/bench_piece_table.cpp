@@ -0,0 +1,126 @@
+/**
+ * Compares piece_table with gap_buffer on large files: opening one, editing at random places across it, and undoing.
+ *
+ * Opening reads a file of the given size written to the working directory, which is removed afterwards. The editing
+ *   trace types a few characters at a random position each time, the worst case for a gap buffer, whose gap has to
+ *   travel there; it replays only as much of the trace as fits a time budget.
+ *
+ * Usage: bench_piece_table [file size in bytes]
+ **/
+
+#include "benchmark.h"
+#include <linear/arrays/gap_buffer.h>
+#include <linear/arrays/piece_table.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t EDITS = 100000;
+const char *PATH = "bench_piece_table.txt";
+
+struct edit {
+    size_t position;
+    std::string typed;
+};
+
+std::vector<edit> jump_trace(size_t document, size_t edits) {
+    std::mt19937_64 rng(1);
+    std::vector<edit> trace;
+    for(size_t i = 0; i < edits; i++) {
+        edit e{rng() % (document + 1), std::string(rng() % 8 + 1, static_cast<char>('a' + rng() % 26))};
+        document += e.typed.size();
+        trace.push_back(e);
+    }
+    return trace;
+}
+
+void bench_open(size_t size) {
+    double ms = benchmark::time_ms([&] {
+        piece_table text = piece_table::open(PATH);
+        benchmark::do_not_optimize(text.size());
+    });
+    benchmark::report("open", "piece_table (mmap)", ms, 1);
+
+    ms = benchmark::time_ms([&] {
+        std::ifstream in(PATH, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        benchmark::do_not_optimize(text.size());
+    });
+    benchmark::report("open", "std::string (read)", ms, 1);
+
+    ms = benchmark::time_ms([&] {
+        std::ifstream in(PATH, std::ios::binary);
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        gap_buffer text(contents.str());
+        benchmark::do_not_optimize(text.size());
+    });
+    benchmark::report("open", "gap_buffer (read)", ms, 1);
+    std::printf("%-28s %-24s %zu bytes\n", "", "", size);
+}
+
+void bench_edits(const std::string& document) {
+    std::vector<edit> trace = jump_trace(document.size(), EDITS);
+
+    piece_table table(document);
+    double ms = benchmark::time_ms([&] {
+        for(const edit& e : trace)
+            table.insert(e.position, e.typed);
+    });
+    benchmark::report("random jumps", "piece_table", ms, trace.size());
+    std::printf("%-28s %-24s %zu pieces\n", "", "", table.piece_count());
+
+    size_t limited = std::max<size_t>(100, std::min<size_t>(trace.size(), 2000000000ull / document.size()));
+    gap_buffer buffer(document);
+    ms = benchmark::time_ms([&] {
+        for(size_t i = 0; i < limited; i++) {
+            buffer.move(0, trace[i].position);
+            buffer.insert(0, trace[i].typed);
+        }
+    });
+    benchmark::do_not_optimize(buffer.size());
+    benchmark::report("random jumps", "gap_buffer", ms, limited);
+
+    ms = benchmark::time_ms([&] {
+        while(table.undo()) {}
+    });
+    benchmark::do_not_optimize(table.size());
+    benchmark::report("undo all", "piece_table", ms, trace.size());
+
+    ms = benchmark::time_ms([&] {
+        while(table.redo()) {}
+    });
+    benchmark::do_not_optimize(table.size());
+    benchmark::report("redo all", "piece_table", ms, trace.size());
+
+    ms = benchmark::time_ms([&] {
+        benchmark::do_not_optimize(table.to_string().size());
+    });
+    benchmark::report("read back", "piece_table", ms, 1);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t size = benchmark::size_arg(argc, argv, 256000000);
+
+    std::string document(size, ' ');
+    for(size_t i = 0; i < size; i++)
+        document[i] = i % 64 == 63 ? '\n' : static_cast<char>('a' + i * 7 % 26);
+    {
+        std::ofstream out(PATH, std::ios::binary);
+        out.write(document.data(), document.size());
+    }
+
+    bench_open(size);
+    std::remove(PATH);
+    bench_edits(document);
+}
@@ -0,0 +1,174 @@
+/**
+ * Benchmarks the d-ary heap priority_queue (d = 2, 4, 8) and pairing_heap against std::priority_queue.
+ *
+ * Usage: bench_priority_queue [operation count]
+ *   - push then pop:  push n/2 random keys, then pop them all
+ *   - hold:           a queue of n/10 keys; each step pops the minimum and pushes it back with a random increment
+ *   - dijkstra:       shortest paths on a random graph with n/8 vertices and n/2 edges. std::priority_queue pushes
+ *                     duplicates and skips stale entries; the addressable heaps use decrease_key.
+ **/
+
+#include "benchmark.h"
+#include <abstracts/queue/priority_queue.h>
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> std_min_queue;
+
+struct graph {
+    std::vector<uint32_t> offsets, targets, weights;
+};
+
+graph random_graph(size_t vertices, size_t edges) {
+    std::mt19937 rng(3);
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> lists(vertices);
+    for(size_t i = 0; i < edges; i++)
+        lists[rng() % vertices].push_back({static_cast<uint32_t>(rng() % vertices), rng() % 1000 + 1});
+
+    graph g;
+    g.offsets.push_back(0);
+    for(auto& list : lists) {
+        for(auto& edge : list) {
+            g.targets.push_back(edge.first);
+            g.weights.push_back(edge.second);
+        }
+        g.offsets.push_back(static_cast<uint32_t>(g.targets.size()));
+    }
+    return g;
+}
+
+template <typename Queue>
+void run_generic(const std::string& subject, size_t n) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> keys(n / 2);
+    for(uint64_t& key : keys)
+        key = rng();
+
+    uint64_t checksum = 0;
+    report("push then pop", subject, time_ms([&] {
+        Queue queue;
+        for(uint64_t key : keys)
+            queue.push(key);
+        while(!queue.empty()) {
+            checksum += queue.top();
+            queue.pop();
+        }
+    }), n);
+
+    Queue queue;
+    for(size_t i = 0; i < n / 10; i++)
+        queue.push(rng() % 1000000);
+    report("hold", subject, time_ms([&] {
+        for(size_t i = 0; i < n / 2; i++) {
+            uint64_t key = queue.top();
+            queue.pop();
+            queue.push(key + rng() % 1000);
+        }
+    }), n);
+    benchmark::do_not_optimize(checksum);
+}
+
+uint64_t dijkstra_lazy(const graph& g) {
+    size_t vertices = g.offsets.size() - 1;
+    std::vector<uint64_t> distance(vertices, std::numeric_limits<uint64_t>::max());
+    std::priority_queue<std::pair<uint64_t, uint32_t>, std::vector<std::pair<uint64_t, uint32_t>>,
+            std::greater<std::pair<uint64_t, uint32_t>>> queue;
+
+    distance[0] = 0;
+    queue.push({0, 0});
+    while(!queue.empty()) {
+        auto top = queue.top();
+        queue.pop();
+        if(top.first != distance[top.second])
+            continue;
+        for(uint32_t e = g.offsets[top.second]; e < g.offsets[top.second + 1]; e++) {
+            uint64_t candidate = top.first + g.weights[e];
+            if(candidate < distance[g.targets[e]]) {
+                distance[g.targets[e]] = candidate;
+                queue.push({candidate, g.targets[e]});
+            }
+        }
+    }
+
+    uint64_t sum = 0;
+    for(uint64_t d : distance)
+        sum += d;
+    return sum;
+}
+
+template <typename Queue>
+uint64_t dijkstra_decrease_key(const graph& g) {
+    size_t vertices = g.offsets.size() - 1;
+    std::vector<uint64_t> distance(vertices, std::numeric_limits<uint64_t>::max());
+    std::vector<typename Queue::handle> handles(vertices);
+    std::vector<bool> queued(vertices, false);
+    Queue queue;
+
+    distance[0] = 0;
+    handles[0] = queue.push({0, 0});
+    queued[0] = true;
+    while(!queue.empty()) {
+        auto top = queue.top();
+        queue.pop();
+        queued[top.second] = false;
+        for(uint32_t e = g.offsets[top.second]; e < g.offsets[top.second + 1]; e++) {
+            uint32_t target = g.targets[e];
+            uint64_t candidate = top.first + g.weights[e];
+            if(candidate < distance[target]) {
+                distance[target] = candidate;
+                if(queued[target]) {
+                    queue.decrease_key(handles[target], {candidate, target});
+                } else {
+                    handles[target] = queue.push({candidate, target});
+                    queued[target] = true;
+                }
+            }
+        }
+    }
+
+    uint64_t sum = 0;
+    for(uint64_t d : distance)
+        sum += d;
+    return sum;
+}
+
+}
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t n = benchmark::size_arg(argc, argv, 10000000);
+    std::printf("%zu operations\n", n);
+
+    run_generic<std_min_queue>("std::priority_queue", n);
+    run_generic<priority_queue<uint64_t, std::less<uint64_t>, 2>>("priority_queue d=2", n);
+    run_generic<priority_queue<uint64_t>>("priority_queue d=4", n);
+    run_generic<priority_queue<uint64_t, std::less<uint64_t>, 8>>("priority_queue d=8", n);
+    run_generic<pairing_heap<uint64_t>>("pairing_heap", n);
+
+    typedef std::pair<uint64_t, uint32_t> item;
+    graph g = random_graph(n / 8, n / 2);
+    uint64_t expected = 0, sum = 0;
+    report("dijkstra", "std::priority_queue", time_ms([&] { expected = dijkstra_lazy(g); }), n / 2);
+    report("dijkstra", "priority_queue d=2", time_ms([&] {
+        sum = dijkstra_decrease_key<priority_queue<item, std::less<item>, 2>>(g);
+    }), n / 2);
+    report("dijkstra", "priority_queue d=4", time_ms([&] {
+        sum = dijkstra_decrease_key<priority_queue<item>>(g);
+    }), n / 2);
+    report("dijkstra", "pairing_heap", time_ms([&] { sum = dijkstra_decrease_key<pairing_heap<item>>(g); }), n / 2);
+    if(sum != expected)
+        std::printf("distance mismatch: %llu vs %llu\n", (unsigned long long) sum, (unsigned long long) expected);
+}
@@ -0,0 +1,150 @@
+/**
+ * Benchmarks spsc_queue and mpmc_queue against a mutex protected std::deque with 1, 4 and 16 producer/consumer
+ *   pairs.
+ *
+ * Usage: bench_queue [items per producer]
+ *   Producers push timestamps; consumers record how long each one spent queued. Besides throughput, the p50, p99 and
+ *   p99.9 of that latency are printed. A thread that finds the queue full (or empty) yields before retrying.
+ **/
+
+#include "benchmark.h"
+#include <abstracts/queue/queue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+class locked_deque {
+public:
+    explicit locked_deque(size_t capacity) : limit(capacity) {}
+
+    bool try_push(uint64_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(items.size() == limit)
+            return false;
+        items.push_back(value);
+        return true;
+    }
+
+    bool try_pop(uint64_t& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(items.empty())
+            return false;
+        out = items.front();
+        items.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<uint64_t> items;
+    size_t limit;
+};
+
+/**
+ * Single-item push and pop, for any of the three queues.
+ */
+template <typename Queue>
+struct single {
+    static size_t push(Queue& queue, const uint64_t *values, size_t n) { return n && queue.try_push(values[0]); }
+    static size_t pop(Queue& queue, uint64_t *out, size_t) { return queue.try_pop(out[0]); }
+};
+
+template <typename Queue>
+struct batched {
+    static size_t push(Queue& queue, const uint64_t *values, size_t n) { return queue.try_push_n(values, n); }
+    static size_t pop(Queue& queue, uint64_t *out, size_t n) { return queue.try_pop_n(out, n); }
+};
+
+template <typename Queue, typename Ops>
+void run(const std::string& subject, size_t pairs, size_t per_producer, size_t batch) {
+    Queue queue(1024);
+    std::vector<std::vector<uint64_t>> latencies(pairs);
+    std::atomic<size_t> remaining(pairs * per_producer);
+
+    double ms = benchmark::time_ms([&] {
+        std::vector<std::thread> threads;
+        for(size_t p = 0; p < pairs; p++) {
+            threads.emplace_back([&] {
+                std::vector<uint64_t> values(batch);
+                for(size_t sent = 0; sent < per_producer;) {
+                    size_t n = std::min(batch, per_producer - sent);
+                    uint64_t stamp = now_ns();
+                    std::fill(values.begin(), values.begin() + n, stamp);
+
+                    size_t pushed = Ops::push(queue, values.data(), n);
+                    sent += pushed;
+                    if(!pushed)
+                        std::this_thread::yield();
+                }
+            });
+        }
+        for(size_t c = 0; c < pairs; c++) {
+            threads.emplace_back([&, c] {
+                std::vector<uint64_t> values(batch);
+                latencies[c].reserve(2 * per_producer);
+                while(remaining.load(std::memory_order_relaxed) > 0) {
+                    size_t popped = Ops::pop(queue, values.data(), batch);
+                    if(!popped) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    uint64_t stamp = now_ns();
+                    for(size_t i = 0; i < popped; i++)
+                        latencies[c].push_back(stamp - values[i]);
+                    remaining.fetch_sub(popped, std::memory_order_relaxed);
+                }
+            });
+        }
+        for(auto& thread : threads)
+            thread.join();
+    });
+
+    std::vector<uint64_t> all;
+    for(auto& samples : latencies)
+        all.insert(all.end(), samples.begin(), samples.end());
+    std::sort(all.begin(), all.end());
+
+    auto percentile = [&](double q) { return all.empty() ? 0.0 : all[size_t(q * (all.size() - 1))] / 1000.0; };
+
+    std::string name = std::to_string(pairs) + "P" + std::to_string(pairs) + "C";
+    benchmark::report(name, subject, ms, pairs * per_producer);
+    std::printf("%-28s %-24s p50 %9.2f us  p99 %9.2f us  p99.9 %9.2f us\n", "", "",
+                percentile(0.5), percentile(0.99), percentile(0.999));
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t per_producer = benchmark::size_arg(argc, argv, 1000000);
+    std::printf("%zu items per producer, capacity 1024, %u hardware threads\n",
+                per_producer, std::thread::hardware_concurrency());
+
+    run<locked_deque, single<locked_deque>>("mutex + std::deque", 1, per_producer, 1);
+    run<spsc_queue<uint64_t>, single<spsc_queue<uint64_t>>>("spsc_queue", 1, per_producer, 1);
+    run<spsc_queue<uint64_t>, batched<spsc_queue<uint64_t>>>("spsc_queue x32", 1, per_producer, 32);
+    run<mpmc_queue<uint64_t>, single<mpmc_queue<uint64_t>>>("mpmc_queue", 1, per_producer, 1);
+    run<mpmc_queue<uint64_t>, batched<mpmc_queue<uint64_t>>>("mpmc_queue x32", 1, per_producer, 32);
+
+    for(size_t pairs : {4, 16}) {
+        // Keep the total work roughly constant as the thread count grows
+        size_t items = per_producer / pairs;
+        run<locked_deque, single<locked_deque>>("mutex + std::deque", pairs, items, 1);
+        run<mpmc_queue<uint64_t>, single<mpmc_queue<uint64_t>>>("mpmc_queue", pairs, items, 1);
+        run<mpmc_queue<uint64_t>, batched<mpmc_queue<uint64_t>>>("mpmc_queue x32", pairs, items, 32);
+    }
+}
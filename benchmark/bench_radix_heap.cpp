@@ -0,0 +1,95 @@
+/**
+ * Benchmarks radix_heap against a binary heap (priority_queue with d = 2) and std::priority_queue on a monotone
+ *   "hold" workload: with n items pending, each operation pops the minimum and pushes it back with a random
+ *   increment, as shortest path searches and event simulations do.
+ *
+ * Usage: bench_radix_heap [largest pending count]
+ *   Runs 1M, 10M, ... pending items up to the given count (default 10M; 100M needs several GB of memory).
+ **/
+
+#include "benchmark.h"
+#include <abstracts/queue/priority_queue.h>
+#include <abstracts/queue/radix_heap.h>
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::pair<uint64_t, uint32_t> item;
+
+struct radix_adapter {
+    radix_heap<uint32_t> heap;
+
+    void push(uint64_t key, uint32_t value) { heap.push(key, value); }
+    item pop() {
+        item top(heap.top_key(), heap.top_value());
+        heap.pop();
+        return top;
+    }
+};
+
+struct binary_adapter {
+    priority_queue<item, std::less<item>, 2> heap;
+
+    void push(uint64_t key, uint32_t value) { heap.push(item(key, value)); }
+    item pop() {
+        item top = heap.top();
+        heap.pop();
+        return top;
+    }
+};
+
+struct std_adapter {
+    std::priority_queue<item, std::vector<item>, std::greater<item>> heap;
+
+    void push(uint64_t key, uint32_t value) { heap.push(item(key, value)); }
+    item pop() {
+        item top = heap.top();
+        heap.pop();
+        return top;
+    }
+};
+
+template <typename Heap>
+void run(const std::string& subject, size_t pending) {
+    std::mt19937_64 rng(4);
+    Heap heap;
+
+    double fill = benchmark::time_ms([&] {
+        for(size_t i = 0; i < pending; i++)
+            heap.push(rng() % 1000000, static_cast<uint32_t>(i));
+    });
+
+    size_t operations = pending;
+    uint64_t checksum = 0;
+    double hold = benchmark::time_ms([&] {
+        for(size_t i = 0; i < operations; i++) {
+            item top = heap.pop();
+            checksum += top.second;
+            heap.push(top.first + rng() % 1000000, top.second);
+        }
+    });
+    benchmark::do_not_optimize(checksum);
+
+    std::string size = std::to_string(pending / 1000000) + "M pending";
+    benchmark::report("fill " + size, subject, fill, pending);
+    benchmark::report("hold " + size, subject, hold, 2 * operations);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t largest = benchmark::size_arg(argc, argv, 10000000);
+
+    for(size_t pending = 1000000; pending <= largest; pending *= 10) {
+        run<radix_adapter>("radix_heap", pending);
+        run<binary_adapter>("priority_queue d=2", pending);
+        run<std_adapter>("std::priority_queue", pending);
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * Benchmarks randomized_binary_search_tree against avl_tree and std::map on random and sorted updates, and its bulk
+ *   constructor, from one thread up to one per hardware thread, against loading the same sorted keys one at a time.
+ *
+ * Usage: bench_randomized_binary_search_tree [key count] [largest thread count]
+ **/
+
+#include "benchmark.h"
+#include <trees/avl_tree.h>
+#include <trees/randomized_binary_search_tree.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef randomized_binary_search_tree<uint64_t, uint64_t> rbst;
+
+template <typename Tree>
+void updates(const std::string& name, const char *subject, const std::vector<uint64_t>& keys) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    Tree tree;
+    report(name + " insert", subject, time_ms([&] {
+        for(uint64_t key : keys)
+            tree.insert(key, key);
+    }), keys.size());
+    uint64_t sum = 0;
+    report(name + " find", subject, time_ms([&] {
+        for(uint64_t key : keys)
+            sum += tree.find(key).value();
+    }), keys.size());
+    report(name + " erase", subject, time_ms([&] {
+        for(uint64_t key : keys)
+            tree.erase(key);
+    }), keys.size());
+    benchmark::do_not_optimize(sum);
+}
+
+void map_updates(const std::string& name, const std::vector<uint64_t>& keys) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    std::map<uint64_t, uint64_t> tree;
+    report(name + " insert", "std::map", time_ms([&] {
+        for(uint64_t key : keys)
+            tree.emplace(key, key);
+    }), keys.size());
+    uint64_t sum = 0;
+    report(name + " find", "std::map", time_ms([&] {
+        for(uint64_t key : keys)
+            sum += tree.find(key)->second;
+    }), keys.size());
+    report(name + " erase", "std::map", time_ms([&] {
+        for(uint64_t key : keys)
+            tree.erase(key);
+    }), keys.size());
+    benchmark::do_not_optimize(sum);
+}
+
+}
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+    unsigned most = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                             : std::max(1u, std::thread::hardware_concurrency());
+
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> random(n), sorted(n);
+    for(size_t i = 0; i < n; i++) {
+        random[i] = rng();
+        sorted[i] = i;
+    }
+
+    updates<rbst>("random", "randomized_bst", random);
+    updates<avl_tree<uint64_t, uint64_t>>("random", "avl_tree", random);
+    map_updates("random", random);
+    updates<rbst>("sorted", "randomized_bst", sorted);
+    updates<avl_tree<uint64_t, uint64_t>>("sorted", "avl_tree", sorted);
+    map_updates("sorted", sorted);
+
+    std::vector<std::pair<uint64_t, uint64_t>> pairs(n);
+    for(size_t i = 0; i < n; i++)
+        pairs[i] = std::make_pair(sorted[i], sorted[i]);
+
+    {
+        rbst tree;
+        report("sorted load", "randomized_bst, insert", time_ms([&] {
+            for(const auto& pair : pairs)
+                tree.insert(pair.first, pair.second);
+        }), n);
+    }
+    {
+        std::map<uint64_t, uint64_t> tree;
+        report("sorted load", "std::map, hinted", time_ms([&] {
+            for(const auto& pair : pairs)
+                tree.emplace_hint(tree.end(), pair.first, pair.second);
+        }), n);
+    }
+    // Double up to the largest count, and finish on it even when it is not a power of two
+    for(unsigned threads = 1; threads <= most; threads = threads == most ? most + 1 : std::min(2 * threads, most)) {
+        // Destroying the tree is not timed
+        rbst tree;
+        report("sorted load", "bulk, " + std::to_string(threads) + (threads == 1 ? " thread" : " threads"),
+               time_ms([&] {
+                   tree = rbst(pairs.begin(), pairs.end(), threads);
+               }), n);
+        benchmark::do_not_optimize(tree.size());
+    }
+}
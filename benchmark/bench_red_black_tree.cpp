@@ -0,0 +1,85 @@
+/**
+ * Benchmarks the parallel set algebra of red_black_tree, from one thread up to one per hardware thread, with
+ *   std::set_union and friends over two std::sets for reference.
+ *
+ * Both sets hold `n` random keys drawn from [0, 4n), so they overlap by about a quarter. Building the operand copies
+ *   is not timed.
+ *
+ * Usage: bench_red_black_tree [set size] [largest thread count]
+ **/
+
+#include "benchmark.h"
+#include <trees/red_black_tree.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+    unsigned most = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10))
+                             : std::max(1u, std::thread::hardware_concurrency());
+
+    std::mt19937_64 rng(1);
+    red_black_tree<uint64_t> a, b;
+    std::set<uint64_t> first, second;
+    for(size_t i = 0; i < n; i++) {
+        uint64_t key = rng() % (4 * n);
+        a.insert(key);
+        first.insert(key);
+        key = rng() % (4 * n);
+        b.insert(key);
+        second.insert(key);
+    }
+
+    // Double up to the largest count, and finish on it even when it is not a power of two
+    for(unsigned threads = 1; threads <= most; threads = threads == most ? most + 1 : std::min(2 * threads, most)) {
+        std::string label = std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+        size_t result = 0;
+
+        red_black_tree<uint64_t> target(a), operand(b);
+        report("union", "red_black_tree, " + label, time_ms([&] {
+            target.unite(std::move(operand), threads);
+        }), 2 * n);
+        result += target.size();
+
+        target = a;
+        operand = b;
+        report("intersection", "red_black_tree, " + label, time_ms([&] {
+            target.intersect(std::move(operand), threads);
+        }), 2 * n);
+        result += target.size();
+
+        target = a;
+        operand = b;
+        report("difference", "red_black_tree, " + label, time_ms([&] {
+            target.subtract(std::move(operand), threads);
+        }), 2 * n);
+        result += target.size();
+        benchmark::do_not_optimize(result);
+    }
+
+    std::set<uint64_t> out;
+    report("union", "std::set", time_ms([&] {
+        std::set_union(first.begin(), first.end(), second.begin(), second.end(), std::inserter(out, out.end()));
+    }), 2 * n);
+    out.clear();
+    report("intersection", "std::set", time_ms([&] {
+        std::set_intersection(first.begin(), first.end(), second.begin(), second.end(),
+                              std::inserter(out, out.end()));
+    }), 2 * n);
+    out.clear();
+    report("difference", "std::set", time_ms([&] {
+        std::set_difference(first.begin(), first.end(), second.begin(), second.end(), std::inserter(out, out.end()));
+    }), 2 * n);
+    benchmark::do_not_optimize(out.size());
+}
@@ -0,0 +1,120 @@
+/**
+ * Benchmarks the Roaring bitmap integer sets against std::unordered_set<uint32_t> on memory use and set algebra.
+ *
+ * Usage: bench_roaring_bitmap [element count]
+ **/
+
+#include "benchmark.h"
+#include <abstracts/set/hash_set.h>
+
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+size_t allocated_bytes = 0;
+
+// Counts every byte handed out so the real footprint of std::unordered_set (nodes plus buckets) can be reported
+template <typename T>
+struct counting_allocator {
+    typedef T value_type;
+
+    counting_allocator() = default;
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T *allocate(size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, size_t n) {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const counting_allocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const counting_allocator<U>&) const { return false; }
+};
+
+typedef std::unordered_set<uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>, counting_allocator<uint32_t>>
+        counted_set;
+
+std::vector<uint32_t> make_ids(size_t n, uint32_t universe, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> ids(n);
+    for(uint32_t& id : ids)
+        id = universe ? rng() % universe : rng();
+    return ids;
+}
+
+void run(const char *label, size_t n, uint32_t universe) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    std::printf("-- %s: %zu ids --\n", label, n);
+
+    std::vector<uint32_t> ids_a = make_ids(n, universe, 1), ids_b = make_ids(n, universe, 2);
+
+    hash_set<uint32_t> a, b;
+    report("build", "hash_set<uint32_t>", time_ms([&] {
+        a.insert_many(ids_a.data(), ids_a.size());
+        b.insert_many(ids_b.data(), ids_b.size());
+    }), 2 * n);
+    a.run_optimize();
+    b.run_optimize();
+
+    allocated_bytes = 0;
+    counted_set ua, ub;
+    report("build", "std::unordered_set", time_ms([&] {
+        ua.insert(ids_a.begin(), ids_a.end());
+        ub.insert(ids_b.begin(), ids_b.end());
+    }), 2 * n);
+    size_t unordered_bytes = allocated_bytes / 2;
+
+    std::printf("%-28s %-24s %10.2f bytes/id\n", "memory", "hash_set<uint32_t>",
+                double(a.memory_usage()) / a.cardinality());
+    std::printf("%-28s %-24s %10.2f bytes/id\n", "memory", "std::unordered_set",
+                double(unordered_bytes) / ua.size());
+
+    uint64_t total = 0;
+    report("union", "hash_set<uint32_t>", time_ms([&] { total += (a | b).cardinality(); }), 2 * n);
+    report("intersection", "hash_set<uint32_t>", time_ms([&] { total += (a & b).cardinality(); }), 2 * n);
+    report("difference", "hash_set<uint32_t>", time_ms([&] { total += (a - b).cardinality(); }), 2 * n);
+
+    report("union", "std::unordered_set", time_ms([&] {
+        counted_set out(ua);
+        out.insert(ub.begin(), ub.end());
+        total += out.size();
+    }), 2 * n);
+    report("intersection", "std::unordered_set", time_ms([&] {
+        counted_set out;
+        for(uint32_t id : ua)
+            if(ub.count(id))
+                out.insert(id);
+        total += out.size();
+    }), 2 * n);
+    report("difference", "std::unordered_set", time_ms([&] {
+        counted_set out;
+        for(uint32_t id : ua)
+            if(!ub.count(id))
+                out.insert(id);
+        total += out.size();
+    }), 2 * n);
+
+    benchmark::do_not_optimize(total);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+
+    run("sparse (full 32-bit range)", n, 0);
+    run("clustered (8x the count)", n, static_cast<uint32_t>(8 * n));
+    run("dense (1.5x the count)", n, static_cast<uint32_t>(3 * n / 2));
+    return 0;
+}
@@ -0,0 +1,163 @@
+/**
+ * Replays access traces through each self_organizing_list policy and reports the comparisons made per access, the
+ *   measure the analysis of self-organizing lists is stated in, along with the running time.
+ *
+ * The traces are independent draws from a Zipf and a uniform distribution, a small working set that moves
+ *   periodically, and two adversaries: one that always asks for the current last element, and one that alternates
+ *   between the two elements that start out last. For the independent traces, the cost of the best static order
+ *   (elements sorted by their frequency in the trace) is reported as a reference.
+ *
+ * Usage: bench_self_organizing_list [access count] [element count]
+ **/
+
+#include "benchmark.h"
+#include <linear/lists/self_organizing_list.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::vector<uint32_t> trace;
+
+void print(const std::string& name, const std::string& policy, double per_access, double ms, size_t accesses) {
+    std::printf("%-24s %-16s %10.2f cmp/access %10.2f ms %8.2f ns/access\n",
+                name.c_str(), policy.c_str(), per_access, ms, ms * 1e6 / accesses);
+}
+
+/**
+ * Draws from a Zipf distribution over the elements: the element of popularity rank r (from 1) has weight 1 / r^s.
+ *   Ranks are assigned to elements at random, so popular elements do not start at the front.
+ */
+trace zipf(size_t n, size_t accesses, double s, std::mt19937_64& rng) {
+    std::vector<double> cumulative(n);
+    double total = 0;
+    for(size_t rank = 0; rank < n; rank++) {
+        total += 1.0 / std::pow(rank + 1.0, s);
+        cumulative[rank] = total;
+    }
+
+    std::vector<uint32_t> element(n);
+    for(uint32_t i = 0; i < n; i++)
+        element[i] = i;
+    std::shuffle(element.begin(), element.end(), rng);
+
+    std::uniform_real_distribution<double> uniform(0, total);
+    trace accesses_made(accesses);
+    for(auto& access : accesses_made) {
+        size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(rng)) - cumulative.begin();
+        access = element[std::min(rank, n - 1)];
+    }
+    return accesses_made;
+}
+
+trace uniform(size_t n, size_t accesses, std::mt19937_64& rng) {
+    trace accesses_made(accesses);
+    for(auto& access : accesses_made)
+        access = static_cast<uint32_t>(rng() % n);
+    return accesses_made;
+}
+
+/**
+ * Uniform accesses within a working set of `width` elements, which jumps to a new random place every `period`
+ *   accesses.
+ */
+trace shifting(size_t n, size_t accesses, size_t width, size_t period, std::mt19937_64& rng) {
+    trace accesses_made(accesses);
+    size_t start = 0;
+    for(size_t i = 0; i < accesses; i++) {
+        if(i % period == 0)
+            start = rng() % (n - width);
+        accesses_made[i] = static_cast<uint32_t>(start + rng() % width);
+    }
+    return accesses_made;
+}
+
+trace alternating(size_t n, size_t accesses) {
+    trace accesses_made(accesses);
+    for(size_t i = 0; i < accesses; i++)
+        accesses_made[i] = static_cast<uint32_t>(n - 1 - i % 2);
+    return accesses_made;
+}
+
+/**
+ * @return the comparisons per access of the best fixed order for `accesses`
+ */
+double static_optimum(size_t n, const trace& accesses) {
+    std::vector<uint64_t> frequency(n, 0);
+    for(uint32_t access : accesses)
+        frequency[access]++;
+    std::sort(frequency.begin(), frequency.end(), std::greater<uint64_t>());
+
+    double total = 0;
+    for(size_t rank = 0; rank < n; rank++)
+        total += double(frequency[rank]) * (rank + 1);
+    return total / accesses.size();
+}
+
+template <typename Policy>
+void replay(const std::string& name, const std::string& policy, size_t n, const trace& accesses) {
+    self_organizing_list<uint32_t, Policy> list;
+    for(uint32_t i = 0; i < n; i++)
+        list.insert(i);
+
+    size_t found = 0;
+    double ms = benchmark::time_ms([&] {
+        for(uint32_t access : accesses)
+            found += list.contains(access);
+    });
+    benchmark::do_not_optimize(found);
+    print(name, policy, double(list.comparisons()) / accesses.size(), ms, accesses.size());
+}
+
+/**
+ * The online adversary: every access asks for whatever is currently last.
+ */
+template <typename Policy>
+void replay_last(const std::string& policy, size_t n, size_t accesses) {
+    self_organizing_list<uint32_t, Policy> list;
+    for(uint32_t i = 0; i < n; i++)
+        list.insert(i);
+
+    size_t found = 0;
+    double ms = benchmark::time_ms([&] {
+        for(size_t i = 0; i < accesses; i++)
+            found += list.contains(list.back());
+    });
+    benchmark::do_not_optimize(found);
+    print("always the last element", policy, double(list.comparisons()) / accesses, ms, accesses);
+}
+
+void replay_all(const std::string& name, size_t n, const trace& accesses, bool independent) {
+    if(independent)
+        std::printf("%-24s %-16s %10.2f cmp/access\n", name.c_str(), "static optimum", static_optimum(n, accesses));
+    replay<self_organizing::none>(name, "none", n, accesses);
+    replay<self_organizing::move_to_front>(name, "move_to_front", n, accesses);
+    replay<self_organizing::transpose>(name, "transpose", n, accesses);
+    replay<self_organizing::count>(name, "count", n, accesses);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t accesses = benchmark::size_arg(argc, argv, 1000000);
+    size_t n = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+    std::printf("%zu elements, %zu accesses\n", n, accesses);
+    std::mt19937_64 rng(42);
+
+    replay_all("zipf s=1", n, zipf(n, accesses, 1.0, rng), true);
+    replay_all("zipf s=1.5", n, zipf(n, accesses, 1.5, rng), true);
+    replay_all("uniform", n, uniform(n, accesses, rng), true);
+    replay_all("shifting working set", n, shifting(n, accesses, 20, 10000, rng), false);
+    replay_all("alternating last two", n, alternating(n, accesses), false);
+
+    replay_last<self_organizing::none>("none", n, accesses);
+    replay_last<self_organizing::move_to_front>("move_to_front", n, accesses);
+    replay_last<self_organizing::transpose>("transpose", n, accesses);
+    replay_last<self_organizing::count>("count", n, accesses);
+}
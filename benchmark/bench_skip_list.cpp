@@ -0,0 +1,137 @@
+/**
+ * Benchmarks skip_list against a mutex protected std::map: concurrent inserts, concurrent lookups, and writers
+ *   inserting while readers scan short ranges.
+ *
+ * Usage: bench_skip_list [key count]
+ **/
+
+#include "benchmark.h"
+#include <linear/lists/skip_list.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Spreads sequential indices over the key space (the splitmix64 finalizer)
+uint64_t scramble(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+class locked_map {
+public:
+    bool insert(uint64_t key, uint64_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.insert({key, value}).second;
+    }
+
+    bool find(uint64_t key, uint64_t& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = items.find(key);
+        if(it == items.end())
+            return false;
+        out = it->second;
+        return true;
+    }
+
+    uint64_t scan(uint64_t from, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t sum = 0;
+        for(auto it = items.lower_bound(from); it != items.end() && count > 0; ++it, count--)
+            sum += it->second;
+        return sum;
+    }
+
+private:
+    std::mutex mutex;
+    std::map<uint64_t, uint64_t> items;
+};
+
+class lock_free_map {
+public:
+    bool insert(uint64_t key, uint64_t value) { return items.insert(key, value); }
+    bool find(uint64_t key, uint64_t& out) { return items.find(key, out); }
+
+    uint64_t scan(uint64_t from, size_t count) {
+        uint64_t sum = 0;
+        for(auto it = items.lower_bound(from); it != items.end() && count > 0; ++it, count--)
+            sum += it->second;
+        return sum;
+    }
+
+private:
+    skip_list<uint64_t, uint64_t> items;
+};
+
+template <typename F>
+double in_parallel(size_t threads, F&& work) {
+    return benchmark::time_ms([&] {
+        std::vector<std::thread> workers;
+        for(size_t t = 0; t < threads; t++)
+            workers.emplace_back(work, t);
+        for(auto& worker : workers)
+            worker.join();
+    });
+}
+
+template <typename Map>
+void run(const std::string& subject, size_t n, size_t threads) {
+    Map map;
+    std::string suffix = " x" + std::to_string(threads);
+
+    benchmark::report("insert" + suffix, subject, in_parallel(threads, [&](size_t t) {
+        for(size_t i = t; i < n; i += threads)
+            map.insert(scramble(i), i);
+    }), n);
+
+    std::atomic<size_t> found(0);
+    benchmark::report("lookup" + suffix, subject, in_parallel(threads, [&](size_t t) {
+        size_t mine = 0;
+        uint64_t value;
+        for(size_t i = t; i < n; i += threads)
+            mine += map.find(scramble(i), value);
+        found += mine;
+    }), n);
+    benchmark::do_not_optimize(found.load());
+
+    // Half the threads insert fresh keys, the other half scan 100 keys at a time
+    size_t writers = threads > 1 ? threads / 2 : 1;
+    std::atomic<size_t> writing(writers);
+    std::atomic<size_t> scans(0);
+    double ms = in_parallel(threads > 1 ? threads : 2, [&](size_t t) {
+        if(t < writers) {
+            for(size_t i = n + t; i < 2 * n; i += writers)
+                map.insert(scramble(i), i);
+            writing--;
+        } else {
+            size_t mine = 0;
+            uint64_t sum = 0;
+            for(uint64_t i = t; writing.load(std::memory_order_relaxed) > 0; i++, mine++)
+                sum += map.scan(scramble(i), 100);
+            benchmark::do_not_optimize(sum);
+            scans += mine;
+        }
+    });
+    benchmark::report("insert while scanning" + suffix, subject, ms, n);
+    std::printf("%-28s %-24s %zu scans of 100 keys\n", "", "", scans.load());
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+    std::printf("%zu keys, %u hardware threads\n", n, std::thread::hardware_concurrency());
+
+    for(size_t threads : {1, 2, 4, 8}) {
+        run<locked_map>("mutex + std::map", n, threads);
+        run<lock_free_map>("skip_list", n, threads);
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ * Benchmarks splay_tree lookups, in each splaying mode, against avl_tree and std::map on traces with and without
+ *   temporal locality.
+ *
+ * The working-set traces draw uniformly from a small set of keys that is replaced by a fresh random one every so
+ *   often; the Zipf trace draws popular keys far more often than others; the uniform trace has no locality at all and
+ *   is where splaying costs the most.
+ *
+ * Usage: bench_splay_tree [key count]
+ **/
+
+#include "benchmark.h"
+#include <trees/avl_tree.h>
+#include <trees/splay_tree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t ACCESSES = 4000000;
+
+typedef splay_tree<uint64_t, uint64_t> splay;
+
+std::vector<uint64_t> working_set_trace(const std::vector<uint64_t>& keys, size_t working_set, size_t lifetime,
+                                        std::mt19937_64& rng) {
+    std::vector<uint64_t> trace(ACCESSES), current(working_set);
+    for(size_t i = 0; i < ACCESSES; i++) {
+        if(i % lifetime == 0)
+            for(uint64_t& key : current)
+                key = keys[rng() % keys.size()];
+        trace[i] = current[rng() % working_set];
+    }
+    return trace;
+}
+
+std::vector<uint64_t> zipf_trace(const std::vector<uint64_t>& keys, double skew, std::mt19937_64& rng) {
+    std::vector<double> cdf(keys.size());
+    double sum = 0;
+    for(size_t i = 0; i < keys.size(); i++)
+        cdf[i] = sum += 1.0 / std::pow(double(i + 1), skew);
+
+    std::uniform_real_distribution<double> uniform(0, sum);
+    std::vector<uint64_t> trace(ACCESSES);
+    for(uint64_t& key : trace)
+        key = keys[std::min<size_t>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin(),
+                                    keys.size() - 1)];
+    return trace;
+}
+
+void replay(const std::string& name, const std::vector<uint64_t>& keys, const std::vector<uint64_t>& trace) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    struct variant {
+        const char *subject;
+        splay::mode splaying;
+        unsigned period;
+    };
+    for(const variant& v : {variant{"splay_tree", splay::mode::full, 1},
+                            variant{"splay_tree (semi)", splay::mode::semi, 1},
+                            variant{"splay_tree (every 4th)", splay::mode::full, 4},
+                            variant{"splay_tree (semi, 4th)", splay::mode::semi, 4}}) {
+        splay tree(v.splaying, v.period);
+        for(uint64_t key : keys)
+            tree.insert(key, key);
+        uint64_t sum = 0;
+        report(name, v.subject, time_ms([&] {
+            for(uint64_t key : trace)
+                sum += tree.find(key).value();
+        }), trace.size());
+        benchmark::do_not_optimize(sum);
+    }
+
+    {
+        avl_tree<uint64_t, uint64_t> tree;
+        for(uint64_t key : keys)
+            tree.insert(key, key);
+        uint64_t sum = 0;
+        report(name, "avl_tree", time_ms([&] {
+            for(uint64_t key : trace)
+                sum += tree.find(key).value();
+        }), trace.size());
+        benchmark::do_not_optimize(sum);
+    }
+    {
+        std::map<uint64_t, uint64_t> tree;
+        for(uint64_t key : keys)
+            tree.emplace(key, key);
+        uint64_t sum = 0;
+        report(name, "std::map", time_ms([&] {
+            for(uint64_t key : trace)
+                sum += tree.find(key)->second;
+        }), trace.size());
+        benchmark::do_not_optimize(sum);
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> keys(n);
+    for(uint64_t& key : keys)
+        key = rng();
+
+    replay("working set 64", keys, working_set_trace(keys, 64, 100000, rng));
+    replay("working set 4096", keys, working_set_trace(keys, 4096, 500000, rng));
+    replay("zipf s=1.2", keys, zipf_trace(keys, 1.2, rng));
+
+    std::vector<uint64_t> uniform(ACCESSES);
+    for(uint64_t& key : uniform)
+        key = keys[rng() % n];
+    replay("uniform", keys, uniform);
+}
@@ -0,0 +1,99 @@
+/**
+ * Benchmarks timer_wheel against a binary heap with handles (priority_queue with d = 2) on a timeout workload.
+ *
+ * Usage: bench_timer_wheel [largest pending count]
+ *   Runs 1M, 10M, ... pending timers up to the given count (default 10M). Every tick, as many timers as are due are
+ *   replaced, and one random pending timer is cancelled and rescheduled, as a connection's idle timeout is pushed
+ *   back when traffic arrives.
+ **/
+
+#include "benchmark.h"
+#include <abstracts/queue/priority_queue.h>
+#include <abstracts/queue/timer_wheel.h>
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Deadlines are spread over this many ticks ahead of the clock
+const uint64_t HORIZON = 1 << 20;
+
+struct wheel_adapter {
+    typedef timer_wheel<uint32_t>::timer_id id;
+    timer_wheel<uint32_t> wheel;
+
+    id schedule(uint64_t deadline, uint32_t owner) { return wheel.schedule(deadline, owner); }
+    void cancel(id timer) { wheel.cancel(timer); }
+    template <typename F>
+    void advance(uint64_t to, F&& expire) {
+        wheel.advance(to, [&](uint64_t, uint32_t owner) { expire(owner); });
+    }
+};
+
+struct heap_adapter {
+    typedef std::pair<uint64_t, uint32_t> entry;
+    typedef priority_queue<entry, std::less<entry>, 2>::handle id;
+    priority_queue<entry, std::less<entry>, 2> heap;
+    uint64_t now = 0;
+
+    id schedule(uint64_t deadline, uint32_t owner) { return heap.push(entry(deadline, owner)); }
+    void cancel(id timer) { heap.erase(timer); }
+    template <typename F>
+    void advance(uint64_t to, F&& expire) {
+        while(!heap.empty() && heap.top().first <= to) {
+            uint32_t owner = heap.top().second;
+            heap.pop();
+            expire(owner);
+        }
+        now = to;
+    }
+};
+
+template <typename Timers>
+void run(const std::string& subject, size_t pending) {
+    std::mt19937_64 rng(6);
+    Timers timers;
+    // One timer per owner; the owner's slot holds its current timer id
+    std::vector<typename Timers::id> ids(pending);
+
+    double fill = benchmark::time_ms([&] {
+        for(uint32_t owner = 0; owner < pending; owner++)
+            ids[owner] = timers.schedule(1 + rng() % HORIZON, owner);
+    });
+
+    size_t ticks = HORIZON / 4, fired = 0;
+    uint64_t now = 0;
+    double run_ms = benchmark::time_ms([&] {
+        for(size_t tick = 0; tick < ticks; tick++) {
+            now++;
+            timers.advance(now, [&](uint32_t owner) {
+                fired++;
+                ids[owner] = timers.schedule(now + 1 + rng() % HORIZON, owner);
+            });
+
+            uint32_t owner = static_cast<uint32_t>(rng() % pending);
+            timers.cancel(ids[owner]);
+            ids[owner] = timers.schedule(now + 1 + rng() % HORIZON, owner);
+        }
+    });
+
+    std::string size = std::to_string(pending / 1000000) + "M pending";
+    benchmark::report("schedule " + size, subject, fill, pending);
+    benchmark::report("expire + reset " + size, subject, run_ms, 2 * (fired + ticks));
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t largest = benchmark::size_arg(argc, argv, 10000000);
+
+    for(size_t pending = 1000000; pending <= largest; pending *= 10) {
+        run<wheel_adapter>("timer_wheel", pending);
+        run<heap_adapter>("priority_queue d=2", pending);
+    }
+}
@@ -0,0 +1,126 @@
+/**
+ * Benchmarks treap against std::vector on sequence editing and range operations.
+ *
+ * Every operation picks its positions uniformly at random. std::vector does the range operations with plain loops;
+ *   those subjects that are O(n) per operation replay fewer of them.
+ *
+ * Usage: bench_treap [sequence length]
+ **/
+
+#include "benchmark.h"
+#include <trees/treap.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+const size_t OPERATIONS = 200000;
+
+struct range {
+    size_t first, last;
+};
+
+std::vector<range> ranges(size_t length, size_t count, std::mt19937_64& rng) {
+    std::vector<range> out(count);
+    for(range& r : out) {
+        size_t a = rng() % (length + 1), b = rng() % (length + 1);
+        r = range{std::min(a, b), std::max(a, b)};
+    }
+    return out;
+}
+
+}
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+    std::mt19937_64 rng(1);
+
+    std::vector<int64_t> values(n);
+    std::iota(values.begin(), values.end(), 0);
+    std::vector<size_t> positions(OPERATIONS);
+    for(size_t i = 0; i < OPERATIONS; i++)
+        positions[i] = rng() % (n + i + 1);
+    // The vector has to shift half its elements per edit
+    size_t vector_operations = std::max<size_t>(100, std::min<size_t>(OPERATIONS, 20000000000ull / (n + 1)));
+
+    treap<int64_t> sequence;
+    report("build", "treap", time_ms([&] {
+        sequence = treap<int64_t>(values.begin(), values.end());
+    }), n);
+
+    report("random insert", "treap", time_ms([&] {
+        for(size_t i = 0; i < OPERATIONS; i++)
+            sequence.insert(positions[i], static_cast<int64_t>(i));
+    }), OPERATIONS);
+    std::vector<int64_t> vector(values);
+    report("random insert", "std::vector", time_ms([&] {
+        for(size_t i = 0; i < vector_operations; i++)
+            vector.insert(vector.begin() + std::min(positions[i], vector.size()), static_cast<int64_t>(i));
+    }), vector_operations);
+
+    report("random erase", "treap", time_ms([&] {
+        for(size_t i = 0; i < OPERATIONS; i++)
+            sequence.erase(positions[i] % sequence.size());
+    }), OPERATIONS);
+    report("random erase", "std::vector", time_ms([&] {
+        for(size_t i = 0; i < vector_operations; i++)
+            vector.erase(vector.begin() + positions[i] % vector.size());
+    }), vector_operations);
+
+    // Range operations over ranges of n / 3 elements on average
+    std::vector<range> spans = ranges(n, OPERATIONS, rng);
+    size_t vector_ranges = std::max<size_t>(100, std::min<size_t>(OPERATIONS, 2000000000ull / (n + 1)));
+    int64_t total = 0;
+
+    report("range reverse", "treap", time_ms([&] {
+        for(const range& r : spans)
+            sequence.reverse(r.first, r.last);
+    }), spans.size());
+    report("range reverse", "std::vector", time_ms([&] {
+        for(size_t i = 0; i < vector_ranges; i++)
+            std::reverse(vector.begin() + spans[i].first, vector.begin() + spans[i].last);
+    }), vector_ranges);
+
+    report("range add", "treap", time_ms([&] {
+        for(const range& r : spans)
+            sequence.add(r.first, r.last, 3);
+    }), spans.size());
+    report("range add", "std::vector", time_ms([&] {
+        for(size_t i = 0; i < vector_ranges; i++)
+            for(size_t j = spans[i].first; j < spans[i].last; j++)
+                vector[j] += 3;
+    }), vector_ranges);
+
+    report("range sum", "treap", time_ms([&] {
+        for(const range& r : spans)
+            total += sequence.sum(r.first, r.last);
+    }), spans.size());
+    report("range sum", "std::vector", time_ms([&] {
+        for(size_t i = 0; i < vector_ranges; i++)
+            total += std::accumulate(vector.begin() + spans[i].first, vector.begin() + spans[i].last, int64_t(0));
+    }), vector_ranges);
+
+    report("range min", "treap", time_ms([&] {
+        for(const range& r : spans)
+            if(r.first < r.last)
+                total += sequence.min(r.first, r.last);
+    }), spans.size());
+
+    size_t reads = std::min<size_t>(OPERATIONS, n);
+    report("random access", "treap", time_ms([&] {
+        for(size_t i = 0; i < reads; i++)
+            total += sequence[positions[i] % n];
+    }), reads);
+    report("random access", "std::vector", time_ms([&] {
+        for(size_t i = 0; i < reads; i++)
+            total += vector[positions[i] % n];
+    }), reads);
+    benchmark::do_not_optimize(total);
+}
@@ -0,0 +1,76 @@
+/**
+ * Benchmarks tree_map (B+tree) against std::map.
+ *
+ * Usage: bench_tree_map [element count]
+ **/
+
+#include "benchmark.h"
+#include <abstracts/map/tree_map.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+int main(int argc, char **argv) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+
+    std::vector<int> lookups(n);
+    std::mt19937 rng(1);
+    for(int& key : lookups)
+        key = static_cast<int>(rng() % n);
+
+    std::vector<std::pair<int, int>> sorted;
+    sorted.reserve(n);
+    for(size_t i = 0; i < n; i++)
+        sorted.emplace_back(static_cast<int>(i), static_cast<int>(i));
+
+    tree_map<int, int> btree;
+    std::map<int, int> rbtree;
+
+    report("ordered insert", "tree_map", time_ms([&] {
+        for(auto& kv : sorted)
+            btree.insert(kv.first, kv.second);
+    }), n);
+    report("ordered insert", "std::map", time_ms([&] {
+        for(auto& kv : sorted)
+            rbtree.emplace_hint(rbtree.end(), kv.first, kv.second);
+    }), n);
+
+    tree_map<int, int> loaded;
+    report("bulk load", "tree_map", time_ms([&] {
+        loaded.bulk_load(sorted.begin(), sorted.end());
+    }), n);
+
+    long long sum = 0;
+    report("random lookup", "tree_map", time_ms([&] {
+        for(int key : lookups)
+            sum += btree.find(key).value();
+    }), n);
+    report("random lookup", "std::map", time_ms([&] {
+        for(int key : lookups)
+            sum += rbtree.find(key)->second;
+    }), n);
+
+    size_t scans = std::max<size_t>(n / 100, 1), width = 100;
+    report("range scan (100 keys)", "tree_map", time_ms([&] {
+        for(size_t i = 0; i < scans; i++) {
+            auto it = btree.lower_bound(lookups[i]);
+            for(size_t j = 0; j < width && it != btree.end(); j++, ++it)
+                sum += it.value();
+        }
+    }), scans * width);
+    report("range scan (100 keys)", "std::map", time_ms([&] {
+        for(size_t i = 0; i < scans; i++) {
+            auto it = rbtree.lower_bound(lookups[i]);
+            for(size_t j = 0; j < width && it != rbtree.end(); j++, ++it)
+                sum += it->second;
+        }
+    }), scans * width);
+
+    benchmark::do_not_optimize(sum);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * Benchmarks unrolled_list against std::list and std::vector: iteration, inserting in the middle and searching.
+ *
+ * Usage: bench_unrolled_list [element count]
+ **/
+
+#include "benchmark.h"
+#include <linear/lists/unrolled_list.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Elements examined by the 20 searches below, which look for n - n / i for i = 1 .. 20
+size_t scanned(size_t n) {
+    size_t total = 0;
+    for(size_t i = 1; i <= 20; i++)
+        total += n - n / i + 1;
+    return total;
+}
+
+// Positions an insertion in each container: vectors index directly, lists walk, unrolled lists skip whole nodes
+template <typename T>
+typename std::vector<T>::iterator position(std::vector<T>& items, size_t index) { return items.begin() + index; }
+
+template <typename T>
+typename std::list<T>::iterator position(std::list<T>& items, size_t index) {
+    return std::next(items.begin(), index);
+}
+
+template <typename T, size_t B>
+typename unrolled_list<T, B>::iterator position(unrolled_list<T, B>& items, size_t index) {
+    return items.nth(index);
+}
+
+template <typename List>
+void run(const std::string& subject, size_t n) {
+    using benchmark::report;
+    using benchmark::time_ms;
+
+    List items;
+    report("push_back", subject, time_ms([&] {
+        for(size_t i = 0; i < n; i++)
+            items.push_back(static_cast<uint32_t>(i));
+    }), n);
+
+    uint64_t sum = 0;
+    report("iterate x10", subject, time_ms([&] {
+        for(int pass = 0; pass < 10; pass++)
+            for(uint32_t value : items)
+                sum += value;
+    }), 10 * n);
+    benchmark::do_not_optimize(sum);
+
+    size_t found = 0;
+    report("find x20", subject, time_ms([&] {
+        for(size_t i = 1; i <= 20; i++)
+            found += std::find(items.begin(), items.end(), static_cast<uint32_t>(n - n / i)) != items.end();
+    }), scanned(n));
+    benchmark::do_not_optimize(found);
+
+    // Insert at a fixed position held by an iterator: the linked list's best case
+    auto middle = position(items, items.size() / 2);
+    report("insert at iterator", subject, time_ms([&] {
+        for(size_t i = 0; i < n / 100; i++)
+            middle = items.insert(middle, static_cast<uint32_t>(i));
+    }), n / 100);
+
+    // Insert at the middle index, which has to be found first
+    size_t inserts = std::max<size_t>(n / 1000, 1);
+    report("insert at middle index", subject, time_ms([&] {
+        for(size_t i = 0; i < inserts; i++)
+            items.insert(position(items, items.size() / 2), static_cast<uint32_t>(i));
+    }), inserts);
+}
+
+/**
+ * unrolled_list::find compares several elements per instruction, std::find over it goes one at a time.
+ */
+template <size_t B>
+void run_member_find(size_t n) {
+    unrolled_list<uint32_t, B> items;
+    for(size_t i = 0; i < n; i++)
+        items.push_back(static_cast<uint32_t>(i));
+
+    size_t found = 0;
+    benchmark::report("find x20 (member)", "unrolled_list<" + std::to_string(B) + ">", benchmark::time_ms([&] {
+        for(size_t i = 1; i <= 20; i++)
+            found += items.find(static_cast<uint32_t>(n - n / i)) != items.end();
+    }), scanned(n));
+    benchmark::do_not_optimize(found);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+    std::printf("%zu elements of uint32_t\n", n);
+
+    run<std::vector<uint32_t>>("std::vector", n);
+    run<std::list<uint32_t>>("std::list", n);
+    run<unrolled_list<uint32_t, 64>>("unrolled_list<64>", n);
+    run<unrolled_list<uint32_t, 128>>("unrolled_list<128>", n);
+    run<unrolled_list<uint32_t, 256>>("unrolled_list<256>", n);
+
+    run_member_find<64>(n);
+    run_member_find<128>(n);
+    run_member_find<256>(n);
+}
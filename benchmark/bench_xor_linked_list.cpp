@@ -0,0 +1,126 @@
+/**
+ * Reports the memory per element and the traversal speed of xor_linked_list, doubly_linked_list and std::list, on a
+ *   freshly built list and on one churned by random erasures and insertions, and for xor_linked_list after compact().
+ *
+ * Usage: bench_xor_linked_list [element count]
+ **/
+
+#include "benchmark.h"
+#include <linear/lists/doubly_linked_list.h>
+#include <linear/lists/xor_linked_list.h>
+
+#include <cstdint>
+#include <list>
+#include <random>
+#include <string>
+
+namespace {
+
+size_t allocated_bytes = 0;
+
+/**
+ * Counts the bytes std::list asks for. malloc adds its own header and rounding on top.
+ */
+template <typename T>
+struct counting_allocator {
+    typedef T value_type;
+
+    counting_allocator() = default;
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T *allocate(size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, size_t n) {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const counting_allocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const counting_allocator<U>&) const { return false; }
+};
+
+typedef std::list<uint32_t, counting_allocator<uint32_t>> std_list;
+
+// The layout of a doubly_linked_list node; its pool hands them out without any per-node header
+struct pooled_node {
+    doubly_linked_list_hook hook;
+    uint32_t value;
+};
+
+double bytes_per_element(std_list& list) { return double(allocated_bytes) / list.size(); }
+double bytes_per_element(doubly_linked_list<uint32_t>&) { return sizeof(pooled_node); }
+double bytes_per_element(xor_linked_list<uint32_t>& list) { return double(list.memory_bytes()) / list.size(); }
+
+template <typename List>
+void traverse(const std::string& name, const std::string& subject, List& list) {
+    uint64_t sum = 0;
+    double ms = benchmark::time_ms([&] {
+        for(int pass = 0; pass < 10; pass++)
+            for(uint32_t value : list)
+                sum += value;
+    });
+    benchmark::do_not_optimize(sum);
+    benchmark::report(name, subject, ms, 10 * list.size());
+}
+
+/**
+ * Erases about half of the elements at random, then appends as many: the appended nodes land wherever the freed
+ *   ones were.
+ */
+template <typename List>
+void churn(List& list, std::mt19937_64& rng) {
+    for(int round = 0; round < 3; round++) {
+        size_t erased = 0;
+        for(auto it = list.begin(); it != list.end();) {
+            if(rng() % 2) {
+                it = list.erase(it);
+                erased++;
+            } else {
+                ++it;
+            }
+        }
+        for(size_t i = 0; i < erased; i++)
+            list.push_back(static_cast<uint32_t>(rng()));
+    }
+}
+
+template <typename List>
+void run(const std::string& subject, size_t n) {
+    List list;
+    benchmark::report("push_back", subject, benchmark::time_ms([&] {
+        for(size_t i = 0; i < n; i++)
+            list.push_back(static_cast<uint32_t>(i));
+    }), n);
+    std::printf("%-28s %-24s %.2f bytes per element\n", "", "", bytes_per_element(list));
+
+    traverse("traverse x10, fresh", subject, list);
+    std::mt19937_64 rng(4);
+    churn(list, rng);
+    traverse("traverse x10, churned", subject, list);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t n = benchmark::size_arg(argc, argv, 1000000);
+    std::printf("%zu uint32_t elements\n", n);
+
+    // std::list goes last: the million small blocks it frees make malloc slow to serve the pools' larger requests
+    run<xor_linked_list<uint32_t>>("xor_linked_list", n);
+    run<doubly_linked_list<uint32_t>>("doubly_linked_list", n);
+    run<std_list>("std::list", n);
+
+    xor_linked_list<uint32_t> list;
+    for(size_t i = 0; i < n; i++)
+        list.push_back(static_cast<uint32_t>(i));
+    std::mt19937_64 rng(4);
+    churn(list, rng);
+    benchmark::report("compact", "xor_linked_list", benchmark::time_ms([&] { list.compact(); }), n);
+    std::printf("%-28s %-24s %.2f bytes per element\n", "", "", bytes_per_element(list));
+    traverse("traverse x10, compacted", "xor_linked_list", list);
+}
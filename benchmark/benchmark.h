@@ -0,0 +1,56 @@
+/**
+ * Tiny timing helpers shared by the benchmark drivers.
+ *
+ * The benchmarks are plain executables so they can be run without any extra dependencies. Each one prints a table
+ *   of results to stdout.
+ **/
+
+#ifndef DATA_STRUCTURES_BENCHMARK_H
+#define DATA_STRUCTURES_BENCHMARK_H
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace benchmark {
+
+/**
+ * @return the wall clock time taken by `fn`, in milliseconds
+ */
+template <typename F>
+double time_ms(F&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * Prints one result row: the benchmark name, the structure under test, the time and the throughput.
+ */
+inline void report(const std::string& name, const std::string& subject, double ms, size_t operations) {
+    std::printf("%-28s %-24s %10.2f ms %12.2f Mops/s\n",
+                name.c_str(), subject.c_str(), ms, ms > 0 ? operations / ms / 1000.0 : 0.0);
+}
+
+/**
+ * Keeps the optimizer from discarding a computed value.
+ */
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @return the size given as the first command line argument, or `fallback`
+ */
+inline size_t size_arg(int argc, char **argv, size_t fallback) {
+    return argc > 1 ? std::strtoull(argv[1], nullptr, 10) : fallback;
+}
+
+}
+
+
+#endif //DATA_STRUCTURES_BENCHMARK_H
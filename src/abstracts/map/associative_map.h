@@ -1,14 +1,269 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * An associative array stored as a flat, sorted array of keys with a parallel array of values.
+ *
+ * What is a flat map?
+ *   Instead of a tree of nodes, the keys live in a single contiguous array kept in sorted order. The value for
+ *   keys[i] is values[i].
+ *
+ * Why is this useful?
+ *   For read-mostly data (configuration, symbol tables, ...) lookups dominate. A binary search over one contiguous
+ *   array of keys is far friendlier to the cache than chasing tree pointers, and the map carries no per-node
+ *   overhead. The price is that a single insertion in the middle shifts everything after it, so writes should be
+ *   batched with `insert_range`.
+ *
+ * How is it implemented?
+ *   Lookups use a branchless binary search: the loop always runs ceil(log2 n) times and the comparison result is
+ *   folded into a conditional move, so there are no mispredicted branches. An Eytzinger layout would prefetch
+ *   better still, but it would make the O(n+m) merge of `insert_range` impossible, so the array stays sorted.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_ASSOCIATIVE_MAP_H
 #define DATA_STRUCTURES_ASSOCIATIVE_MAP_H
 
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+template <typename K, typename V, typename Compare = std::less<K>>
 class associative_map {
+public:
+    class iterator {
+    public:
+        iterator() = default;
+
+        const K& key() const { return map->keys[index]; }
+        V& value() const { return map->values[index]; }
+
+        iterator& operator++() {
+            index++;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator ret = *this;
+            index++;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        friend class associative_map;
+        iterator(associative_map *map, size_t index) : map(map), index(index) {}
+
+        associative_map *map = nullptr;
+        size_t index = 0;
+    };
+
+    /**
+     * Construct an empty map.
+     */
+    associative_map() = default;
+
 
+    /**
+     * Inserts `key` -> `value` if `key` is not already present. This is O(n) in the worst case; prefer
+     *   `insert_range` for more than a handful of keys.
+     *
+     * @return true if the pair was inserted, false if the key already existed
+     */
+    bool insert(const K& key, const V& value);
+    /**
+     * Inserts every pair in [first,last) whose key is not already present.
+     *
+     * The batch is sorted and then merged into the map from the back in a single O(n+m) pass, instead of m separate
+     *   O(n) shifts. When a key appears more than once in the batch, its first occurrence wins.
+     *
+     * @return the number of pairs inserted
+     */
+    template <typename It>
+    size_t insert_range(It first, It last);
+    /**
+     * @return a reference to the value mapped to `key`, default constructing it if needed
+     */
+    V& operator[](const K& key);
+    /**
+     * Removes `key` from the map.
+     *
+     * @return true if the key was present
+     */
+    bool erase(const K& key);
+    /**
+     * Removes every pair from the map.
+     */
+    void clear() {
+        keys.clear();
+        values.clear();
+    }
+    /**
+     * Reserves room for `count` pairs.
+     */
+    void reserve(size_t count) {
+        keys.reserve(count);
+        values.reserve(count);
+    }
+
+
+    /**
+     * @return an iterator to `key`, or end() if it isn't present
+     */
+    iterator find(const K& key) const;
+    /**
+     * @return an iterator to the first key not less than `key`
+     */
+    iterator lower_bound(const K& key) const { return make_iterator(lower_index(key)); }
+    /**
+     * @return an iterator to the first key greater than `key`
+     */
+    iterator upper_bound(const K& key) const;
+    /**
+     * @return 1 if `key` is present, 0 otherwise
+     */
+    size_t count(const K& key) const { return find(key) != end() ? 1 : 0; }
+
+
+    iterator begin() const { return make_iterator(0); }
+    iterator end() const { return make_iterator(keys.size()); }
+
+    size_t size() const { return keys.size(); }
+    bool empty() const { return keys.empty(); }
+
+private:
+    std::vector<K> keys;
+    std::vector<V> values;
+    Compare comp;
+
+    iterator make_iterator(size_t index) const { return iterator(const_cast<associative_map*>(this), index); }
+    size_t lower_index(const K& key) const;
 };
 
 
+template <typename K, typename V, typename C>
+size_t associative_map<K, V, C>::lower_index(const K& key) const {
+    size_t n = keys.size();
+    if(n == 0)
+        return 0;
+
+    // Branchless lower bound: halve the range every iteration, picking the new base with a conditional move
+    const K *base = keys.data();
+    while(n > 1) {
+        size_t half = n / 2;
+        base = comp(base[half - 1], key) ? base + half : base;
+        n -= half;
+    }
+
+    return (base - keys.data()) + (comp(*base, key) ? 1 : 0);
+}
+
+template <typename K, typename V, typename C>
+typename associative_map<K, V, C>::iterator associative_map<K, V, C>::find(const K& key) const {
+    size_t index = lower_index(key);
+    if(index < keys.size() && !comp(key, keys[index]))
+        return make_iterator(index);
+    return end();
+}
+
+template <typename K, typename V, typename C>
+typename associative_map<K, V, C>::iterator associative_map<K, V, C>::upper_bound(const K& key) const {
+    size_t index = lower_index(key);
+    if(index < keys.size() && !comp(key, keys[index]))
+        index++;
+    return make_iterator(index);
+}
+
+template <typename K, typename V, typename C>
+bool associative_map<K, V, C>::insert(const K& key, const V& value) {
+    size_t index = lower_index(key);
+    if(index < keys.size() && !comp(key, keys[index]))
+        return false;
+
+    keys.insert(keys.begin() + index, key);
+    values.insert(values.begin() + index, value);
+    return true;
+}
+
+template <typename K, typename V, typename C>
+V& associative_map<K, V, C>::operator[](const K& key) {
+    size_t index = lower_index(key);
+    if(index == keys.size() || comp(key, keys[index])) {
+        keys.insert(keys.begin() + index, key);
+        values.insert(values.begin() + index, V());
+    }
+    return values[index];
+}
+
+template <typename K, typename V, typename C>
+bool associative_map<K, V, C>::erase(const K& key) {
+    size_t index = lower_index(key);
+    if(index == keys.size() || comp(key, keys[index]))
+        return false;
+
+    keys.erase(keys.begin() + index);
+    values.erase(values.begin() + index);
+    return true;
+}
+
+template <typename K, typename V, typename C>
+template <typename It>
+size_t associative_map<K, V, C>::insert_range(It first, It last) {
+    std::vector<std::pair<K, V>> batch(first, last);
+    if(batch.empty())
+        return 0;
+
+    // Sort the batch and drop repeated keys, keeping the first occurrence
+    std::stable_sort(batch.begin(), batch.end(), [this](const std::pair<K, V>& a, const std::pair<K, V>& b) {
+        return comp(a.first, b.first);
+    });
+    batch.erase(std::unique(batch.begin(), batch.end(), [this](const std::pair<K, V>& a, const std::pair<K, V>& b) {
+        return !comp(a.first, b.first) && !comp(b.first, a.first);
+    }), batch.end());
+
+    // Count how many batch keys are new so the arrays can be grown once
+    size_t old_size = keys.size(), added = 0;
+    for(size_t i = 0, j = 0; j < batch.size();) {
+        if(i == old_size || comp(batch[j].first, keys[i])) {
+            added++;
+            j++;
+        } else if(comp(keys[i], batch[j].first)) {
+            i++;
+        } else {
+            i++;
+            j++;
+        }
+    }
+    if(added == 0)
+        return 0;
+
+    keys.resize(old_size + added);
+    values.resize(old_size + added);
+
+    // Merge from the back so every element moves at most once
+    size_t i = old_size, j = batch.size(), out = old_size + added;
+    while(j > 0) {
+        if(i > 0 && comp(batch[j - 1].first, keys[i - 1])) {
+            out--;
+            i--;
+            keys[out] = std::move(keys[i]);
+            values[out] = std::move(values[i]);
+        } else if(i > 0 && !comp(keys[i - 1], batch[j - 1].first)) {
+            // Key already present; the existing value wins
+            j--;
+        } else {
+            out--;
+            j--;
+            keys[out] = std::move(batch[j].first);
+            values[out] = std::move(batch[j].second);
+        }
+    }
+
+    return added;
+}
+
+
 #endif //DATA_STRUCTURES_ASSOCIATIVE_MAP_H
@@ -1,14 +1,172 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * A map from each key to any number of values.
+ *
+ * What is a multimap?
+ *   It is a map that allows a key to appear more than once, e.g. a secondary index mapping a column value to every
+ *   row that holds it.
+ *
+ * Why not just use std::multimap?
+ *   std::multimap allocates one tree node per value. Walking the values of a popular key means chasing thousands of
+ *   pointers scattered throughout the heap.
+ *
+ * How is it implemented?
+ *   Each distinct key owns a single contiguous, growable block of values. The blocks are indexed by a `tree_map`,
+ *   so one tree lookup finds the key and its values are then read from one array. `equal_range` hands back a view
+ *   of that array, and iterating the whole map never allocates.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_MULTI_MAP_H
 #define DATA_STRUCTURES_MULTI_MAP_H
 
 
+#include "tree_map.h"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+template <typename K, typename V, typename Compare = std::less<K>>
 class multi_map {
+    typedef std::vector<V> block;
+    typedef tree_map<K, block, Compare> index_map;
+
+public:
+    /**
+     * A non-owning view of the values stored under one key. It is invalidated by any later insertion or erasure
+     *   under the same key.
+     */
+    class value_range {
+    public:
+        value_range() = default;
+        value_range(const V *first, const V *last) : first(first), last(last) {}
+
+        const V *begin() const { return first; }
+        const V *end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+        const V& operator[](size_t index) const { return first[index]; }
+
+    private:
+        const V *first = nullptr, *last = nullptr;
+    };
+
+    class iterator {
+    public:
+        iterator() = default;
+
+        const K& key() const { return it.key(); }
+        value_range values() const { return view(it.value()); }
+
+        iterator& operator++() {
+            ++it;
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const { return it == other.it; }
+        bool operator!=(const iterator& other) const { return it != other.it; }
+
+    private:
+        friend class multi_map;
+        explicit iterator(typename index_map::iterator it) : it(it) {}
+
+        typename index_map::iterator it;
+    };
+
+    /**
+     * Construct an empty multimap.
+     */
+    multi_map() = default;
+
 
+    /**
+     * Appends `value` to the values stored under `key`.
+     */
+    void insert(const K& key, const V& value) {
+        index[key].push_back(value);
+        length++;
+    }
+    /**
+     * Appends every value in [first,last) under `key`. The key is looked up once, and for forward iterators the block
+     *   grows at most once.
+     */
+    template <typename It>
+    void insert_many(const K& key, It first, It last);
+    /**
+     * Removes `key` and all of its values.
+     *
+     * @return the number of values removed
+     */
+    size_t erase(const K& key);
+    /**
+     * Removes every key and value.
+     */
+    void clear() {
+        index.clear();
+        length = 0;
+    }
+
+
+    /**
+     * @return a view of all values stored under `key` (empty if there are none)
+     */
+    value_range equal_range(const K& key) const {
+        typename index_map::iterator it = index.find(key);
+        return it == index.end() ? value_range() : view(it.value());
+    }
+    /**
+     * @return the number of values stored under `key`
+     */
+    size_t count(const K& key) const { return equal_range(key).size(); }
+
+
+    /**
+     * Iterates over the distinct keys in order; use iterator::values() to reach the values.
+     */
+    iterator begin() const { return iterator(index.begin()); }
+    iterator end() const { return iterator(index.end()); }
+
+    /**
+     * @return the total number of values
+     */
+    size_t size() const { return length; }
+    /**
+     * @return the number of distinct keys
+     */
+    size_t key_count() const { return index.size(); }
+    bool empty() const { return length == 0; }
+
+private:
+    index_map index;
+    size_t length = 0;
+
+    static value_range view(const block& values) {
+        return value_range(values.data(), values.data() + values.size());
+    }
 };
 
 
+template <typename K, typename V, typename C>
+template <typename It>
+void multi_map<K, V, C>::insert_many(const K& key, It first, It last) {
+    if(first == last)
+        return;
+
+    block& values = index[key];
+    size_t before = values.size();
+    values.insert(values.end(), first, last);
+
+    length += values.size() - before;
+}
+
+template <typename K, typename V, typename C>
+size_t multi_map<K, V, C>::erase(const K& key) {
+    size_t removed = count(key);
+    if(index.erase(key))
+        length -= removed;
+    return removed;
+}
+
+
 #endif //DATA_STRUCTURES_MULTI_MAP_H
@@ -1,14 +1,758 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * An ordered map implemented as an in-memory B+tree.
+ *
+ * What is a B+tree?
+ *   It is a search tree where every node holds many keys instead of one. Internal nodes only hold separator keys
+ *   used for routing, while all of the key/value pairs live in the leaves. The leaves are linked together so that
+ *   an in-order traversal never has to climb back up the tree.
+ *
+ * Why is this useful?
+ *   A binary tree (red-black, AVL, ...) pays for one pointer chase, and usually one cache miss, per level. A B+tree
+ *   node is sized to a handful of cache lines so a single miss brings in dozens of keys, and the tree is only a few
+ *   levels deep. Range scans walk contiguous arrays inside each leaf and then hop to the next leaf.
+ *
+ * How is it implemented?
+ *   Nodes are sized by the `NodeBytes` parameter, which must be a multiple of 64 bytes, and allocated on 64 byte
+ *   boundaries. The number of keys per node is derived from the key/value sizes. Keys and values are kept in
+ *   separate arrays inside each leaf so the binary search only touches keys.
+ *
+ *   Keys and values must be default constructible and move assignable.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_TREE_MAP_H
 #define DATA_STRUCTURES_TREE_MAP_H
 
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+template <typename K, typename V, typename Compare = std::less<K>, size_t NodeBytes = 256>
 class tree_map {
+    static_assert(NodeBytes % 64 == 0, "NodeBytes must be a multiple of the cache line size (64)");
+
+    struct node {
+        bool is_leaf;
+        uint16_t count;
+    };
+
+    static constexpr size_t leaf_header = sizeof(node) + 2 * sizeof(void*);
+    static constexpr size_t inner_header = sizeof(node) + sizeof(void*);
+    static constexpr size_t leaf_fit =
+            NodeBytes > leaf_header ? (NodeBytes - leaf_header) / (sizeof(K) + sizeof(V)) : 0;
+    static constexpr size_t inner_fit =
+            NodeBytes > inner_header ? (NodeBytes - inner_header) / (sizeof(K) + sizeof(void*)) : 0;
+
+public:
+    /**
+     * Maximum number of key/value pairs held by a leaf.
+     */
+    static constexpr size_t leaf_capacity = leaf_fit > 4 ? leaf_fit : 4;
+    /**
+     * Maximum number of separator keys held by an internal node.
+     */
+    static constexpr size_t inner_capacity = inner_fit > 4 ? inner_fit : 4;
+
+private:
+    static constexpr size_t leaf_min = leaf_capacity / 2;
+    static constexpr size_t inner_min = inner_capacity / 2;
+
+    struct leaf_node : node {
+        leaf_node *prev = nullptr, *next = nullptr;
+        K keys[leaf_capacity];
+        V values[leaf_capacity];
+    };
+
+    struct inner_node : node {
+        K keys[inner_capacity];
+        node *children[inner_capacity + 1];
+    };
+
+public:
+    class iterator {
+    public:
+        iterator() = default;
+
+        const K& key() const { return leaf->keys[index]; }
+        V& value() const { return leaf->values[index]; }
+
+        iterator& operator++() {
+            if(++index >= leaf->count) {
+                leaf = leaf->next;
+                index = 0;
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return leaf == other.leaf && index == other.index; }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class tree_map;
+        iterator(leaf_node *leaf, size_t index) : leaf(leaf), index(index) {}
+
+        leaf_node *leaf = nullptr;
+        size_t index = 0;
+    };
 
+    /**
+     * Construct an empty map. No nodes are allocated until the first insertion.
+     */
+    tree_map() = default;
+    /**
+     * Copy the contents of `other`. The copy is bulk loaded, so it is fully packed.
+     *
+     * @param other map to copy
+     */
+    tree_map(const tree_map& other) : comp(other.comp) {
+        std::vector<std::pair<K, V>> items;
+        items.reserve(other.length);
+        for(iterator it = other.begin(); it != other.end(); ++it)
+            items.emplace_back(it.key(), it.value());
+        build(items);
+    }
+    tree_map(tree_map&& other) noexcept { swap(other); }
+    ~tree_map() { clear(); }
+
+    tree_map& operator=(tree_map other) {
+        swap(other);
+        return *this;
+    }
+
+    void swap(tree_map& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(head, other.head);
+        std::swap(length, other.length);
+        std::swap(comp, other.comp);
+    }
+
+
+    /**
+     * Inserts `key` -> `value` if `key` is not already present.
+     *
+     * @return true if the pair was inserted, false if the key already existed
+     */
+    bool insert(const K& key, const V& value);
+    /**
+     * @return a reference to the value mapped to `key`, default constructing it if needed
+     */
+    V& operator[](const K& key);
+    /**
+     * Removes `key` from the map.
+     *
+     * @return true if the key was present
+     */
+    bool erase(const K& key);
+    /**
+     * Replaces the contents of the map with the pairs in [first,last).
+     *
+     * The input must be sorted by key with no duplicates. Leaves are packed full and the tree is built bottom up in
+     *   O(n), which is much faster than n individual insertions. If it throws, the map is left as it was.
+     *
+     * @throws std::invalid_argument if the input is not strictly increasing
+     */
+    template <typename It>
+    void bulk_load(It first, It last);
+    /**
+     * Removes every pair from the map.
+     */
+    void clear();
+
+
+    /**
+     * @return an iterator to `key`, or end() if it isn't present
+     */
+    iterator find(const K& key) const;
+    /**
+     * @return an iterator to the first key not less than `key`
+     */
+    iterator lower_bound(const K& key) const;
+    /**
+     * @return an iterator to the first key greater than `key`
+     */
+    iterator upper_bound(const K& key) const;
+    /**
+     * @return 1 if `key` is present, 0 otherwise
+     */
+    size_t count(const K& key) const { return find(key) != end() ? 1 : 0; }
+
+
+    iterator begin() const { return iterator(head, 0); }
+    iterator end() const { return iterator(); }
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    /**
+     * @return the number of levels in the tree (0 when empty)
+     */
+    size_t height() const;
+
+private:
+    node *root = nullptr;
+    leaf_node *head = nullptr;
+    size_t length = 0;
+    Compare comp;
+
+    static void *allocate_aligned(size_t bytes);
+    static void free_aligned(void *ptr);
+    static leaf_node *new_leaf();
+    static inner_node *new_inner();
+    static void delete_node(node *n);
+    static void delete_subtree(node *n);
+
+    size_t leaf_lower(const leaf_node *leaf, const K& key) const;
+    size_t leaf_upper(const leaf_node *leaf, const K& key) const;
+    size_t child_index(const inner_node *inner, const K& key) const;
+    leaf_node *find_leaf(const K& key) const;
+
+    bool insert_into(node *n, const K& key, const V& value, K& split_key, node *&split_node, bool& split);
+    bool erase_from(node *n, const K& key);
+    void rebalance_child(inner_node *parent, size_t index);
+    /**
+     * Fills the empty map from `items`, which are strictly increasing, moving out of them.
+     */
+    void build(std::vector<std::pair<K, V>>& items);
 };
 
 
+template <typename K, typename V, typename C, size_t B>
+constexpr size_t tree_map<K, V, C, B>::leaf_capacity;
+template <typename K, typename V, typename C, size_t B>
+constexpr size_t tree_map<K, V, C, B>::inner_capacity;
+
+
+// Allocation helpers. Nodes are placed on cache line boundaries; the original pointer is stored just before the
+//   aligned block so it can be handed back to operator delete.
+
+template <typename K, typename V, typename C, size_t B>
+void *tree_map<K, V, C, B>::allocate_aligned(size_t bytes) {
+    bytes = (bytes + 63) & ~size_t(63);
+    char *raw = static_cast<char*>(::operator new(bytes + 64 + sizeof(void*)));
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + 63) & ~uintptr_t(63);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return reinterpret_cast<void*>(aligned);
+}
+
+template <typename K, typename V, typename C, size_t B>
+void tree_map<K, V, C, B>::free_aligned(void *ptr) {
+    ::operator delete(static_cast<void**>(ptr)[-1]);
+}
+
+template <typename K, typename V, typename C, size_t B>
+typename tree_map<K, V, C, B>::leaf_node *tree_map<K, V, C, B>::new_leaf() {
+    void *mem = allocate_aligned(sizeof(leaf_node));
+    leaf_node *leaf;
+    try {
+        leaf = new(mem) leaf_node();
+    } catch(...) {
+        free_aligned(mem);
+        throw;
+    }
+    leaf->is_leaf = true;
+    leaf->count = 0;
+    return leaf;
+}
+
+template <typename K, typename V, typename C, size_t B>
+typename tree_map<K, V, C, B>::inner_node *tree_map<K, V, C, B>::new_inner() {
+    void *mem = allocate_aligned(sizeof(inner_node));
+    inner_node *inner;
+    try {
+        inner = new(mem) inner_node();
+    } catch(...) {
+        free_aligned(mem);
+        throw;
+    }
+    inner->is_leaf = false;
+    inner->count = 0;
+    return inner;
+}
+
+template <typename K, typename V, typename C, size_t B>
+void tree_map<K, V, C, B>::delete_node(node *n) {
+    if(n->is_leaf) {
+        static_cast<leaf_node*>(n)->~leaf_node();
+    } else {
+        static_cast<inner_node*>(n)->~inner_node();
+    }
+    free_aligned(n);
+}
+
+template <typename K, typename V, typename C, size_t B>
+void tree_map<K, V, C, B>::delete_subtree(node *n) {
+    if(!n->is_leaf) {
+        inner_node *inner = static_cast<inner_node*>(n);
+        for(size_t i = 0; i <= inner->count; i++)
+            delete_subtree(inner->children[i]);
+    }
+    delete_node(n);
+}
+
+template <typename K, typename V, typename C, size_t B>
+void tree_map<K, V, C, B>::clear() {
+    if(root)
+        delete_subtree(root);
+    root = nullptr;
+    head = nullptr;
+    length = 0;
+}
+
+
+// Searching
+
+template <typename K, typename V, typename C, size_t B>
+size_t tree_map<K, V, C, B>::leaf_lower(const leaf_node *leaf, const K& key) const {
+    return std::lower_bound(leaf->keys, leaf->keys + leaf->count, key, comp) - leaf->keys;
+}
+
+template <typename K, typename V, typename C, size_t B>
+size_t tree_map<K, V, C, B>::leaf_upper(const leaf_node *leaf, const K& key) const {
+    return std::upper_bound(leaf->keys, leaf->keys + leaf->count, key, comp) - leaf->keys;
+}
+
+template <typename K, typename V, typename C, size_t B>
+size_t tree_map<K, V, C, B>::child_index(const inner_node *inner, const K& key) const {
+    // children[i] holds keys < keys[i], children[i+1] holds keys >= keys[i]
+    return std::upper_bound(inner->keys, inner->keys + inner->count, key, comp) - inner->keys;
+}
+
+template <typename K, typename V, typename C, size_t B>
+typename tree_map<K, V, C, B>::leaf_node *tree_map<K, V, C, B>::find_leaf(const K& key) const {
+    node *current = root;
+    while(current && !current->is_leaf) {
+        inner_node *inner = static_cast<inner_node*>(current);
+        current = inner->children[child_index(inner, key)];
+    }
+    return static_cast<leaf_node*>(current);
+}
+
+template <typename K, typename V, typename C, size_t B>
+typename tree_map<K, V, C, B>::iterator tree_map<K, V, C, B>::find(const K& key) const {
+    leaf_node *leaf = find_leaf(key);
+    if(!leaf)
+        return end();
+
+    size_t index = leaf_lower(leaf, key);
+    if(index < leaf->count && !comp(key, leaf->keys[index]))
+        return iterator(leaf, index);
+    return end();
+}
+
+template <typename K, typename V, typename C, size_t B>
+typename tree_map<K, V, C, B>::iterator tree_map<K, V, C, B>::lower_bound(const K& key) const {
+    leaf_node *leaf = find_leaf(key);
+    if(!leaf)
+        return end();
+
+    size_t index = leaf_lower(leaf, key);
+    if(index < leaf->count)
+        return iterator(leaf, index);
+    return iterator(leaf->next, 0);
+}
+
+template <typename K, typename V, typename C, size_t B>
+typename tree_map<K, V, C, B>::iterator tree_map<K, V, C, B>::upper_bound(const K& key) const {
+    leaf_node *leaf = find_leaf(key);
+    if(!leaf)
+        return end();
+
+    size_t index = leaf_upper(leaf, key);
+    if(index < leaf->count)
+        return iterator(leaf, index);
+    return iterator(leaf->next, 0);
+}
+
+template <typename K, typename V, typename C, size_t B>
+size_t tree_map<K, V, C, B>::height() const {
+    size_t levels = 0;
+    for(node *current = root; current; levels++) {
+        if(current->is_leaf)
+            return levels + 1;
+        current = static_cast<inner_node*>(current)->children[0];
+    }
+    return levels;
+}
+
+
+// Insertion
+
+template <typename K, typename V, typename C, size_t B>
+bool tree_map<K, V, C, B>::insert_into(node *n, const K& key, const V& value,
+                                       K& split_key, node *&split_node, bool& split) {
+    split = false;
+
+    if(n->is_leaf) {
+        leaf_node *leaf = static_cast<leaf_node*>(n);
+        size_t pos = leaf_lower(leaf, key);
+        if(pos < leaf->count && !comp(key, leaf->keys[pos]))
+            return false;
+
+        leaf_node *target = leaf;
+        if(leaf->count == leaf_capacity) {
+            // Split before inserting so we never need scratch space
+            leaf_node *right = new_leaf();
+            size_t mid = leaf_capacity / 2;
+
+            std::move(leaf->keys + mid, leaf->keys + leaf_capacity, right->keys);
+            std::move(leaf->values + mid, leaf->values + leaf_capacity, right->values);
+            right->count = static_cast<uint16_t>(leaf_capacity - mid);
+            leaf->count = static_cast<uint16_t>(mid);
+
+            right->next = leaf->next;
+            right->prev = leaf;
+            if(leaf->next)
+                leaf->next->prev = right;
+            leaf->next = right;
+
+            if(pos > mid) {
+                target = right;
+                pos -= mid;
+            }
+
+            split = true;
+            split_node = right;
+        }
+
+        std::move_backward(target->keys + pos, target->keys + target->count, target->keys + target->count + 1);
+        std::move_backward(target->values + pos, target->values + target->count,
+                           target->values + target->count + 1);
+        target->keys[pos] = key;
+        target->values[pos] = value;
+        target->count++;
+
+        if(split)
+            split_key = static_cast<leaf_node*>(split_node)->keys[0];
+        return true;
+    }
+
+    inner_node *inner = static_cast<inner_node*>(n);
+    size_t index = child_index(inner, key);
+
+    K child_key;
+    node *child_split = nullptr;
+    bool child_did_split = false;
+    if(!insert_into(inner->children[index], key, value, child_key, child_split, child_did_split))
+        return false;
+    if(!child_did_split)
+        return true;
+
+    inner_node *target = inner;
+    if(inner->count == inner_capacity) {
+        inner_node *right = new_inner();
+        size_t mid = inner_capacity / 2;
+
+        split_key = std::move(inner->keys[mid]);
+        std::move(inner->keys + mid + 1, inner->keys + inner_capacity, right->keys);
+        std::copy(inner->children + mid + 1, inner->children + inner_capacity + 1, right->children);
+        right->count = static_cast<uint16_t>(inner_capacity - mid - 1);
+        inner->count = static_cast<uint16_t>(mid);
+
+        if(index > mid) {
+            target = right;
+            index -= mid + 1;
+        }
+
+        split = true;
+        split_node = right;
+    }
+
+    std::move_backward(target->keys + index, target->keys + target->count, target->keys + target->count + 1);
+    std::copy_backward(target->children + index + 1, target->children + target->count + 1,
+                       target->children + target->count + 2);
+    target->keys[index] = std::move(child_key);
+    target->children[index + 1] = child_split;
+    target->count++;
+
+    return true;
+}
+
+template <typename K, typename V, typename C, size_t B>
+bool tree_map<K, V, C, B>::insert(const K& key, const V& value) {
+    if(!root) {
+        head = new_leaf();
+        root = head;
+    }
+
+    K split_key;
+    node *split_node = nullptr;
+    bool split = false;
+    if(!insert_into(root, key, value, split_key, split_node, split))
+        return false;
+
+    if(split) {
+        inner_node *new_root = new_inner();
+        new_root->keys[0] = std::move(split_key);
+        new_root->children[0] = root;
+        new_root->children[1] = split_node;
+        new_root->count = 1;
+        root = new_root;
+    }
+
+    length++;
+    return true;
+}
+
+template <typename K, typename V, typename C, size_t B>
+V& tree_map<K, V, C, B>::operator[](const K& key) {
+    iterator it = find(key);
+    if(it == end()) {
+        insert(key, V());
+        it = find(key);
+    }
+    return it.value();
+}
+
+
+// Deletion
+
+template <typename K, typename V, typename C, size_t B>
+void tree_map<K, V, C, B>::rebalance_child(inner_node *parent, size_t index) {
+    node *child = parent->children[index];
+    node *left = index > 0 ? parent->children[index - 1] : nullptr;
+    node *right = index < parent->count ? parent->children[index + 1] : nullptr;
+    size_t minimum = child->is_leaf ? leaf_min : inner_min;
+
+    if(child->is_leaf) {
+        leaf_node *c = static_cast<leaf_node*>(child);
+
+        if(left && left->count > minimum) {
+            leaf_node *l = static_cast<leaf_node*>(left);
+            std::move_backward(c->keys, c->keys + c->count, c->keys + c->count + 1);
+            std::move_backward(c->values, c->values + c->count, c->values + c->count + 1);
+            c->keys[0] = std::move(l->keys[l->count - 1]);
+            c->values[0] = std::move(l->values[l->count - 1]);
+            c->count++;
+            l->count--;
+            parent->keys[index - 1] = c->keys[0];
+            return;
+        }
+
+        if(right && right->count > minimum) {
+            leaf_node *r = static_cast<leaf_node*>(right);
+            c->keys[c->count] = std::move(r->keys[0]);
+            c->values[c->count] = std::move(r->values[0]);
+            c->count++;
+            std::move(r->keys + 1, r->keys + r->count, r->keys);
+            std::move(r->values + 1, r->values + r->count, r->values);
+            r->count--;
+            parent->keys[index] = r->keys[0];
+            return;
+        }
+    } else {
+        inner_node *c = static_cast<inner_node*>(child);
+
+        if(left && left->count > minimum) {
+            inner_node *l = static_cast<inner_node*>(left);
+            std::move_backward(c->keys, c->keys + c->count, c->keys + c->count + 1);
+            std::copy_backward(c->children, c->children + c->count + 1, c->children + c->count + 2);
+            c->keys[0] = std::move(parent->keys[index - 1]);
+            c->children[0] = l->children[l->count];
+            c->count++;
+            parent->keys[index - 1] = std::move(l->keys[l->count - 1]);
+            l->count--;
+            return;
+        }
+
+        if(right && right->count > minimum) {
+            inner_node *r = static_cast<inner_node*>(right);
+            c->keys[c->count] = std::move(parent->keys[index]);
+            c->children[c->count + 1] = r->children[0];
+            c->count++;
+            parent->keys[index] = std::move(r->keys[0]);
+            std::move(r->keys + 1, r->keys + r->count, r->keys);
+            std::copy(r->children + 1, r->children + r->count + 1, r->children);
+            r->count--;
+            return;
+        }
+    }
+
+    // Neither sibling can spare a key, so merge with one of them
+    size_t sep = left ? index - 1 : index;
+    node *dst = parent->children[sep];
+    node *src = parent->children[sep + 1];
+
+    if(dst->is_leaf) {
+        leaf_node *d = static_cast<leaf_node*>(dst), *s = static_cast<leaf_node*>(src);
+        std::move(s->keys, s->keys + s->count, d->keys + d->count);
+        std::move(s->values, s->values + s->count, d->values + d->count);
+        d->count = static_cast<uint16_t>(d->count + s->count);
+
+        d->next = s->next;
+        if(s->next)
+            s->next->prev = d;
+    } else {
+        inner_node *d = static_cast<inner_node*>(dst), *s = static_cast<inner_node*>(src);
+        d->keys[d->count] = std::move(parent->keys[sep]);
+        std::move(s->keys, s->keys + s->count, d->keys + d->count + 1);
+        std::copy(s->children, s->children + s->count + 1, d->children + d->count + 1);
+        d->count = static_cast<uint16_t>(d->count + s->count + 1);
+    }
+
+    std::move(parent->keys + sep + 1, parent->keys + parent->count, parent->keys + sep);
+    std::copy(parent->children + sep + 2, parent->children + parent->count + 1, parent->children + sep + 1);
+    parent->count--;
+
+    delete_node(src);
+}
+
+template <typename K, typename V, typename C, size_t B>
+bool tree_map<K, V, C, B>::erase_from(node *n, const K& key) {
+    if(n->is_leaf) {
+        leaf_node *leaf = static_cast<leaf_node*>(n);
+        size_t pos = leaf_lower(leaf, key);
+        if(pos >= leaf->count || comp(key, leaf->keys[pos]))
+            return false;
+
+        std::move(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+        std::move(leaf->values + pos + 1, leaf->values + leaf->count, leaf->values + pos);
+        leaf->count--;
+        // Release whatever the vacated slot still holds, so the erased value does not outlive the call
+        leaf->keys[leaf->count] = K();
+        leaf->values[leaf->count] = V();
+        return true;
+    }
+
+    inner_node *inner = static_cast<inner_node*>(n);
+    size_t index = child_index(inner, key);
+    node *child = inner->children[index];
+
+    if(!erase_from(child, key))
+        return false;
+
+    if(child->count < (child->is_leaf ? leaf_min : inner_min))
+        rebalance_child(inner, index);
+    return true;
+}
+
+template <typename K, typename V, typename C, size_t B>
+bool tree_map<K, V, C, B>::erase(const K& key) {
+    if(!root || !erase_from(root, key))
+        return false;
+
+    length--;
+
+    if(!root->is_leaf && root->count == 0) {
+        inner_node *old = static_cast<inner_node*>(root);
+        root = old->children[0];
+        delete_node(old);
+    } else if(root->is_leaf && root->count == 0) {
+        delete_node(root);
+        root = nullptr;
+        head = nullptr;
+    }
+
+    return true;
+}
+
+
+// Bulk loading
+
+template <typename K, typename V, typename C, size_t B>
+template <typename It>
+void tree_map<K, V, C, B>::bulk_load(It first, It last) {
+    std::vector<std::pair<K, V>> items;
+    for(It it = first; it != last; ++it) {
+        if(!items.empty() && !comp(items.back().first, it->first))
+            throw std::invalid_argument("bulk_load input must be strictly increasing");
+        items.emplace_back(it->first, it->second);
+    }
+
+    // Build beside the current contents, so that a throw leaves them untouched
+    tree_map loaded;
+    loaded.comp = comp;
+    loaded.build(items);
+    swap(loaded);
+}
+
+template <typename K, typename V, typename C, size_t B>
+void tree_map<K, V, C, B>::build(std::vector<std::pair<K, V>>& items) {
+    if(items.empty())
+        return;
+
+    // Spread `total` entries as evenly as possible across the fewest nodes of size `capacity`.
+    // Even spreading keeps every node at or above half capacity.
+    auto group_sizes = [](size_t total, size_t capacity) {
+        size_t groups = (total + capacity - 1) / capacity;
+        std::vector<size_t> sizes(groups, total / groups);
+        for(size_t i = 0; i < total % groups; i++)
+            sizes[i]++;
+        return sizes;
+    };
+
+    std::vector<node*> level, next_level;
+    std::vector<K> lows, next_lows;
+
+    try {
+        leaf_node *prev = nullptr;
+        size_t offset = 0;
+        for(size_t size : group_sizes(items.size(), leaf_capacity)) {
+            leaf_node *leaf = new_leaf();
+            for(size_t i = 0; i < size; i++) {
+                leaf->keys[i] = std::move(items[offset + i].first);
+                leaf->values[i] = std::move(items[offset + i].second);
+            }
+            leaf->count = static_cast<uint16_t>(size);
+            offset += size;
+
+            leaf->prev = prev;
+            if(prev)
+                prev->next = leaf;
+            else
+                head = leaf;
+            prev = leaf;
+
+            level.push_back(leaf);
+            lows.push_back(leaf->keys[0]);
+        }
+
+        while(level.size() > 1) {
+            next_level.clear();
+            next_lows.clear();
+
+            offset = 0;
+            for(size_t size : group_sizes(level.size(), inner_capacity + 1)) {
+                inner_node *inner = new_inner();
+                inner->children[0] = level[offset];
+                for(size_t i = 1; i < size; i++) {
+                    inner->keys[i - 1] = lows[offset + i];
+                    inner->children[i] = level[offset + i];
+                }
+                inner->count = static_cast<uint16_t>(size - 1);
+
+                next_level.push_back(inner);
+                next_lows.push_back(lows[offset]);
+                offset += size;
+            }
+
+            level.swap(next_level);
+            lows.swap(next_lows);
+        }
+    } catch(...) {
+        // Everything below the current level hangs off of it. Partially built parents are freed on their own.
+        for(node *n : next_level)
+            delete_node(n);
+        for(node *n : level)
+            delete_subtree(n);
+        head = nullptr;
+        throw;
+    }
+
+    root = level[0];
+    length = items.size();
+}
+
+
 #endif //DATA_STRUCTURES_TREE_MAP_H
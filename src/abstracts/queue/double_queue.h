@@ -1,14 +1,534 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Double-ended queues: a block-based deque, and a Chase-Lev work-stealing deque.
+ *
+ * What is a double-ended queue?
+ *   A sequence that supports O(1) insertion and removal at both ends as well as O(1) indexing.
+ *
+ * Why is this useful?
+ *   A vector can only grow cheaply at the back, and a linked list pays for one allocation and one cache miss per
+ *   element. A deque built from fixed-size blocks keeps elements contiguous within each block and never moves them.
+ *
+ *   The work-stealing deque is the building block of task schedulers (Cilk, TBB, Rayon, ...): each worker thread
+ *   pushes and pops tasks at the bottom of its own deque like a stack, which keeps cache-hot work local, while idle
+ *   workers steal the oldest tasks from the top of other workers' deques.
+ *
+ * How are they implemented?
+ *   double_queue: elements live in blocks of `block_capacity` slots (a power of two derived from `BlockBytes`). A
+ *   circular map of block pointers, also a power of two long, locates the block holding any position, so indexing is
+ *   two shifts and two masks. Positions are unsigned and allowed to wrap, which makes push_front no different from
+ *   push_back. Blocks emptied by a pop go into a pool rather than back to the allocator, so a deque that stays
+ *   within its high-water mark never allocates; `shrink_to_fit` releases the pool.
+ *
+ *   work_stealing_deque: the algorithm of Chase and Lev ("Dynamic Circular Work-Stealing Deque", SPAA 2005) with the
+ *   memory orderings given by Le et al. ("Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013).
+ *   The owner only races with thieves for the last element. When the circular array is full the owner copies it into
+ *   one twice the size; old arrays are kept until the deque is destroyed because a thief may still be reading one.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_DOUBLE_QUEUE_H
 #define DATA_STRUCTURES_DOUBLE_QUEUE_H
 
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace double_queue_detail {
+
+constexpr size_t floor_pow2(size_t n) {
+    size_t power = 1;
+    while(power * 2 <= n)
+        power *= 2;
+    return power;
+}
+
+constexpr size_t log2(size_t power) {
+    size_t bits = 0;
+    while(power > 1) {
+        power >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+}
+
+/**
+ * A double-ended queue made of fixed-size blocks.
+ *
+ * @tparam BlockBytes approximate size of each block; the block holds the largest power of two number of elements
+ *   that fits, but never fewer than 16
+ */
+template <typename T, size_t BlockBytes = 4096>
 class double_queue {
+    static constexpr size_t block_fit = double_queue_detail::floor_pow2(BlockBytes / sizeof(T));
+
+public:
+    /**
+     * Number of elements held by each block.
+     */
+    static constexpr size_t block_capacity = block_fit > 16 ? block_fit : 16;
+
+    class iterator {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T& reference;
+
+        iterator() = default;
+
+        T& operator*() const { return (*owner)[index]; }
+        T *operator->() const { return &(*owner)[index]; }
+        T& operator[](difference_type offset) const { return (*owner)[index + offset]; }
+
+        iterator& operator++() {
+            index++;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            index++;
+            return ret;
+        }
+        iterator& operator--() {
+            index--;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator ret = *this;
+            index--;
+            return ret;
+        }
+
+        iterator& operator+=(difference_type offset) {
+            index += offset;
+            return *this;
+        }
+        iterator& operator-=(difference_type offset) {
+            index -= offset;
+            return *this;
+        }
+        iterator operator+(difference_type offset) const { return iterator(owner, index + offset); }
+        iterator operator-(difference_type offset) const { return iterator(owner, index - offset); }
+        difference_type operator-(const iterator& other) const {
+            return static_cast<difference_type>(index) - static_cast<difference_type>(other.index);
+        }
+
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+        bool operator<(const iterator& other) const { return index < other.index; }
+
+    private:
+        friend class double_queue;
+        iterator(double_queue *owner, size_t index) : owner(owner), index(index) {}
+
+        double_queue *owner = nullptr;
+        size_t index = 0;
+    };
+
+    /**
+     * Construct an empty deque. No memory is allocated until the first push.
+     */
+    double_queue() = default;
+    double_queue(const double_queue& other);
+    double_queue(double_queue&& other) noexcept { swap(other); }
+    double_queue& operator=(double_queue other) {
+        swap(other);
+        return *this;
+    }
+    ~double_queue();
+
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+    void push_front(const T& value) { emplace_front(value); }
+    void push_front(T&& value) { emplace_front(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args);
+    template <typename... Args>
+    T& emplace_front(Args&&... args);
+
+    /**
+     * Removes the last element. The deque must not be empty.
+     */
+    void pop_back();
+    /**
+     * Removes the first element. The deque must not be empty.
+     */
+    void pop_front();
+    /**
+     * Removes every element. Emptied blocks are kept in the pool.
+     */
+    void clear();
+    /**
+     * Frees every pooled block.
+     */
+    void shrink_to_fit();
+
+
+    T& operator[](size_t index) { return *slot(head + index); }
+    const T& operator[](size_t index) const { return *slot(head + index); }
+    /**
+     * @throws std::out_of_range if `index` >= size()
+     */
+    T& at(size_t index);
+    const T& at(size_t index) const { return const_cast<double_queue*>(this)->at(index); }
 
+    T& front() { return *slot(head); }
+    const T& front() const { return *slot(head); }
+    T& back() { return *slot(head + count - 1); }
+    const T& back() const { return *slot(head + count - 1); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    /**
+     * @return the number of blocks in the pool, ready to be reused without allocating
+     */
+    size_t pooled_blocks() const { return pool.size(); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, count); }
+
+    void swap(double_queue& other) noexcept {
+        map.swap(other.map);
+        pool.swap(other.pool);
+        std::swap(head, other.head);
+        std::swap(count, other.count);
+    }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    static constexpr size_t block_shift = double_queue_detail::log2(block_capacity);
+
+    // Circular map of blocks, indexed by (position / block_capacity) modulo its power of two size
+    std::vector<storage*> map;
+    std::vector<storage*> pool;
+    // Position of the first element; positions wrap around modulo 2^64
+    size_t head = 0;
+    size_t count = 0;
+
+    size_t map_slot(size_t position) const { return (position >> block_shift) & (map.size() - 1); }
+    T *slot(size_t position) const {
+        return reinterpret_cast<T*>(&map[map_slot(position)][position & (block_capacity - 1)]);
+    }
+
+    /**
+     * Installs a block for `position`, which is just outside the current range and is the first position of the
+     *   block it falls in (counting in the direction of the push).
+     */
+    void prepare(size_t position);
+    void release_block(size_t position);
 };
 
+template <typename T, size_t B>
+constexpr size_t double_queue<T, B>::block_capacity;
+
+
+/**
+ * A Chase-Lev work-stealing deque. One owner thread calls push and pop; any number of other threads call steal.
+ *
+ * Items are copied in and out with relaxed atomic loads and stores, so T must be trivially copyable. Tasks are
+ *   normally passed as pointers.
+ */
+template <typename T>
+class work_stealing_deque {
+    static_assert(std::is_trivially_copyable<T>::value, "work_stealing_deque items must be trivially copyable");
+
+public:
+    /**
+     * @param capacity initial capacity, rounded up to a power of two. The deque grows as needed.
+     */
+    explicit work_stealing_deque(size_t capacity = 64);
+
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+
+    /**
+     * Owner only. Pushes `item` onto the bottom.
+     */
+    void push(T item);
+    /**
+     * Owner only. Pops the most recently pushed item.
+     *
+     * @return false if the deque is empty (or a thief took the last item)
+     */
+    bool pop(T& out);
+    /**
+     * Any thread. Takes the oldest item from the top.
+     *
+     * @return false if the deque is empty or another thread won the race for the top item. Schedulers usually move
+     *   on to another victim rather than retrying.
+     */
+    bool steal(T& out);
+
+
+    /**
+     * @return an approximate number of items in the deque
+     */
+    size_t size() const {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return array.load(std::memory_order_relaxed)->mask + 1; }
+
+private:
+    struct ring {
+        explicit ring(size_t size) : mask(size - 1), items(new std::atomic<T>[size]) {}
+
+        T get(int64_t index) const { return items[index & mask].load(std::memory_order_relaxed); }
+        void put(int64_t index, T item) { items[index & mask].store(item, std::memory_order_relaxed); }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+    };
+
+    static const size_t CACHE_LINE = 64;
+
+    std::atomic<int64_t> top;
+    char pad0[CACHE_LINE];
+    std::atomic<int64_t> bottom;
+    std::atomic<ring*> array;
+    char pad1[CACHE_LINE];
+
+    // Every array ever used, so that thieves still reading an old one never see it freed. Owner only.
+    std::vector<std::unique_ptr<ring>> rings;
+
+    ring *grow(ring *old, int64_t b, int64_t t);
+};
+
+
+// Define double_queue
+
+template <typename T, size_t B>
+double_queue<T, B>::double_queue(const double_queue& other) {
+    for(size_t i = 0; i < other.count; i++)
+        emplace_back(other[i]);
+}
+
+template <typename T, size_t B>
+double_queue<T, B>::~double_queue() {
+    clear();
+    shrink_to_fit();
+}
+
+template <typename T, size_t B>
+void double_queue<T, B>::prepare(size_t position) {
+    if(map.empty())
+        map.assign(8, nullptr);
+
+    // Counted from the offset within the first block so that it stays right when positions wrap around
+    size_t live = count == 0 ? 0 : (((head & (block_capacity - 1)) + count - 1) >> block_shift) + 1;
+    if(live == map.size()) {
+        // Every slot is in use: double the map, re-homing each live block by its block number
+        std::vector<storage*> bigger(map.size() * 2, nullptr);
+        for(size_t i = 0, block = head >> block_shift; i < live; i++, block++)
+            bigger[block & (bigger.size() - 1)] = map[block & (map.size() - 1)];
+        map.swap(bigger);
+    }
+
+    storage *&target = map[map_slot(position)];
+    if(!pool.empty()) {
+        target = pool.back();
+        pool.pop_back();
+    } else {
+        target = new storage[block_capacity];
+    }
+}
+
+template <typename T, size_t B>
+void double_queue<T, B>::release_block(size_t position) {
+    storage *&target = map[map_slot(position)];
+    pool.push_back(target);
+    target = nullptr;
+}
+
+template <typename T, size_t B>
+template <typename... Args>
+T& double_queue<T, B>::emplace_back(Args&&... args) {
+    size_t position = head + count;
+    if(count == 0 || (position & (block_capacity - 1)) == 0)
+        prepare(position);
+
+    T *value = slot(position);
+    try {
+        new(value) T(std::forward<Args>(args)...);
+    } catch(...) {
+        if(count == 0 || (position & (block_capacity - 1)) == 0)
+            release_block(position);
+        throw;
+    }
+    count++;
+    return *value;
+}
+
+template <typename T, size_t B>
+template <typename... Args>
+T& double_queue<T, B>::emplace_front(Args&&... args) {
+    size_t position = head - 1;
+    if(count == 0 || (head & (block_capacity - 1)) == 0)
+        prepare(position);
+
+    T *value = slot(position);
+    try {
+        new(value) T(std::forward<Args>(args)...);
+    } catch(...) {
+        if(count == 0 || (head & (block_capacity - 1)) == 0)
+            release_block(position);
+        throw;
+    }
+    head = position;
+    count++;
+    return *value;
+}
+
+template <typename T, size_t B>
+void double_queue<T, B>::pop_back() {
+    size_t position = head + count - 1;
+    slot(position)->~T();
+    count--;
+
+    // Release the block if that was its first live element
+    if(count == 0 || (position & (block_capacity - 1)) == 0)
+        release_block(position);
+}
+
+template <typename T, size_t B>
+void double_queue<T, B>::pop_front() {
+    size_t position = head;
+    slot(position)->~T();
+    head++;
+    count--;
+
+    // Release the block if that was its last live element
+    if(count == 0 || (head & (block_capacity - 1)) == 0)
+        release_block(position);
+}
+
+template <typename T, size_t B>
+void double_queue<T, B>::clear() {
+    while(count > 0)
+        pop_back();
+    head = 0;
+}
+
+template <typename T, size_t B>
+void double_queue<T, B>::shrink_to_fit() {
+    for(storage *block : pool)
+        delete[] block;
+    pool.clear();
+    pool.shrink_to_fit();
+    if(count == 0)
+        map = std::vector<storage*>();
+}
+
+template <typename T, size_t B>
+T& double_queue<T, B>::at(size_t index) {
+    if(index >= count)
+        throw std::out_of_range("double_queue index out of range");
+    return *slot(head + index);
+}
+
+// End of double_queue definitions
+
+
+// Define work_stealing_deque
+
+template <typename T>
+work_stealing_deque<T>::work_stealing_deque(size_t capacity) : top(0), bottom(0) {
+    size_t size = 2;
+    while(size < capacity)
+        size <<= 1;
+
+    rings.emplace_back(new ring(size));
+    array.store(rings.back().get(), std::memory_order_relaxed);
+}
+
+template <typename T>
+typename work_stealing_deque<T>::ring *work_stealing_deque<T>::grow(ring *old, int64_t b, int64_t t) {
+    std::unique_ptr<ring> bigger(new ring(2 * (old->mask + 1)));
+    for(int64_t i = t; i < b; i++)
+        bigger->put(i, old->get(i));
+
+    rings.push_back(std::move(bigger));
+    ring *fresh = rings.back().get();
+    array.store(fresh, std::memory_order_release);
+    return fresh;
+}
+
+template <typename T>
+void work_stealing_deque<T>::push(T item) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    ring *a = array.load(std::memory_order_relaxed);
+
+    if(b - t > static_cast<int64_t>(a->mask))
+        a = grow(a, b, t);
+
+    a->put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool work_stealing_deque<T>::pop(T& out) {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    ring *a = array.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if(t > b) {
+        // Already empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    out = a->get(b);
+    if(t == b) {
+        // Last item: race the thieves for it
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+template <typename T>
+bool work_stealing_deque<T>::steal(T& out) {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+
+    if(t >= b)
+        return false;
+
+    // The paper uses a consume load; acquire is what compilers implement it as anyway
+    ring *a = array.load(std::memory_order_acquire);
+    T item = a->get(t);
+    if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return false;
+
+    out = item;
+    return true;
+}
+
+// End of work_stealing_deque definitions
+
 
 #endif //DATA_STRUCTURES_DOUBLE_QUEUE_H
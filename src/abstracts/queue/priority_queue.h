@@ -1,14 +1,551 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Addressable priority queues: an implicit d-ary heap and a pairing heap.
+ *
+ * What are they?
+ *   Both keep a collection ordered just enough to return its minimum (by `Compare`) in O(1). Unlike
+ *   std::priority_queue, every push returns a handle that stays valid until the element leaves the queue. Through it
+ *   an element's value can be changed (`decrease_key`, `update`) or removed (`erase`) without searching for it.
+ *
+ *   Note the direction: with the default std::less, `top` is the *smallest* element, which is what shortest path
+ *   and timer code want.
+ *
+ * Why is this useful?
+ *   Without decrease-key, Dijkstra's algorithm has to push duplicate entries and skip stale ones when they surface,
+ *   so the heap grows to O(E) instead of O(V).
+ *
+ *   priority_queue (the d-ary heap) is the one to reach for by default. A 4-ary heap is half as deep as a binary
+ *   heap, and the four children of a node are adjacent in memory, so a sift-down step reads one or two cache lines
+ *   instead of chasing a pointer. Keeping handles valid costs one scattered write per entry moved, so when
+ *   decrease_key is not needed std::priority_queue is still faster on large heaps.
+ *
+ *   pairing_heap melds two heaps in O(1) and has O(1) push and amortized o(log n) decrease_key, which makes it the
+ *   better choice when heaps are merged often.
+ *
+ * How are they implemented?
+ *   priority_queue stores (value, handle) entries in one array and a second array maps each handle to its entry's
+ *   position. Sifts move a hole rather than swapping, so every entry is written once per level. Handles of erased
+ *   elements are recycled.
+ *
+ *   pairing_heap is a heap-ordered multi-way tree stored as a leftmost-child/next-sibling binary tree. Pops merge the
+ *   root's children with the standard two-pass pairing. Nodes come from a free list refilled in chunks, so steady
+ *   state operations do not allocate.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_PRIORITY_QUEUE_H
 #define DATA_STRUCTURES_PRIORITY_QUEUE_H
 
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * An implicit d-ary min-heap with stable handles.
+ *
+ * @tparam D number of children per node (default 4)
+ */
+template <typename T, typename Compare = std::less<T>, size_t D = 4>
 class priority_queue {
+    static_assert(D >= 2, "a heap node needs at least two children");
+
+public:
+    typedef uint32_t handle;
+
+    priority_queue() = default;
+    explicit priority_queue(const Compare& comp) : comp(comp) {}
+
+
+    /**
+     * @return a handle to the new element
+     */
+    handle push(const T& value) { return emplace(T(value)); }
+    handle push(T&& value) { return emplace(std::move(value)); }
+    /**
+     * Removes the top element. The queue must not be empty.
+     */
+    void pop();
+    /**
+     * Removes the element behind `h`; `h` is invalid afterwards.
+     */
+    void erase(handle h);
+    /**
+     * Replaces the value behind `h` with `value`, which must not compare greater than the current value.
+     */
+    void decrease_key(handle h, const T& value);
+    /**
+     * Replaces the value behind `h` with `value`, moving it in whichever direction is needed.
+     */
+    void update(handle h, const T& value);
+    void clear();
+    void reserve(size_t count) {
+        heap.reserve(count);
+        positions.reserve(count);
+    }
+
+
+    /**
+     * @return the minimum element. The queue must not be empty.
+     */
+    const T& top() const { return heap[0].value; }
+    handle top_handle() const { return heap[0].id; }
+    /**
+     * @return the value behind `h`
+     */
+    const T& value(handle h) const { return heap[positions[h]].value; }
+    /**
+     * @return true if `h` refers to an element still in the queue
+     */
+    bool contains(handle h) const { return h < positions.size() && positions[h] != NONE; }
+
+    size_t size() const { return heap.size(); }
+    bool empty() const { return heap.empty(); }
+
+private:
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct entry {
+        T value;
+        handle id;
+    };
+
+    std::vector<entry> heap;
+    // Heap index of each handle, or NONE for handles waiting in free_handles
+    std::vector<uint32_t> positions;
+    std::vector<handle> free_handles;
+    Compare comp;
+
+    handle emplace(T&& value);
+    void sift_up(size_t index, entry&& moving);
+    void sift_down(size_t index, entry&& moving);
+    void place(size_t index, entry&& moving) {
+        positions[moving.id] = static_cast<uint32_t>(index);
+        heap[index] = std::move(moving);
+    }
+};
+
+
+/**
+ * A pairing min-heap with stable handles and O(1) meld.
+ */
+template <typename T, typename Compare = std::less<T>>
+class pairing_heap {
+    struct node {
+        T value;
+        node *child = nullptr;
+        node *next = nullptr;
+        // The left sibling, or the parent for a leftmost child
+        node *prev = nullptr;
+    };
+
+public:
+    class handle {
+    public:
+        handle() = default;
+
+        bool operator==(const handle& other) const { return target == other.target; }
+        bool operator!=(const handle& other) const { return target != other.target; }
+
+    private:
+        friend class pairing_heap;
+        explicit handle(node *target) : target(target) {}
+
+        node *target = nullptr;
+    };
 
+    pairing_heap() = default;
+    explicit pairing_heap(const Compare& comp) : comp(comp) {}
+    pairing_heap(pairing_heap&& other) noexcept { swap(other); }
+    pairing_heap& operator=(pairing_heap&& other) noexcept {
+        swap(other);
+        return *this;
+    }
+    pairing_heap(const pairing_heap&) = delete;
+    pairing_heap& operator=(const pairing_heap&) = delete;
+    ~pairing_heap() { clear(); }
+
+
+    /**
+     * @return a handle to the new element
+     */
+    handle push(const T& value) { return emplace(T(value)); }
+    handle push(T&& value) { return emplace(std::move(value)); }
+    /**
+     * Removes the top element. The heap must not be empty.
+     */
+    void pop();
+    /**
+     * Removes the element behind `h`; `h` is invalid afterwards.
+     */
+    void erase(handle h);
+    /**
+     * Replaces the value behind `h` with `value`, which must not compare greater than the current value.
+     */
+    void decrease_key(handle h, const T& value);
+    /**
+     * Moves every element of `other` into this heap in O(1). Handles into `other` stay valid and now refer to this
+     *   heap. `other` is left empty.
+     */
+    void meld(pairing_heap& other);
+    void clear();
+
+
+    /**
+     * @return the minimum element. The heap must not be empty.
+     */
+    const T& top() const { return root->value; }
+    handle top_handle() const { return handle(root); }
+    const T& value(handle h) const { return h.target->value; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    void swap(pairing_heap& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(count, other.count);
+        std::swap(free_nodes, other.free_nodes);
+        chunks.swap(other.chunks);
+        std::swap(comp, other.comp);
+    }
+
+private:
+    static const size_t CHUNK_NODES = 256;
+
+    node *root = nullptr;
+    size_t count = 0;
+    // Unused nodes, chained through `next`
+    node *free_nodes = nullptr;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    Compare comp;
+
+    handle emplace(T&& value);
+    node *allocate(T&& value);
+    void release(node *n);
+
+    node *link(node *a, node *b);
+    void cut(node *n);
+    node *merge_pairs(node *first);
 };
 
 
+// Define priority_queue
+
+template <typename T, typename C, size_t D>
+const uint32_t priority_queue<T, C, D>::NONE;
+
+template <typename T, typename C, size_t D>
+typename priority_queue<T, C, D>::handle priority_queue<T, C, D>::emplace(T&& value) {
+    handle id;
+    if(!free_handles.empty()) {
+        id = free_handles.back();
+        free_handles.pop_back();
+    } else {
+        if(positions.size() == NONE)
+            throw std::length_error("priority_queue has run out of handles");
+        id = static_cast<handle>(positions.size());
+        positions.push_back(NONE);
+    }
+
+    try {
+        heap.push_back(entry{std::move(value), id});
+    } catch(...) {
+        free_handles.push_back(id);
+        throw;
+    }
+    // Lift the new entry out of its slot; sift_up fills the hole it leaves
+    entry moving = std::move(heap.back());
+    sift_up(heap.size() - 1, std::move(moving));
+    return id;
+}
+
+template <typename T, typename C, size_t D>
+void priority_queue<T, C, D>::sift_up(size_t index, entry&& moving) {
+    while(index > 0) {
+        size_t parent = (index - 1) / D;
+        if(!comp(moving.value, heap[parent].value))
+            break;
+        place(index, std::move(heap[parent]));
+        index = parent;
+    }
+    place(index, std::move(moving));
+}
+
+template <typename T, typename C, size_t D>
+void priority_queue<T, C, D>::sift_down(size_t index, entry&& moving) {
+    size_t n = heap.size();
+
+    while(true) {
+        size_t first = D * index + 1;
+        if(first >= n)
+            break;
+
+        // Find the smallest child; the children are adjacent, so this scan stays within a cache line or two
+        size_t best = first, last = first + D < n ? first + D : n;
+        for(size_t child = first + 1; child < last; child++)
+            if(comp(heap[child].value, heap[best].value))
+                best = child;
+
+        if(!comp(heap[best].value, moving.value))
+            break;
+        place(index, std::move(heap[best]));
+        index = best;
+    }
+    place(index, std::move(moving));
+}
+
+template <typename T, typename C, size_t D>
+void priority_queue<T, C, D>::pop() {
+    handle h = heap[0].id;
+    positions[h] = NONE;
+    free_handles.push_back(h);
+
+    entry last = std::move(heap.back());
+    heap.pop_back();
+    if(heap.empty())
+        return;
+
+    // The last entry almost always belongs near the bottom, so walk the hole all the way down along the smallest
+    //   children and sift the last entry up from there. This needs about half the comparisons of a plain sift-down.
+    size_t index = 0, n = heap.size();
+    while(true) {
+        size_t first = D * index + 1;
+        if(first >= n)
+            break;
+
+        size_t best = first, end = first + D < n ? first + D : n;
+        for(size_t child = first + 1; child < end; child++)
+            if(comp(heap[child].value, heap[best].value))
+                best = child;
+
+        place(index, std::move(heap[best]));
+        index = best;
+    }
+    sift_up(index, std::move(last));
+}
+
+template <typename T, typename C, size_t D>
+void priority_queue<T, C, D>::erase(handle h) {
+    size_t index = positions[h];
+    positions[h] = NONE;
+    free_handles.push_back(h);
+
+    entry last = std::move(heap.back());
+    heap.pop_back();
+    if(index == heap.size())
+        return;
+
+    // Fill the hole with the last entry and restore the heap in whichever direction it needs
+    if(index > 0 && comp(last.value, heap[(index - 1) / D].value))
+        sift_up(index, std::move(last));
+    else
+        sift_down(index, std::move(last));
+}
+
+template <typename T, typename C, size_t D>
+void priority_queue<T, C, D>::decrease_key(handle h, const T& value) {
+    size_t index = positions[h];
+    sift_up(index, entry{value, h});
+}
+
+template <typename T, typename C, size_t D>
+void priority_queue<T, C, D>::update(handle h, const T& value) {
+    size_t index = positions[h];
+    if(comp(value, heap[index].value))
+        sift_up(index, entry{value, h});
+    else
+        sift_down(index, entry{value, h});
+}
+
+template <typename T, typename C, size_t D>
+void priority_queue<T, C, D>::clear() {
+    heap.clear();
+    positions.clear();
+    free_handles.clear();
+}
+
+// End of priority_queue definitions
+
+
+// Define pairing_heap
+
+template <typename T, typename C>
+typename pairing_heap<T, C>::node *pairing_heap<T, C>::allocate(T&& value) {
+    if(!free_nodes) {
+        chunks.emplace_back(new char[CHUNK_NODES * sizeof(node)]);
+        node *chunk = reinterpret_cast<node*>(chunks.back().get());
+        for(size_t i = 0; i < CHUNK_NODES; i++) {
+            chunk[i].next = free_nodes;
+            free_nodes = &chunk[i];
+        }
+    }
+
+    node *n = free_nodes;
+    free_nodes = n->next;
+    return new(n) node{std::move(value)};
+}
+
+template <typename T, typename C>
+void pairing_heap<T, C>::release(node *n) {
+    n->~node();
+    n->next = free_nodes;
+    free_nodes = n;
+}
+
+template <typename T, typename C>
+typename pairing_heap<T, C>::node *pairing_heap<T, C>::link(node *a, node *b) {
+    // Makes the larger root the leftmost child of the smaller one. Both must be roots without siblings.
+    if(comp(b->value, a->value))
+        std::swap(a, b);
+
+    b->prev = a;
+    b->next = a->child;
+    if(a->child)
+        a->child->prev = b;
+    a->child = b;
+    return a;
+}
+
+template <typename T, typename C>
+void pairing_heap<T, C>::cut(node *n) {
+    // Detaches the subtree rooted at n (which is not the root) from its parent and siblings
+    if(n->prev->child == n)
+        n->prev->child = n->next;
+    else
+        n->prev->next = n->next;
+    if(n->next)
+        n->next->prev = n->prev;
+    n->prev = n->next = nullptr;
+}
+
+template <typename T, typename C>
+typename pairing_heap<T, C>::node *pairing_heap<T, C>::merge_pairs(node *first) {
+    if(!first)
+        return nullptr;
+
+    // First pass, left to right: link siblings in pairs, stacking the results through `prev`
+    node *stack = nullptr;
+    while(first) {
+        node *a = first, *b = first->next;
+        if(!b) {
+            a->prev = stack;
+            a->next = nullptr;
+            stack = a;
+            break;
+        }
+        first = b->next;
+        a->next = b->next = nullptr;
+        a->prev = b->prev = nullptr;
+
+        node *pair = link(a, b);
+        pair->prev = stack;
+        stack = pair;
+    }
+
+    // Second pass, right to left: fold the pairs into one tree
+    node *result = stack;
+    stack = stack->prev;
+    result->prev = nullptr;
+    while(stack) {
+        node *below = stack->prev;
+        stack->prev = nullptr;
+        result = link(stack, result);
+        stack = below;
+    }
+    return result;
+}
+
+template <typename T, typename C>
+typename pairing_heap<T, C>::handle pairing_heap<T, C>::emplace(T&& value) {
+    node *n = allocate(std::move(value));
+    root = root ? link(root, n) : n;
+    count++;
+    return handle(n);
+}
+
+template <typename T, typename C>
+void pairing_heap<T, C>::pop() {
+    node *old = root;
+    root = merge_pairs(old->child);
+    release(old);
+    count--;
+}
+
+template <typename T, typename C>
+void pairing_heap<T, C>::erase(handle h) {
+    node *n = h.target;
+    if(n == root) {
+        pop();
+        return;
+    }
+
+    cut(n);
+    node *rest = merge_pairs(n->child);
+    if(rest)
+        root = link(root, rest);
+    release(n);
+    count--;
+}
+
+template <typename T, typename C>
+void pairing_heap<T, C>::decrease_key(handle h, const T& value) {
+    node *n = h.target;
+    n->value = value;
+    if(n != root) {
+        cut(n);
+        root = link(root, n);
+    }
+}
+
+template <typename T, typename C>
+void pairing_heap<T, C>::meld(pairing_heap& other) {
+    if(this == &other || !other.root)
+        return;
+
+    root = root ? link(root, other.root) : other.root;
+    count += other.count;
+    other.root = nullptr;
+    other.count = 0;
+
+    // The nodes live in other's chunks, so take ownership of those as well
+    for(auto& chunk : other.chunks)
+        chunks.push_back(std::move(chunk));
+    other.chunks.clear();
+    while(other.free_nodes) {
+        node *n = other.free_nodes;
+        other.free_nodes = n->next;
+        n->next = free_nodes;
+        free_nodes = n;
+    }
+}
+
+template <typename T, typename C>
+void pairing_heap<T, C>::clear() {
+    // Walk the tree with an explicit stack of subtrees still to visit, chained through `prev`
+    node *pending = root;
+    if(pending)
+        pending->prev = nullptr;
+    while(pending) {
+        node *n = pending;
+        pending = n->prev;
+
+        for(node *child = n->child; child; child = child->next) {
+            child->prev = pending;
+            pending = child;
+        }
+        release(n);
+    }
+
+    root = nullptr;
+    count = 0;
+}
+
+// End of pairing_heap definitions
+
+
 #endif //DATA_STRUCTURES_PRIORITY_QUEUE_H
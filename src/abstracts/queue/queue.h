@@ -1,14 +1,450 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Bounded lock-free FIFO queues for passing work between threads.
+ *
+ * What are they?
+ *   - `spsc_queue`: a ring buffer for exactly one producer thread and one consumer thread.
+ *   - `mpmc_queue`: a ring buffer any number of producers and consumers may use at once (Dmitry Vyukov's bounded
+ *     MPMC queue).
+ *   Both have a fixed power of two capacity chosen at construction, never allocate after that, and never block:
+ *   `try_push` fails when the queue is full and `try_pop` fails when it is empty.
+ *
+ * Why is this useful?
+ *   A mutex protected std::deque serializes every producer and consumer on one lock, and a preempted lock holder
+ *   stalls everyone. These queues only synchronize through atomic indices.
+ *
+ * How are they implemented?
+ *   spsc_queue: the producer owns `tail` and the consumer owns `head`. Each side also keeps a private cached copy
+ *   of the other side's index, and only re-reads the shared one when the cache says the queue is full (or empty).
+ *   Every index lives on its own cache line so the two threads never write to the same line.
+ *
+ *   mpmc_queue: every cell carries a sequence number that says whose turn it is. A producer claims position p by
+ *   advancing `enqueue_pos` with a CAS once cell p's sequence equals p, writes the value, and then publishes it by
+ *   setting the sequence to p + 1. Consumers do the mirror image and hand the cell back to the producer of lap
+ *   p + capacity.
+ *
+ *   The batched `try_push_n`/`try_pop_n` move as many items as are ready, up to n, and pay for the synchronization
+ *   (one index update, or one CAS for mpmc_queue) only once per batch.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_QUEUE_H
 #define DATA_STRUCTURES_QUEUE_H
 
 
-class queue {
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
+/**
+ * A bounded single-producer single-consumer ring buffer.
+ */
+template <typename T>
+class spsc_queue {
+public:
+    /**
+     * @param capacity minimum number of items the queue can hold; rounded up to a power of two
+     */
+    explicit spsc_queue(size_t capacity);
+    ~spsc_queue();
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+
+    /**
+     * Producer only.
+     *
+     * @return false if the queue is full
+     */
+    bool try_push(const T& value) { return emplace(value); }
+    bool try_push(T&& value) { return emplace(std::move(value)); }
+    /**
+     * Producer only. Pushes up to `n` items from `first`.
+     *
+     * @return the number of items pushed
+     */
+    template <typename It>
+    size_t try_push_n(It first, size_t n);
+    /**
+     * Consumer only.
+     *
+     * @return false if the queue is empty
+     */
+    bool try_pop(T& out);
+    /**
+     * Consumer only. Pops up to `n` items into `out`.
+     *
+     * @return the number of items popped
+     */
+    template <typename OutIt>
+    size_t try_pop_n(OutIt out, size_t n);
+
+
+    /**
+     * @return the number of items queued. Only a snapshot when other threads are active.
+     */
+    size_t size() const {
+        // Read head first, so tail cannot be behind it; items pushed after a pop in between can still take the
+        //   difference past the capacity, so clamp it
+        size_t dequeued = head.load(std::memory_order_acquire);
+        size_t enqueued = tail.load(std::memory_order_acquire);
+        size_t queued = enqueued > dequeued ? enqueued - dequeued : 0;
+        return queued < capacity() ? queued : capacity();
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask + 1; }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    static const size_t CACHE_LINE = 64;
+
+    // Read-only after construction
+    size_t mask;
+    std::unique_ptr<storage[]> buffer;
+    char pad0[CACHE_LINE];
+
+    // Consumer side
+    std::atomic<size_t> head;
+    size_t cached_tail = 0;
+    char pad1[CACHE_LINE];
+
+    // Producer side
+    std::atomic<size_t> tail;
+    size_t cached_head = 0;
+    char pad2[CACHE_LINE];
+
+    T *slot(size_t index) { return reinterpret_cast<T*>(&buffer[index & mask]); }
+
+    template <typename U>
+    bool emplace(U&& value);
 };
 
+/**
+ * A bounded multi-producer multi-consumer queue.
+ */
+template <typename T>
+class mpmc_queue {
+public:
+    /**
+     * @param capacity minimum number of items the queue can hold; rounded up to a power of two (at least 2)
+     */
+    explicit mpmc_queue(size_t capacity);
+    ~mpmc_queue();
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+
+    /**
+     * @return false if the queue is full
+     */
+    bool try_push(const T& value) { return emplace(value); }
+    bool try_push(T&& value) { return emplace(std::move(value)); }
+    /**
+     * Pushes up to `n` items from `first` into consecutive cells claimed with a single CAS.
+     *
+     * @return the number of items pushed
+     */
+    template <typename It>
+    size_t try_push_n(It first, size_t n);
+    /**
+     * @return false if the queue is empty
+     */
+    bool try_pop(T& out);
+    /**
+     * Pops up to `n` items into `out` from consecutive cells claimed with a single CAS.
+     *
+     * @return the number of items popped
+     */
+    template <typename OutIt>
+    size_t try_pop_n(OutIt out, size_t n);
+
+
+    /**
+     * @return an approximate number of items queued
+     */
+    size_t size() const {
+        size_t enqueued = enqueue_pos.load(std::memory_order_relaxed);
+        size_t dequeued = dequeue_pos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask + 1; }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    struct cell {
+        std::atomic<size_t> sequence;
+        storage data;
+    };
+
+    static const size_t CACHE_LINE = 64;
+
+    size_t mask;
+    std::unique_ptr<cell[]> cells;
+    char pad0[CACHE_LINE];
+
+    std::atomic<size_t> enqueue_pos;
+    char pad1[CACHE_LINE];
+
+    std::atomic<size_t> dequeue_pos;
+    char pad2[CACHE_LINE];
+
+    T *value_of(cell& c) { return reinterpret_cast<T*>(&c.data); }
+
+    template <typename U>
+    bool emplace(U&& value);
+    size_t claim(std::atomic<size_t>& position, size_t lag, size_t n, size_t& first);
+};
+
+
+namespace queue_detail {
+
+inline size_t round_up_pow2(size_t n) {
+    size_t rounded = 1;
+    while(rounded < n)
+        rounded <<= 1;
+    return rounded;
+}
+
+}
+
+
+// Define spsc_queue
+
+template <typename T>
+spsc_queue<T>::spsc_queue(size_t capacity) : head(0), tail(0) {
+    if(capacity == 0)
+        throw std::invalid_argument("spsc_queue capacity must be positive");
+
+    mask = queue_detail::round_up_pow2(capacity) - 1;
+    buffer.reset(new storage[mask + 1]);
+}
+
+template <typename T>
+spsc_queue<T>::~spsc_queue() {
+    for(size_t i = head.load(std::memory_order_relaxed), end = tail.load(std::memory_order_relaxed); i != end; i++)
+        slot(i)->~T();
+}
+
+template <typename T>
+template <typename U>
+bool spsc_queue<T>::emplace(U&& value) {
+    size_t position = tail.load(std::memory_order_relaxed);
+    if(position - cached_head > mask) {
+        cached_head = head.load(std::memory_order_acquire);
+        if(position - cached_head > mask)
+            return false;
+    }
+
+    new(slot(position)) T(std::forward<U>(value));
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+template <typename It>
+size_t spsc_queue<T>::try_push_n(It first, size_t n) {
+    size_t position = tail.load(std::memory_order_relaxed);
+    size_t free = mask + 1 - (position - cached_head);
+    if(free < n) {
+        cached_head = head.load(std::memory_order_acquire);
+        free = mask + 1 - (position - cached_head);
+    }
+
+    size_t count = n < free ? n : free;
+    for(size_t i = 0; i < count; i++, ++first)
+        new(slot(position + i)) T(*first);
+
+    if(count)
+        tail.store(position + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T>
+bool spsc_queue<T>::try_pop(T& out) {
+    size_t position = head.load(std::memory_order_relaxed);
+    if(position == cached_tail) {
+        cached_tail = tail.load(std::memory_order_acquire);
+        if(position == cached_tail)
+            return false;
+    }
+
+    T *value = slot(position);
+    out = std::move(*value);
+    value->~T();
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+template <typename OutIt>
+size_t spsc_queue<T>::try_pop_n(OutIt out, size_t n) {
+    size_t position = head.load(std::memory_order_relaxed);
+    size_t available = cached_tail - position;
+    if(available < n) {
+        cached_tail = tail.load(std::memory_order_acquire);
+        available = cached_tail - position;
+    }
+
+    size_t count = n < available ? n : available;
+    for(size_t i = 0; i < count; i++, ++out) {
+        T *value = slot(position + i);
+        *out = std::move(*value);
+        value->~T();
+    }
+
+    if(count)
+        head.store(position + count, std::memory_order_release);
+    return count;
+}
+
+// End of spsc_queue definitions
+
+
+// Define mpmc_queue
+
+template <typename T>
+mpmc_queue<T>::mpmc_queue(size_t capacity) : enqueue_pos(0), dequeue_pos(0) {
+    if(capacity == 0)
+        throw std::invalid_argument("mpmc_queue capacity must be positive");
+
+    mask = queue_detail::round_up_pow2(capacity < 2 ? 2 : capacity) - 1;
+    cells.reset(new cell[mask + 1]);
+    for(size_t i = 0; i <= mask; i++)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+mpmc_queue<T>::~mpmc_queue() {
+    for(size_t i = dequeue_pos.load(std::memory_order_relaxed), end = enqueue_pos.load(std::memory_order_relaxed);
+        i != end; i++)
+        value_of(cells[i & mask])->~T();
+}
+
+template <typename T>
+template <typename U>
+bool mpmc_queue<T>::emplace(U&& value) {
+    size_t position = enqueue_pos.load(std::memory_order_relaxed);
+    cell *c;
+
+    while(true) {
+        c = &cells[position & mask];
+        size_t sequence = c->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+        if(difference == 0) {
+            if(enqueue_pos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if(difference < 0) {
+            // The cell still holds a value from the previous lap: full
+            return false;
+        } else {
+            position = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    new(value_of(*c)) T(std::forward<U>(value));
+    c->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool mpmc_queue<T>::try_pop(T& out) {
+    size_t position = dequeue_pos.load(std::memory_order_relaxed);
+    cell *c;
+
+    while(true) {
+        c = &cells[position & mask];
+        size_t sequence = c->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+        if(difference == 0) {
+            if(dequeue_pos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if(difference < 0) {
+            // Nothing has been published in this cell yet: empty
+            return false;
+        } else {
+            position = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    T *value = value_of(*c);
+    out = std::move(*value);
+    value->~T();
+    c->sequence.store(position + mask + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+size_t mpmc_queue<T>::claim(std::atomic<size_t>& position, size_t lag, size_t n, size_t& first) {
+    // A cell at position p is ready for this side once its sequence is p + lag (0 for producers, 1 for consumers).
+    //   Count the run of ready cells, then claim all of them by moving `position` past the run in one CAS. No other
+    //   thread can change those cells until `position` has moved past them, so the run is still ready if the CAS
+    //   succeeds.
+    first = position.load(std::memory_order_relaxed);
+    if(n == 0)
+        return 0;
+
+    while(true) {
+        size_t ready = 0;
+        while(ready < n && cells[(first + ready) & mask].sequence.load(std::memory_order_acquire) == first + ready + lag)
+            ready++;
+
+        if(ready == 0) {
+            size_t sequence = cells[first & mask].sequence.load(std::memory_order_acquire);
+            if(static_cast<intptr_t>(sequence) - static_cast<intptr_t>(first + lag) < 0)
+                return 0;
+            // Another thread claimed this position first
+            first = position.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        if(position.compare_exchange_weak(first, first + ready, std::memory_order_relaxed))
+            return ready;
+    }
+}
+
+template <typename T>
+template <typename It>
+size_t mpmc_queue<T>::try_push_n(It first, size_t n) {
+    size_t position;
+    size_t count = claim(enqueue_pos, 0, n, position);
+
+    for(size_t i = 0; i < count; i++, ++first) {
+        cell& c = cells[(position + i) & mask];
+        new(value_of(c)) T(*first);
+        c.sequence.store(position + i + 1, std::memory_order_release);
+    }
+    return count;
+}
+
+template <typename T>
+template <typename OutIt>
+size_t mpmc_queue<T>::try_pop_n(OutIt out, size_t n) {
+    size_t position;
+    size_t count = claim(dequeue_pos, 1, n, position);
+
+    for(size_t i = 0; i < count; i++, ++out) {
+        cell& c = cells[(position + i) & mask];
+        T *value = value_of(c);
+        *out = std::move(*value);
+        value->~T();
+        c.sequence.store(position + i + mask + 1, std::memory_order_release);
+    }
+    return count;
+}
+
+// End of mpmc_queue definitions
+
 
 #endif //DATA_STRUCTURES_QUEUE_H
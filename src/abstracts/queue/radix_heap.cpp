@@ -0,0 +1,5 @@
+/**
+ * Translation unit for a radix heap, which is a template defined entirely in its header.
+ **/
+
+#include "radix_heap.h"
@@ -0,0 +1,136 @@
+/**
+ * A monotone priority queue over unsigned 64-bit keys.
+ *
+ * What is a radix heap?
+ *   A min-priority queue that only works when the keys it hands out never decrease: every pushed key must be at
+ *   least as large as the last minimum the heap reported (through `top_key`, `top_value` or `pop`). Shortest path
+ *   distances and timer deadlines both behave this way.
+ *
+ * Why is this useful?
+ *   Pushes are O(1) and pops are amortized O(log C), where C is the largest difference between a pushed key and the
+ *   current minimum, regardless of how many items are queued. Each bucket is a plain array that is appended to and
+ *   scanned sequentially, so the constant factor is far lower than a comparison heap's.
+ *
+ * How is it implemented?
+ *   Items live in 65 buckets. Bucket 0 holds the keys equal to `last`, the last minimum reported, and bucket i
+ *   holds the keys whose highest bit differing from `last` is bit i - 1. When bucket 0 runs dry, the first non-empty
+ *   bucket is scanned for its minimum, which becomes the new `last`, and its items are redistributed; every one of
+ *   them lands in a strictly lower bucket, so an item moves at most 64 times over its lifetime.
+ **/
+
+#ifndef DATA_STRUCTURES_RADIX_HEAP_H
+#define DATA_STRUCTURES_RADIX_HEAP_H
+
+
+#include "../../primitives/bits.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * A radix heap of (key, value) pairs.
+ */
+template <typename V>
+class radix_heap {
+public:
+    radix_heap() = default;
+
+
+    /**
+     * Adds `value` with priority `key`.
+     *
+     * @throws std::invalid_argument if `key` is smaller than the last minimum reported
+     */
+    void push(uint64_t key, const V& value) { emplace(key, V(value)); }
+    void push(uint64_t key, V&& value) { emplace(key, std::move(value)); }
+    /**
+     * Removes an item with the smallest key. The heap must not be empty.
+     */
+    void pop() {
+        settle();
+        buckets[0].pop_back();
+        count--;
+    }
+    void clear();
+
+
+    /**
+     * @return the smallest key. The heap must not be empty.
+     */
+    uint64_t top_key() const {
+        settle();
+        return last;
+    }
+    /**
+     * @return the value of an item with the smallest key. The heap must not be empty.
+     */
+    const V& top_value() const {
+        settle();
+        return buckets[0].back().second;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    static const size_t BUCKETS = 65;
+
+    // Refilling bucket 0 does not change the contents of the heap, so it is allowed from the const accessors
+    mutable std::vector<std::pair<uint64_t, V>> buckets[BUCKETS];
+    mutable uint64_t last = 0;
+    size_t count = 0;
+
+    static size_t bucket_for(uint64_t key, uint64_t reference) {
+        return key == reference ? 0 : highest_set_bit(key ^ reference) + 1;
+    }
+
+    void emplace(uint64_t key, V&& value);
+    void settle() const;
+};
+
+
+template <typename V>
+void radix_heap<V>::emplace(uint64_t key, V&& value) {
+    if(key < last)
+        throw std::invalid_argument("radix_heap keys must not be smaller than the last minimum");
+
+    buckets[bucket_for(key, last)].emplace_back(key, std::move(value));
+    count++;
+}
+
+template <typename V>
+void radix_heap<V>::settle() const {
+    if(!buckets[0].empty())
+        return;
+
+    size_t index = 1;
+    while(buckets[index].empty())
+        index++;
+
+    // Every key in this bucket agrees with `last` above bit index - 1 and has that bit set, so relative to the new
+    //   minimum they all differ below it
+    std::vector<std::pair<uint64_t, V>>& source = buckets[index];
+    uint64_t minimum = source[0].first;
+    for(size_t i = 1; i < source.size(); i++)
+        if(source[i].first < minimum)
+            minimum = source[i].first;
+
+    last = minimum;
+    for(auto& item : source)
+        buckets[bucket_for(item.first, last)].push_back(std::move(item));
+    source.clear();
+}
+
+template <typename V>
+void radix_heap<V>::clear() {
+    for(auto& bucket : buckets)
+        bucket.clear();
+    last = 0;
+    count = 0;
+}
+
+
+#endif //DATA_STRUCTURES_RADIX_HEAP_H
@@ -0,0 +1,5 @@
+/**
+ * Translation unit for a hierarchical timing wheel, which is a template defined entirely in its header.
+ **/
+
+#include "timer_wheel.h"
@@ -0,0 +1,273 @@
+/**
+ * A hierarchical timing wheel for scheduling deadlines.
+ *
+ * What is a timing wheel?
+ *   A timer queue keyed by integer ticks. Timers are scheduled for a deadline, may be cancelled, and fire once the
+ *   wheel's clock is advanced past their deadline. Varghese and Lauck describe it in "Hashed and Hierarchical Timing
+ *   Wheels" (SOSP 1987); kernels and network stacks use it for timeouts.
+ *
+ * Why is this useful?
+ *   Most timeouts are cancelled long before they fire. A heap pays O(log n) to insert and again to cancel; a timing
+ *   wheel does both in O(1) by dropping the timer into a bucket chosen from its deadline's bits.
+ *
+ * How is it implemented?
+ *   The 64-bit tick space is split into 11 levels of 6 bits. A timer goes on the lowest level whose 6-bit digit is
+ *   the highest one where its deadline differs from the current time, in the slot given by that digit. Level 0
+ *   therefore holds the timers due within the current 64 ticks, level 1 those due within the current 4096, and so
+ *   on. Whenever the clock's digit at level L changes, the matching slot on level L is emptied and its timers are
+ *   re-filed on lower levels ("cascading"); a timer cascades at most once per level.
+ *
+ *   Each level keeps a 64-bit occupancy mask, so `advance` jumps straight to the next tick at which some slot has
+ *   work instead of stepping through empty ticks. Timers live in a slab of nodes linked into per-slot doubly linked
+ *   lists by 32-bit indices, so schedule and cancel never allocate once the slab has grown. A timer_id carries a
+ *   generation number, which makes cancelling a timer that already fired a harmless no-op.
+ *
+ *   Payloads must be default constructible and move assignable.
+ **/
+
+#ifndef DATA_STRUCTURES_TIMER_WHEEL_H
+#define DATA_STRUCTURES_TIMER_WHEEL_H
+
+
+#include "../../primitives/bits.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class timer_wheel {
+public:
+    typedef uint64_t timer_id;
+
+    /**
+     * @param now the starting tick
+     */
+    explicit timer_wheel(uint64_t now = 0) : current(now) {
+        for(uint32_t& head : heads)
+            head = NONE;
+        for(uint64_t& mask : occupied)
+            mask = 0;
+    }
+
+
+    /**
+     * Schedules `payload` to fire at tick `deadline`. A deadline that is not in the future is treated as due at
+     *   now() + 1: it fires on the next `advance` that moves the clock forward, not on `advance(now())`. Once the
+     *   clock has reached UINT64_MAX it cannot move forward, and such a timer stays pending until cancelled.
+     *
+     * @return an id for `cancel`
+     */
+    timer_id schedule(uint64_t deadline, const T& payload) { return emplace(deadline, T(payload)); }
+    timer_id schedule(uint64_t deadline, T&& payload) { return emplace(deadline, std::move(payload)); }
+    /**
+     * Cancels a pending timer.
+     *
+     * @return false if the timer already fired or was already cancelled
+     */
+    bool cancel(timer_id id);
+    /**
+     * Moves the clock forward to `to`, calling `expire(deadline, payload)` for each timer due at or before `to`.
+     *   Timers fire in deadline order, except that timers due on the same tick, overdue ones included, fire in no
+     *   particular order. Does nothing unless `to` > now(). The callback may schedule and cancel timers.
+     *
+     * @return the number of timers fired
+     */
+    template <typename F>
+    size_t advance(uint64_t to, F&& expire);
+
+
+    /**
+     * @return the current tick
+     */
+    uint64_t now() const { return current; }
+    /**
+     * @return the number of pending timers
+     */
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    static const uint32_t NONE = UINT32_MAX;
+    static const size_t BITS = 6;
+    static const size_t SLOTS = 64;
+    static const size_t LEVELS = 11;
+
+    struct node {
+        uint64_t deadline;
+        T payload;
+        uint32_t prev, next;
+        // Bumped whenever the node is freed, to invalidate old timer_ids
+        uint32_t generation = 0;
+        // level * SLOTS + slot, or NONE while the node is free
+        uint32_t bucket = NONE;
+    };
+
+    uint64_t current;
+    size_t count = 0;
+    std::vector<node> nodes;
+    std::vector<uint32_t> free_nodes;
+    uint32_t heads[LEVELS * SLOTS];
+    uint64_t occupied[LEVELS];
+
+    timer_id emplace(uint64_t deadline, T&& payload);
+    void file(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    uint64_t next_event() const;
+    template <typename F>
+    size_t process(uint64_t tick, F& expire);
+};
+
+
+template <typename T>
+const uint32_t timer_wheel<T>::NONE;
+
+template <typename T>
+typename timer_wheel<T>::timer_id timer_wheel<T>::emplace(uint64_t deadline, T&& payload) {
+    uint32_t index;
+    if(!free_nodes.empty()) {
+        index = free_nodes.back();
+        free_nodes.pop_back();
+        nodes[index].payload = std::move(payload);
+    } else {
+        if(nodes.size() == NONE)
+            throw std::length_error("timer_wheel has run out of timer slots");
+        index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(node{0, std::move(payload), NONE, NONE});
+    }
+
+    nodes[index].deadline = deadline;
+    file(index);
+    count++;
+    return (uint64_t(nodes[index].generation) << 32) | index;
+}
+
+template <typename T>
+void timer_wheel<T>::file(uint32_t index) {
+    node& n = nodes[index];
+    // Overdue timers are filed for the next tick. At the last tick there is no next one, and they stay pending.
+    uint64_t when = n.deadline > current ? n.deadline : current < UINT64_MAX ? current + 1 : current;
+
+    size_t level = when == current ? 0 : highest_set_bit(when ^ current) / BITS;
+    size_t slot = (when >> (level * BITS)) & (SLOTS - 1);
+    uint32_t bucket = static_cast<uint32_t>(level * SLOTS + slot);
+
+    n.bucket = bucket;
+    n.prev = NONE;
+    n.next = heads[bucket];
+    if(n.next != NONE)
+        nodes[n.next].prev = index;
+    heads[bucket] = index;
+    occupied[level] |= uint64_t(1) << slot;
+}
+
+template <typename T>
+void timer_wheel<T>::unlink(uint32_t index) {
+    node& n = nodes[index];
+    if(n.prev != NONE)
+        nodes[n.prev].next = n.next;
+    else
+        heads[n.bucket] = n.next;
+    if(n.next != NONE)
+        nodes[n.next].prev = n.prev;
+
+    if(heads[n.bucket] == NONE)
+        occupied[n.bucket / SLOTS] &= ~(uint64_t(1) << (n.bucket % SLOTS));
+}
+
+template <typename T>
+void timer_wheel<T>::release(uint32_t index) {
+    nodes[index].bucket = NONE;
+    nodes[index].generation++;
+    free_nodes.push_back(index);
+    count--;
+}
+
+template <typename T>
+bool timer_wheel<T>::cancel(timer_id id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    if(index >= nodes.size() || nodes[index].generation != uint32_t(id >> 32) || nodes[index].bucket == NONE)
+        return false;
+
+    unlink(index);
+    nodes[index].payload = T();
+    release(index);
+    return true;
+}
+
+template <typename T>
+uint64_t timer_wheel<T>::next_event() const {
+    // On level L, only slots past the clock's own digit can be occupied. The slot with digit d becomes due when the
+    //   clock reaches the current level L + 1 prefix followed by d and L zero digits.
+    uint64_t next = UINT64_MAX;
+    for(size_t level = 0; level < LEVELS; level++) {
+        size_t shift = level * BITS;
+        size_t digit = (current >> shift) & (SLOTS - 1);
+        uint64_t later = digit == SLOTS - 1 ? 0 : occupied[level] & (~uint64_t(0) << (digit + 1));
+        if(!later)
+            continue;
+
+        uint64_t prefix = shift + BITS >= 64 ? 0 : (current >> (shift + BITS)) << (shift + BITS);
+        uint64_t tick = prefix | (uint64_t(lowest_set_bit(later)) << shift);
+        if(tick < next)
+            next = tick;
+    }
+    return next;
+}
+
+template <typename T>
+template <typename F>
+size_t timer_wheel<T>::process(uint64_t tick, F& expire) {
+    size_t fired = 0;
+
+    // Cascade every level whose digit just rolled over, highest first, then fire level 0's slot
+    for(size_t level = LEVELS; level-- > 0;) {
+        size_t shift = level * BITS;
+        if(level > 0 && (tick & ((uint64_t(1) << shift) - 1)) != 0)
+            continue;
+
+        uint32_t bucket = static_cast<uint32_t>(level * SLOTS + ((tick >> shift) & (SLOTS - 1)));
+        while(heads[bucket] != NONE) {
+            uint32_t index = heads[bucket];
+            unlink(index);
+
+            if(nodes[index].deadline > tick) {
+                file(index);
+                continue;
+            }
+
+            // Free the node before calling back, so the callback can schedule timers into it
+            uint64_t deadline = nodes[index].deadline;
+            T payload = std::move(nodes[index].payload);
+            release(index);
+            expire(deadline, payload);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+template <typename T>
+template <typename F>
+size_t timer_wheel<T>::advance(uint64_t to, F&& expire) {
+    size_t fired = 0;
+
+    while(count > 0 && current < to) {
+        uint64_t tick = next_event();
+        if(tick > to)
+            break;
+
+        current = tick;
+        fired += process(tick, expire);
+    }
+
+    if(current < to)
+        current = to;
+    return fired;
+}
+
+
+#endif //DATA_STRUCTURES_TIMER_WHEEL_H
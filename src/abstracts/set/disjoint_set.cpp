@@ -1,5 +1,161 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Implementation of the sequential and concurrent disjoint-set forests.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #include "disjoint_set.h"
+
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+
+namespace {
+
+/**
+ * @return n, once it is known to fit in 32-bit indices; constructors call it before allocating anything
+ */
+size_t checked_capacity(size_t n) {
+    if(n > std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument("disjoint_set holds at most 2^32 - 1 elements");
+    return n;
+}
+
+/**
+ * A fixed pseudo-random total order on elements. Multiplying by an odd constant is a bijection on 32-bit
+ *   integers, so no two elements share a priority.
+ */
+inline uint32_t priority(uint32_t x) {
+    return x * 0x9E3779B1u;
+}
+
+}
+
+
+// Define disjoint_set
+
+disjoint_set::disjoint_set(size_t n) : parents(checked_capacity(n)), sizes(n, 1), sets(n) {
+    for(size_t i = 0; i < n; i++)
+        parents[i] = static_cast<uint32_t>(i);
+}
+
+void disjoint_set::check(size_t x) const {
+    if(x >= parents.size())
+        throw std::out_of_range("element is not in the disjoint_set");
+}
+
+size_t disjoint_set::make_set() {
+    checked_capacity(parents.size() + 1);
+
+    parents.push_back(static_cast<uint32_t>(parents.size()));
+    sizes.push_back(1);
+    sets++;
+    return parents.size() - 1;
+}
+
+size_t disjoint_set::find(size_t x) {
+    check(x);
+
+    uint32_t current = static_cast<uint32_t>(x);
+    while(parents[current] != current) {
+        // Path halving: skip over the parent on every step
+        parents[current] = parents[parents[current]];
+        current = parents[current];
+    }
+    return current;
+}
+
+bool disjoint_set::unite(size_t a, size_t b) {
+    uint32_t root_a = static_cast<uint32_t>(find(a));
+    uint32_t root_b = static_cast<uint32_t>(find(b));
+    if(root_a == root_b)
+        return false;
+
+    if(sizes[root_a] < sizes[root_b])
+        std::swap(root_a, root_b);
+
+    parents[root_b] = root_a;
+    sizes[root_a] += sizes[root_b];
+    sets--;
+    return true;
+}
+
+// End of disjoint_set definitions
+
+
+// Define concurrent_disjoint_set
+
+concurrent_disjoint_set::concurrent_disjoint_set(size_t n)
+        : parents(new std::atomic<uint32_t>[checked_capacity(n)]), length(n), sets(n) {
+    for(size_t i = 0; i < n; i++)
+        parents[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+}
+
+void concurrent_disjoint_set::check(size_t x) const {
+    if(x >= length)
+        throw std::out_of_range("element is not in the disjoint_set");
+}
+
+uint32_t concurrent_disjoint_set::root_of(uint32_t x) {
+    while(true) {
+        uint32_t parent = parents[x].load(std::memory_order_acquire);
+        if(parent == x)
+            return x;
+
+        uint32_t grandparent = parents[parent].load(std::memory_order_acquire);
+        if(parent == grandparent)
+            return parent;
+
+        // Path halving with CAS. If another thread already changed x's parent the CAS fails harmlessly, since
+        //   parents only ever move closer to the root.
+        parents[x].compare_exchange_weak(parent, grandparent, std::memory_order_acq_rel, std::memory_order_relaxed);
+        x = grandparent;
+    }
+}
+
+size_t concurrent_disjoint_set::find(size_t x) {
+    check(x);
+    return root_of(static_cast<uint32_t>(x));
+}
+
+bool concurrent_disjoint_set::unite(size_t a, size_t b) {
+    check(a);
+    check(b);
+
+    uint32_t root_a = static_cast<uint32_t>(a), root_b = static_cast<uint32_t>(b);
+    while(true) {
+        root_a = root_of(root_a);
+        root_b = root_of(root_b);
+        if(root_a == root_b)
+            return false;
+
+        // Always link the lower priority root under the higher one
+        if(priority(root_a) > priority(root_b))
+            std::swap(root_a, root_b);
+
+        uint32_t expected = root_a;
+        if(parents[root_a].compare_exchange_strong(expected, root_b, std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed)) {
+            sets.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        // root_a gained a parent in the meantime; search again from where we are
+    }
+}
+
+bool concurrent_disjoint_set::connected(size_t a, size_t b) {
+    check(a);
+    check(b);
+
+    uint32_t root_a = static_cast<uint32_t>(a), root_b = static_cast<uint32_t>(b);
+    while(true) {
+        root_a = root_of(root_a);
+        root_b = root_of(root_b);
+        if(root_a == root_b)
+            return true;
+        // If root_a is still a root then a and b were in different sets at the moment it was read
+        if(parents[root_a].load(std::memory_order_acquire) == root_a)
+            return false;
+    }
+}
@@ -1,13 +1,133 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Disjoint-set forests (union-find) over the elements 0..n-1.
+ *
+ * What is a disjoint-set?
+ *   It tracks a partition of elements into sets, supporting two operations: `find` the set an element belongs to,
+ *   and `unite` two sets into one. Every set is a tree whose root identifies the set.
+ *
+ * Why is this useful?
+ *   Connected components, Kruskal's minimum spanning tree, unification, percolation, ... With union by size and
+ *   path compression both operations run in amortized O(α(n)) time, which is effectively constant.
+ *
+ * How is it implemented?
+ *   `disjoint_set` stores parents and set sizes in two flat arrays of 32-bit indices. `find` uses path halving:
+ *   every visited node is pointed at its grandparent, which flattens the tree in a single pass without recursion.
+ *
+ *   `concurrent_disjoint_set` follows Jayanti and Tarjan: the parent array is atomic, `find` halves paths with
+ *   compare-and-swap, and `unite` links one root under the other with a single CAS. Instead of ranks (which
+ *   cannot be updated atomically together with the parent), roots are linked by a fixed pseudo-random priority
+ *   derived from the index, which keeps the expected tree depth logarithmic. No operation ever blocks; a `unite`
+ *   only retries when another thread changed one of its roots first.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_DISJOINT_SET_H
 #define DATA_STRUCTURES_DISJOINT_SET_H
 
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 class disjoint_set {
+public:
+    /**
+     * Construct `n` singleton sets {0}, {1}, ..., {n-1}.
+     *
+     * @throws std::invalid_argument if `n` does not fit in 32 bits
+     */
+    explicit disjoint_set(size_t n = 0);
+
+
+    /**
+     * Adds a new singleton set.
+     *
+     * @return the new element
+     */
+    size_t make_set();
+    /**
+     * @return the representative (root) of the set holding `x`
+     */
+    size_t find(size_t x);
+    /**
+     * Merges the sets holding `a` and `b`, attaching the smaller set under the larger one.
+     *
+     * @return true if they were in different sets
+     */
+    bool unite(size_t a, size_t b);
+    /**
+     * @return true if `a` and `b` are in the same set
+     */
+    bool connected(size_t a, size_t b) { return find(a) == find(b); }
+
+
+    /**
+     * @return the number of elements in the set holding `x`
+     */
+    size_t set_size(size_t x) { return sizes[find(x)]; }
+    /**
+     * @return the number of disjoint sets
+     */
+    size_t count() const { return sets; }
+    /**
+     * @return the number of elements
+     */
+    size_t size() const { return parents.size(); }
+
+private:
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> sizes;
+    size_t sets = 0;
+
+    void check(size_t x) const;
+};
+
+class concurrent_disjoint_set {
+public:
+    /**
+     * Construct `n` singleton sets {0}, {1}, ..., {n-1}. The element count is fixed.
+     *
+     * @throws std::invalid_argument if `n` does not fit in 32 bits
+     */
+    explicit concurrent_disjoint_set(size_t n);
+
+
+    /**
+     * @return the representative (root) of the set holding `x`. Safe to call from any thread; the root may change
+     *   as soon as another thread unites its set.
+     */
+    size_t find(size_t x);
+    /**
+     * Merges the sets holding `a` and `b`. Safe to call from any thread.
+     *
+     * @return true if this call merged two different sets
+     */
+    bool unite(size_t a, size_t b);
+    /**
+     * @return true if `a` and `b` are in the same set. Accurate with respect to some moment during the call.
+     */
+    bool connected(size_t a, size_t b);
+
+
+    /**
+     * @return the number of disjoint sets
+     */
+    size_t count() const { return sets.load(std::memory_order_relaxed); }
+    /**
+     * @return the number of elements
+     */
+    size_t size() const { return length; }
+
+private:
+    std::unique_ptr<std::atomic<uint32_t>[]> parents;
+    size_t length;
+    std::atomic<size_t> sets;
 
+    uint32_t root_of(uint32_t x);
+    void check(size_t x) const;
 };
 
 
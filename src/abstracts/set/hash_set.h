@@ -1,13 +1,35 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * An unordered set.
+ *
+ * Only the 32-bit unsigned integer specialization exists so far. It is backed by a `roaring_bitmap`: membership
+ *   tests cost a short binary search over container keys plus one probe inside a container, which is competitive
+ *   with hashing, while the memory footprint is a small fraction of a node based hash set.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_HASH_SET_H
 #define DATA_STRUCTURES_HASH_SET_H
 
 
-class hash_set {
+#include "roaring_bitmap.h"
 
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+template <typename T, typename Hash = std::hash<T>>
+class hash_set;
+
+/**
+ * Sets of 32-bit IDs are stored as Roaring bitmaps.
+ */
+template <>
+class hash_set<uint32_t, std::hash<uint32_t>> : public roaring_bitmap {
+public:
+    hash_set() = default;
+    hash_set(roaring_bitmap other) : roaring_bitmap(std::move(other)) {}
+    hash_set(const uint32_t *values, size_t count) : roaring_bitmap(values, count) {}
 };
 
 
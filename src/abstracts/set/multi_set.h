@@ -1,13 +1,621 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Multisets (bags): sets that remember how many times each element was added.
+ *
+ * What is a multiset?
+ *   A set where elements may appear more than once. It is really a map from each distinct element to a count, which
+ *   makes it the natural structure for frequency counting.
+ *
+ * How is it implemented?
+ *   `multi_set` is an open addressing hash table with linear probing. Each slot holds the element and a 32-bit
+ *   count inline; a count of zero marks an empty slot, so no separate occupancy data is needed. The rare count that
+ *   outgrows 31 bits is moved to a side array of 64-bit counters and the slot keeps its index instead, flagged by
+ *   the top bit. Erasure uses backward shift deletion so the table never accumulates tombstones.
+ *
+ *   `approximate_multi_set` trades exactness for memory that does not grow with the number of distinct elements:
+ *     - a count-min sketch (`count_min_sketch`) estimates the count of any element. Estimates never undercount
+ *       and overcount by at most 2N/width with probability 1 - (1/2)^depth, N being the total count.
+ *     - a SpaceSaving summary (`space_saving`) tracks the k most frequent elements (heavy hitters). Any element
+ *       whose count exceeds N/k is guaranteed to be in it.
+ *   Both summaries can be merged, so each worker thread can count into its own copy and the copies can be combined
+ *   at the end without any locking on the hot path.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_MULTI_SET_H
 #define DATA_STRUCTURES_MULTI_SET_H
 
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace multi_set_detail {
+
+/**
+ * Scrambles a hash value (MurmurHash3's finalizer). std::hash is the identity for integers on common standard
+ *   libraries, which would make linear probing and sketch rows cluster badly.
+ */
+inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+}
+
+template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
 class multi_set {
+    static const uint32_t BIG_FLAG = uint32_t(1) << 31;
+
+    struct slot {
+        T key = T();
+        // 0: empty; BIG_FLAG set: index into big_counts; otherwise the count itself
+        uint32_t count = 0;
+    };
+
+public:
+    class iterator {
+    public:
+        iterator() = default;
+
+        const T& key() const { return owner->slots[index].key; }
+        uint64_t count() const { return owner->decode(owner->slots[index]); }
+
+        iterator& operator++() {
+            index++;
+            skip_empty();
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        friend class multi_set;
+        iterator(const multi_set *owner, size_t index) : owner(owner), index(index) { skip_empty(); }
+
+        void skip_empty() {
+            while(index < owner->slots.size() && owner->slots[index].count == 0)
+                index++;
+        }
+
+        const multi_set *owner = nullptr;
+        size_t index = 0;
+    };
+
+    /**
+     * Construct an empty multiset with room for about `expected` distinct elements before it needs to grow.
+     */
+    explicit multi_set(size_t expected = 0) { rehash(capacity_for(expected)); }
+
+
+    /**
+     * Adds `n` copies of `value`.
+     *
+     * @return the new count of `value`
+     */
+    uint64_t insert(const T& value, uint64_t n = 1);
+    /**
+     * Removes up to `n` copies of `value`.
+     *
+     * @return the number of copies actually removed
+     */
+    uint64_t erase(const T& value, uint64_t n = 1);
+    /**
+     * Removes every copy of `value`.
+     *
+     * @return the number of copies removed
+     */
+    uint64_t erase_all(const T& value) { return erase(value, UINT64_MAX); }
+    /**
+     * Adds every count from `other` into this multiset.
+     */
+    void merge(const multi_set& other) {
+        for(iterator it = other.begin(); it != other.end(); ++it)
+            insert(it.key(), it.count());
+    }
+    /**
+     * Removes every element.
+     */
+    void clear() {
+        slots.assign(slots.size(), slot());
+        big_counts.clear();
+        free_big.clear();
+        distinct = 0;
+        total = 0;
+    }
+
+
+    /**
+     * @return how many copies of `value` are present
+     */
+    uint64_t count(const T& value) const {
+        size_t index = find_slot(value);
+        return slots[index].count ? decode(slots[index]) : 0;
+    }
+    bool contains(const T& value) const { return slots[find_slot(value)].count != 0; }
+
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, slots.size()); }
+
+    /**
+     * @return the total number of copies of all elements
+     */
+    uint64_t size() const { return total; }
+    /**
+     * @return the number of distinct elements
+     */
+    size_t distinct_size() const { return distinct; }
+    bool empty() const { return total == 0; }
+    /**
+     * @return the heap memory used, in bytes
+     */
+    size_t memory_usage() const {
+        return slots.capacity() * sizeof(slot) + big_counts.capacity() * sizeof(uint64_t) +
+               free_big.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    std::vector<slot> slots;
+    std::vector<uint64_t> big_counts;
+    std::vector<uint32_t> free_big;
+    size_t mask = 0;
+    size_t distinct = 0;
+    uint64_t total = 0;
+    Hash hasher;
+    KeyEqual equal;
+
+    static size_t capacity_for(size_t expected) {
+        size_t capacity = 16;
+        while(capacity * 3 / 4 < expected)
+            capacity *= 2;
+        return capacity;
+    }
+
+    size_t ideal_slot(const T& value) const {
+        return static_cast<size_t>(multi_set_detail::mix(hasher(value))) & mask;
+    }
+
+    uint64_t decode(const slot& s) const {
+        return (s.count & BIG_FLAG) ? big_counts[s.count & ~BIG_FLAG] : s.count;
+    }
+
+    void encode(slot& s, uint64_t value);
+    void release(slot& s);
+    size_t find_slot(const T& value) const;
+    void rehash(size_t capacity);
+};
+
+
+template <typename T, typename H, typename E>
+size_t multi_set<T, H, E>::find_slot(const T& value) const {
+    size_t index = ideal_slot(value);
+    while(slots[index].count != 0 && !equal(slots[index].key, value))
+        index = (index + 1) & mask;
+    return index;
+}
+
+template <typename T, typename H, typename E>
+void multi_set<T, H, E>::encode(slot& s, uint64_t value) {
+    if(s.count & BIG_FLAG) {
+        big_counts[s.count & ~BIG_FLAG] = value;
+        return;
+    }
+
+    if(value < BIG_FLAG) {
+        s.count = static_cast<uint32_t>(value);
+        return;
+    }
+
+    // Spill to a 64-bit counter, reusing a freed one if possible
+    uint32_t index;
+    if(!free_big.empty()) {
+        index = free_big.back();
+        free_big.pop_back();
+        big_counts[index] = value;
+    } else {
+        index = static_cast<uint32_t>(big_counts.size());
+        big_counts.push_back(value);
+    }
+    s.count = index | BIG_FLAG;
+}
+
+template <typename T, typename H, typename E>
+void multi_set<T, H, E>::release(slot& s) {
+    if(s.count & BIG_FLAG)
+        free_big.push_back(s.count & ~BIG_FLAG);
+    s.count = 0;
+    s.key = T();
+}
+
+template <typename T, typename H, typename E>
+void multi_set<T, H, E>::rehash(size_t capacity) {
+    std::vector<slot> old;
+    old.swap(slots);
+    slots.resize(capacity);
+    mask = capacity - 1;
+
+    for(slot& s : old) {
+        if(s.count == 0)
+            continue;
+        size_t index = ideal_slot(s.key);
+        while(slots[index].count != 0)
+            index = (index + 1) & mask;
+        slots[index] = std::move(s);
+    }
+}
+
+template <typename T, typename H, typename E>
+uint64_t multi_set<T, H, E>::insert(const T& value, uint64_t n) {
+    if(n == 0)
+        return count(value);
+
+    size_t index = find_slot(value);
+    if(slots[index].count == 0) {
+        if((distinct + 1) * 4 > slots.size() * 3) {
+            rehash(slots.size() * 2);
+            index = find_slot(value);
+        }
+        slots[index].key = value;
+        distinct++;
+    }
+
+    uint64_t updated = decode(slots[index]) + n;
+    encode(slots[index], updated);
+    total += n;
+    return updated;
+}
+
+template <typename T, typename H, typename E>
+uint64_t multi_set<T, H, E>::erase(const T& value, uint64_t n) {
+    size_t index = find_slot(value);
+    if(slots[index].count == 0 || n == 0)
+        return 0;
+
+    uint64_t current = decode(slots[index]);
+    if(n < current) {
+        if(current - n < BIG_FLAG && (slots[index].count & BIG_FLAG)) {
+            // Move back inline
+            free_big.push_back(slots[index].count & ~BIG_FLAG);
+            slots[index].count = static_cast<uint32_t>(current - n);
+        } else {
+            encode(slots[index], current - n);
+        }
+        total -= n;
+        return n;
+    }
+
+    total -= current;
+    distinct--;
+    release(slots[index]);
+
+    // Backward shift deletion: pull later entries of the probe chain into the hole
+    size_t hole = index, next = index;
+    while(true) {
+        next = (next + 1) & mask;
+        if(slots[next].count == 0)
+            break;
+
+        size_t ideal = ideal_slot(slots[next].key);
+        // Move it if its ideal slot is not cyclically within (hole, next]
+        bool movable = hole <= next ? (ideal <= hole || ideal > next) : (ideal <= hole && ideal > next);
+        if(movable) {
+            slots[hole] = std::move(slots[next]);
+            slots[next].count = 0;
+            slots[next].key = T();
+            hole = next;
+        }
+    }
+
+    return current;
+}
+
+
+/**
+ * A count-min sketch: `depth` rows of `width` counters. Each element increments one counter per row, and its
+ *   estimate is the minimum of those counters.
+ */
+template <typename T, typename Hash = std::hash<T>>
+class count_min_sketch {
+public:
+    /**
+     * @param width counters per row, rounded up to a power of two
+     * @param depth number of rows
+     */
+    count_min_sketch(size_t width, size_t depth) : depth(depth == 0 ? 1 : depth) {
+        size_t rounded = 1;
+        while(rounded < width)
+            rounded *= 2;
+        this->width = rounded;
+        counters.assign(this->width * this->depth, 0);
+    }
+
+    void insert(const T& value, uint64_t n = 1) {
+        uint64_t h = multi_set_detail::mix(hasher(value));
+        uint32_t h1 = static_cast<uint32_t>(h), h2 = static_cast<uint32_t>(h >> 32) | 1;
+
+        for(size_t row = 0; row < depth; row++)
+            counters[row * width + ((h1 + row * h2) & (width - 1))] += n;
+        total += n;
+    }
+
+    /**
+     * @return an upper bound on the count of `value`
+     */
+    uint64_t estimate(const T& value) const {
+        uint64_t h = multi_set_detail::mix(hasher(value));
+        uint32_t h1 = static_cast<uint32_t>(h), h2 = static_cast<uint32_t>(h >> 32) | 1;
+
+        uint64_t best = UINT64_MAX;
+        for(size_t row = 0; row < depth; row++)
+            best = std::min(best, counters[row * width + ((h1 + row * h2) & (width - 1))]);
+        return best;
+    }
+
+    /**
+     * Adds the counters of `other`, which must have the same dimensions.
+     *
+     * @throws std::invalid_argument if the dimensions differ
+     */
+    void merge(const count_min_sketch& other) {
+        if(width != other.width || depth != other.depth)
+            throw std::invalid_argument("count_min_sketch dimensions differ");
+        for(size_t i = 0; i < counters.size(); i++)
+            counters[i] += other.counters[i];
+        total += other.total;
+    }
+
+    void clear() {
+        std::fill(counters.begin(), counters.end(), 0);
+        total = 0;
+    }
+
+    uint64_t size() const { return total; }
+    size_t memory_usage() const { return counters.capacity() * sizeof(uint64_t); }
+
+private:
+    size_t width;
+    size_t depth;
+    std::vector<uint64_t> counters;
+    uint64_t total = 0;
+    Hash hasher;
+};
+
+
+/**
+ * The SpaceSaving heavy hitters summary: at most `capacity` monitored elements. An unmonitored element evicts the
+ *   element with the smallest count and inherits that count as its possible overestimate.
+ */
+template <typename T, typename Hash = std::hash<T>>
+class space_saving {
+public:
+    struct entry {
+        T value;
+        uint64_t count;
+        // The count may overestimate the true count by at most this much
+        uint64_t error;
+    };
+
+    explicit space_saving(size_t capacity) : capacity(capacity == 0 ? 1 : capacity) {
+        heap.reserve(this->capacity);
+        positions.reserve(this->capacity);
+    }
+
+    void insert(const T& value, uint64_t n = 1);
+    /**
+     * Merges `other` into this summary (Agarwal et al., "Mergeable Summaries"). The result keeps this summary's
+     *   capacity and the same error guarantee for the combined stream.
+     */
+    void merge(const space_saving& other);
+
+    /**
+     * @return an upper bound on the count of `value`
+     */
+    uint64_t estimate(const T& value) const {
+        auto it = positions.find(value);
+        if(it != positions.end())
+            return heap[it->second].count;
+        return full() ? heap[0].count : 0;
+    }
+    /**
+     * @return the monitored elements, most frequent first
+     */
+    std::vector<entry> top() const {
+        std::vector<entry> sorted(heap);
+        std::sort(sorted.begin(), sorted.end(), [](const entry& a, const entry& b) { return a.count > b.count; });
+        return sorted;
+    }
+
+    void clear() {
+        heap.clear();
+        positions.clear();
+        total = 0;
+    }
+
+    uint64_t size() const { return total; }
+    size_t memory_usage() const {
+        return heap.capacity() * sizeof(entry) + positions.bucket_count() * sizeof(void*) +
+               positions.size() * (sizeof(std::pair<const T, size_t>) + sizeof(void*));
+    }
+
+private:
+    size_t capacity;
+    // Min-heap on count, plus each monitored element's position in it
+    std::vector<entry> heap;
+    std::unordered_map<T, size_t, Hash> positions;
+    uint64_t total = 0;
+
+    bool full() const { return heap.size() == capacity; }
+    void swap_entries(size_t a, size_t b);
+    void sift_up(size_t index);
+    void sift_down(size_t index);
+};
+
+template <typename T, typename H>
+void space_saving<T, H>::swap_entries(size_t a, size_t b) {
+    std::swap(heap[a], heap[b]);
+    positions[heap[a].value] = a;
+    positions[heap[b].value] = b;
+}
+
+template <typename T, typename H>
+void space_saving<T, H>::sift_up(size_t index) {
+    while(index > 0) {
+        size_t parent = (index - 1) / 2;
+        if(heap[parent].count <= heap[index].count)
+            break;
+        swap_entries(parent, index);
+        index = parent;
+    }
+}
+
+template <typename T, typename H>
+void space_saving<T, H>::sift_down(size_t index) {
+    while(true) {
+        size_t smallest = index, left = 2 * index + 1, right = left + 1;
+        if(left < heap.size() && heap[left].count < heap[smallest].count)
+            smallest = left;
+        if(right < heap.size() && heap[right].count < heap[smallest].count)
+            smallest = right;
+        if(smallest == index)
+            return;
+        swap_entries(index, smallest);
+        index = smallest;
+    }
+}
+
+template <typename T, typename H>
+void space_saving<T, H>::insert(const T& value, uint64_t n) {
+    total += n;
+
+    auto it = positions.find(value);
+    if(it != positions.end()) {
+        heap[it->second].count += n;
+        sift_down(it->second);
+        return;
+    }
+
+    if(!full()) {
+        heap.push_back(entry{value, n, 0});
+        positions[value] = heap.size() - 1;
+        sift_up(heap.size() - 1);
+        return;
+    }
+
+    // Replace the minimum, which inherits the evicted count as its error
+    entry& minimum = heap[0];
+    positions.erase(minimum.value);
+    minimum.error = minimum.count;
+    minimum.count += n;
+    minimum.value = value;
+    positions[value] = 0;
+    sift_down(0);
+}
+
+template <typename T, typename H>
+void space_saving<T, H>::merge(const space_saving& other) {
+    uint64_t this_min = full() ? heap[0].count : 0;
+    uint64_t other_min = other.full() ? other.heap[0].count : 0;
+
+    std::vector<entry> combined;
+    combined.reserve(heap.size() + other.heap.size());
+
+    for(const entry& e : heap) {
+        auto it = other.positions.find(e.value);
+        if(it != other.positions.end()) {
+            const entry& o = other.heap[it->second];
+            combined.push_back(entry{e.value, e.count + o.count, e.error + o.error});
+        } else {
+            combined.push_back(entry{e.value, e.count + other_min, e.error + other_min});
+        }
+    }
+    for(const entry& o : other.heap) {
+        if(positions.find(o.value) == positions.end())
+            combined.push_back(entry{o.value, o.count + this_min, o.error + this_min});
+    }
+
+    if(combined.size() > capacity) {
+        std::nth_element(combined.begin(), combined.begin() + capacity, combined.end(),
+                         [](const entry& a, const entry& b) { return a.count > b.count; });
+        combined.resize(capacity);
+    }
+
+    heap.swap(combined);
+    positions.clear();
+    for(size_t i = 0; i < heap.size(); i++)
+        positions[heap[i].value] = i;
+    for(size_t i = heap.size() / 2; i-- > 0;)
+        sift_down(i);
+
+    total += other.total;
+}
+
+
+/**
+ * A multiset with bounded memory: approximate counts from a count-min sketch, plus the exact identities of the
+ *   most frequent elements from a SpaceSaving summary.
+ */
+template <typename T, typename Hash = std::hash<T>>
+class approximate_multi_set {
+public:
+    /**
+     * @param width count-min sketch counters per row
+     * @param depth count-min sketch rows
+     * @param heavy_hitters number of most frequent elements to track (0 disables tracking)
+     */
+    approximate_multi_set(size_t width, size_t depth, size_t heavy_hitters = 0)
+            : sketch(width, depth), heavy(heavy_hitters), track_heavy(heavy_hitters > 0) {}
+
+    void insert(const T& value, uint64_t n = 1) {
+        sketch.insert(value, n);
+        if(track_heavy)
+            heavy.insert(value, n);
+    }
+
+    /**
+     * @return an estimate of the count of `value` that is never too low
+     */
+    uint64_t count(const T& value) const { return sketch.estimate(value); }
+    /**
+     * @return the most frequent elements seen, most frequent first, with their estimated counts
+     */
+    std::vector<typename space_saving<T, Hash>::entry> heavy_hitters() const {
+        return track_heavy ? heavy.top() : std::vector<typename space_saving<T, Hash>::entry>();
+    }
+
+    /**
+     * Adds the counts of `other`, which must have been built with the same parameters.
+     *
+     * @throws std::invalid_argument if the sketch dimensions differ
+     */
+    void merge(const approximate_multi_set& other) {
+        sketch.merge(other.sketch);
+        if(track_heavy)
+            heavy.merge(other.heavy);
+    }
+
+    void clear() {
+        sketch.clear();
+        heavy.clear();
+    }
+
+    uint64_t size() const { return sketch.size(); }
+    size_t memory_usage() const { return sketch.memory_usage() + (track_heavy ? heavy.memory_usage() : 0); }
 
+private:
+    count_min_sketch<T, Hash> sketch;
+    space_saving<T, Hash> heavy;
+    bool track_heavy;
 };
 
 
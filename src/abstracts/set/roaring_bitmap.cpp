@@ -0,0 +1,988 @@
+/**
+ * Implementation of a Roaring bitmap.
+ **/
+
+#include "roaring_bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+const uint32_t ARRAY_MAX = 4096;
+const size_t BITMAP_WORDS = 1024;
+const size_t BITMAP_BYTES = BITMAP_WORDS * sizeof(uint64_t);
+
+const uint32_t SERIAL_COOKIE_NO_RUN = 12346;
+const uint32_t SERIAL_COOKIE = 12347;
+const size_t NO_OFFSET_THRESHOLD = 4;
+
+inline uint32_t popcount64(uint64_t word) {
+#if defined(__GNUC__)
+    return static_cast<uint32_t>(__builtin_popcountll(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<uint32_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline uint32_t count_trailing_zeros(uint64_t word) {
+#if defined(__GNUC__)
+    return static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+    uint32_t count = 0;
+    while(!(word & 1)) {
+        word >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+inline bool test_bit(const std::vector<uint64_t>& words, uint32_t bit) {
+    return (words[bit >> 6] >> (bit & 63)) & 1;
+}
+
+inline void set_bit(std::vector<uint64_t>& words, uint32_t bit) {
+    words[bit >> 6] |= uint64_t(1) << (bit & 63);
+}
+
+/**
+ * Sets bits [first,last] (inclusive).
+ */
+void set_bit_range(std::vector<uint64_t>& words, uint32_t first, uint32_t last) {
+    size_t first_word = first >> 6, last_word = last >> 6;
+    uint64_t first_mask = ~uint64_t(0) << (first & 63);
+    uint64_t last_mask = ~uint64_t(0) >> (63 - (last & 63));
+
+    if(first_word == last_word) {
+        words[first_word] |= first_mask & last_mask;
+        return;
+    }
+
+    words[first_word] |= first_mask;
+    for(size_t i = first_word + 1; i < last_word; i++)
+        words[i] = ~uint64_t(0);
+    words[last_word] |= last_mask;
+}
+
+// Word-wise combinators for bitmap containers. Each has a scalar form plus SIMD forms where the target has them.
+
+struct or_op {
+    static uint64_t apply(uint64_t a, uint64_t b) { return a | b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+#endif
+#if defined(__AVX2__)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#endif
+};
+
+struct and_op {
+    static uint64_t apply(uint64_t a, uint64_t b) { return a & b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+#endif
+#if defined(__AVX2__)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#endif
+};
+
+struct andnot_op {
+    static uint64_t apply(uint64_t a, uint64_t b) { return a & ~b; }
+#if defined(__SSE2__)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_andnot_si128(b, a); }
+#endif
+#if defined(__AVX2__)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+#endif
+};
+
+/**
+ * out = a OP b over a whole bitmap container.
+ *
+ * @return the cardinality of the result
+ */
+template <typename Op>
+uint32_t combine_words(const uint64_t *a, const uint64_t *b, uint64_t *out) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for(; i + 4 <= BITMAP_WORDS; i += 4) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), Op::apply(va, vb));
+    }
+#elif defined(__SSE2__)
+    for(; i + 2 <= BITMAP_WORDS; i += 2) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), Op::apply(va, vb));
+    }
+#endif
+    for(; i < BITMAP_WORDS; i++)
+        out[i] = Op::apply(a[i], b[i]);
+
+    uint32_t cardinality = 0;
+    for(i = 0; i < BITMAP_WORDS; i++)
+        cardinality += popcount64(out[i]);
+    return cardinality;
+}
+
+// Little endian encoding helpers for serialization
+
+void put16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+void put64(std::vector<uint8_t>& out, uint64_t value) {
+    put32(out, static_cast<uint32_t>(value));
+    put32(out, static_cast<uint32_t>(value >> 32));
+}
+
+struct reader {
+    const uint8_t *data;
+    size_t length, position;
+
+    void need(size_t bytes) {
+        if(length - position < bytes)
+            throw std::invalid_argument("roaring_bitmap: serialized data is truncated");
+    }
+
+    uint16_t get16() {
+        need(2);
+        uint16_t value = static_cast<uint16_t>(data[position] | (data[position + 1] << 8));
+        position += 2;
+        return value;
+    }
+
+    uint32_t get32() {
+        uint32_t low = get16();
+        return low | (uint32_t(get16()) << 16);
+    }
+
+    uint64_t get64() {
+        uint64_t low = get32();
+        return low | (uint64_t(get32()) << 32);
+    }
+};
+
+}
+
+
+// Define the container helper struct
+
+bool roaring_bitmap::container::contains(uint16_t value) const {
+    switch(type) {
+        case ARRAY:
+            return std::binary_search(values.begin(), values.end(), value);
+        case BITMAP:
+            return test_bit(words, value);
+        case RUN: {
+            // Find the last run starting at or before `value`
+            size_t low = 0, high = values.size() / 2;
+            while(low < high) {
+                size_t mid = (low + high) / 2;
+                if(values[2 * mid] <= value)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+            return low > 0 && uint32_t(value - values[2 * (low - 1)]) <= values[2 * (low - 1) + 1];
+        }
+    }
+    return false;
+}
+
+bool roaring_bitmap::container::insert(uint16_t value) {
+    if(type == RUN) {
+        if(contains(value))
+            return false;
+        materialize();
+    }
+
+    if(type == ARRAY) {
+        auto it = std::lower_bound(values.begin(), values.end(), value);
+        if(it != values.end() && *it == value)
+            return false;
+
+        if(cardinality < ARRAY_MAX) {
+            values.insert(it, value);
+            cardinality++;
+            return true;
+        }
+        to_bitmap();
+    }
+
+    if(test_bit(words, value))
+        return false;
+    set_bit(words, value);
+    cardinality++;
+    return true;
+}
+
+bool roaring_bitmap::container::erase(uint16_t value) {
+    if(type == RUN) {
+        if(!contains(value))
+            return false;
+        materialize();
+    }
+
+    if(type == ARRAY) {
+        auto it = std::lower_bound(values.begin(), values.end(), value);
+        if(it == values.end() || *it != value)
+            return false;
+        values.erase(it);
+        cardinality--;
+        return true;
+    }
+
+    if(!test_bit(words, value))
+        return false;
+    words[value >> 6] &= ~(uint64_t(1) << (value & 63));
+    if(--cardinality <= ARRAY_MAX)
+        to_array();
+    return true;
+}
+
+void roaring_bitmap::container::to_array() {
+    if(type == ARRAY)
+        return;
+
+    std::vector<uint16_t> out;
+    out.reserve(cardinality);
+
+    if(type == BITMAP) {
+        for(size_t i = 0; i < BITMAP_WORDS; i++) {
+            for(uint64_t word = words[i]; word; word &= word - 1)
+                out.push_back(static_cast<uint16_t>(i * 64 + count_trailing_zeros(word)));
+        }
+        std::vector<uint64_t>().swap(words);
+    } else {
+        for(size_t i = 0; i < values.size(); i += 2) {
+            for(uint32_t v = values[i]; v <= uint32_t(values[i]) + values[i + 1]; v++)
+                out.push_back(static_cast<uint16_t>(v));
+        }
+    }
+
+    values.swap(out);
+    type = ARRAY;
+}
+
+void roaring_bitmap::container::to_bitmap() {
+    if(type == BITMAP)
+        return;
+
+    words.assign(BITMAP_WORDS, 0);
+    if(type == ARRAY) {
+        for(uint16_t v : values)
+            set_bit(words, v);
+    } else {
+        for(size_t i = 0; i < values.size(); i += 2)
+            set_bit_range(words, values[i], uint32_t(values[i]) + values[i + 1]);
+    }
+
+    std::vector<uint16_t>().swap(values);
+    type = BITMAP;
+}
+
+void roaring_bitmap::container::to_runs() {
+    if(type == RUN)
+        return;
+
+    std::vector<uint16_t> runs;
+    runs.reserve(2 * run_count());
+
+    auto extend = [&runs](uint16_t v) {
+        if(!runs.empty() && uint32_t(runs[runs.size() - 2]) + runs.back() + 1 == v) {
+            runs.back()++;
+        } else {
+            runs.push_back(v);
+            runs.push_back(0);
+        }
+    };
+
+    if(type == ARRAY) {
+        for(uint16_t v : values)
+            extend(v);
+    } else {
+        for(size_t i = 0; i < BITMAP_WORDS; i++) {
+            for(uint64_t word = words[i]; word; word &= word - 1)
+                extend(static_cast<uint16_t>(i * 64 + count_trailing_zeros(word)));
+        }
+        std::vector<uint64_t>().swap(words);
+    }
+
+    values.swap(runs);
+    type = RUN;
+}
+
+void roaring_bitmap::container::materialize() {
+    if(type != RUN)
+        return;
+
+    if(cardinality <= ARRAY_MAX)
+        to_array();
+    else
+        to_bitmap();
+}
+
+size_t roaring_bitmap::container::run_count() const {
+    switch(type) {
+        case ARRAY: {
+            size_t runs = values.empty() ? 0 : 1;
+            for(size_t i = 1; i < values.size(); i++)
+                runs += values[i] != values[i - 1] + 1 ? 1 : 0;
+            return runs;
+        }
+        case BITMAP: {
+            // A run starts wherever a set bit follows a clear bit
+            size_t runs = 0;
+            uint64_t carry = 0;
+            for(size_t i = 0; i < BITMAP_WORDS; i++) {
+                runs += popcount64(words[i] & ~((words[i] << 1) | carry));
+                carry = words[i] >> 63;
+            }
+            return runs;
+        }
+        case RUN:
+            return values.size() / 2;
+    }
+    return 0;
+}
+
+size_t roaring_bitmap::container::bytes() const {
+    switch(type) {
+        case ARRAY:
+            return 2 * cardinality;
+        case BITMAP:
+            return BITMAP_BYTES;
+        case RUN:
+            return 2 + 2 * values.size();
+    }
+    return 0;
+}
+
+// End of container definitions
+
+
+// Define the iterator
+
+roaring_bitmap::iterator::iterator(const roaring_bitmap *owner, size_t index) : owner(owner), index(index) {
+    if(index < owner->keys.size())
+        load_first();
+}
+
+void roaring_bitmap::iterator::load_first() {
+    const container& c = owner->containers[index];
+    position = 0;
+
+    if(c.type == container::BITMAP) {
+        size_t word = 0;
+        while(!c.words[word])
+            word++;
+        low = static_cast<uint32_t>(word * 64 + count_trailing_zeros(c.words[word]));
+    } else {
+        low = c.values[0];
+    }
+}
+
+roaring_bitmap::iterator& roaring_bitmap::iterator::operator++() {
+    const container& c = owner->containers[index];
+
+    switch(c.type) {
+        case container::ARRAY:
+            if(++position < c.values.size()) {
+                low = c.values[position];
+                return *this;
+            }
+            break;
+        case container::RUN:
+            if(low < uint32_t(c.values[2 * position]) + c.values[2 * position + 1]) {
+                low++;
+                return *this;
+            }
+            if(++position < c.values.size() / 2) {
+                low = c.values[2 * position];
+                return *this;
+            }
+            break;
+        case container::BITMAP:
+            if(low < 65535) {
+                size_t word = (low + 1) >> 6;
+                uint64_t bits = c.words[word] & (~uint64_t(0) << ((low + 1) & 63));
+                while(!bits && ++word < BITMAP_WORDS)
+                    bits = c.words[word];
+                if(bits) {
+                    low = static_cast<uint32_t>(word * 64 + count_trailing_zeros(bits));
+                    return *this;
+                }
+            }
+            break;
+    }
+
+    if(++index < owner->keys.size())
+        load_first();
+    else
+        low = 0;
+    return *this;
+}
+
+// End of iterator definitions
+
+
+// Define roaring_bitmap
+
+roaring_bitmap::roaring_bitmap(const uint32_t *values, size_t count) {
+    insert_many(values, count);
+}
+
+size_t roaring_bitmap::find_key(uint16_t key) const {
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if(it != keys.end() && *it == key)
+        return static_cast<size_t>(it - keys.begin());
+    return keys.size();
+}
+
+roaring_bitmap::container& roaring_bitmap::container_for(uint16_t key) {
+    // Appending in key order is the common case, so check the last container first
+    if(!keys.empty() && keys.back() == key)
+        return containers.back();
+
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    size_t index = static_cast<size_t>(it - keys.begin());
+    if(it == keys.end() || *it != key) {
+        keys.insert(it, key);
+        containers.insert(containers.begin() + index, container());
+    }
+    return containers[index];
+}
+
+void roaring_bitmap::erase_container(size_t index) {
+    keys.erase(keys.begin() + index);
+    containers.erase(containers.begin() + index);
+}
+
+void roaring_bitmap::append(uint16_t key, container&& c) {
+    if(c.cardinality == 0)
+        return;
+    keys.push_back(key);
+    containers.push_back(std::move(c));
+}
+
+bool roaring_bitmap::insert(uint32_t value) {
+    return container_for(static_cast<uint16_t>(value >> 16)).insert(static_cast<uint16_t>(value));
+}
+
+void roaring_bitmap::insert_many(const uint32_t *values, size_t count) {
+    // Unsorted input would insert containers into the middle of the key array over and over, so sort a copy first
+    std::vector<uint32_t> sorted;
+    if(!std::is_sorted(values, values + count)) {
+        sorted.assign(values, values + count);
+        std::sort(sorted.begin(), sorted.end());
+        values = sorted.data();
+    }
+
+    container *current = nullptr;
+    uint32_t current_key = 0;
+
+    for(size_t i = 0; i < count; i++) {
+        uint32_t key = values[i] >> 16;
+        if(!current || key != current_key) {
+            current = &container_for(static_cast<uint16_t>(key));
+            current_key = key;
+        }
+        current->insert(static_cast<uint16_t>(values[i]));
+    }
+}
+
+bool roaring_bitmap::erase(uint32_t value) {
+    size_t index = find_key(static_cast<uint16_t>(value >> 16));
+    if(index == keys.size() || !containers[index].erase(static_cast<uint16_t>(value)))
+        return false;
+
+    if(containers[index].cardinality == 0)
+        erase_container(index);
+    return true;
+}
+
+bool roaring_bitmap::contains(uint32_t value) const {
+    size_t index = find_key(static_cast<uint16_t>(value >> 16));
+    return index < keys.size() && containers[index].contains(static_cast<uint16_t>(value));
+}
+
+void roaring_bitmap::clear() {
+    keys.clear();
+    containers.clear();
+}
+
+uint64_t roaring_bitmap::cardinality() const {
+    uint64_t total = 0;
+    for(const container& c : containers)
+        total += c.cardinality;
+    return total;
+}
+
+size_t roaring_bitmap::memory_usage() const {
+    size_t total = sizeof(*this) + keys.capacity() * sizeof(uint16_t) + containers.capacity() * sizeof(container);
+    for(const container& c : containers)
+        total += c.values.capacity() * sizeof(uint16_t) + c.words.capacity() * sizeof(uint64_t);
+    return total;
+}
+
+bool roaring_bitmap::run_optimize() {
+    bool any_runs = false;
+
+    for(container& c : containers) {
+        size_t run_bytes = 2 + 4 * c.run_count();
+        size_t plain_bytes = c.cardinality <= ARRAY_MAX ? 2 * c.cardinality : BITMAP_BYTES;
+
+        if(run_bytes < plain_bytes) {
+            c.to_runs();
+            any_runs = true;
+        } else {
+            c.materialize();
+        }
+    }
+
+    return any_runs;
+}
+
+bool roaring_bitmap::operator==(const roaring_bitmap& other) const {
+    if(keys != other.keys)
+        return false;
+
+    for(size_t i = 0; i < containers.size(); i++) {
+        const container &a = containers[i], &b = other.containers[i];
+        if(a.cardinality != b.cardinality)
+            return false;
+
+        if(a.type == b.type) {
+            if(a.values != b.values || a.words != b.words)
+                return false;
+        } else {
+            // Equal cardinalities means both materialize to the same container type
+            container x = a, y = b;
+            x.materialize();
+            y.materialize();
+            if(x.values != y.values || x.words != y.words)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Container algebra. Run containers are materialized first so only array/bitmap pairs need special cases.
+
+namespace {
+
+typedef std::vector<uint16_t> value_vector;
+
+}
+
+roaring_bitmap::container roaring_bitmap::container_union(const container& a, const container& b) {
+    if(a.type == container::RUN || b.type == container::RUN) {
+        container x = a, y = b;
+        x.materialize();
+        y.materialize();
+        return container_union(x, y);
+    }
+
+    container out;
+
+    if(a.type == container::BITMAP && b.type == container::BITMAP) {
+        out.type = container::BITMAP;
+        out.words.resize(BITMAP_WORDS);
+        out.cardinality = combine_words<or_op>(a.words.data(), b.words.data(), out.words.data());
+    } else if(a.type == container::BITMAP || b.type == container::BITMAP) {
+        const container &bitmap = a.type == container::BITMAP ? a : b;
+        const container &array = a.type == container::BITMAP ? b : a;
+
+        out = bitmap;
+        for(uint16_t v : array.values) {
+            if(!test_bit(out.words, v)) {
+                set_bit(out.words, v);
+                out.cardinality++;
+            }
+        }
+    } else if(a.cardinality + b.cardinality <= ARRAY_MAX) {
+        out.values.reserve(a.cardinality + b.cardinality);
+        std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                       std::back_inserter(out.values));
+        out.cardinality = static_cast<uint32_t>(out.values.size());
+    } else {
+        out.type = container::BITMAP;
+        out.words.assign(BITMAP_WORDS, 0);
+        for(uint16_t v : a.values)
+            set_bit(out.words, v);
+        for(uint16_t v : b.values)
+            set_bit(out.words, v);
+        for(uint64_t word : out.words)
+            out.cardinality += popcount64(word);
+        if(out.cardinality <= ARRAY_MAX)
+            out.to_array();
+    }
+
+    return out;
+}
+
+roaring_bitmap::container roaring_bitmap::container_intersection(const container& a, const container& b) {
+    if(a.type == container::RUN || b.type == container::RUN) {
+        container x = a, y = b;
+        x.materialize();
+        y.materialize();
+        return container_intersection(x, y);
+    }
+
+    container out;
+
+    if(a.type == container::BITMAP && b.type == container::BITMAP) {
+        out.type = container::BITMAP;
+        out.words.resize(BITMAP_WORDS);
+        out.cardinality = combine_words<and_op>(a.words.data(), b.words.data(), out.words.data());
+        if(out.cardinality <= ARRAY_MAX)
+            out.to_array();
+    } else if(a.type == container::BITMAP || b.type == container::BITMAP) {
+        const container &bitmap = a.type == container::BITMAP ? a : b;
+        const container &array = a.type == container::BITMAP ? b : a;
+
+        for(uint16_t v : array.values) {
+            if(test_bit(bitmap.words, v))
+                out.values.push_back(v);
+        }
+        out.cardinality = static_cast<uint32_t>(out.values.size());
+    } else {
+        const value_vector &small = a.cardinality <= b.cardinality ? a.values : b.values;
+        const value_vector &large = a.cardinality <= b.cardinality ? b.values : a.values;
+
+        if(small.size() * 64 < large.size()) {
+            // Very different sizes: binary search each small value in the remaining part of the large array
+            auto from = large.begin();
+            for(uint16_t v : small) {
+                from = std::lower_bound(from, large.end(), v);
+                if(from == large.end())
+                    break;
+                if(*from == v)
+                    out.values.push_back(v);
+            }
+        } else {
+            std::set_intersection(small.begin(), small.end(), large.begin(), large.end(),
+                                  std::back_inserter(out.values));
+        }
+        out.cardinality = static_cast<uint32_t>(out.values.size());
+    }
+
+    return out;
+}
+
+roaring_bitmap::container roaring_bitmap::container_difference(const container& a, const container& b) {
+    if(a.type == container::RUN || b.type == container::RUN) {
+        container x = a, y = b;
+        x.materialize();
+        y.materialize();
+        return container_difference(x, y);
+    }
+
+    container out;
+
+    if(a.type == container::BITMAP && b.type == container::BITMAP) {
+        out.type = container::BITMAP;
+        out.words.resize(BITMAP_WORDS);
+        out.cardinality = combine_words<andnot_op>(a.words.data(), b.words.data(), out.words.data());
+        if(out.cardinality <= ARRAY_MAX)
+            out.to_array();
+    } else if(a.type == container::BITMAP) {
+        out = a;
+        for(uint16_t v : b.values) {
+            if(test_bit(out.words, v)) {
+                out.words[v >> 6] &= ~(uint64_t(1) << (v & 63));
+                out.cardinality--;
+            }
+        }
+        if(out.cardinality <= ARRAY_MAX)
+            out.to_array();
+    } else if(b.type == container::BITMAP) {
+        for(uint16_t v : a.values) {
+            if(!test_bit(b.words, v))
+                out.values.push_back(v);
+        }
+        out.cardinality = static_cast<uint32_t>(out.values.size());
+    } else {
+        std::set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                            std::back_inserter(out.values));
+        out.cardinality = static_cast<uint32_t>(out.values.size());
+    }
+
+    return out;
+}
+
+uint32_t roaring_bitmap::container_intersection_cardinality(const container& a, const container& b) {
+    if(a.type == container::RUN || b.type == container::RUN) {
+        container x = a, y = b;
+        x.materialize();
+        y.materialize();
+        return container_intersection_cardinality(x, y);
+    }
+
+    uint32_t count = 0;
+
+    if(a.type == container::BITMAP && b.type == container::BITMAP) {
+        for(size_t i = 0; i < BITMAP_WORDS; i++)
+            count += popcount64(a.words[i] & b.words[i]);
+    } else if(a.type == container::BITMAP || b.type == container::BITMAP) {
+        const container &bitmap = a.type == container::BITMAP ? a : b;
+        const container &array = a.type == container::BITMAP ? b : a;
+        for(uint16_t v : array.values)
+            count += test_bit(bitmap.words, v) ? 1 : 0;
+    } else {
+        size_t i = 0, j = 0;
+        while(i < a.values.size() && j < b.values.size()) {
+            if(a.values[i] < b.values[j]) {
+                i++;
+            } else if(b.values[j] < a.values[i]) {
+                j++;
+            } else {
+                count++;
+                i++;
+                j++;
+            }
+        }
+    }
+
+    return count;
+}
+
+roaring_bitmap roaring_bitmap::set_union(const roaring_bitmap& a, const roaring_bitmap& b) {
+    roaring_bitmap out;
+    out.keys.reserve(a.keys.size() + b.keys.size());
+    out.containers.reserve(a.keys.size() + b.keys.size());
+
+    size_t i = 0, j = 0;
+    while(i < a.keys.size() || j < b.keys.size()) {
+        if(j == b.keys.size() || (i < a.keys.size() && a.keys[i] < b.keys[j])) {
+            out.append(a.keys[i], container(a.containers[i]));
+            i++;
+        } else if(i == a.keys.size() || b.keys[j] < a.keys[i]) {
+            out.append(b.keys[j], container(b.containers[j]));
+            j++;
+        } else {
+            out.append(a.keys[i], container_union(a.containers[i], b.containers[j]));
+            i++;
+            j++;
+        }
+    }
+
+    return out;
+}
+
+roaring_bitmap roaring_bitmap::set_intersection(const roaring_bitmap& a, const roaring_bitmap& b) {
+    roaring_bitmap out;
+
+    size_t i = 0, j = 0;
+    while(i < a.keys.size() && j < b.keys.size()) {
+        if(a.keys[i] < b.keys[j]) {
+            i++;
+        } else if(b.keys[j] < a.keys[i]) {
+            j++;
+        } else {
+            out.append(a.keys[i], container_intersection(a.containers[i], b.containers[j]));
+            i++;
+            j++;
+        }
+    }
+
+    return out;
+}
+
+roaring_bitmap roaring_bitmap::set_difference(const roaring_bitmap& a, const roaring_bitmap& b) {
+    roaring_bitmap out;
+
+    size_t i = 0, j = 0;
+    while(i < a.keys.size()) {
+        if(j == b.keys.size() || a.keys[i] < b.keys[j]) {
+            out.append(a.keys[i], container(a.containers[i]));
+            i++;
+        } else if(b.keys[j] < a.keys[i]) {
+            j++;
+        } else {
+            out.append(a.keys[i], container_difference(a.containers[i], b.containers[j]));
+            i++;
+            j++;
+        }
+    }
+
+    return out;
+}
+
+uint64_t roaring_bitmap::intersection_cardinality(const roaring_bitmap& a, const roaring_bitmap& b) {
+    uint64_t count = 0;
+
+    size_t i = 0, j = 0;
+    while(i < a.keys.size() && j < b.keys.size()) {
+        if(a.keys[i] < b.keys[j]) {
+            i++;
+        } else if(b.keys[j] < a.keys[i]) {
+            j++;
+        } else {
+            count += container_intersection_cardinality(a.containers[i], b.containers[j]);
+            i++;
+            j++;
+        }
+    }
+
+    return count;
+}
+
+
+// Serialization
+
+std::vector<uint8_t> roaring_bitmap::serialize() const {
+    std::vector<uint8_t> out;
+    size_t n = keys.size();
+
+    bool has_runs = false;
+    for(const container& c : containers)
+        has_runs = has_runs || c.type == container::RUN;
+
+    if(has_runs) {
+        put32(out, SERIAL_COOKIE | (static_cast<uint32_t>(n - 1) << 16));
+
+        std::vector<uint8_t> run_flags((n + 7) / 8, 0);
+        for(size_t i = 0; i < n; i++) {
+            if(containers[i].type == container::RUN)
+                run_flags[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+        }
+        out.insert(out.end(), run_flags.begin(), run_flags.end());
+    } else {
+        put32(out, SERIAL_COOKIE_NO_RUN);
+        put32(out, static_cast<uint32_t>(n));
+    }
+
+    for(size_t i = 0; i < n; i++) {
+        put16(out, keys[i]);
+        put16(out, static_cast<uint16_t>(containers[i].cardinality - 1));
+    }
+
+    if(!has_runs || n >= NO_OFFSET_THRESHOLD) {
+        size_t offset = out.size() + 4 * n;
+        for(const container& c : containers) {
+            put32(out, static_cast<uint32_t>(offset));
+            offset += c.bytes();
+        }
+    }
+
+    for(const container& c : containers) {
+        switch(c.type) {
+            case container::ARRAY:
+                for(uint16_t v : c.values)
+                    put16(out, v);
+                break;
+            case container::BITMAP:
+                for(uint64_t word : c.words)
+                    put64(out, word);
+                break;
+            case container::RUN:
+                put16(out, static_cast<uint16_t>(c.values.size() / 2));
+                for(uint16_t v : c.values)
+                    put16(out, v);
+                break;
+        }
+    }
+
+    return out;
+}
+
+roaring_bitmap roaring_bitmap::deserialize(const uint8_t *data, size_t length) {
+    reader in = {data, length, 0};
+    roaring_bitmap out;
+
+    uint32_t cookie = in.get32();
+    size_t n;
+    std::vector<uint8_t> run_flags;
+
+    if((cookie & 0xFFFF) == SERIAL_COOKIE) {
+        n = (cookie >> 16) + 1;
+        in.need((n + 7) / 8);
+        run_flags.assign(data + in.position, data + in.position + (n + 7) / 8);
+        in.position += run_flags.size();
+    } else if(cookie == SERIAL_COOKIE_NO_RUN) {
+        n = in.get32();
+        if(n > 65536)
+            throw std::invalid_argument("roaring_bitmap: too many containers");
+    } else {
+        throw std::invalid_argument("roaring_bitmap: unrecognized cookie");
+    }
+
+    std::vector<uint32_t> cardinalities(n);
+    out.keys.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        out.keys[i] = in.get16();
+        cardinalities[i] = uint32_t(in.get16()) + 1;
+        if(i > 0 && out.keys[i] <= out.keys[i - 1])
+            throw std::invalid_argument("roaring_bitmap: container keys are not increasing");
+    }
+
+    if(run_flags.empty() || n >= NO_OFFSET_THRESHOLD) {
+        in.need(4 * n);
+        in.position += 4 * n;
+    }
+
+    out.containers.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        container &c = out.containers[i];
+        bool is_run = !run_flags.empty() && (run_flags[i / 8] >> (i % 8)) & 1;
+
+        if(is_run) {
+            size_t runs = in.get16();
+            c.type = container::RUN;
+            c.values.resize(2 * runs);
+            uint32_t next_start = 0;
+            for(size_t r = 0; r < runs; r++) {
+                c.values[2 * r] = in.get16();
+                c.values[2 * r + 1] = in.get16();
+
+                uint32_t end = uint32_t(c.values[2 * r]) + c.values[2 * r + 1];
+                if(c.values[2 * r] < next_start || end > 65535)
+                    throw std::invalid_argument("roaring_bitmap: malformed run container");
+                next_start = end + 1;
+                c.cardinality += c.values[2 * r + 1] + 1;
+            }
+        } else if(cardinalities[i] > ARRAY_MAX) {
+            c.type = container::BITMAP;
+            c.words.resize(BITMAP_WORDS);
+            for(uint64_t& word : c.words) {
+                word = in.get64();
+                c.cardinality += popcount64(word);
+            }
+        } else {
+            c.values.resize(cardinalities[i]);
+            for(size_t v = 0; v < c.values.size(); v++) {
+                c.values[v] = in.get16();
+                if(v > 0 && c.values[v] <= c.values[v - 1])
+                    throw std::invalid_argument("roaring_bitmap: array container is not increasing");
+            }
+            c.cardinality = cardinalities[i];
+        }
+
+        if(c.cardinality != cardinalities[i])
+            throw std::invalid_argument("roaring_bitmap: container cardinality does not match its header");
+    }
+
+    return out;
+}
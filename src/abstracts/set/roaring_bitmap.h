@@ -0,0 +1,226 @@
+/**
+ * A compressed set of 32-bit integers using Roaring bitmap containers.
+ *
+ * What is a Roaring bitmap?
+ *   The 32-bit space is cut into 65536 chunks of 65536 values each, keyed by the high 16 bits. Only chunks that
+ *   contain at least one value are stored, each in whichever of three containers is smallest:
+ *     - array:  a sorted array of the low 16 bits, used for up to 4096 values
+ *     - bitmap: a 65536 bit (8 KB) bitmap, used above 4096 values
+ *     - run:    sorted (start, length - 1) pairs, used when the values form long runs (see `run_optimize`)
+ *
+ * Why is this useful?
+ *   A hash set of IDs costs tens of bytes per element. A Roaring bitmap costs at most 2 bytes per element, often
+ *   far less, and set algebra between two bitmaps works on whole 64-bit words (or SIMD registers) at a time.
+ *
+ * How is it implemented?
+ *   The chunk keys and containers are kept in two parallel sorted arrays. Binary operations walk both key arrays in
+ *   step and combine matching containers with a routine specialized for each pair of container types. Bitmap
+ *   containers are combined with SSE2/AVX2 when available. `serialize` writes the portable format shared by the
+ *   other Roaring implementations (https://github.com/RoaringBitmap/RoaringFormatSpec).
+ **/
+
+#ifndef DATA_STRUCTURES_ROARING_BITMAP_H
+#define DATA_STRUCTURES_ROARING_BITMAP_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+class roaring_bitmap {
+    struct container {
+        enum kind : uint8_t { ARRAY, BITMAP, RUN };
+
+        kind type = ARRAY;
+        uint32_t cardinality = 0;
+        // ARRAY: sorted values; RUN: (start, length - 1) pairs
+        std::vector<uint16_t> values;
+        // BITMAP: 1024 words
+        std::vector<uint64_t> words;
+
+        bool contains(uint16_t value) const;
+        bool insert(uint16_t value);
+        bool erase(uint16_t value);
+
+        void to_array();
+        void to_bitmap();
+        void to_runs();
+        void materialize();
+        size_t run_count() const;
+        size_t bytes() const;
+    };
+
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef uint32_t value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const uint32_t *pointer;
+        typedef uint32_t reference;
+
+        iterator() = default;
+
+        uint32_t operator*() const { return (uint32_t(owner->keys[index]) << 16) | low; }
+
+        iterator& operator++();
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const {
+            return index == other.index && (index == end_index() || low == other.low);
+        }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class roaring_bitmap;
+        iterator(const roaring_bitmap *owner, size_t index);
+
+        size_t end_index() const { return owner ? owner->keys.size() : 0; }
+        void load_first();
+
+        const roaring_bitmap *owner = nullptr;
+        size_t index = 0;
+        size_t position = 0;
+        uint32_t low = 0;
+    };
+
+    /**
+     * Construct an empty bitmap.
+     */
+    roaring_bitmap() = default;
+    /**
+     * Construct a bitmap holding the `count` values at `values`. The input does not need to be sorted.
+     */
+    roaring_bitmap(const uint32_t *values, size_t count);
+
+
+    /**
+     * Adds `value` to the set.
+     *
+     * @return true if it was not already present
+     */
+    bool insert(uint32_t value);
+    /**
+     * Adds the `count` values at `values`. Unsorted input is sorted into a temporary copy first, so that each
+     *   container is found once and filled with appends.
+     */
+    void insert_many(const uint32_t *values, size_t count);
+    /**
+     * Removes `value` from the set.
+     *
+     * @return true if it was present
+     */
+    bool erase(uint32_t value);
+    /**
+     * @return true if `value` is in the set
+     */
+    bool contains(uint32_t value) const;
+    /**
+     * Removes every value.
+     */
+    void clear();
+
+
+    /**
+     * @return the number of values in the set
+     */
+    uint64_t cardinality() const;
+    size_t size() const { return static_cast<size_t>(cardinality()); }
+    bool empty() const { return keys.empty(); }
+    /**
+     * @return the smallest value in the set. The set must not be empty.
+     */
+    uint32_t minimum() const { return *begin(); }
+    /**
+     * @return an estimate of the heap memory used, in bytes
+     */
+    size_t memory_usage() const;
+
+
+    /**
+     * Converts each container to a run container wherever that is smaller. Worth calling once a bitmap holding
+     *   long runs of consecutive values is done being built.
+     *
+     * @return true if any container is now a run container
+     */
+    bool run_optimize();
+
+
+    /**
+     * @return the values in either set
+     */
+    static roaring_bitmap set_union(const roaring_bitmap& a, const roaring_bitmap& b);
+    /**
+     * @return the values in both sets
+     */
+    static roaring_bitmap set_intersection(const roaring_bitmap& a, const roaring_bitmap& b);
+    /**
+     * @return the values in `a` that are not in `b`
+     */
+    static roaring_bitmap set_difference(const roaring_bitmap& a, const roaring_bitmap& b);
+    /**
+     * @return |a & b|, computed without building the intersection
+     */
+    static uint64_t intersection_cardinality(const roaring_bitmap& a, const roaring_bitmap& b);
+
+    roaring_bitmap& operator|=(const roaring_bitmap& other) { return *this = set_union(*this, other); }
+    roaring_bitmap& operator&=(const roaring_bitmap& other) { return *this = set_intersection(*this, other); }
+    roaring_bitmap& operator-=(const roaring_bitmap& other) { return *this = set_difference(*this, other); }
+
+    bool operator==(const roaring_bitmap& other) const;
+    bool operator!=(const roaring_bitmap& other) const { return !(*this == other); }
+
+
+    /**
+     * Writes the set using the portable Roaring format. Integers are little endian regardless of the host.
+     */
+    std::vector<uint8_t> serialize() const;
+    /**
+     * Reads a set written by `serialize` (or by any other Roaring implementation).
+     *
+     * @throws std::invalid_argument if the buffer is truncated or malformed
+     */
+    static roaring_bitmap deserialize(const uint8_t *data, size_t length);
+    static roaring_bitmap deserialize(const std::vector<uint8_t>& data) {
+        return deserialize(data.data(), data.size());
+    }
+
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, keys.size()); }
+
+private:
+    std::vector<uint16_t> keys;
+    std::vector<container> containers;
+
+    size_t find_key(uint16_t key) const;
+    container& container_for(uint16_t key);
+    void erase_container(size_t index);
+
+    void append(uint16_t key, container&& c);
+
+    static container container_union(const container& a, const container& b);
+    static container container_intersection(const container& a, const container& b);
+    static container container_difference(const container& a, const container& b);
+    static uint32_t container_intersection_cardinality(const container& a, const container& b);
+};
+
+inline roaring_bitmap operator|(const roaring_bitmap& a, const roaring_bitmap& b) {
+    return roaring_bitmap::set_union(a, b);
+}
+
+inline roaring_bitmap operator&(const roaring_bitmap& a, const roaring_bitmap& b) {
+    return roaring_bitmap::set_intersection(a, b);
+}
+
+inline roaring_bitmap operator-(const roaring_bitmap& a, const roaring_bitmap& b) {
+    return roaring_bitmap::set_difference(a, b);
+}
+
+
+#endif //DATA_STRUCTURES_ROARING_BITMAP_H
@@ -1,13 +1,93 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * An ordered set.
+ *
+ * The general version stores its elements as the keys of a `tree_map` (a B+tree), so it gets the same cache
+ *   friendly lookups and linked leaf iteration.
+ *
+ * Sets of 32-bit unsigned integers are specialized to use a `roaring_bitmap` instead, which is also ordered but
+ *   stores dense or clustered IDs in a fraction of the space and supports fast set algebra.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_TREE_SET_H
 #define DATA_STRUCTURES_TREE_SET_H
 
 
+#include "../map/tree_map.h"
+#include "roaring_bitmap.h"
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+template <typename T, typename Compare = std::less<T>>
 class tree_set {
+    typedef tree_map<T, char, Compare> storage;
+
+public:
+    class iterator {
+    public:
+        iterator() = default;
+
+        const T& operator*() const { return it.key(); }
+        const T *operator->() const { return &it.key(); }
+
+        iterator& operator++() {
+            ++it;
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const { return it == other.it; }
+        bool operator!=(const iterator& other) const { return it != other.it; }
+
+    private:
+        friend class tree_set;
+        explicit iterator(typename storage::iterator it) : it(it) {}
+
+        typename storage::iterator it;
+    };
+
+    /**
+     * Adds `value` to the set.
+     *
+     * @return true if it was not already present
+     */
+    bool insert(const T& value) { return elements.insert(value, 0); }
+    /**
+     * Removes `value` from the set.
+     *
+     * @return true if it was present
+     */
+    bool erase(const T& value) { return elements.erase(value); }
+    /**
+     * @return true if `value` is in the set
+     */
+    bool contains(const T& value) const { return elements.find(value) != elements.end(); }
+    void clear() { elements.clear(); }
+
+    iterator lower_bound(const T& value) const { return iterator(elements.lower_bound(value)); }
+    iterator upper_bound(const T& value) const { return iterator(elements.upper_bound(value)); }
+
+    iterator begin() const { return iterator(elements.begin()); }
+    iterator end() const { return iterator(elements.end()); }
+
+    size_t size() const { return elements.size(); }
+    bool empty() const { return elements.empty(); }
+
+private:
+    storage elements;
+};
 
+/**
+ * Ordered sets of 32-bit IDs are stored as Roaring bitmaps.
+ */
+template <>
+class tree_set<uint32_t, std::less<uint32_t>> : public roaring_bitmap {
+public:
+    tree_set() = default;
+    tree_set(roaring_bitmap other) : roaring_bitmap(std::move(other)) {}
+    tree_set(const uint32_t *values, size_t count) : roaring_bitmap(values, count) {}
 };
 
 
@@ -1,14 +1,385 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Last-in first-out stacks: a segmented stack with inline storage, and a lock-free Treiber stack.
+ *
+ * What is a stack?
+ *   A sequence where elements are only added (pushed) and removed (popped) at one end, the top.
+ *
+ * Why is this useful?
+ *   std::stack over a vector relocates every element whenever it grows, which costs an O(n) spike and invalidates
+ *   every reference into the stack. `stack` keeps its first N elements inside the object itself, so shallow stacks
+ *   never allocate, and grows by linking in new segments instead of relocating, so a reference to an element stays
+ *   valid until that element is popped.
+ *
+ *   `treiber_stack` can be pushed to and popped from by any number of threads at once without locks, which makes it
+ *   a good concurrent free list.
+ *
+ * How are they implemented?
+ *   stack: the inline array is followed by a chain of heap segments, each twice the size of the one below it. When
+ *   the top segment empties it is kept as a spare rather than freed, so pushing and popping around a segment boundary
+ *   does not allocate every time.
+ *
+ *   treiber_stack: R. K. Treiber's stack ("Systems Programming: Coping with Parallelism", IBM 1986) is a linked list
+ *   whose head is swapped with compare-and-swap. The classic hazard is ABA: a thread reads head A and its successor
+ *   B, other threads pop A and B and push A back, and the first thread's CAS succeeds and installs the long gone B.
+ *   Here the head is a 32-bit node index paired with a 32-bit tag that changes on every update, packed into one
+ *   64-bit atomic, so such a stale CAS fails. Nodes come from an internal pool and are never returned to the
+ *   allocator while the stack lives, so a thread reading a node that was just popped still reads valid memory.
+ *   Popped nodes go on a second tagged stack for reuse; the pool only takes a lock when it has to allocate a new
+ *   chunk, which happens O(log n) times.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_STACK_H
 #define DATA_STRUCTURES_STACK_H
 
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * A stack that stores its first N elements inline and the rest in linked segments. Elements never move.
+ */
+template <typename T, size_t N = 16>
 class stack {
+    static_assert(N > 0, "stack needs room for at least one inline element");
+
+public:
+    stack() = default;
+    ~stack();
+
+    // Elements live inside the object, and references to them must stay valid, so stacks are neither copied nor
+    //   moved
+    stack(const stack&) = delete;
+    stack& operator=(const stack&) = delete;
+
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+    /**
+     * Constructs a new element on top of the stack.
+     *
+     * @return a reference to it, valid until it is popped
+     */
+    template <typename... Args>
+    T& emplace(Args&&... args);
+    /**
+     * Removes the top element. The stack must not be empty.
+     */
+    void pop();
+    /**
+     * Removes every element and frees every segment.
+     */
+    void clear();
+
+
+    T& top() { return *slot(used - 1); }
+    const T& top() const { return const_cast<stack*>(this)->top(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    /**
+     * @return true while every element is stored inline
+     */
+    bool is_inline() const { return !current; }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    struct segment {
+        segment *below;
+        size_t capacity;
+        storage *items;
+    };
+
+    storage local[N];
+    // The top segment, or nullptr while the inline array is on top
+    segment *current = nullptr;
+    segment *spare = nullptr;
+    // Number of elements in the top region (the inline array or `current`)
+    size_t used = 0;
+    size_t count = 0;
+
+    size_t region_capacity() const { return current ? current->capacity : N; }
+    T *slot(size_t index) {
+        return reinterpret_cast<T*>(current ? &current->items[index] : &local[index]);
+    }
+
+    void grow();
+    void shrink();
+    static void free_segment(segment *s) {
+        delete[] s->items;
+        delete s;
+    }
+};
 
+
+/**
+ * A lock-free stack for any number of concurrent pushers and poppers.
+ */
+template <typename T>
+class treiber_stack {
+public:
+    treiber_stack() : items(EMPTY), free_nodes(EMPTY), fresh(0), approximate_size(0) {
+        for(auto& chunk : chunks)
+            chunk.store(nullptr, std::memory_order_relaxed);
+    }
+    ~treiber_stack();
+
+    treiber_stack(const treiber_stack&) = delete;
+    treiber_stack& operator=(const treiber_stack&) = delete;
+
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+    template <typename... Args>
+    void emplace(Args&&... args);
+    /**
+     * Pops the top element into `out`.
+     *
+     * @return false if the stack was empty
+     */
+    bool try_pop(T& out);
+
+
+    /**
+     * @return the number of elements. Only a snapshot when other threads are active.
+     */
+    size_t size() const {
+        // A pop can be counted before the push it undoes, so the counter can briefly dip below zero
+        int64_t counted = approximate_size.load(std::memory_order_relaxed);
+        return counted > 0 ? static_cast<size_t>(counted) : 0;
+    }
+    bool empty() const { return index_of(items.load(std::memory_order_acquire)) == NONE; }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    struct node {
+        storage value;
+        std::atomic<uint32_t> next;
+    };
+
+    static const uint32_t NONE = UINT32_MAX;
+    // A tagged head holding no node, with tag 0
+    static const uint64_t EMPTY = NONE;
+    // Chunk k holds FIRST_CHUNK << k nodes, so 26 chunks hold FIRST_CHUNK * (2^26 - 1) nodes, just short of NONE
+    static const size_t FIRST_CHUNK = 64;
+    static const size_t CHUNKS = 26;
+    static const uint32_t MAX_NODES = static_cast<uint32_t>(FIRST_CHUNK * ((size_t(1) << CHUNKS) - 1));
+
+    std::atomic<uint64_t> items;
+    char pad0[64];
+    std::atomic<uint64_t> free_nodes;
+    char pad1[64];
+    std::atomic<uint32_t> fresh;
+    std::atomic<int64_t> approximate_size;
+    std::atomic<node*> chunks[CHUNKS];
+    std::mutex chunk_mutex;
+
+    static uint32_t index_of(uint64_t tagged) { return static_cast<uint32_t>(tagged); }
+    static uint64_t tagged(uint32_t index, uint64_t previous) {
+        return ((previous >> 32) + 1) << 32 | index;
+    }
+
+    node& at(uint32_t index) const;
+    void link(std::atomic<uint64_t>& head, uint32_t index);
+    uint32_t unlink(std::atomic<uint64_t>& head);
+    uint32_t acquire_node();
 };
 
 
+// Define stack
+
+template <typename T, size_t N>
+stack<T, N>::~stack() {
+    clear();
+}
+
+template <typename T, size_t N>
+void stack<T, N>::grow() {
+    segment *next = spare;
+    if(next) {
+        spare = nullptr;
+    } else {
+        next = new segment{nullptr, 2 * region_capacity(), nullptr};
+        try {
+            next->items = new storage[next->capacity];
+        } catch(...) {
+            delete next;
+            throw;
+        }
+    }
+
+    next->below = current;
+    current = next;
+    used = 0;
+}
+
+template <typename T, size_t N>
+template <typename... Args>
+T& stack<T, N>::emplace(Args&&... args) {
+    bool grew = used == region_capacity();
+    if(grew)
+        grow();
+
+    T *value;
+    try {
+        value = new(slot(used)) T(std::forward<Args>(args)...);
+    } catch(...) {
+        if(grew)
+            shrink();
+        throw;
+    }
+    used++;
+    count++;
+    return *value;
+}
+
+template <typename T, size_t N>
+void stack<T, N>::pop() {
+    used--;
+    count--;
+    slot(used)->~T();
+
+    if(used == 0 && current)
+        shrink();
+}
+
+template <typename T, size_t N>
+void stack<T, N>::shrink() {
+    // Step down into the (full) region below, keeping the empty top segment as the spare
+    segment *emptied = current;
+    current = emptied->below;
+    used = region_capacity();
+
+    if(spare)
+        free_segment(spare);
+    spare = emptied;
+}
+
+template <typename T, size_t N>
+void stack<T, N>::clear() {
+    while(count > 0)
+        pop();
+    if(spare) {
+        free_segment(spare);
+        spare = nullptr;
+    }
+}
+
+// End of stack definitions
+
+
+// Define treiber_stack
+
+template <typename T>
+const uint32_t treiber_stack<T>::NONE;
+template <typename T>
+const uint32_t treiber_stack<T>::MAX_NODES;
+
+template <typename T>
+typename treiber_stack<T>::node& treiber_stack<T>::at(uint32_t index) const {
+    // Chunk k starts at index FIRST_CHUNK * (2^k - 1)
+    size_t block = index / FIRST_CHUNK + 1;
+    size_t k = 63 - __builtin_clzll(block);
+    size_t offset = index - FIRST_CHUNK * ((size_t(1) << k) - 1);
+    return chunks[k].load(std::memory_order_acquire)[offset];
+}
+
+template <typename T>
+void treiber_stack<T>::link(std::atomic<uint64_t>& head, uint32_t index) {
+    node& n = at(index);
+    uint64_t old = head.load(std::memory_order_relaxed);
+    do {
+        n.next.store(index_of(old), std::memory_order_relaxed);
+    } while(!head.compare_exchange_weak(old, tagged(index, old), std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+
+template <typename T>
+uint32_t treiber_stack<T>::unlink(std::atomic<uint64_t>& head) {
+    uint64_t old = head.load(std::memory_order_acquire);
+    while(true) {
+        uint32_t index = index_of(old);
+        if(index == NONE)
+            return NONE;
+
+        // If another thread pops this node first, `next` may be stale, but then the tag has moved on and the CAS fails
+        uint32_t next = at(index).next.load(std::memory_order_relaxed);
+        if(head.compare_exchange_weak(old, tagged(next, old), std::memory_order_acquire, std::memory_order_acquire))
+            return index;
+    }
+}
+
+template <typename T>
+uint32_t treiber_stack<T>::acquire_node() {
+    uint32_t index = unlink(free_nodes);
+    if(index != NONE)
+        return index;
+
+    // Not fetch_add: failed calls must not move the counter on, or it would wrap around to indices in use
+    index = fresh.load(std::memory_order_relaxed);
+    do {
+        if(index >= MAX_NODES)
+            throw std::length_error("treiber_stack has run out of nodes");
+    } while(!fresh.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+    size_t k = 63 - __builtin_clzll(index / FIRST_CHUNK + 1);
+    if(!chunks[k].load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(chunk_mutex);
+        if(!chunks[k].load(std::memory_order_relaxed)) {
+            node *chunk = new node[FIRST_CHUNK << k];
+            chunks[k].store(chunk, std::memory_order_release);
+        }
+    }
+    return index;
+}
+
+template <typename T>
+template <typename... Args>
+void treiber_stack<T>::emplace(Args&&... args) {
+    uint32_t index = acquire_node();
+    try {
+        new(&at(index).value) T(std::forward<Args>(args)...);
+    } catch(...) {
+        link(free_nodes, index);
+        throw;
+    }
+
+    link(items, index);
+    approximate_size.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool treiber_stack<T>::try_pop(T& out) {
+    uint32_t index = unlink(items);
+    if(index == NONE)
+        return false;
+
+    approximate_size.fetch_sub(1, std::memory_order_relaxed);
+    T *value = reinterpret_cast<T*>(&at(index).value);
+    out = std::move(*value);
+    value->~T();
+    link(free_nodes, index);
+    return true;
+}
+
+template <typename T>
+treiber_stack<T>::~treiber_stack() {
+    for(uint32_t index = index_of(items.load()); index != NONE; index = at(index).next.load())
+        reinterpret_cast<T*>(&at(index).value)->~T();
+    for(auto& chunk : chunks)
+        delete[] chunk.load();
+}
+
+// End of treiber_stack definitions
+
+
 #endif //DATA_STRUCTURES_STACK_H
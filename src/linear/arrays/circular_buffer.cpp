@@ -1,5 +1,325 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Implementation of the lock-free byte ring buffers.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #include "circular_buffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+size_t round_up_power_of_two(size_t n) {
+    size_t power = 1;
+    while(power < n)
+        power <<= 1;
+    return power;
+}
+
+/**
+ * Waits for `counter` to reach `expected`, spinning briefly before yielding to whoever has to move it.
+ */
+void await(const std::atomic<uint64_t>& counter, uint64_t expected) {
+    for(unsigned spins = 0; counter.load(std::memory_order_acquire) != expected; spins++) {
+        if(spins >= 64)
+            std::this_thread::yield();
+    }
+}
+
+}
+
+
+// Define circular_buffer
+
+const size_t circular_buffer::CACHE_LINE;
+
+circular_buffer::circular_buffer(size_t capacity, producers producer_mode, mapping memory)
+        : ring(nullptr), ring_size(0), mask(0), multiple_producers(producer_mode == producers::multiple),
+          magic(memory == mapping::magic) {
+    if(capacity == 0)
+        throw std::invalid_argument("circular_buffer capacity must be positive");
+    ring_size = round_up_power_of_two(capacity);
+
+    if(magic) {
+        map_magic();
+    } else {
+        allocation = new uint8_t[ring_size + CACHE_LINE];
+        size_t offset = reinterpret_cast<uintptr_t>(allocation) % CACHE_LINE;
+        ring = allocation + (offset ? CACHE_LINE - offset : 0);
+    }
+    mask = ring_size - 1;
+}
+
+circular_buffer::~circular_buffer() {
+#if defined(__linux__)
+    if(magic) {
+        munmap(ring, 2 * ring_size);
+        return;
+    }
+#endif
+    delete[] allocation;
+}
+
+void circular_buffer::map_magic() {
+#if defined(__linux__)
+    // Both mappings must start on a page boundary, and a power of two at least a page long is a whole number of pages
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    ring_size = std::max(ring_size, page);
+
+    int fd = static_cast<int>(syscall(SYS_memfd_create, "circular_buffer", 1u /* MFD_CLOEXEC */));
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category(), "circular_buffer: memfd_create");
+    if(ftruncate(fd, static_cast<off_t>(ring_size)) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "circular_buffer: ftruncate");
+    }
+
+    // Reserve twice the address space, then map the memory over each half
+    void *base = mmap(nullptr, 2 * ring_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base == MAP_FAILED) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "circular_buffer: mmap");
+    }
+    uint8_t *bytes = static_cast<uint8_t*>(base);
+    for(uint8_t *half : {bytes, bytes + ring_size}) {
+        if(mmap(half, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            int error = errno;
+            munmap(base, 2 * ring_size);
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "circular_buffer: mmap");
+        }
+    }
+
+    // The mappings keep the memory alive
+    close(fd);
+    ring = bytes;
+#else
+    throw std::system_error(std::make_error_code(std::errc::function_not_supported),
+                            "circular_buffer: magic rings need Linux");
+#endif
+}
+
+size_t circular_buffer::contiguous(uint64_t position, size_t n) const {
+    if(magic)
+        return n;
+    return std::min(n, static_cast<size_t>(ring_size - (position & mask)));
+}
+
+circular_buffer::region circular_buffer::reserve(size_t n) {
+    if(!multiple_producers) {
+        uint64_t position = written.load(std::memory_order_relaxed);
+        size_t available = static_cast<size_t>(ring_size - (position - cached_read));
+        if(available < n) {
+            cached_read = read.load(std::memory_order_acquire);
+            available = static_cast<size_t>(ring_size - (position - cached_read));
+        }
+        return region{ring + (position & mask), contiguous(position, std::min(n, available)), position};
+    }
+
+    uint64_t position = claimed.load(std::memory_order_relaxed);
+    for(;;) {
+        size_t available = static_cast<size_t>(ring_size - (position - read.load(std::memory_order_acquire)));
+        size_t size = contiguous(position, std::min(n, available));
+        if(size == 0)
+            return region{ring + (position & mask), 0, position};
+        if(claimed.compare_exchange_weak(position, position + size, std::memory_order_relaxed))
+            return region{ring + (position & mask), size, position};
+    }
+}
+
+void circular_buffer::commit(size_t n) {
+    if(multiple_producers)
+        throw std::logic_error("circular_buffer: commit the region itself when there are multiple producers");
+    written.store(written.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+void circular_buffer::commit(const region& reserved) {
+    if(!multiple_producers) {
+        commit(reserved.size);
+        return;
+    }
+    if(reserved.size == 0)
+        return;
+
+    // Earlier claims have to be published first, or the consumer would read bytes that are still being written
+    await(written, reserved.position);
+    written.store(reserved.position + reserved.size, std::memory_order_release);
+}
+
+circular_buffer::region circular_buffer::peek() {
+    uint64_t position = read.load(std::memory_order_relaxed);
+    if(cached_written == position)
+        cached_written = written.load(std::memory_order_acquire);
+    size_t available = static_cast<size_t>(cached_written - position);
+    return region{ring + (position & mask), contiguous(position, available), position};
+}
+
+void circular_buffer::consume(size_t n) {
+    read.store(read.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+// End of circular_buffer definitions
+
+
+// Define flight_recorder
+
+const size_t flight_recorder::SLOT_BYTES;
+const size_t flight_recorder::SLOT_PAYLOAD;
+
+namespace {
+
+const size_t PAYLOAD_WORDS = flight_recorder::SLOT_PAYLOAD / 8;
+
+uint64_t finished(uint64_t sequence) { return (sequence + 1) << 1; }
+uint64_t writing(uint64_t sequence) { return finished(sequence) | 1; }
+
+size_t slots_for(size_t size) {
+    return size == 0 ? 1 : (size + flight_recorder::SLOT_PAYLOAD - 1) / flight_recorder::SLOT_PAYLOAD;
+}
+
+}
+
+flight_recorder::flight_recorder(size_t capacity) : slots(nullptr), allocation(nullptr), slot_count(0), mask(0) {
+    static_assert(sizeof(slot) == SLOT_BYTES, "a slot should take up exactly one cache line");
+    if(capacity == 0)
+        throw std::invalid_argument("flight_recorder capacity must be positive");
+
+    slot_count = round_up_power_of_two((capacity + SLOT_BYTES - 1) / SLOT_BYTES);
+    mask = slot_count - 1;
+
+    allocation = new uint8_t[(slot_count + 1) * SLOT_BYTES];
+    size_t offset = reinterpret_cast<uintptr_t>(allocation) % SLOT_BYTES;
+    slots = reinterpret_cast<slot*>(allocation + (offset ? SLOT_BYTES - offset : 0));
+    for(size_t i = 0; i < slot_count; i++) {
+        slot *fresh = new(&slots[i]) slot;
+        fresh->stamp.store(0, std::memory_order_relaxed);
+        fresh->header.store(0, std::memory_order_relaxed);
+        for(std::atomic<uint64_t>& word : fresh->payload)
+            word.store(0, std::memory_order_relaxed);
+    }
+}
+
+flight_recorder::~flight_recorder() {
+    // Slots only hold atomic integers, which need no destruction
+    delete[] allocation;
+}
+
+size_t flight_recorder::max_record() const {
+    return std::min<size_t>(slot_count * SLOT_PAYLOAD, UINT32_MAX);
+}
+
+bool flight_recorder::claim(slot& target, uint64_t sequence) {
+    uint64_t stamp = target.stamp.load(std::memory_order_relaxed);
+    for(unsigned spins = 0;; spins++) {
+        if(stamp != 0 && (stamp >> 1) - 1 > sequence)
+            return false;
+        if(stamp & 1) {
+            // A writer a whole ring behind is still copying into this slot
+            if(spins >= 64)
+                std::this_thread::yield();
+            stamp = target.stamp.load(std::memory_order_relaxed);
+            continue;
+        }
+        if(target.stamp.compare_exchange_weak(stamp, writing(sequence), std::memory_order_relaxed)) {
+            // Readers that see any of the bytes written next also see this stamp
+            std::atomic_thread_fence(std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+uint64_t flight_recorder::append(const void *data, size_t size) {
+    if(size > max_record())
+        throw std::length_error("flight_recorder record larger than the ring");
+
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+    size_t count = slots_for(size);
+    uint64_t first = next.fetch_add(count, std::memory_order_relaxed);
+
+    for(size_t i = 0; i < count; i++) {
+        uint64_t sequence = first + i;
+        slot& target = slots[sequence & mask];
+        if(!claim(target, sequence))
+            continue;
+
+        target.header.store(static_cast<uint64_t>(size) << 32 | i, std::memory_order_relaxed);
+        size_t offset = i * SLOT_PAYLOAD;
+        for(size_t w = 0; w < PAYLOAD_WORDS; w++, offset += 8) {
+            uint64_t word = 0;
+            if(offset < size)
+                std::memcpy(&word, bytes + offset, std::min<size_t>(8, size - offset));
+            target.payload[w].store(word, std::memory_order_relaxed);
+        }
+        target.stamp.store(finished(sequence), std::memory_order_release);
+    }
+    return first;
+}
+
+bool flight_recorder::read(uint64_t sequence, uint64_t& header, uint64_t *payload) const {
+    const slot& source = slots[sequence & mask];
+    uint64_t stamp = source.stamp.load(std::memory_order_acquire);
+    if(stamp != finished(sequence))
+        return false;
+
+    header = source.header.load(std::memory_order_relaxed);
+    for(size_t w = 0; w < PAYLOAD_WORDS; w++)
+        payload[w] = source.payload[w].load(std::memory_order_relaxed);
+
+    // If a writer got to the slot meanwhile, its stamp is visible now
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return source.stamp.load(std::memory_order_relaxed) == stamp;
+}
+
+std::vector<flight_recorder::record> flight_recorder::snapshot() const {
+    std::vector<record> records;
+    uint64_t end = next.load(std::memory_order_acquire);
+    uint64_t sequence = end > slot_count ? end - slot_count : 0;
+
+    uint64_t header, payload[PAYLOAD_WORDS];
+    while(sequence < end) {
+        // Skip to the first slot of a complete record
+        if(!read(sequence, header, payload) || static_cast<uint32_t>(header) != 0) {
+            sequence++;
+            continue;
+        }
+
+        size_t size = static_cast<size_t>(header >> 32);
+        size_t count = slots_for(size);
+        record copy;
+        copy.sequence = sequence;
+        copy.bytes.resize(size);
+
+        size_t i = 0;
+        for(;;) {
+            size_t offset = i * SLOT_PAYLOAD;
+            if(offset < size)
+                std::memcpy(&copy.bytes[offset], payload, std::min(SLOT_PAYLOAD, size - offset));
+            if(++i == count || !read(sequence + i, header, payload)
+               || header != (static_cast<uint64_t>(size) << 32 | i))
+                break;
+        }
+
+        if(i == count)
+            records.push_back(std::move(copy));
+        sequence += i;
+    }
+    return records;
+}
+
+// End of flight_recorder definitions
@@ -1,13 +1,245 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Lock-free byte ring buffers: a FIFO with zero-copy reads and writes, and an overwriting flight recorder.
+ *
+ * What is a circular buffer?
+ *   A fixed-size array used as a FIFO queue: a producer writes at the tail, a consumer reads from the head, and both
+ *   wrap around to the start of the array when they reach its end.
+ *
+ * Why is this useful?
+ *   `circular_buffer` moves bytes from one thread to another without allocating and without locks. Rather than
+ *   copying data in and out, a producer `reserve`s a region of the ring, writes into it in place (serializes a log
+ *   record, receives from a socket) and `commit`s it; the consumer `peek`s at the committed bytes, hands them straight
+ *   to write(2) or a parser, and `consume`s them.
+ *
+ *   `flight_recorder` never makes writers wait for a reader: it keeps the most recent records, overwriting the oldest
+ *   ones, and a reader takes a snapshot of whatever is there when something goes wrong. That is what tracing on a hot
+ *   path needs, where appending must cost a few atomic operations and losing old records is expected.
+ *
+ * How are they implemented?
+ *   The capacity is a power of two, and positions are 64-bit counters that never wrap; a position is reduced modulo
+ *   the capacity only to address the array.
+ *
+ *   In `circular_buffer`, the consumer publishes its position for the producer and vice versa, each on its own cache
+ *   line, and each side keeps a cached copy of the other's position so that it only touches the shared line when the
+ *   cached value says the ring is full (or empty). With `producers::multiple`, producers claim space by advancing a
+ *   shared claim counter with compare-and-swap. Claims are committed in claim order: a producer whose claim comes after
+ *   a slower one waits for it before publishing, so the consumer only ever sees contiguous committed bytes.
+ *
+ *   In a plain ring, a region that reaches the end of the array stops there: `reserve` and `peek` may return fewer
+ *   bytes than are free or committed, and the rest is available from the start of the array. With
+ *   `mapping::magic`, the ring is mapped twice, back to back, in virtual memory (a memfd mapped at two adjacent
+ *   addresses, Linux only), so a region running off the end of the first mapping continues into the second, which is
+ *   the start of the same memory. Every region is then contiguous, and `reserve(n)` succeeds as soon as n bytes are
+ *   free. Magic rings round their capacity up to a whole number of pages.
+ *
+ *   `flight_recorder` is an array of 64-byte slots, each carrying a sequence stamp and 48 bytes of a record; a record
+ *   spans as many consecutive slots as it needs. A writer claims its slots with a single fetch_add on the next
+ *   sequence number and fills them in like a seqlock: it stamps each slot as being written, copies its bytes, and
+ *   stamps it again with the slot's sequence number when done. A reader copies a slot and keeps the copy only if the
+ *   slot carried the expected finished stamp both before and after, so a snapshot holds every record that was
+ *   complete and not overwritten while it was taken, each one intact. Writers only ever wait for each other when one
+ *   laps another that is still copying into the same slot, a whole ring behind.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_CIRCULAR_BUFFER_H
 #define DATA_STRUCTURES_CIRCULAR_BUFFER_H
 
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A bounded FIFO of bytes for one consumer and one or more producers.
+ */
 class circular_buffer {
+public:
+    enum class producers { single, multiple };
+    enum class mapping { plain, magic };
+
+    /**
+     * A contiguous range of the ring.
+     */
+    struct region {
+        uint8_t *data;
+        size_t size;
+        // Where the region starts in the byte stream; multiple producers commit by it
+        uint64_t position;
+
+        explicit operator bool() const { return size > 0; }
+    };
+
+    /**
+     * @param capacity rounded up to a power of two, and for magic rings to a whole number of pages
+     * @throws std::invalid_argument if capacity is 0
+     * @throws std::system_error if a magic ring cannot be mapped
+     */
+    explicit circular_buffer(size_t capacity, producers producer_mode = producers::single,
+                             mapping memory = mapping::plain);
+    ~circular_buffer();
+
+    circular_buffer(const circular_buffer&) = delete;
+    circular_buffer& operator=(const circular_buffer&) = delete;
+
+
+    // Producer side
+
+    /**
+     * Reserves up to `n` contiguous bytes to write into. With a single producer, nothing is claimed until `commit`.
+     *
+     * @return the region, which is empty if the ring is full
+     */
+    region reserve(size_t n);
+    /**
+     * Publishes the first `n` bytes of the last reservation. Single producer only.
+     */
+    void commit(size_t n);
+    /**
+     * Publishes a whole reservation. With multiple producers, waits for earlier reservations to be committed first.
+     */
+    void commit(const region& reserved);
+
+
+    // Consumer side
+
+    /**
+     * @return the committed bytes not yet consumed, as one contiguous region (up to the end of the array in a plain
+     *   ring)
+     */
+    region peek();
+    /**
+     * Releases the first `n` bytes returned by `peek` back to the producers.
+     */
+    void consume(size_t n);
+
+
+    /**
+     * @return the number of committed bytes not yet consumed. Only a snapshot when other threads are active.
+     */
+    size_t size() const {
+        return static_cast<size_t>(written.load(std::memory_order_acquire) - read.load(std::memory_order_acquire));
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return ring_size; }
+    bool is_magic() const { return magic; }
+
+private:
+    static const size_t CACHE_LINE = 64;
+
+    // Read-only after construction
+    uint8_t *ring;
+    // What to free for a plain ring, which is aligned to a cache line within it
+    uint8_t *allocation = nullptr;
+    size_t ring_size;
+    uint64_t mask;
+    bool multiple_producers;
+    bool magic;
+    char pad0[CACHE_LINE];
+
+    // Producer side: bytes committed, and the single producer's view of `read`
+    std::atomic<uint64_t> written{0};
+    uint64_t cached_read = 0;
+    char pad1[CACHE_LINE];
+
+    // Multiple producers only: bytes claimed, always >= written
+    std::atomic<uint64_t> claimed{0};
+    char pad2[CACHE_LINE];
+
+    // Consumer side: bytes consumed, and the consumer's view of `written`
+    std::atomic<uint64_t> read{0};
+    uint64_t cached_written = 0;
+    char pad3[CACHE_LINE];
+
+    size_t contiguous(uint64_t position, size_t n) const;
+    void map_magic();
+};
+
+/**
+ * A ring of the most recent records, appended to by any number of threads and read by snapshot.
+ */
+class flight_recorder {
+public:
+    static const size_t SLOT_BYTES = 64;
+    // The bytes of a record each slot carries
+    static const size_t SLOT_PAYLOAD = 48;
+
+    struct record {
+        // The sequence number of the record's first slot; records lost between two records leave a gap
+        uint64_t sequence;
+        std::vector<uint8_t> bytes;
+    };
+
+    /**
+     * @param capacity in bytes, rounded up to a power of two number of slots
+     * @throws std::invalid_argument if capacity is 0
+     */
+    explicit flight_recorder(size_t capacity);
+    ~flight_recorder();
+
+    flight_recorder(const flight_recorder&) = delete;
+    flight_recorder& operator=(const flight_recorder&) = delete;
+
+
+    /**
+     * Appends a record, overwriting the oldest ones if the ring is full. Safe to call from any number of threads.
+     *
+     * @return the record's sequence number
+     * @throws std::length_error if the record is larger than `max_record`
+     */
+    uint64_t append(const void *data, size_t size);
+    /**
+     * Copies the records currently in the ring, oldest first, without stopping writers. Records still being written,
+     *   or overwritten while the snapshot was taken, are left out.
+     */
+    std::vector<record> snapshot() const;
+
+
+    /**
+     * @return the size of the largest record, which takes up the whole ring
+     */
+    size_t max_record() const;
+    size_t capacity() const { return slot_count * SLOT_BYTES; }
+    /**
+     * @return the number of slots appended so far, including overwritten ones
+     */
+    uint64_t appended() const { return next.load(std::memory_order_relaxed); }
+
+private:
+    struct slot {
+        // 0 if never written, otherwise (sequence + 1) * 2, plus 1 while being written
+        std::atomic<uint64_t> stamp;
+        // The record's size in the high half, the slot's index within the record in the low half
+        std::atomic<uint64_t> header;
+        // The bytes are copied in as words so that a reader racing with a writer reads stale data, not a data race
+        std::atomic<uint64_t> payload[SLOT_PAYLOAD / 8];
+    };
+
+    // Read-only after construction
+    slot *slots;
+    uint8_t *allocation;
+    size_t slot_count;
+    uint64_t mask;
+    char pad0[SLOT_BYTES];
+
+    // The sequence number of the next slot to append
+    std::atomic<uint64_t> next{0};
+    char pad1[SLOT_BYTES];
 
+    /**
+     * Waits for the slot to be free of older writers and stamps it as being written for `sequence`.
+     *
+     * @return false if a newer record has already taken the slot
+     */
+    bool claim(slot& target, uint64_t sequence);
+    /**
+     * Copies the slot holding `sequence`.
+     *
+     * @return false if the slot holds another sequence number or is being written
+     */
+    bool read(uint64_t sequence, uint64_t& header, uint64_t *payload) const;
 };
 
 
@@ -1,5 +1,271 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Implementation of a multi-cursor gap buffer.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #include "gap_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+const size_t gap_buffer::MIN_CAPACITY;
+const size_t gap_buffer::NONE;
+
+gap_buffer::gap_buffer(const std::string& text) : length(text.size()) {
+    buffer.resize(length + std::max(MIN_CAPACITY, length / 4));
+    std::memcpy(buffer.data(), text.data(), length);
+    gaps.push_back(gap{length, buffer.size(), 0});
+    gap_of.push_back(0);
+}
+
+size_t gap_buffer::gap_index(cursor id) const {
+    if(id >= gap_of.size() || gap_of[id] == NONE)
+        throw std::out_of_range("gap_buffer: no such cursor");
+    return gap_of[id];
+}
+
+size_t gap_buffer::logical_position(size_t index) const {
+    size_t position = gaps[index].start;
+    for(size_t i = 0; i < index; i++)
+        position -= gaps[i].size();
+    return position;
+}
+
+size_t gap_buffer::position(cursor id) const {
+    return logical_position(gap_index(id));
+}
+
+size_t gap_buffer::gap_size(cursor id) const {
+    return gaps[gap_index(id)].size();
+}
+
+void gap_buffer::swap_gaps(size_t first) {
+    // The gaps are adjacent, so they only have to trade sizes
+    gap& left = gaps[first];
+    gap& right = gaps[first + 1];
+    size_t boundary = left.start + right.size();
+    right.start = left.start;
+    left.end = right.end;
+    left.start = right.end = boundary;
+
+    std::swap(left, right);
+    gap_of[left.owner] = first;
+    gap_of[right.owner] = first + 1;
+}
+
+size_t gap_buffer::move_gap(size_t index, size_t target) {
+    size_t current = logical_position(index);
+
+    while(current > target) {
+        size_t floor = index ? gaps[index - 1].end : 0;
+        if(gaps[index].start == floor) {
+            swap_gaps(index - 1);
+            index--;
+            continue;
+        }
+        size_t distance = std::min(current - target, gaps[index].start - floor);
+        gap& moving = gaps[index];
+        std::memmove(buffer.data() + moving.end - distance, buffer.data() + moving.start - distance, distance);
+        moving.start -= distance;
+        moving.end -= distance;
+        current -= distance;
+    }
+
+    while(current < target) {
+        size_t ceiling = index + 1 < gaps.size() ? gaps[index + 1].start : buffer.size();
+        if(gaps[index].end == ceiling) {
+            swap_gaps(index);
+            index++;
+            continue;
+        }
+        size_t distance = std::min(target - current, ceiling - gaps[index].end);
+        gap& moving = gaps[index];
+        std::memmove(buffer.data() + moving.start, buffer.data() + moving.end, distance);
+        moving.start += distance;
+        moving.end += distance;
+        current += distance;
+    }
+    return index;
+}
+
+void gap_buffer::reallocate(size_t size, size_t favoured) {
+    size_t free = size - length;
+    size_t share = free / (2 * gaps.size());
+    size_t kept = 0;
+    for(size_t i = 0; i < gaps.size(); i++) {
+        if(i != favoured)
+            kept += std::min(gaps[i].size(), share);
+    }
+
+    std::vector<char> fresh(size);
+    size_t from = 0, to = 0;
+    for(size_t i = 0; i < gaps.size(); i++) {
+        size_t run = gaps[i].start - from;
+        std::memcpy(fresh.data() + to, buffer.data() + from, run);
+        to += run;
+        from = gaps[i].end;
+
+        size_t room = i == favoured ? free - kept : std::min(gaps[i].size(), share);
+        gaps[i].start = to;
+        to += room;
+        gaps[i].end = to;
+    }
+    std::memcpy(fresh.data() + to, buffer.data() + from, buffer.size() - from);
+    buffer.swap(fresh);
+}
+
+void gap_buffer::shrink_if_sparse(size_t index) {
+    size_t size = buffer.size();
+    while(size > MIN_CAPACITY && length < size / 4)
+        size /= 2;
+    if(size != buffer.size())
+        reallocate(std::max(MIN_CAPACITY, size), index);
+}
+
+gap_buffer::cursor gap_buffer::add_cursor(size_t position) {
+    if(position > length)
+        throw std::out_of_range("gap_buffer: cursor past the end of the text");
+
+    // The new gap goes before the first gap past `position`, at the address of `position`
+    size_t index = 0, address = position;
+    while(index < gaps.size() && logical_position(index) <= position)
+        address += gaps[index++].size();
+
+    cursor id = std::find(gap_of.begin(), gap_of.end(), NONE) - gap_of.begin();
+    if(id == gap_of.size())
+        gap_of.push_back(NONE);
+
+    gaps.insert(gaps.begin() + index, gap{address, address, id});
+    for(size_t i = index; i < gaps.size(); i++)
+        gap_of[gaps[i].owner] = i;
+    return id;
+}
+
+void gap_buffer::remove_cursor(cursor id) {
+    size_t index = gap_index(id);
+    if(gaps.size() == 1)
+        throw std::logic_error("gap_buffer: cannot remove the last cursor");
+
+    // Bring the gap next to a neighbouring one and hand its space over
+    size_t neighbour = index ? index - 1 : index + 1;
+    index = move_gap(index, logical_position(neighbour));
+    if(neighbour < index)
+        gaps[neighbour].end = gaps[index].end;
+    else
+        gaps[neighbour].start = gaps[index].start;
+
+    gaps.erase(gaps.begin() + index);
+    gap_of[id] = NONE;
+    for(size_t i = index; i < gaps.size(); i++)
+        gap_of[gaps[i].owner] = i;
+}
+
+void gap_buffer::move(cursor id, size_t position) {
+    size_t index = gap_index(id);
+    if(position > length)
+        throw std::out_of_range("gap_buffer: cursor past the end of the text");
+    move_gap(index, position);
+}
+
+void gap_buffer::insert(cursor id, const char *text, size_t count) {
+    size_t index = gap_index(id);
+    if(gaps[index].size() < count) {
+        // Spread the free space again while there is plenty of it, otherwise grow geometrically; either way this
+        //   gap ends up with at least half of the free space
+        size_t free = buffer.size() - length;
+        if(free >= 2 * count && free >= buffer.size() / 8)
+            reallocate(buffer.size(), index);
+        else
+            reallocate(std::max(2 * buffer.size(), length + 2 * count + MIN_CAPACITY), index);
+    }
+
+    std::memcpy(buffer.data() + gaps[index].start, text, count);
+    gaps[index].start += count;
+    length += count;
+}
+
+size_t gap_buffer::erase_before(cursor id, size_t n) {
+    size_t index = gap_index(id);
+    size_t erased = 0;
+    while(erased < n) {
+        size_t floor = index ? gaps[index - 1].end : 0;
+        if(gaps[index].start == floor) {
+            if(index == 0)
+                break;
+            swap_gaps(index - 1);
+            index--;
+            continue;
+        }
+        size_t count = std::min(n - erased, gaps[index].start - floor);
+        gaps[index].start -= count;
+        erased += count;
+    }
+    length -= erased;
+    shrink_if_sparse(index);
+    return erased;
+}
+
+size_t gap_buffer::erase_after(cursor id, size_t n) {
+    size_t index = gap_index(id);
+    size_t erased = 0;
+    while(erased < n) {
+        size_t ceiling = index + 1 < gaps.size() ? gaps[index + 1].start : buffer.size();
+        if(gaps[index].end == ceiling) {
+            if(index + 1 == gaps.size())
+                break;
+            swap_gaps(index);
+            index++;
+            continue;
+        }
+        size_t count = std::min(n - erased, ceiling - gaps[index].end);
+        gaps[index].end += count;
+        erased += count;
+    }
+    length -= erased;
+    shrink_if_sparse(index);
+    return erased;
+}
+
+gap_buffer::view gap_buffer::before(cursor id) const {
+    size_t index = gap_index(id);
+    size_t floor = index ? gaps[index - 1].end : 0;
+    return view{buffer.data() + floor, gaps[index].start - floor};
+}
+
+gap_buffer::view gap_buffer::after(cursor id) const {
+    size_t index = gap_index(id);
+    size_t ceiling = index + 1 < gaps.size() ? gaps[index + 1].start : buffer.size();
+    return view{buffer.data() + gaps[index].end, ceiling - gaps[index].end};
+}
+
+std::vector<gap_buffer::view> gap_buffer::segments() const {
+    std::vector<view> runs;
+    size_t from = 0;
+    for(const gap& g : gaps) {
+        runs.push_back(view{buffer.data() + from, g.start - from});
+        from = g.end;
+    }
+    runs.push_back(view{buffer.data() + from, buffer.size() - from});
+    return runs;
+}
+
+std::string gap_buffer::to_string() const {
+    std::string text;
+    text.reserve(length);
+    for(const view& run : segments())
+        text.append(run.data, run.size);
+    return text;
+}
+
+char gap_buffer::operator[](size_t index) const {
+    size_t address = index;
+    for(const gap& g : gaps) {
+        if(address < g.start)
+            break;
+        address += g.size();
+    }
+    return buffer[address];
+}
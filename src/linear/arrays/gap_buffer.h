@@ -1,13 +1,174 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * A text buffer for editors, with one gap per cursor.
+ *
+ * What is a gap buffer?
+ *   An array holding the text with an unused stretch, the gap, at the cursor. Typing fills the gap from its start and
+ *   deleting widens it, so editing at the cursor is O(1); moving the cursor moves the gap, by shifting the characters
+ *   between the old and the new position across it.
+ *
+ * Why is this useful?
+ *   Edits cluster: people type and delete around the cursor far more than they jump. A gap buffer makes those edits
+ *   as cheap as appending to a string while keeping the text in at most a couple of contiguous runs, which are what
+ *   searching, rendering and writing to disk want. Moving the cursor costs O(distance), which is a memmove that
+ *   runs at memory bandwidth.
+ *
+ *   With several cursors (multi-cursor editing, or several views of one file) a single gap would shuttle back and
+ *   forth between them. Here each cursor owns a gap, so typing at all of them in turn stays O(1) per character.
+ *
+ * How is it implemented?
+ *   The gaps are kept sorted by address. The text is the runs between them, and a cursor's position is its gap's
+ *   address minus the size of the gaps before it, which costs O(number of cursors) to compute. Moving a gap shifts
+ *   text across it with memmove. When it reaches another gap, the two are adjacent with no text between them, so
+ *   they are swapped simply by exchanging their boundaries; cursors can therefore pass each other freely.
+ *
+ *   Inserting more than a gap holds redistributes the free space: while the buffer has at least twice the insertion
+ *   and an eighth of its size free, the gaps are respread at the same capacity; otherwise the buffer is reallocated
+ *   to at least twice its size. Either way the other gaps keep a bounded share of the free space and the gap being
+ *   typed into gets the rest. Once the text takes up less than a quarter of the buffer, erasing halves it until it
+ *   no longer is, so capacity follows the text without reallocating back and forth.
+ *
+ *   `before` and `after` give direct access to the runs on each side of a cursor's gap: with a single cursor they are
+ *   the two halves of the text.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_GAP_BUFFER_H
 #define DATA_STRUCTURES_GAP_BUFFER_H
 
 
+#include <cstddef>
+#include <string>
+#include <vector>
+
 class gap_buffer {
+public:
+    /**
+     * Identifies a cursor. Cursor 0 is created along with the buffer, at the end of its text.
+     */
+    typedef size_t cursor;
+
+    /**
+     * A read-only run of the text, valid until the buffer is next modified.
+     */
+    struct view {
+        const char *data;
+        size_t size;
+
+        std::string str() const { return std::string(data, size); }
+        bool empty() const { return size == 0; }
+    };
+
+    gap_buffer() : gap_buffer(std::string()) {}
+    explicit gap_buffer(const std::string& text);
+
+
+    /**
+     * Adds a cursor at `position`.
+     *
+     * @return its id; ids of removed cursors are reused
+     * @throws std::out_of_range if position > size()
+     */
+    cursor add_cursor(size_t position);
+    /**
+     * Removes a cursor, moving its gap to a neighbouring one to merge them.
+     *
+     * @throws std::logic_error when removing the last cursor
+     */
+    void remove_cursor(cursor id);
+    /**
+     * Moves a cursor, and its gap with it, in O(distance).
+     *
+     * @throws std::out_of_range if position > size()
+     */
+    void move(cursor id, size_t position);
+    /**
+     * @return the position of the cursor in the text
+     */
+    size_t position(cursor id) const;
+    size_t cursor_count() const { return gaps.size(); }
+
+
+    /**
+     * Inserts text at the cursor, leaving the cursor after it.
+     */
+    void insert(cursor id, const char *text, size_t count);
+    void insert(cursor id, const std::string& text) { insert(id, text.data(), text.size()); }
+    /**
+     * Erases up to `n` characters before the cursor, like backspace.
+     *
+     * @return the number erased
+     */
+    size_t erase_before(cursor id, size_t n);
+    /**
+     * Erases up to `n` characters after the cursor, like delete.
+     *
+     * @return the number erased
+     */
+    size_t erase_after(cursor id, size_t n);
+
+
+    /**
+     * @return the run of text ending at the cursor, back to the previous gap
+     */
+    view before(cursor id) const;
+    /**
+     * @return the run of text starting at the cursor, up to the next gap
+     */
+    view after(cursor id) const;
+    /**
+     * @return the runs making up the text, in order, empty ones included
+     */
+    std::vector<view> segments() const;
+    std::string to_string() const;
+    /**
+     * @return the character at `index`, in O(number of cursors)
+     */
+    char operator[](size_t index) const;
+
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    /**
+     * @return the size of the buffer, text and gaps
+     */
+    size_t capacity() const { return buffer.size(); }
+    size_t gap_size(cursor id) const;
+
+private:
+    static const size_t MIN_CAPACITY = 64;
+
+    struct gap {
+        size_t start, end;
+        cursor owner;
+
+        size_t size() const { return end - start; }
+    };
+
+    std::vector<char> buffer;
+    // Sorted by address
+    std::vector<gap> gaps;
+    // The index in `gaps` of each cursor's gap, or NONE for removed cursors
+    std::vector<size_t> gap_of;
+    size_t length;
+
+    static const size_t NONE = static_cast<size_t>(-1);
 
+    size_t gap_index(cursor id) const;
+    size_t logical_position(size_t index) const;
+    void swap_gaps(size_t first);
+    /**
+     * Moves gaps[index] to `target`, passing other gaps as needed.
+     *
+     * @return the gap's index once there
+     */
+    size_t move_gap(size_t index, size_t target);
+    /**
+     * Lays the text out in a new buffer of `size` bytes. Every gap but `favoured` keeps part of its free space, and
+     *   `favoured` gets the rest.
+     */
+    void reallocate(size_t size, size_t favoured);
+    void shrink_if_sparse(size_t index);
 };
 
 
@@ -0,0 +1,297 @@
+/**
+ * Implementation of a piece table over a persistent treap.
+ **/
+
+#include "piece_table.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PIECE_TABLE_MMAP 1
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+
+/**
+ * The original text: a copy, or a read-only mapping of a file.
+ */
+struct piece_table::source {
+    const char *data = nullptr;
+    size_t size = 0;
+    std::string owned;
+    void *mapping = nullptr;
+
+    source() = default;
+    source(const source&) = delete;
+    source& operator=(const source&) = delete;
+
+    ~source() {
+#if PIECE_TABLE_MMAP
+        if(mapping)
+            munmap(mapping, size);
+#endif
+    }
+};
+
+piece_table::piece_table(const std::string& text) {
+    std::shared_ptr<source> copy = std::make_shared<source>();
+    copy->owned = text;
+    copy->data = copy->owned.data();
+    copy->size = copy->owned.size();
+
+    original = copy;
+    versions.push_back(copy->size ? leaf(false, 0, copy->size) : tree());
+}
+
+piece_table::piece_table(std::shared_ptr<const source> text) : original(std::move(text)) {
+    versions.push_back(original->size ? leaf(false, 0, original->size) : tree());
+}
+
+piece_table piece_table::open(const std::string& path) {
+    std::shared_ptr<source> file = std::make_shared<source>();
+#if PIECE_TABLE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        throw std::system_error(errno, std::generic_category(), "piece_table: open " + path);
+    struct stat status;
+    if(fstat(fd, &status) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "piece_table: stat " + path);
+    }
+
+    file->size = static_cast<size_t>(status.st_size);
+    if(file->size) {
+        void *mapping = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "piece_table: mmap " + path);
+        }
+        file->mapping = mapping;
+        file->data = static_cast<const char*>(mapping);
+    }
+    // The mapping keeps the file alive
+    close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if(!in)
+        throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory),
+                                "piece_table: open " + path);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    file->owned = contents.str();
+    file->data = file->owned.data();
+    file->size = file->owned.size();
+#endif
+    return piece_table(std::shared_ptr<const source>(file));
+}
+
+
+// Define the persistent treap
+
+piece_table::tree piece_table::make(const tree& left, const tree& right, bool in_add, size_t start, size_t length,
+                                    uint32_t priority) const {
+    std::shared_ptr<node> fresh = std::make_shared<node>();
+    fresh->left = left;
+    fresh->right = right;
+    fresh->in_add = in_add;
+    fresh->start = start;
+    fresh->length = length;
+    fresh->total_length = length + (left ? left->total_length : 0) + (right ? right->total_length : 0);
+    fresh->pieces = 1 + (left ? left->pieces : 0) + (right ? right->pieces : 0);
+    fresh->priority = priority;
+    return fresh;
+}
+
+piece_table::tree piece_table::leaf(bool in_add, size_t start, size_t length) {
+    return make(tree(), tree(), in_add, start, length, random.next32());
+}
+
+piece_table::tree piece_table::merge(const tree& left, const tree& right) const {
+    if(!left)
+        return right;
+    if(!right)
+        return left;
+    if(left->priority > right->priority)
+        return make(left->left, merge(left->right, right), left->in_add, left->start, left->length, left->priority);
+    return make(merge(left, right->left), right->right, right->in_add, right->start, right->length, right->priority);
+}
+
+void piece_table::split(const tree& t, size_t position, tree& left, tree& right) {
+    if(!t) {
+        left = right = tree();
+        return;
+    }
+
+    size_t before = t->left ? t->left->total_length : 0;
+    if(position <= before) {
+        tree inner;
+        split(t->left, position, left, inner);
+        right = make(inner, t->right, t->in_add, t->start, t->length, t->priority);
+    } else if(position >= before + t->length) {
+        tree inner;
+        split(t->right, position - before - t->length, inner, right);
+        left = make(t->left, inner, t->in_add, t->start, t->length, t->priority);
+    } else {
+        // Cut the piece: the node keeps its head and its place, and the tail becomes a new piece
+        size_t cut = position - before;
+        left = make(t->left, tree(), t->in_add, t->start, cut, t->priority);
+        right = merge(leaf(t->in_add, t->start + cut, t->length - cut), t->right);
+    }
+}
+
+piece_table::tree piece_table::extend_last(const tree& t, size_t extra) const {
+    if(t->right)
+        return make(t->left, extend_last(t->right, extra), t->in_add, t->start, t->length, t->priority);
+    return make(t->left, tree(), t->in_add, t->start, t->length + extra, t->priority);
+}
+
+// End of persistent treap definitions
+
+
+void piece_table::commit(tree edited) {
+    versions.resize(version + 1);
+    versions.push_back(std::move(edited));
+    version++;
+}
+
+const char *piece_table::data(const node& piece) const {
+    return (piece.in_add ? added.data() : original->data) + piece.start;
+}
+
+size_t piece_table::size() const {
+    return root() ? root()->total_length : 0;
+}
+
+size_t piece_table::piece_count() const {
+    return root() ? root()->pieces : 0;
+}
+
+void piece_table::insert(size_t position, const char *text, size_t length) {
+    if(position > size())
+        throw std::out_of_range("piece_table: insertion past the end of the text");
+    if(length == 0)
+        return;
+
+    tree left, right;
+    split(root(), position, left, right);
+
+    // Typing right after the last insertion extends its piece
+    const node *last = left.get();
+    while(last && last->right)
+        last = last->right.get();
+    bool extends = last && last->in_add && last->start + last->length == added.size();
+
+    size_t start = added.size();
+    added.append(text, length);
+    if(extends)
+        left = extend_last(left, length);
+    else
+        left = merge(left, leaf(true, start, length));
+    commit(merge(left, right));
+}
+
+void piece_table::erase(size_t position, size_t length) {
+    if(position > size())
+        throw std::out_of_range("piece_table: erasure past the end of the text");
+    length = std::min(length, size() - position);
+    if(length == 0)
+        return;
+
+    tree left, rest, middle, right;
+    split(root(), position, left, rest);
+    split(rest, length, middle, right);
+    commit(merge(left, right));
+}
+
+bool piece_table::undo() {
+    if(!can_undo())
+        return false;
+    version--;
+    return true;
+}
+
+bool piece_table::redo() {
+    if(!can_redo())
+        return false;
+    version++;
+    return true;
+}
+
+char piece_table::operator[](size_t index) const {
+    const node *current = root().get();
+    for(;;) {
+        size_t before = current->left ? current->left->total_length : 0;
+        if(index < before) {
+            current = current->left.get();
+        } else if(index < before + current->length) {
+            return data(*current)[index - before];
+        } else {
+            index -= before + current->length;
+            current = current->right.get();
+        }
+    }
+}
+
+std::vector<piece_table::view> piece_table::views(size_t position, size_t length) const {
+    if(position > size())
+        throw std::out_of_range("piece_table: range past the end of the text");
+    length = std::min(length, size() - position);
+
+    // In-order walk from the piece holding `position`, keeping the path on a stack
+    std::vector<view> runs;
+    std::vector<const node*> path;
+    const node *current = root().get();
+    size_t offset = position;
+    while(current) {
+        size_t before = current->left ? current->left->total_length : 0;
+        if(offset < before) {
+            path.push_back(current);
+            current = current->left.get();
+        } else if(offset < before + current->length || !current->right) {
+            offset -= before;
+            break;
+        } else {
+            offset -= before + current->length;
+            current = current->right.get();
+        }
+    }
+
+    while(length > 0 && current) {
+        size_t take = std::min(length, current->length - offset);
+        runs.push_back(view{data(*current) + offset, take});
+        length -= take;
+        offset = 0;
+
+        if(current->right) {
+            current = current->right.get();
+            while(current->left) {
+                path.push_back(current);
+                current = current->left.get();
+            }
+        } else if(!path.empty()) {
+            current = path.back();
+            path.pop_back();
+        } else {
+            current = nullptr;
+        }
+    }
+    return runs;
+}
+
+std::string piece_table::substr(size_t position, size_t length) const {
+    std::string text;
+    for(const view& run : views(position, length))
+        text.append(run.data, run.size);
+    return text;
+}
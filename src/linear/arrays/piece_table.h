@@ -0,0 +1,160 @@
+/**
+ * A text buffer for large files, with constant-time undo and redo.
+ *
+ * What is a piece table?
+ *   A representation of text as a sequence of pieces, each a range of one of two buffers: the original text, which is
+ *   never modified, and an add buffer, which inserted text is only ever appended to. Inserting splits a piece and puts
+ *   a new one, over the freshly appended text, in between; erasing trims or drops pieces. Neither touches the bytes
+ *   of the text itself.
+ *
+ * Why is this useful?
+ *   A gap_buffer has to move its gap to wherever the edit is, which costs O(distance): jumping across a 1 GB file
+ *   shifts hundreds of megabytes. A piece table edits anywhere in O(log pieces) however large the text is. The
+ *   original is never written to, so a file can be mapped into memory and opened in O(1), without reading it, and
+ *   pages of it that are never looked at are never loaded.
+ *
+ *   Since no byte is ever overwritten, an old version of the text is fully described by its old list of pieces.
+ *   Keeping those lists makes undo and redo O(1).
+ *
+ * How is it implemented?
+ *   The pieces are the nodes of a treap ordered by position, each node also storing the length of the text in its
+ *   subtree, so finding the piece at a position and splitting or joining the sequence are O(log pieces) expected.
+ *   The treap is persistent: an edit copies the O(log pieces) nodes on the paths it changes and shares every other
+ *   node with the previous version. Each version is a root, and undo and redo just step through the list of roots.
+ *
+ *   Typing character by character would add a piece per keystroke. When an insertion starts right where the
+ *   previous one ended, the piece before it already ends at the end of the add buffer, so it is extended instead,
+ *   and a run of typing stays a single piece.
+ *
+ *   `open` maps the file read-only with mmap (reading it into memory where mmap is not available). The mapping must
+ *   not be changed by anyone else while the table is alive.
+ **/
+
+#ifndef DATA_STRUCTURES_PIECE_TABLE_H
+#define DATA_STRUCTURES_PIECE_TABLE_H
+
+
+#include "../../primitives/xorshift.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class piece_table {
+public:
+    /**
+     * A read-only run of the text, valid until the table is next edited.
+     */
+    struct view {
+        const char *data;
+        size_t size;
+
+        std::string str() const { return std::string(data, size); }
+    };
+
+    piece_table() : piece_table(std::string()) {}
+    explicit piece_table(const std::string& text);
+
+    /**
+     * Opens a file as the original text, without copying it.
+     *
+     * @throws std::system_error if the file cannot be opened or mapped
+     */
+    static piece_table open(const std::string& path);
+
+
+    /**
+     * Inserts text before `position`.
+     *
+     * @throws std::out_of_range if position > size()
+     */
+    void insert(size_t position, const char *text, size_t length);
+    void insert(size_t position, const std::string& text) { insert(position, text.data(), text.size()); }
+    /**
+     * Erases up to `length` characters starting at `position`.
+     *
+     * @throws std::out_of_range if position > size()
+     */
+    void erase(size_t position, size_t length);
+
+    /**
+     * Reverts the last edit that has not been undone, in O(1).
+     *
+     * @return false if there was none
+     */
+    bool undo();
+    /**
+     * Reapplies the last edit undone, in O(1). Any edit after an undo discards the edits that could be redone.
+     *
+     * @return false if there was none
+     */
+    bool redo();
+    bool can_undo() const { return version > 0; }
+    bool can_redo() const { return version + 1 < versions.size(); }
+
+
+    /**
+     * @return the character at `index`, in O(log pieces)
+     */
+    char operator[](size_t index) const;
+    /**
+     * @return the runs making up [position, position + length), without copying the text
+     */
+    std::vector<view> views(size_t position, size_t length) const;
+    std::string substr(size_t position, size_t length) const;
+    std::string to_string() const { return substr(0, size()); }
+
+
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    size_t piece_count() const;
+    /**
+     * @return the bytes appended to the add buffer so far, by every version
+     */
+    size_t added_bytes() const { return added.size(); }
+
+private:
+    struct source;
+    struct node;
+    typedef std::shared_ptr<const node> tree;
+
+    struct node {
+        tree left, right;
+        // Whether the piece is in the add buffer rather than the original
+        bool in_add;
+        size_t start, length;
+        // Of the subtree
+        size_t total_length, pieces;
+        uint32_t priority;
+    };
+
+    std::shared_ptr<const source> original;
+    std::string added;
+    // The root of every version of the text, and the one being edited
+    std::vector<tree> versions;
+    size_t version = 0;
+    xorshift64_star random{0x9e3779b97f4a7c15ull};
+
+    explicit piece_table(std::shared_ptr<const source> text);
+
+    const tree& root() const { return versions[version]; }
+    void commit(tree edited);
+    const char *data(const node& piece) const;
+
+    tree make(const tree& left, const tree& right, bool in_add, size_t start, size_t length, uint32_t priority) const;
+    tree leaf(bool in_add, size_t start, size_t length);
+    tree merge(const tree& left, const tree& right) const;
+    /**
+     * Splits `t` into the text before `position` and the rest, cutting the piece that straddles it in two.
+     */
+    void split(const tree& t, size_t position, tree& left, tree& right);
+    /**
+     * @return `t` with its last piece `extra` characters longer
+     */
+    tree extend_last(const tree& t, size_t extra) const;
+};
+
+
+#endif //DATA_STRUCTURES_PIECE_TABLE_H
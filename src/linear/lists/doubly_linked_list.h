@@ -1,14 +1,395 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Doubly linked lists: an intrusive one, and one that owns its elements and draws its nodes from a slab pool.
+ *
+ * What is a doubly linked list?
+ *   A linked list whose nodes point to both their neighbours, so it can be walked in both directions and any node
+ *   can be unlinked in O(1) given only a reference to it.
+ *
+ * Why is this useful?
+ *   That last property is what an LRU cache needs: a hash table finds the entry, and the entry is moved to the front
+ *   of the recency list (or evicted from its back) in O(1).
+ *
+ *   `intrusive_doubly_linked_list` keeps the links (a `doubly_linked_list_hook`) inside the elements, so a cache
+ *   whose entries embed a hook never allocates to reorder them. `doubly_linked_list` owns its elements like
+ *   std::list, but takes nodes from a slab pool owned by the list and reuses freed ones, so a list that stays around
+ *   a fixed size, like a full cache, stops allocating altogether. See linked_list.h for the pool.
+ *
+ * How are they implemented?
+ *   A circular list through a sentinel hook owned by the list, so no operation has to special case either end.
+ *   Unlinked hooks have null links, which is how `is_linked` tells whether an element is on a list.
+ *
+ *   Splicing a whole list, or a single element, is O(1). Splicing a range out of another list has to count the
+ *   elements moved to keep `size` O(1), like std::list; within one list it is O(1). `doubly_linked_list` can only
+ *   splice elements within itself, or whole lists, whose node pool it then adopts.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_DOUBLY_LINKED_LIST_H
 #define DATA_STRUCTURES_DOUBLY_LINKED_LIST_H
 
 
+#include "linked_list.h"
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+/**
+ * The links an element embeds to be put on an intrusive_doubly_linked_list.
+ */
+struct doubly_linked_list_hook {
+    doubly_linked_list_hook *prev = nullptr;
+    doubly_linked_list_hook *next = nullptr;
+
+    bool is_linked() const { return next != nullptr; }
+};
+
+/**
+ * A doubly linked list of objects that embed a doubly_linked_list_hook as the member `Hook`. The list does not own
+ *   them.
+ */
+template <typename T, doubly_linked_list_hook T::*Hook>
+class intrusive_doubly_linked_list {
+public:
+    class iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T& reference;
+
+        iterator() = default;
+
+        T& operator*() const { return *linked_list_detail::owner<T, doubly_linked_list_hook, Hook>(current); }
+        T *operator->() const { return linked_list_detail::owner<T, doubly_linked_list_hook, Hook>(current); }
+
+        iterator& operator++() {
+            current = current->next;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            current = current->next;
+            return ret;
+        }
+        iterator& operator--() {
+            current = current->prev;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator ret = *this;
+            current = current->prev;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+
+    private:
+        friend class intrusive_doubly_linked_list;
+        explicit iterator(doubly_linked_list_hook *current) : current(current) {}
+
+        doubly_linked_list_hook *current = nullptr;
+    };
+
+    intrusive_doubly_linked_list() { sentinel.prev = sentinel.next = &sentinel; }
+    intrusive_doubly_linked_list(intrusive_doubly_linked_list&& other) noexcept : intrusive_doubly_linked_list() {
+        swap(other);
+    }
+    intrusive_doubly_linked_list& operator=(intrusive_doubly_linked_list&& other) noexcept {
+        clear();
+        swap(other);
+        return *this;
+    }
+    ~intrusive_doubly_linked_list() { clear(); }
+
+    intrusive_doubly_linked_list(const intrusive_doubly_linked_list&) = delete;
+    intrusive_doubly_linked_list& operator=(const intrusive_doubly_linked_list&) = delete;
+
+
+    void push_front(T& value) { insert(begin(), value); }
+    void push_back(T& value) { insert(end(), value); }
+    void pop_front() { erase(begin()); }
+    void pop_back() { erase(--end()); }
+    /**
+     * Links `value`, which must not be on a list, before `position`.
+     *
+     * @return an iterator to `value`
+     */
+    iterator insert(iterator position, T& value);
+    /**
+     * Unlinks the element at `position`.
+     *
+     * @return an iterator to the element that followed it
+     */
+    iterator erase(iterator position);
+    /**
+     * Unlinks `value`, which must be on this list.
+     */
+    void erase(T& value) { erase(iterator_to(value)); }
+    /**
+     * Moves every element of `other` before `position`.
+     */
+    void splice(iterator position, intrusive_doubly_linked_list& other) {
+        splice(position, other, other.begin(), other.end(), other.count);
+    }
+    /**
+     * Moves the element at `element`, which is on `other`, before `position`.
+     */
+    void splice(iterator position, intrusive_doubly_linked_list& other, iterator element) {
+        if(position != element && position.current != element.current->next)
+            splice(position, other, element, std::next(element), 1);
+    }
+    /**
+     * Moves [first, last) from `other` before `position`. O(1) if `other` is this list, O(last - first) otherwise.
+     */
+    void splice(iterator position, intrusive_doubly_linked_list& other, iterator first, iterator last) {
+        splice(position, other, first, last, &other == this ? 0 : std::distance(first, last));
+    }
+    /**
+     * Unlinks every element.
+     */
+    void clear();
+
+
+    T& front() { return *begin(); }
+    T& back() { return *--end(); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    iterator begin() { return iterator(sentinel.next); }
+    iterator end() { return iterator(&sentinel); }
+    iterator iterator_to(T& value) { return iterator(&(value.*Hook)); }
+
+    void swap(intrusive_doubly_linked_list& other) noexcept;
+
+private:
+    doubly_linked_list_hook sentinel;
+    size_t count = 0;
+
+    /**
+     * Moves [first, last), holding `moved` elements, from `other` before `position`.
+     */
+    void splice(iterator position, intrusive_doubly_linked_list& other, iterator first, iterator last, size_t moved);
+};
+
+
+/**
+ * A doubly linked list that owns its elements, with nodes drawn from a per-list slab pool.
+ */
+template <typename T>
 class doubly_linked_list {
+    struct node {
+        doubly_linked_list_hook hook;
+        T value;
+
+        template <typename... Args>
+        explicit node(Args&&... args) : value(std::forward<Args>(args)...) {}
+    };
+
+    typedef intrusive_doubly_linked_list<node, &node::hook> links_type;
 
+public:
+    class iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T& reference;
+
+        iterator() = default;
+
+        T& operator*() const { return position->value; }
+        T *operator->() const { return &position->value; }
+
+        iterator& operator++() {
+            ++position;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++position;
+            return ret;
+        }
+        iterator& operator--() {
+            --position;
+            return *this;
+        }
+        iterator operator--(int) {
+            iterator ret = *this;
+            --position;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return position == other.position; }
+        bool operator!=(const iterator& other) const { return position != other.position; }
+
+    private:
+        friend class doubly_linked_list;
+        explicit iterator(typename links_type::iterator position) : position(position) {}
+
+        typename links_type::iterator position;
+    };
+
+    doubly_linked_list() = default;
+    doubly_linked_list(const doubly_linked_list& other) {
+        for(auto& n : const_cast<links_type&>(other.links))
+            push_back(n.value);
+    }
+    doubly_linked_list(doubly_linked_list&& other) noexcept { swap(other); }
+    doubly_linked_list& operator=(doubly_linked_list other) {
+        swap(other);
+        return *this;
+    }
+    ~doubly_linked_list() { clear(); }
+
+
+    void push_front(const T& value) { emplace(begin(), value); }
+    void push_front(T&& value) { emplace(begin(), std::move(value)); }
+    void push_back(const T& value) { emplace(end(), value); }
+    void push_back(T&& value) { emplace(end(), std::move(value)); }
+    void pop_front() { erase(begin()); }
+    void pop_back() { erase(--end()); }
+    iterator insert(iterator position, const T& value) { return emplace(position, value); }
+    template <typename... Args>
+    iterator emplace(iterator position, Args&&... args) {
+        return iterator(links.insert(position.position, *pool.create(std::forward<Args>(args)...)));
+    }
+    /**
+     * Removes the element at `position`.
+     *
+     * @return an iterator to the element that followed it
+     */
+    iterator erase(iterator position) {
+        node& removed = *position.position;
+        iterator next(links.erase(position.position));
+        pool.destroy(&removed);
+        return next;
+    }
+    /**
+     * Moves every element of `other` before `position`, in O(1). This list takes over other's node pool.
+     */
+    void splice(iterator position, doubly_linked_list& other) {
+        links.splice(position.position, other.links);
+        pool.adopt(other.pool);
+    }
+    /**
+     * Moves the element at `element` before `position`, in O(1).
+     */
+    void splice(iterator position, iterator element) { links.splice(position.position, links, element.position); }
+    /**
+     * Moves [first, last) before `position`, in O(1).
+     */
+    void splice(iterator position, iterator first, iterator last) {
+        links.splice(position.position, links, first.position, last.position);
+    }
+    void clear() {
+        while(!empty())
+            pop_front();
+    }
+
+
+    T& front() { return links.front().value; }
+    T& back() { return links.back().value; }
+    size_t size() const { return links.size(); }
+    bool empty() const { return links.empty(); }
+
+    iterator begin() { return iterator(links.begin()); }
+    iterator end() { return iterator(links.end()); }
+
+    void swap(doubly_linked_list& other) noexcept {
+        links.swap(other.links);
+        pool.swap(other.pool);
+    }
+
+private:
+    links_type links;
+    linked_list_detail::slab_pool<node> pool;
 };
 
 
+// Define intrusive_doubly_linked_list
+
+template <typename T, doubly_linked_list_hook T::*Hook>
+typename intrusive_doubly_linked_list<T, Hook>::iterator intrusive_doubly_linked_list<T, Hook>::insert(
+        iterator position, T& value) {
+    doubly_linked_list_hook *hook = &(value.*Hook);
+    doubly_linked_list_hook *next = position.current;
+    hook->prev = next->prev;
+    hook->next = next;
+    next->prev->next = hook;
+    next->prev = hook;
+    count++;
+    return iterator(hook);
+}
+
+template <typename T, doubly_linked_list_hook T::*Hook>
+typename intrusive_doubly_linked_list<T, Hook>::iterator intrusive_doubly_linked_list<T, Hook>::erase(
+        iterator position) {
+    doubly_linked_list_hook *hook = position.current;
+    doubly_linked_list_hook *next = hook->next;
+    hook->prev->next = next;
+    next->prev = hook->prev;
+    hook->prev = hook->next = nullptr;
+    count--;
+    return iterator(next);
+}
+
+template <typename T, doubly_linked_list_hook T::*Hook>
+void intrusive_doubly_linked_list<T, Hook>::splice(iterator position, intrusive_doubly_linked_list& other,
+                                                   iterator first, iterator last, size_t moved) {
+    if(first == last)
+        return;
+
+    doubly_linked_list_hook *head = first.current, *tail = last.current->prev;
+    // Cut [head, tail] out of its list
+    head->prev->next = last.current;
+    last.current->prev = head->prev;
+
+    // And link it in before position
+    doubly_linked_list_hook *next = position.current;
+    head->prev = next->prev;
+    tail->next = next;
+    next->prev->next = head;
+    next->prev = tail;
+
+    other.count -= moved;
+    count += moved;
+}
+
+template <typename T, doubly_linked_list_hook T::*Hook>
+void intrusive_doubly_linked_list<T, Hook>::clear() {
+    doubly_linked_list_hook *hook = sentinel.next;
+    while(hook != &sentinel) {
+        doubly_linked_list_hook *next = hook->next;
+        hook->prev = hook->next = nullptr;
+        hook = next;
+    }
+    sentinel.prev = sentinel.next = &sentinel;
+    count = 0;
+}
+
+template <typename T, doubly_linked_list_hook T::*Hook>
+void intrusive_doubly_linked_list<T, Hook>::swap(intrusive_doubly_linked_list& other) noexcept {
+    std::swap(sentinel, other.sentinel);
+    std::swap(count, other.count);
+    // Point each chain's ends back at the sentinel that now owns it
+    for(intrusive_doubly_linked_list *list : {this, &other}) {
+        doubly_linked_list_hook& s = list->sentinel;
+        if(list->count == 0) {
+            s.prev = s.next = &s;
+        } else {
+            s.next->prev = &s;
+            s.prev->next = &s;
+        }
+    }
+}
+
+// End of intrusive_doubly_linked_list definitions
+
+
 #endif //DATA_STRUCTURES_DOUBLY_LINKED_LIST_H
@@ -1,14 +1,501 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * Singly linked lists: an intrusive one, and one that owns its elements and draws its nodes from a slab pool.
+ *
+ * What is a linked list?
+ *   A sequence stored as a chain of nodes, each pointing to the next. Inserting or removing next to a known node is
+ *   O(1), as is moving a whole chain from one list to another (splicing), but reaching the i-th element is O(i).
+ *
+ * Why is this useful?
+ *   `intrusive_linked_list` does not allocate anything: the link (a `linked_list_hook`) is a member of the element
+ *   itself, so objects can be put on and taken off lists without touching the allocator, and one object can sit on
+ *   several lists at once through several hooks. The list never owns its elements.
+ *
+ *   `linked_list` owns copies of its elements like std::forward_list, but allocates its nodes from slabs owned by the
+ *   list rather than one by one, and reuses freed nodes. Nodes of one list stay close together in memory, and a list
+ *   whose size oscillates stops allocating once it has reached its peak.
+ *
+ * How are they implemented?
+ *   The intrusive list keeps a sentinel hook before the first element and a pointer to the last hook, so pushing at
+ *   either end and splicing a whole list after any position are O(1). Hooks are converted back to their element
+ *   with the member's offset.
+ *
+ *   `linked_list` is an intrusive list of nodes that each hold a hook and a value. Its pool hands out nodes from
+ *   slabs that double in size up to 4096 nodes, and keeps freed nodes on a free list threaded through their storage.
+ *   Splicing another linked_list adopts that list's slabs along with its nodes, so it stays O(1).
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_LINKED_LIST_H
 #define DATA_STRUCTURES_LINKED_LIST_H
 
 
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * The link an element embeds to be put on an intrusive_linked_list.
+ */
+struct linked_list_hook {
+    linked_list_hook *next = nullptr;
+};
+
+namespace linked_list_detail {
+
+/**
+ * @return the object whose hook `Member` is `hook`
+ */
+template <typename T, typename Hook, Hook T::*Member>
+T *owner(Hook *hook) {
+    // Find the member's offset from a dummy object's address; this folds to a constant
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    T *object = reinterpret_cast<T*>(&storage);
+    size_t offset = reinterpret_cast<char*>(&(object->*Member)) - reinterpret_cast<char*>(object);
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(hook) - offset);
+}
+
+/**
+ * Allocates Nodes from slabs that double in size, recycling freed nodes.
+ */
+template <typename Node>
+class slab_pool {
+public:
+    slab_pool() = default;
+    ~slab_pool() { release(); }
+
+    slab_pool(const slab_pool&) = delete;
+    slab_pool& operator=(const slab_pool&) = delete;
+
+    template <typename... Args>
+    Node *create(Args&&... args) {
+        slot *s = take();
+        try {
+            return new(s) Node(std::forward<Args>(args)...);
+        } catch(...) {
+            give_back(s);
+            throw;
+        }
+    }
+
+    void destroy(Node *n) {
+        n->~Node();
+        give_back(reinterpret_cast<slot*>(n));
+    }
+
+    /**
+     * Takes over every slab of `other`, so that nodes created by `other` may now be destroyed by this pool.
+     */
+    void adopt(slab_pool& other) {
+        if(!newest) {
+            swap(other);
+        } else if(other.newest) {
+            // Link other's chain in behind our newest slab, which we keep bumping into. The untouched tail of other's
+            //   newest slab is given up.
+            other.oldest->previous = newest->previous;
+            newest->previous = other.newest;
+            if(oldest == newest)
+                oldest = other.oldest;
+            if(other.next_capacity > next_capacity)
+                next_capacity = other.next_capacity;
+        }
+
+        if(other.free_tail) {
+            other.free_tail->next_free = free;
+            free = other.free;
+            if(!free_tail)
+                free_tail = other.free_tail;
+        }
+        other.forget();
+    }
+
+    void swap(slab_pool& other) noexcept {
+        std::swap(newest, other.newest);
+        std::swap(oldest, other.oldest);
+        std::swap(used, other.used);
+        std::swap(next_capacity, other.next_capacity);
+        std::swap(free, other.free);
+        std::swap(free_tail, other.free_tail);
+    }
+
+    /**
+     * Frees every slab. Every node must have been destroyed.
+     */
+    void release() {
+        while(newest) {
+            slab *previous = newest->previous;
+            ::operator delete(newest);
+            newest = previous;
+        }
+        forget();
+    }
+
+private:
+    static const size_t FIRST_SLAB = 16;
+    static const size_t MAX_SLAB = 4096;
+
+    union slot {
+        slot *next_free;
+        typename std::aligned_storage<sizeof(Node), alignof(Node)>::type storage;
+    };
+
+    struct slab {
+        slab *previous;
+        size_t capacity;
+        slot *slots() { return reinterpret_cast<slot*>(this + 1); }
+    };
+
+    // Slabs form a chain from the newest, which is bumped into, to the oldest
+    slab *newest = nullptr;
+    slab *oldest = nullptr;
+    size_t used = 0;
+    size_t next_capacity = FIRST_SLAB;
+    slot *free = nullptr;
+    slot *free_tail = nullptr;
+
+    void forget() {
+        newest = oldest = nullptr;
+        used = 0;
+        next_capacity = FIRST_SLAB;
+        free = free_tail = nullptr;
+    }
+
+    slot *take() {
+        if(free) {
+            slot *s = free;
+            free = s->next_free;
+            if(!free)
+                free_tail = nullptr;
+            return s;
+        }
+
+        if(!newest || used == newest->capacity) {
+            slab *fresh = static_cast<slab*>(::operator new(sizeof(slab) + next_capacity * sizeof(slot)));
+            fresh->previous = newest;
+            fresh->capacity = next_capacity;
+            newest = fresh;
+            if(!oldest)
+                oldest = fresh;
+            used = 0;
+            if(next_capacity < MAX_SLAB)
+                next_capacity *= 2;
+        }
+        return &newest->slots()[used++];
+    }
+
+    void give_back(slot *s) {
+        s->next_free = free;
+        free = s;
+        if(!free_tail)
+            free_tail = s;
+    }
+};
+
+}
+
+
+/**
+ * A singly linked list of objects that embed a linked_list_hook as the member `Hook`. The list does not own them.
+ */
+template <typename T, linked_list_hook T::*Hook>
+class intrusive_linked_list {
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T& reference;
+
+        iterator() = default;
+
+        T& operator*() const { return *linked_list_detail::owner<T, linked_list_hook, Hook>(current); }
+        T *operator->() const { return linked_list_detail::owner<T, linked_list_hook, Hook>(current); }
+
+        iterator& operator++() {
+            current = current->next;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            current = current->next;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+
+    private:
+        friend class intrusive_linked_list;
+        explicit iterator(linked_list_hook *current) : current(current) {}
+
+        linked_list_hook *current = nullptr;
+    };
+
+    intrusive_linked_list() = default;
+    intrusive_linked_list(intrusive_linked_list&& other) noexcept { swap(other); }
+    intrusive_linked_list& operator=(intrusive_linked_list&& other) noexcept {
+        clear();
+        swap(other);
+        return *this;
+    }
+    ~intrusive_linked_list() { clear(); }
+
+    intrusive_linked_list(const intrusive_linked_list&) = delete;
+    intrusive_linked_list& operator=(const intrusive_linked_list&) = delete;
+
+
+    void push_front(T& value) { insert_after(before_begin(), value); }
+    void push_back(T& value) { insert_after(iterator(tail), value); }
+    /**
+     * Unlinks the first element. The list must not be empty.
+     */
+    void pop_front() { erase_after(before_begin()); }
+    /**
+     * Links `value` after `position`.
+     *
+     * @return an iterator to `value`
+     */
+    iterator insert_after(iterator position, T& value);
+    /**
+     * Unlinks the element after `position`.
+     *
+     * @return an iterator to the element that followed it
+     */
+    iterator erase_after(iterator position);
+    /**
+     * Moves every element of `other` after `position`, in O(1).
+     */
+    void splice_after(iterator position, intrusive_linked_list& other);
+    /**
+     * Unlinks every element.
+     */
+    void clear();
+
+
+    T& front() { return *begin(); }
+    T& back() { return *iterator(tail); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /**
+     * @return an iterator before the first element, for insert_after and erase_after
+     */
+    iterator before_begin() { return iterator(&head); }
+    iterator begin() { return iterator(head.next); }
+    iterator end() { return iterator(); }
+    iterator iterator_to(T& value) { return iterator(&(value.*Hook)); }
+
+    void swap(intrusive_linked_list& other) noexcept;
+
+private:
+    // The sentinel before the first element
+    linked_list_hook head;
+    linked_list_hook *tail = &head;
+    size_t count = 0;
+};
+
+
+/**
+ * A singly linked list that owns its elements, with nodes drawn from a per-list slab pool.
+ */
+template <typename T>
 class linked_list {
+    struct node {
+        linked_list_hook hook;
+        T value;
+
+        template <typename... Args>
+        explicit node(Args&&... args) : value(std::forward<Args>(args)...) {}
+    };
+
+    typedef intrusive_linked_list<node, &node::hook> links_type;
+
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T& reference;
+
+        iterator() = default;
+
+        T& operator*() const { return position->value; }
+        T *operator->() const { return &position->value; }
+
+        iterator& operator++() {
+            ++position;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++position;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return position == other.position; }
+        bool operator!=(const iterator& other) const { return position != other.position; }
+
+    private:
+        friend class linked_list;
+        explicit iterator(typename links_type::iterator position) : position(position) {}
+
+        typename links_type::iterator position;
+    };
+
+    linked_list() = default;
+    linked_list(const linked_list& other);
+    linked_list(linked_list&& other) noexcept { swap(other); }
+    linked_list& operator=(linked_list other) {
+        swap(other);
+        return *this;
+    }
+    ~linked_list() { clear(); }
+
+
+    void push_front(const T& value) { emplace_after(before_begin(), value); }
+    void push_front(T&& value) { emplace_after(before_begin(), std::move(value)); }
+    void push_back(const T& value) { emplace_after(last(), value); }
+    void push_back(T&& value) { emplace_after(last(), std::move(value)); }
+    void pop_front() { erase_after(before_begin()); }
+    iterator insert_after(iterator position, const T& value) { return emplace_after(position, value); }
+    template <typename... Args>
+    iterator emplace_after(iterator position, Args&&... args) {
+        return iterator(links.insert_after(position.position, *pool.create(std::forward<Args>(args)...)));
+    }
+    /**
+     * Removes the element after `position`.
+     *
+     * @return an iterator to the element that followed it
+     */
+    iterator erase_after(iterator position) {
+        node& removed = *std::next(position.position);
+        iterator next(links.erase_after(position.position));
+        pool.destroy(&removed);
+        return next;
+    }
+    /**
+     * Moves every element of `other` after `position`, in O(1). This list takes over other's node pool.
+     */
+    void splice_after(iterator position, linked_list& other) {
+        links.splice_after(position.position, other.links);
+        pool.adopt(other.pool);
+    }
+    void clear();
+
+
+    T& front() { return links.front().value; }
+    T& back() { return links.back().value; }
+    size_t size() const { return links.size(); }
+    bool empty() const { return links.empty(); }
 
+    iterator before_begin() { return iterator(links.before_begin()); }
+    iterator begin() { return iterator(links.begin()); }
+    iterator end() { return iterator(links.end()); }
+
+    void swap(linked_list& other) noexcept {
+        links.swap(other.links);
+        pool.swap(other.pool);
+    }
+
+private:
+    links_type links;
+    linked_list_detail::slab_pool<node> pool;
+
+    iterator last() { return empty() ? before_begin() : iterator(links.iterator_to(links.back())); }
 };
 
 
+// Define intrusive_linked_list
+
+template <typename T, linked_list_hook T::*Hook>
+typename intrusive_linked_list<T, Hook>::iterator intrusive_linked_list<T, Hook>::insert_after(iterator position,
+                                                                                                T& value) {
+    linked_list_hook *hook = &(value.*Hook);
+    hook->next = position.current->next;
+    position.current->next = hook;
+    if(tail == position.current)
+        tail = hook;
+    count++;
+    return iterator(hook);
+}
+
+template <typename T, linked_list_hook T::*Hook>
+typename intrusive_linked_list<T, Hook>::iterator intrusive_linked_list<T, Hook>::erase_after(iterator position) {
+    linked_list_hook *removed = position.current->next;
+    position.current->next = removed->next;
+    if(tail == removed)
+        tail = position.current;
+    removed->next = nullptr;
+    count--;
+    return iterator(position.current->next);
+}
+
+template <typename T, linked_list_hook T::*Hook>
+void intrusive_linked_list<T, Hook>::splice_after(iterator position, intrusive_linked_list& other) {
+    if(other.empty())
+        return;
+
+    other.tail->next = position.current->next;
+    position.current->next = other.head.next;
+    if(tail == position.current)
+        tail = other.tail;
+    count += other.count;
+
+    other.head.next = nullptr;
+    other.tail = &other.head;
+    other.count = 0;
+}
+
+template <typename T, linked_list_hook T::*Hook>
+void intrusive_linked_list<T, Hook>::clear() {
+    linked_list_hook *hook = head.next;
+    while(hook) {
+        linked_list_hook *next = hook->next;
+        hook->next = nullptr;
+        hook = next;
+    }
+    head.next = nullptr;
+    tail = &head;
+    count = 0;
+}
+
+template <typename T, linked_list_hook T::*Hook>
+void intrusive_linked_list<T, Hook>::swap(intrusive_linked_list& other) noexcept {
+    std::swap(head.next, other.head.next);
+    std::swap(tail, other.tail);
+    std::swap(count, other.count);
+    // An empty list's tail is its own sentinel
+    if(tail == &other.head)
+        tail = &head;
+    if(other.tail == &head)
+        other.tail = &other.head;
+}
+
+// End of intrusive_linked_list definitions
+
+
+// Define linked_list
+
+template <typename T>
+linked_list<T>::linked_list(const linked_list& other) {
+    iterator position = before_begin();
+    for(auto& n : const_cast<links_type&>(other.links))
+        position = emplace_after(position, n.value);
+}
+
+template <typename T>
+void linked_list<T>::clear() {
+    while(!empty())
+        pop_front();
+}
+
+// End of linked_list definitions
+
+
 #endif //DATA_STRUCTURES_LINKED_LIST_H
@@ -1,14 +1,229 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * A list that reorders itself so that frequently searched elements are found quickly.
+ *
+ * What is a self-organizing list?
+ *   An unsorted list searched linearly from the front. After every successful search, the element found is moved
+ *   closer to the front according to a policy, so that elements which are accessed often end up cheap to reach
+ *   without anyone knowing the access frequencies in advance.
+ *
+ * Why is this useful?
+ *   For small collections with skewed access patterns (symbol tables, caches, the buckets of a hash table) a linear
+ *   scan over a contiguous array beats a tree or hash lookup, and self-organization keeps the expected scan short.
+ *
+ * How is it implemented?
+ *   Elements live in a contiguous array. The reordering policy is a template parameter:
+ *
+ *   - self_organizing::move_to_front moves the element found to the front, shifting the ones before it back by one.
+ *     Sleator and Tarjan ("Amortized efficiency of list update and paging rules", CACM 1985) showed that its total
+ *     cost on any access sequence is at most twice that of the best possible algorithm, even one that knows the
+ *     sequence in advance: it is 2-competitive. It adapts immediately to changes in the working set.
+ *   - self_organizing::transpose swaps the element found with its predecessor. Once settled under a fixed access
+ *     distribution, its expected cost is never worse than move-to-front's (Rivest, "On self-organizing sequential
+ *     search heuristics", CACM 1976), but it gets there slowly and it is not competitive: alternately accessing the
+ *     last two elements costs n comparisons every time, where move-to-front pays 2.
+ *   - self_organizing::count keeps an access counter per element and the array sorted by decreasing count. It
+ *     converges to the optimal static order when accesses are independent draws from a fixed distribution, but
+ *     reacts slowly when the distribution changes and needs a counter per element. An access only swaps the element
+ *     with the first one of equal count, found by binary search, so it costs O(log n) on top of the search.
+ *   - self_organizing::none never reorders; it is the baseline.
+ *
+ *   Move-to-front rotates the prefix in front of the element found, which costs as many moves as the search made
+ *   comparisons, so every policy keeps the search cost as the dominant term.
+ *
+ *   The list counts the comparisons made by its searches. benchmark/bench_self_organizing_list.cpp replays Zipfian,
+ *   uniform, shifting and adversarial access traces through each policy and reports comparisons per access. Over
+ *   1000 elements and 10^6 accesses (fixed seeds) it shows:
+ *
+ *   - Zipf, s = 1: the best static order averages 133 comparisons, count 135, transpose 179 and move-to-front 185,
+ *     within the pi / 2 factor of the optimum that Gonnet, Munro and Suwanda proved for move-to-front (1981).
+ *   - Zipf, s = 1.5: optimum 24, count 25, move-to-front 36, transpose 48; transpose has not settled yet.
+ *   - Uniform: every policy pays n / 2, as does any order.
+ *   - A working set of 20 elements that moves every 10^4 accesses: move-to-front 11, count 284, transpose 288, no
+ *     reordering 477. Counts remember the old working set for a long time.
+ *   - Alternating between the two last elements: move-to-front 2, count 1.5, transpose 1000.
+ *   - Always asking for the current last element costs every policy n per access. No online policy can do better
+ *     against this adversary, while an offline one pays about n / 2, which is where the factor 2 comes from.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_SELF_ORGANIZING_LIST_H
 #define DATA_STRUCTURES_SELF_ORGANIZING_LIST_H
 
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace self_organizing {
+
+/**
+ * Leaves the order alone.
+ *
+ * A policy's `accessed` reorders `items` after a search found `items[index]`, and returns the element's new index.
+ */
+struct none {
+    static const bool counts_accesses = false;
+
+    template <typename T>
+    static size_t accessed(std::vector<T>&, std::vector<uint64_t>&, size_t index) { return index; }
+};
+
+/**
+ * Moves the element found to the front.
+ */
+struct move_to_front {
+    static const bool counts_accesses = false;
+
+    template <typename T>
+    static size_t accessed(std::vector<T>& items, std::vector<uint64_t>&, size_t index) {
+        std::rotate(items.begin(), items.begin() + index, items.begin() + index + 1);
+        return 0;
+    }
+};
+
+/**
+ * Swaps the element found with its predecessor.
+ */
+struct transpose {
+    static const bool counts_accesses = false;
+
+    template <typename T>
+    static size_t accessed(std::vector<T>& items, std::vector<uint64_t>&, size_t index) {
+        if(index == 0)
+            return 0;
+        std::swap(items[index], items[index - 1]);
+        return index - 1;
+    }
+};
+
+/**
+ * Keeps elements sorted by decreasing access count.
+ */
+struct count {
+    static const bool counts_accesses = true;
+
+    template <typename T>
+    static size_t accessed(std::vector<T>& items, std::vector<uint64_t>& counts, size_t index) {
+        // Every element between the first one with the old count and this one shares the old count, so swapping with
+        //   the first keeps the counts sorted
+        uint64_t old = counts[index]++;
+        size_t first = std::lower_bound(counts.begin(), counts.begin() + index, old,
+                                        std::greater<uint64_t>()) - counts.begin();
+        if(first != index) {
+            std::swap(items[first], items[index]);
+            std::swap(counts[first], counts[index]);
+        }
+        return first;
+    }
+};
+
+}
+
+/**
+ * An array-backed self-organizing list.
+ *
+ * @tparam Policy one of the self_organizing policies
+ */
+template <typename T, typename Policy = self_organizing::move_to_front>
 class self_organizing_list {
+public:
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    self_organizing_list() = default;
 
+
+    /**
+     * Adds `value` at the back, where it is the most expensive to find.
+     */
+    void insert(const T& value);
+    /**
+     * Removes the first element equal to `value`.
+     *
+     * @return false if there was none
+     */
+    bool erase(const T& value);
+    void clear() {
+        items.clear();
+        counts.clear();
+    }
+
+
+    /**
+     * Searches for `value` and reorganizes the list according to the policy.
+     *
+     * @return the element found, valid until the list next changes, or nullptr
+     */
+    const T *find(const T& value);
+    bool contains(const T& value) { return find(value) != nullptr; }
+
+
+    /**
+     * @return the number of element comparisons made by searches so far
+     */
+    uint64_t comparisons() const { return compared; }
+    void reset_comparisons() { compared = 0; }
+
+    const T& operator[](size_t index) const { return items[index]; }
+    const T& front() const { return items.front(); }
+    const T& back() const { return items.back(); }
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+
+    const_iterator begin() const { return items.begin(); }
+    const_iterator end() const { return items.end(); }
+
+private:
+    std::vector<T> items;
+    // Access counts, parallel to `items`, for policies that need them
+    std::vector<uint64_t> counts;
+    uint64_t compared = 0;
+
+    /**
+     * @return the index of the first element equal to `value`, or size()
+     */
+    size_t search(const T& value);
 };
 
 
+template <typename T, typename Policy>
+size_t self_organizing_list<T, Policy>::search(const T& value) {
+    size_t index = 0;
+    while(index < items.size() && !(items[index] == value))
+        index++;
+    compared += index < items.size() ? index + 1 : index;
+    return index;
+}
+
+template <typename T, typename Policy>
+void self_organizing_list<T, Policy>::insert(const T& value) {
+    items.push_back(value);
+    if(Policy::counts_accesses)
+        counts.push_back(0);
+}
+
+template <typename T, typename Policy>
+bool self_organizing_list<T, Policy>::erase(const T& value) {
+    size_t index = search(value);
+    if(index == items.size())
+        return false;
+
+    items.erase(items.begin() + index);
+    if(Policy::counts_accesses)
+        counts.erase(counts.begin() + index);
+    return true;
+}
+
+template <typename T, typename Policy>
+const T *self_organizing_list<T, Policy>::find(const T& value) {
+    size_t index = search(value);
+    if(index == items.size())
+        return nullptr;
+
+    return &items[Policy::accessed(items, counts, index)];
+}
+
+
 #endif //DATA_STRUCTURES_SELF_ORGANIZING_LIST_H
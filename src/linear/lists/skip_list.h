@@ -1,14 +1,655 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * A lock-free ordered map.
+ *
+ * What is a skip list?
+ *   A sorted linked list where every node also sits on a random number of express lanes. Level 0 links every node,
+ *   and each level above links roughly a quarter of the nodes of the level below, so a search drops down from the
+ *   sparsest level and skips most of the list. Searches, inserts and erases take O(log n) expected time.
+ *
+ * Why is this useful?
+ *   Unlike a balanced tree, a skip list never rebalances: an insert only changes the links around the new node, one
+ *   level at a time. That makes it practical to update without locks, which is why databases use skip lists for
+ *   their in-memory write buffers (memtables): many threads insert at once while others look keys up and scan
+ *   ranges in order.
+ *
+ * How is it implemented?
+ *   Following Fraser ("Practical lock-freedom", 2004) and Herlihy & Shavit ("The Art of Multiprocessor
+ *   Programming", chapter 14). Every link is a pointer whose lowest bit marks the node holding it as deleted. An
+ *   insert links the new node into level 0 with a compare-and-swap, which is the moment it becomes part of the set,
+ *   then links it into its upper levels one at a time. An erase marks the node's links from the top down; whoever
+ *   marks level 0 has erased the key, and searches unlink marked nodes as they pass them.
+ *
+ *   Nodes are carved out of large chunks by a shared bump pointer, with a tower height drawn from a thread-local
+ *   xorshift generator. An erased node may still be in use by a concurrent reader, so it is only recycled through
+ *   epoch-based reclamation (Fraser, ibid.): every operation announces the global epoch it started in, the epoch
+ *   advances once no thread is still in an older one, and nodes unlinked in epoch e are reused once the global
+ *   epoch reaches e + 2, when every thread that could have seen them has finished.
+ *
+ *   Iterators pin the epoch for their whole lifetime, so the node they point at stays readable while other threads
+ *   insert and erase around it. Iterating sees every key present for the whole iteration, in order, and may or may
+ *   not see keys inserted or erased meanwhile. Values cannot be changed once inserted.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_SKIP_LIST_H
 #define DATA_STRUCTURES_SKIP_LIST_H
 
 
+#include "../../primitives/xorshift.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace skip_list_detail {
+
+/**
+ * Epoch-based reclamation for one data structure. Threads pin the domain while they hold pointers into the
+ *   structure, and retire memory they unlinked; retired memory is handed back once no pinned thread can reach it.
+ */
+class epoch_domain {
+    struct retired {
+        void *pointer;
+        uint64_t epoch;
+    };
+
+    struct record {
+        // (epoch << 1) | 1 while pinned, 0 while quiescent
+        std::atomic<uint64_t> announced{0};
+        std::atomic<bool> in_use{true};
+        record *next = nullptr;
+        // Only touched by the thread holding the record
+        std::vector<retired> limbo;
+    };
+
+public:
+    typedef void (*reclaimer)(void *context, void *pointer);
+
+    /**
+     * Keeps the domain pinned while it lives.
+     */
+    class guard {
+    public:
+        guard() = default;
+        explicit guard(epoch_domain *domain) : domain(domain), held(domain->pin()) {}
+        guard(const guard& other) : guard() {
+            if(other.domain)
+                *this = guard(other.domain);
+        }
+        guard(guard&& other) noexcept : domain(other.domain), held(other.held) {
+            other.domain = nullptr;
+            other.held = nullptr;
+        }
+        guard& operator=(guard other) noexcept {
+            std::swap(domain, other.domain);
+            std::swap(held, other.held);
+            return *this;
+        }
+        ~guard() {
+            if(held)
+                domain->unpin(held);
+        }
+
+        /**
+         * Hands `pointer` to the reclaimer once every thread pinned now has unpinned.
+         */
+        void retire(void *pointer) { domain->retire(held, pointer); }
+
+    private:
+        epoch_domain *domain = nullptr;
+        record *held = nullptr;
+    };
+
+    epoch_domain(reclaimer reclaim, void *context)
+            : reclaim(reclaim), context(context), id(next_id().fetch_add(1, std::memory_order_relaxed)) {}
+    ~epoch_domain() {
+        drain();
+        record *r = records.load();
+        while(r) {
+            record *next = r->next;
+            delete r;
+            r = next;
+        }
+    }
+
+    epoch_domain(const epoch_domain&) = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+
+    /**
+     * Reclaims everything retired so far. No thread may be pinned.
+     */
+    void drain() {
+        for(record *r = records.load(); r; r = r->next) {
+            for(retired& item : r->limbo)
+                reclaim(context, item.pointer);
+            r->limbo.clear();
+        }
+    }
+
+private:
+    // Retired memory is reclaimed in batches of this size
+    static const size_t BATCH = 64;
+
+    std::atomic<uint64_t> global{1};
+    std::atomic<record*> records{nullptr};
+    reclaimer reclaim;
+    void *context;
+    // Distinguishes domains in the per-thread cache, even if one is later allocated at a dead one's address
+    uint64_t id;
+
+    static std::atomic<uint64_t>& next_id() {
+        static std::atomic<uint64_t> counter(1);
+        return counter;
+    }
+
+    struct cache {
+        uint64_t domain = 0;
+        record *held = nullptr;
+    };
+
+    record *acquire() {
+        // Threads usually get back the record they used last
+        static thread_local cache last;
+        bool expected = false;
+        if(last.domain == id && last.held->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return last.held;
+
+        record *r = records.load(std::memory_order_acquire);
+        for(; r; r = r->next) {
+            expected = false;
+            if(!r->in_use.load(std::memory_order_relaxed) &&
+               r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                break;
+        }
+        if(!r) {
+            r = new record;
+            r->next = records.load(std::memory_order_relaxed);
+            while(!records.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {}
+        }
+
+        last.domain = id;
+        last.held = r;
+        return r;
+    }
+
+    record *pin() {
+        record *r = acquire();
+        // A stale epoch is harmless: nothing retired before it was read can be reached any more
+        r->announced.store(global.load() << 1 | 1);
+        return r;
+    }
+
+    void unpin(record *r) {
+        r->announced.store(0, std::memory_order_release);
+        r->in_use.store(false, std::memory_order_release);
+    }
+
+    void retire(record *r, void *pointer) {
+        r->limbo.push_back({pointer, global.load()});
+        if(r->limbo.size() % BATCH != 0)
+            return;
+
+        try_advance();
+        uint64_t now = global.load();
+        size_t kept = 0;
+        for(retired& item : r->limbo) {
+            if(item.epoch + 2 <= now)
+                reclaim(context, item.pointer);
+            else
+                r->limbo[kept++] = item;
+        }
+        r->limbo.resize(kept);
+    }
+
+    void try_advance() {
+        uint64_t epoch = global.load();
+        for(record *r = records.load(std::memory_order_acquire); r; r = r->next) {
+            uint64_t announced = r->announced.load();
+            if((announced & 1) && (announced >> 1) != epoch)
+                return;
+        }
+        global.compare_exchange_strong(epoch, epoch + 1);
+    }
+};
+
+/**
+ * @return a tower height between 1 and `max`, each level with probability 1/4 of the one below
+ */
+inline size_t random_height(size_t max) {
+    // Two bits per level, from the top, where xorshift64* is strongest
+    uint64_t bits = xorshift64_star::for_this_thread().next();
+    size_t height = 1;
+    while(height < max && (bits >> 62) == 0) {
+        height++;
+        bits <<= 2;
+    }
+    return height;
+}
+
+}
+
+/**
+ * A lock-free ordered map from keys to immutable values.
+ */
+template <typename K, typename V, typename Compare = std::less<K>>
 class skip_list {
+public:
+    typedef std::pair<const K, V> value_type;
+
+private:
+    static const size_t MAX_HEIGHT = 16;
+    static const size_t CHUNK_BYTES = 1 << 20;
+
+    struct node {
+        value_type item;
+        size_t height;
+        // Actually `height` links long: nodes are allocated with room for the extra ones
+        std::atomic<uintptr_t> next[1];
+    };
+
+    static size_t node_bytes(size_t height) {
+        size_t bytes = sizeof(node) + (height - 1) * sizeof(std::atomic<uintptr_t>);
+        return (bytes + alignof(node) - 1) / alignof(node) * alignof(node);
+    }
+
+    static node *pointer(uintptr_t link) { return reinterpret_cast<node*>(link & ~uintptr_t(1)); }
+    static bool marked(uintptr_t link) { return link & 1; }
+    static uintptr_t address(node *n) { return reinterpret_cast<uintptr_t>(n); }
+
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename skip_list::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type *pointer;
+        typedef const value_type& reference;
+
+        iterator() = default;
+
+        reference operator*() const { return current->item; }
+        pointer operator->() const { return &current->item; }
+
+        iterator& operator++() {
+            current = skip_list::next_live(current);
+            if(!current)
+                pin = skip_list_detail::epoch_domain::guard();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+
+    private:
+        friend class skip_list;
+        iterator(skip_list_detail::epoch_domain::guard&& held, node *current)
+                : pin(current ? std::move(held) : skip_list_detail::epoch_domain::guard()), current(current) {}
+
+        // Keeps `current` from being reclaimed
+        skip_list_detail::epoch_domain::guard pin;
+        // nullptr for end()
+        node *current = nullptr;
+    };
+
+    explicit skip_list(const Compare& compare = Compare());
+    ~skip_list();
+
+    skip_list(const skip_list&) = delete;
+    skip_list& operator=(const skip_list&) = delete;
 
+
+    /**
+     * Inserts `key` with `value`, unless `key` is already present.
+     *
+     * @return true if the key was inserted
+     */
+    bool insert(const K& key, const V& value);
+    /**
+     * Removes `key`.
+     *
+     * @return true if this call removed it
+     */
+    bool erase(const K& key);
+
+
+    bool contains(const K& key) const;
+    /**
+     * Copies the value stored under `key` into `out`.
+     *
+     * @return false if `key` is absent
+     */
+    bool find(const K& key, V& out) const;
+    /**
+     * @return an iterator to the first key not less than `key`
+     */
+    iterator lower_bound(const K& key) const;
+    iterator begin() const {
+        skip_list_detail::epoch_domain::guard pin(&domain);
+        return iterator(std::move(pin), next_live(head));
+    }
+    iterator end() const { return iterator(); }
+
+    /**
+     * @return the number of keys. Only a snapshot when other threads are active.
+     */
+    size_t size() const {
+        int64_t counted = approximate_size.load(std::memory_order_relaxed);
+        return counted > 0 ? static_cast<size_t>(counted) : 0;
+    }
+    bool empty() const {
+        skip_list_detail::epoch_domain::guard pin(&domain);
+        return !next_live(head);
+    }
+
+private:
+    struct chunk {
+        chunk *previous;
+        size_t bytes;
+        std::atomic<size_t> used;
+
+        // The header rounded up to a whole node alignment, so that the first node carved is aligned
+        static size_t header_bytes() { return (sizeof(chunk) + alignof(node) - 1) / alignof(node) * alignof(node); }
+        char *data() { return reinterpret_cast<char*>(this) + header_bytes(); }
+    };
+
+    Compare less;
+    node *head;
+    std::atomic<int64_t> approximate_size{0};
+
+    std::atomic<chunk*> current_chunk{nullptr};
+    std::mutex allocation_mutex;
+    // Reclaimed nodes, by height. `recycled` lets allocations skip the lock while there are none.
+    std::vector<node*> free_nodes[MAX_HEIGHT + 1];
+    std::atomic<size_t> recycled{0};
+
+    mutable skip_list_detail::epoch_domain domain;
+
+    bool key_less(const node *n, const K& key) const { return less(n->item.first, key); }
+    bool key_equal(const node *n, const K& key) const { return !less(key, n->item.first); }
+
+    node *allocate(size_t height);
+    void *carve(size_t bytes);
+    static void reclaim(void *list, void *n);
+    void release(node *n);
+
+    /**
+     * Finds the neighbours of `key` on every level, unlinking marked nodes on the way.
+     *
+     * @return true if an unmarked node with `key` is at succs[0]
+     */
+    bool search(const K& key, node **preds, node **succs);
+    /**
+     * @return the first unmarked node whose key is not less than `key`, without modifying the list
+     */
+    node *seek(const K& key) const;
+    static node *next_live(node *n);
 };
 
 
+template <typename K, typename V, typename C>
+const size_t skip_list<K, V, C>::MAX_HEIGHT;
+
+template <typename K, typename V, typename C>
+skip_list<K, V, C>::skip_list(const C& compare) : less(compare), domain(&skip_list::reclaim, this) {
+    // The head never holds an item, so only its links are constructed
+    head = static_cast<node*>(carve(node_bytes(MAX_HEIGHT)));
+    head->height = MAX_HEIGHT;
+    for(size_t level = 0; level < MAX_HEIGHT; level++)
+        new(&head->next[level]) std::atomic<uintptr_t>(0);
+}
+
+template <typename K, typename V, typename C>
+skip_list<K, V, C>::~skip_list() {
+    domain.drain();
+    for(node *n = pointer(head->next[0].load()); n; n = pointer(n->next[0].load()))
+        n->item.~value_type();
+
+    chunk *c = current_chunk.load();
+    while(c) {
+        chunk *previous = c->previous;
+        ::operator delete(c);
+        c = previous;
+    }
+}
+
+template <typename K, typename V, typename C>
+void *skip_list<K, V, C>::carve(size_t bytes) {
+    // Chunks come from ::operator new, and node sizes are already rounded to alignof(node)
+    static_assert(alignof(node) <= alignof(std::max_align_t), "skip_list cannot carve over-aligned nodes");
+    while(true) {
+        chunk *c = current_chunk.load(std::memory_order_acquire);
+        if(c) {
+            size_t offset = c->used.fetch_add(bytes, std::memory_order_relaxed);
+            if(offset + bytes <= c->bytes)
+                return c->data() + offset;
+        }
+
+        // The chunk is exhausted: the first thread to get here replaces it
+        std::lock_guard<std::mutex> lock(allocation_mutex);
+        if(current_chunk.load(std::memory_order_relaxed) != c)
+            continue;
+        size_t capacity = bytes > CHUNK_BYTES ? bytes : CHUNK_BYTES;
+        chunk *fresh = static_cast<chunk*>(::operator new(chunk::header_bytes() + capacity));
+        fresh->previous = c;
+        fresh->bytes = capacity;
+        new(&fresh->used) std::atomic<size_t>(0);
+        current_chunk.store(fresh, std::memory_order_release);
+    }
+}
+
+template <typename K, typename V, typename C>
+typename skip_list<K, V, C>::node *skip_list<K, V, C>::allocate(size_t height) {
+    if(recycled.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(allocation_mutex);
+        if(!free_nodes[height].empty()) {
+            node *n = free_nodes[height].back();
+            free_nodes[height].pop_back();
+            recycled.fetch_sub(1, std::memory_order_relaxed);
+            return n;
+        }
+    }
+
+    node *n = static_cast<node*>(carve(node_bytes(height)));
+    n->height = height;
+    for(size_t level = 0; level < height; level++)
+        new(&n->next[level]) std::atomic<uintptr_t>(0);
+    return n;
+}
+
+template <typename K, typename V, typename C>
+void skip_list<K, V, C>::release(node *n) {
+    std::lock_guard<std::mutex> lock(allocation_mutex);
+    free_nodes[n->height].push_back(n);
+    recycled.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename C>
+void skip_list<K, V, C>::reclaim(void *list, void *n) {
+    node *dead = static_cast<node*>(n);
+    dead->item.~value_type();
+    static_cast<skip_list*>(list)->release(dead);
+}
+
+template <typename K, typename V, typename C>
+bool skip_list<K, V, C>::search(const K& key, node **preds, node **succs) {
+retry:
+    node *pred = head;
+    for(size_t level = MAX_HEIGHT; level-- > 0;) {
+        node *curr = pointer(pred->next[level].load());
+        while(curr) {
+            uintptr_t succ = curr->next[level].load();
+            while(marked(succ)) {
+                // curr is being erased: unlink it here, or start over if pred changed under us
+                uintptr_t expected = address(curr);
+                if(!pred->next[level].compare_exchange_strong(expected, address(pointer(succ))))
+                    goto retry;
+                curr = pointer(succ);
+                if(!curr)
+                    break;
+                succ = curr->next[level].load();
+            }
+            if(!curr || !key_less(curr, key))
+                break;
+            pred = curr;
+            curr = pointer(succ);
+        }
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+    return succs[0] && key_equal(succs[0], key);
+}
+
+template <typename K, typename V, typename C>
+bool skip_list<K, V, C>::insert(const K& key, const V& value) {
+    skip_list_detail::epoch_domain::guard pin(&domain);
+    node *preds[MAX_HEIGHT], *succs[MAX_HEIGHT];
+    node *fresh = nullptr;
+    size_t height = 0;
+
+    while(true) {
+        if(search(key, preds, succs)) {
+            if(fresh) {
+                fresh->item.~value_type();
+                release(fresh);
+            }
+            return false;
+        }
+
+        if(!fresh) {
+            height = skip_list_detail::random_height(MAX_HEIGHT);
+            fresh = allocate(height);
+            try {
+                new(&fresh->item) value_type(key, value);
+            } catch(...) {
+                release(fresh);
+                throw;
+            }
+        }
+        for(size_t level = 0; level < height; level++)
+            fresh->next[level].store(address(succs[level]), std::memory_order_relaxed);
+
+        // Linking level 0 is what makes the key present
+        uintptr_t expected = address(succs[0]);
+        if(preds[0]->next[0].compare_exchange_strong(expected, address(fresh)))
+            break;
+    }
+    approximate_size.fetch_add(1, std::memory_order_relaxed);
+
+    for(size_t level = 1; level < height; level++) {
+        while(true) {
+            // Point our link at the current successor, unless an erase has marked it
+            uintptr_t link = fresh->next[level].load();
+            if(marked(link))
+                goto linked;
+            if(pointer(link) != succs[level] &&
+               !fresh->next[level].compare_exchange_strong(link, address(succs[level])))
+                goto linked;
+
+            uintptr_t expected = address(succs[level]);
+            if(preds[level]->next[level].compare_exchange_strong(expected, address(fresh)))
+                break;
+
+            search(key, preds, succs);
+            if(succs[0] != fresh)
+                goto linked;
+        }
+    }
+
+linked:
+    // An erase may have finished unlinking before we linked one of the upper levels; unlink it again so that
+    //   nothing reaches the node once it is reclaimed
+    if(marked(fresh->next[0].load()))
+        search(key, preds, succs);
+    return true;
+}
+
+template <typename K, typename V, typename C>
+bool skip_list<K, V, C>::erase(const K& key) {
+    skip_list_detail::epoch_domain::guard pin(&domain);
+    node *preds[MAX_HEIGHT], *succs[MAX_HEIGHT];
+    if(!search(key, preds, succs))
+        return false;
+
+    node *victim = succs[0];
+    for(size_t level = victim->height; level-- > 1;)
+        victim->next[level].fetch_or(1);
+
+    // Whoever marks level 0 owns the erase
+    uintptr_t link = victim->next[0].load();
+    while(!marked(link)) {
+        if(victim->next[0].compare_exchange_weak(link, link | 1)) {
+            approximate_size.fetch_sub(1, std::memory_order_relaxed);
+            search(key, preds, succs);
+            pin.retire(victim);
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename K, typename V, typename C>
+typename skip_list<K, V, C>::node *skip_list<K, V, C>::seek(const K& key) const {
+    node *pred = head;
+    node *curr = nullptr;
+    for(size_t level = MAX_HEIGHT; level-- > 0;) {
+        curr = pointer(pred->next[level].load());
+        while(curr) {
+            uintptr_t succ = curr->next[level].load();
+            if(marked(succ)) {
+                // Step over nodes being erased without unlinking them
+                curr = pointer(succ);
+                continue;
+            }
+            if(!key_less(curr, key))
+                break;
+            pred = curr;
+            curr = pointer(succ);
+        }
+    }
+    return curr;
+}
+
+template <typename K, typename V, typename C>
+typename skip_list<K, V, C>::node *skip_list<K, V, C>::next_live(node *n) {
+    node *next = pointer(n->next[0].load());
+    while(next && marked(next->next[0].load()))
+        next = pointer(next->next[0].load());
+    return next;
+}
+
+template <typename K, typename V, typename C>
+bool skip_list<K, V, C>::contains(const K& key) const {
+    skip_list_detail::epoch_domain::guard pin(&domain);
+    node *n = seek(key);
+    return n && key_equal(n, key);
+}
+
+template <typename K, typename V, typename C>
+bool skip_list<K, V, C>::find(const K& key, V& out) const {
+    skip_list_detail::epoch_domain::guard pin(&domain);
+    node *n = seek(key);
+    if(!n || !key_equal(n, key))
+        return false;
+    out = n->item.second;
+    return true;
+}
+
+template <typename K, typename V, typename C>
+typename skip_list<K, V, C>::iterator skip_list<K, V, C>::lower_bound(const K& key) const {
+    skip_list_detail::epoch_domain::guard pin(&domain);
+    return iterator(std::move(pin), seek(key));
+}
+
+
 #endif //DATA_STRUCTURES_SKIP_LIST_H
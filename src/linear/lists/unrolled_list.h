@@ -1,14 +1,505 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * A doubly linked list of small arrays.
+ *
+ * What is an unrolled linked list?
+ *   A linked list where each node holds up to `node_capacity` elements in a contiguous array instead of just one.
+ *
+ * Why is this useful?
+ *   A classic linked list spends two pointers and one cache miss per element. A vector is dense but inserting in the
+ *   middle shifts everything after the insertion point. An unrolled list sits in between: traversal touches one or
+ *   a few cache lines per `node_capacity` elements, and an insertion only shifts the elements of one node.
+ *
+ * How is it implemented?
+ *   Nodes are `NodeBytes` long (one to four cache lines) and allocated on 64 byte boundaries; the element count per
+ *   node is derived from sizeof(T). Inserting into a full node splits it in two half-full nodes. When an erase leaves
+ *   a node less than half full, it is merged with its successor if both fit in one node, or otherwise borrows an
+ *   element from it, so every node except the last stays at least half full.
+ *
+ *   `find` compares a whole SSE2 register of elements at a time when T is an integer, enum or pointer type (types
+ *   whose equality is bitwise equality), and falls back to operator== otherwise.
+ *
+ *   Iterators are invalidated by any insertion or erasure in the node they point into, or in a neighbouring node
+ *   that gets split or merged.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_UNROLLED_LIST_H
 #define DATA_STRUCTURES_UNROLLED_LIST_H
 
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace unrolled_list_detail {
+
+/**
+ * Linear search of `n` elements, one at a time.
+ */
+template <typename T, typename Enable = void>
+struct search {
+    static size_t find(const T *data, size_t n, const T& value) {
+        for(size_t i = 0; i < n; i++)
+            if(data[i] == value)
+                return i;
+        return n;
+    }
+};
+
+#if defined(__SSE2__)
+template <size_t Size> struct lanes;
+
+template <> struct lanes<1> {
+    static __m128i broadcast(const void *value) { return _mm_set1_epi8(*static_cast<const char*>(value)); }
+    static __m128i equal(__m128i a, __m128i b) { return _mm_cmpeq_epi8(a, b); }
+};
+
+template <> struct lanes<2> {
+    static __m128i broadcast(const void *value) { return _mm_set1_epi16(*static_cast<const int16_t*>(value)); }
+    static __m128i equal(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+};
+
+template <> struct lanes<4> {
+    static __m128i broadcast(const void *value) { return _mm_set1_epi32(*static_cast<const int32_t*>(value)); }
+    static __m128i equal(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+};
+
+template <> struct lanes<8> {
+    static __m128i broadcast(const void *value) { return _mm_set1_epi64x(*static_cast<const int64_t*>(value)); }
+    static __m128i equal(__m128i a, __m128i b) {
+        // SSE2 has no 64-bit compare: both 32-bit halves have to match
+        __m128i halves = _mm_cmpeq_epi32(a, b);
+        return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+};
+
+/**
+ * SSE2 search for types whose equality is bitwise equality.
+ */
+template <typename T>
+struct search<T, typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value ||
+                                          std::is_pointer<T>::value) &&
+                                         (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+                                          sizeof(T) == 8)>::type> {
+    static size_t find(const T *data, size_t n, const T& value) {
+        const size_t per_register = 16 / sizeof(T);
+        __m128i needle = lanes<sizeof(T)>::broadcast(&value);
+
+        size_t i = 0;
+        for(; i + per_register <= n; i += per_register) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            int mask = _mm_movemask_epi8(lanes<sizeof(T)>::equal(block, needle));
+            if(mask)
+                return i + __builtin_ctz(mask) / sizeof(T);
+        }
+        for(; i < n; i++)
+            if(data[i] == value)
+                return i;
+        return n;
+    }
+};
+#endif
+
+}
+
+/**
+ * An unrolled doubly linked list.
+ *
+ * @tparam NodeBytes size of each node: 64, 128, 192 or 256 bytes. Nodes are made larger if they would otherwise
+ *   hold fewer than 4 elements.
+ */
+template <typename T, size_t NodeBytes = 128>
 class unrolled_list {
+    static_assert(NodeBytes % 64 == 0 && NodeBytes >= 64 && NodeBytes <= 256,
+                  "NodeBytes must be one to four cache lines (64 to 256 bytes)");
+
+    struct header {
+        header *prev, *next;
+        uint32_t count;
+    };
+
+    // Offset of the element array: the header, rounded up to T's alignment
+    static constexpr size_t items_offset = (sizeof(header) + alignof(T) - 1) / alignof(T) * alignof(T);
+    static constexpr size_t fit = NodeBytes > items_offset ? (NodeBytes - items_offset) / sizeof(T) : 0;
+
+public:
+    /**
+     * Maximum number of elements held by a node.
+     */
+    static constexpr size_t node_capacity = fit > 4 ? fit : 4;
+
+private:
+    static constexpr size_t min_fill = node_capacity / 2;
+    static constexpr size_t node_bytes = (items_offset + node_capacity * sizeof(T) + 63) / 64 * 64;
+
+    struct node : header {
+        T *items() { return reinterpret_cast<T*>(reinterpret_cast<char*>(this) + items_offset); }
+    };
+
+public:
+    /**
+     * An iterator over elements of type T, or const T when `Const`.
+     */
+    template <bool Const>
+    class basic_iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<Const, const T, T>::type *pointer;
+        typedef typename std::conditional<Const, const T, T>::type& reference;
+
+        basic_iterator() = default;
+        // A mutable iterator converts to a const one
+        template <bool C = Const, typename = typename std::enable_if<C>::type>
+        basic_iterator(const basic_iterator<false>& other)
+                : owner(other.owner), current(other.current), index(other.index) {}
+
+        reference operator*() const { return current->items()[index]; }
+        pointer operator->() const { return &current->items()[index]; }
+
+        basic_iterator& operator++() {
+            if(++index == current->count) {
+                current = static_cast<node*>(current->next);
+                index = 0;
+            }
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+        basic_iterator& operator--() {
+            if(!current) {
+                current = owner->tail;
+                index = current->count - 1;
+            } else if(index == 0) {
+                current = static_cast<node*>(current->prev);
+                index = current->count - 1;
+            } else {
+                index--;
+            }
+            return *this;
+        }
+        basic_iterator operator--(int) {
+            basic_iterator ret = *this;
+            --*this;
+            return ret;
+        }
+
+        bool operator==(const basic_iterator& other) const {
+            return current == other.current && index == other.index;
+        }
+        bool operator!=(const basic_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class unrolled_list;
+        friend class basic_iterator<!Const>;
+        basic_iterator(const unrolled_list *owner, node *current, size_t index)
+                : owner(owner), current(current), index(index) {}
+
+        const unrolled_list *owner = nullptr;
+        // nullptr for end()
+        node *current = nullptr;
+        size_t index = 0;
+    };
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true> const_iterator;
+
+    /**
+     * Construct an empty list.
+     */
+    unrolled_list() = default;
+    unrolled_list(const unrolled_list& other) {
+        for(const T& value : other)
+            push_back(value);
+    }
+    unrolled_list(unrolled_list&& other) noexcept { swap(other); }
+    unrolled_list& operator=(unrolled_list other) {
+        swap(other);
+        return *this;
+    }
+    ~unrolled_list() { clear(); }
 
+
+    void push_back(const T& value) { insert(end(), value); }
+    void push_back(T&& value) { insert(end(), std::move(value)); }
+    void push_front(const T& value) { insert(begin(), value); }
+    void push_front(T&& value) { insert(begin(), std::move(value)); }
+    /**
+     * Inserts `value` before `position`.
+     *
+     * @return an iterator to the inserted element
+     */
+    iterator insert(iterator position, const T& value) { return emplace(position, value); }
+    iterator insert(iterator position, T&& value) { return emplace(position, std::move(value)); }
+    template <typename... Args>
+    iterator emplace(iterator position, Args&&... args);
+    /**
+     * Removes the element at `position`.
+     *
+     * @return an iterator to the element that followed it
+     */
+    iterator erase(iterator position);
+    void pop_back() { erase(--end()); }
+    void pop_front() { erase(begin()); }
+    void clear();
+
+
+    /**
+     * @return an iterator to the first element equal to `value`, or end()
+     */
+    iterator find(const T& value) { return find_from(value); }
+    const_iterator find(const T& value) const { return find_from(value); }
+    /**
+     * @return an iterator to the element at `index`, found by skipping whole nodes
+     */
+    iterator nth(size_t index) { return nth_from(index); }
+    const_iterator nth(size_t index) const { return nth_from(index); }
+
+    T& front() { return *begin(); }
+    const T& front() const { return *begin(); }
+    T& back() { return *--end(); }
+    const T& back() const { return *--end(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    /**
+     * @return the number of nodes
+     */
+    size_t node_count() const { return nodes; }
+
+    iterator begin() { return iterator(this, head, 0); }
+    iterator end() { return iterator(this, nullptr, 0); }
+    const_iterator begin() const { return const_iterator(this, head, 0); }
+    const_iterator end() const { return const_iterator(this, nullptr, 0); }
+
+    void swap(unrolled_list& other) noexcept {
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        std::swap(count, other.count);
+        std::swap(nodes, other.nodes);
+    }
+
+private:
+    node *head = nullptr;
+    node *tail = nullptr;
+    size_t count = 0;
+    size_t nodes = 0;
+
+    node *allocate_node();
+    void free_node(node *n);
+    node *insert_node_after(node *before);
+    void unlink_node(node *n);
+    /**
+     * Moves elements [from, n->count) of `n` to the front of the empty node `to`.
+     */
+    static void move_tail(node *n, size_t from, node *to);
+    iterator find_from(const T& value) const;
+    iterator nth_from(size_t index) const;
 };
 
+template <typename T, size_t B>
+constexpr size_t unrolled_list<T, B>::node_capacity;
+
+
+template <typename T, size_t B>
+typename unrolled_list<T, B>::node *unrolled_list<T, B>::allocate_node() {
+    // Over-allocate to place the node on a 64 byte boundary, and remember the raw pointer just before it
+    char *raw = static_cast<char*>(::operator new(node_bytes + 64 + sizeof(void*)));
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + 63) & ~uintptr_t(63);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+
+    node *n = reinterpret_cast<node*>(aligned);
+    n->prev = n->next = nullptr;
+    n->count = 0;
+    nodes++;
+    return n;
+}
+
+template <typename T, size_t B>
+void unrolled_list<T, B>::free_node(node *n) {
+    nodes--;
+    ::operator delete(reinterpret_cast<void**>(n)[-1]);
+}
+
+template <typename T, size_t B>
+typename unrolled_list<T, B>::node *unrolled_list<T, B>::insert_node_after(node *before) {
+    node *n = allocate_node();
+    n->prev = before;
+    n->next = before ? before->next : head;
+    if(n->next)
+        n->next->prev = n;
+    else
+        tail = n;
+    if(before)
+        before->next = n;
+    else
+        head = n;
+    return n;
+}
+
+template <typename T, size_t B>
+void unrolled_list<T, B>::unlink_node(node *n) {
+    if(n->prev)
+        n->prev->next = n->next;
+    else
+        head = static_cast<node*>(n->next);
+    if(n->next)
+        n->next->prev = n->prev;
+    else
+        tail = static_cast<node*>(n->prev);
+    free_node(n);
+}
+
+template <typename T, size_t B>
+void unrolled_list<T, B>::move_tail(node *n, size_t from, node *to) {
+    T *source = n->items(), *target = to->items() + to->count;
+    for(size_t i = from; i < n->count; i++) {
+        new(target++) T(std::move(source[i]));
+        source[i].~T();
+    }
+    to->count += n->count - from;
+    n->count = static_cast<uint32_t>(from);
+}
+
+template <typename T, size_t B>
+template <typename... Args>
+typename unrolled_list<T, B>::iterator unrolled_list<T, B>::emplace(iterator position, Args&&... args) {
+    // Construct before any node is allocated or split, so that a throwing constructor leaves the list untouched,
+    //   and so that `args` may refer to an element a split would move
+    T value(std::forward<Args>(args)...);
+
+    node *n = position.current;
+    size_t index = position.index;
+
+    if(!n) {
+        // Appending: use the tail node if it has room
+        n = tail;
+        if(!n || n->count == node_capacity)
+            n = insert_node_after(tail);
+        index = n->count;
+    } else if(n->count == node_capacity) {
+        // Split the full node in half, then insert into whichever half holds the position
+        node *right = insert_node_after(n);
+        move_tail(n, node_capacity / 2, right);
+        if(index > n->count) {
+            index -= n->count;
+            n = right;
+        }
+    }
+
+    T *items = n->items();
+    if(index == n->count) {
+        new(items + index) T(std::move(value));
+    } else {
+        new(items + n->count) T(std::move(items[n->count - 1]));
+        for(size_t i = n->count - 1; i > index; i--)
+            items[i] = std::move(items[i - 1]);
+        items[index] = std::move(value);
+    }
+
+    n->count++;
+    count++;
+    return iterator(this, n, index);
+}
+
+template <typename T, size_t B>
+typename unrolled_list<T, B>::iterator unrolled_list<T, B>::erase(iterator position) {
+    node *n = position.current;
+    size_t index = position.index;
+
+    T *items = n->items();
+    for(size_t i = index; i + 1 < n->count; i++)
+        items[i] = std::move(items[i + 1]);
+    items[n->count - 1].~T();
+    n->count--;
+    count--;
+
+    node *next = static_cast<node*>(n->next);
+    if(n->count < min_fill && next) {
+        if(n->count + next->count <= node_capacity) {
+            move_tail(next, 0, n);
+            unlink_node(next);
+        } else {
+            // Borrow the successor's first element
+            T *borrowed = next->items();
+            new(items + n->count) T(std::move(borrowed[0]));
+            n->count++;
+            for(size_t i = 0; i + 1 < next->count; i++)
+                borrowed[i] = std::move(borrowed[i + 1]);
+            borrowed[next->count - 1].~T();
+            next->count--;
+        }
+    }
+
+    if(n->count == 0) {
+        next = static_cast<node*>(n->next);
+        unlink_node(n);
+        return iterator(this, next, 0);
+    }
+    if(index < n->count)
+        return iterator(this, n, index);
+    return iterator(this, static_cast<node*>(n->next), 0);
+}
+
+template <typename T, size_t B>
+void unrolled_list<T, B>::clear() {
+    node *n = head;
+    while(n) {
+        node *next = static_cast<node*>(n->next);
+        T *items = n->items();
+        for(size_t i = 0; i < n->count; i++)
+            items[i].~T();
+        free_node(n);
+        n = next;
+    }
+    head = tail = nullptr;
+    count = 0;
+}
+
+template <typename T, size_t B>
+typename unrolled_list<T, B>::iterator unrolled_list<T, B>::find_from(const T& value) const {
+    for(node *n = head; n; n = static_cast<node*>(n->next)) {
+        size_t index = unrolled_list_detail::search<T>::find(n->items(), n->count, value);
+        if(index < n->count)
+            return iterator(this, n, index);
+    }
+    return iterator(this, nullptr, 0);
+}
+
+template <typename T, size_t B>
+typename unrolled_list<T, B>::iterator unrolled_list<T, B>::nth_from(size_t index) const {
+    if(index >= count)
+        return iterator(this, nullptr, 0);
+
+    // Walk from whichever end is closer
+    if(index < count / 2) {
+        node *n = head;
+        while(index >= n->count) {
+            index -= n->count;
+            n = static_cast<node*>(n->next);
+        }
+        return iterator(this, n, index);
+    }
+
+    size_t from_back = count - 1 - index;
+    node *n = tail;
+    while(from_back >= n->count) {
+        from_back -= n->count;
+        n = static_cast<node*>(n->prev);
+    }
+    return iterator(this, n, n->count - 1 - from_back);
+}
+
 
 #endif //DATA_STRUCTURES_UNROLLED_LIST_H
@@ -0,0 +1,43 @@
+/**
+ * Bit scanning on 64-bit words, with the compiler's builtins where they exist and portable loops elsewhere.
+ **/
+
+#ifndef DATA_STRUCTURES_BITS_H
+#define DATA_STRUCTURES_BITS_H
+
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @return the index of the highest set bit of `word`, which must not be 0
+ */
+inline size_t highest_set_bit(uint64_t word) {
+#if defined(__GNUC__)
+    return static_cast<size_t>(63 - __builtin_clzll(word));
+#else
+    size_t index = 0;
+    while(word >>= 1)
+        index++;
+    return index;
+#endif
+}
+
+/**
+ * @return the index of the lowest set bit of `word`, which must not be 0
+ */
+inline size_t lowest_set_bit(uint64_t word) {
+#if defined(__GNUC__)
+    return static_cast<size_t>(__builtin_ctzll(word));
+#else
+    size_t index = 0;
+    while(!(word & 1)) {
+        word >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+
+#endif //DATA_STRUCTURES_BITS_H
@@ -0,0 +1,89 @@
+/**
+ * A small, fast pseudo-random number generator for randomized data structures.
+ *
+ * What is xorshift64*?
+ *   One of Marsaglia's xorshift generators, a 64-bit state scrambled with three shifts and XORs per step, with its
+ *   output multiplied by an odd constant as Vigna proposes ("An experimental exploration of Marsaglia's xorshift
+ *   generators, scrambled"). The period is 2^64 - 1, and the high bits of the output pass BigCrush.
+ *
+ * Why is this useful?
+ *   Randomized structures such as skip lists draw a random number on every update, so the generator is on their hot
+ *   path. This one is a handful of instructions and 8 bytes of state; std::rand takes a lock in some C libraries
+ *   and std::mt19937 carries 2.5 KB of state. None of these structures need more than statistical quality.
+ *
+ * How is it implemented?
+ *   A structure that owns one generator seeds it with a constant, so it behaves the same from run to run. Code that
+ *   can run on many threads at once uses `xorshift64_star::for_this_thread()` instead: one generator per thread,
+ *   seeded from the thread's id on first use. It is constant-initialized, so reaching it costs no initialization
+ *   guard.
+ *
+ *   The low bits of the output are the weak ones, so callers that consume bits piecemeal take them from the top.
+ **/
+
+#ifndef DATA_STRUCTURES_XORSHIFT_H
+#define DATA_STRUCTURES_XORSHIFT_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+class xorshift64_star {
+public:
+    /**
+     * @param seed any value; 0, which xorshift never leaves, is replaced
+     */
+    explicit xorshift64_star(uint64_t seed) : state(seed ? seed : 0x9e3779b97f4a7c15ull) {}
+
+    /**
+     * @return 64 random bits
+     */
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dull;
+    }
+    /**
+     * @return 32 random bits, the output's stronger high half
+     */
+    uint32_t next32() { return static_cast<uint32_t>(next() >> 32); }
+    /**
+     * @return a random number in [0, n), from the high half of a 64 x 64-bit product rather than a division
+     */
+    size_t below(size_t n) {
+#ifdef __SIZEOF_INT128__
+        return static_cast<size_t>((static_cast<unsigned __int128>(next()) * n) >> 64);
+#else
+        return static_cast<size_t>(next() % n);
+#endif
+    }
+
+    /**
+     * @return the calling thread's generator
+     */
+    static xorshift64_star& for_this_thread();
+
+private:
+    struct unseeded {};
+    constexpr explicit xorshift64_star(unseeded) : state(0) {}
+
+    uint64_t state;
+};
+
+
+inline xorshift64_star& xorshift64_star::for_this_thread() {
+    static thread_local xorshift64_star generator{unseeded()};
+    if(!generator.state) {
+        // Any nonzero seed that differs between threads will do
+        generator.state = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                          reinterpret_cast<uintptr_t>(&generator) ^ 0x9e3779b97f4a7c15ull;
+        if(!generator.state)
+            generator.state = 1;
+    }
+    return generator;
+}
+
+
+#endif //DATA_STRUCTURES_XORSHIFT_H
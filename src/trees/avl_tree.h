@@ -1,14 +1,464 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * An ordered map implemented as an AVL tree with order statistics.
+ *
+ * What is an AVL tree?
+ *   A binary search tree where the heights of the two subtrees of every node differ by at most one. Each node stores
+ *   that difference, its balance factor; an insertion or erasure that pushes it to +-2 is fixed by one or two
+ *   rotations, which keeps the height below 1.44 log2(n).
+ *
+ * Why is this useful?
+ *   AVL trees are more tightly balanced than red-black trees, so lookups visit fewer nodes, at the price of more
+ *   rotations on updates; they suit lookup-heavy maps. Storing the size of every subtree in its root also gives
+ *   order statistics: the i-th smallest key (`select`) and the number of keys below a key (`rank`) in O(log n).
+ *
+ * How is it implemented?
+ *   Nodes have no parent pointer. Insert and erase descend iteratively, recording on a fixed-size stack the address
+ *   of each link they follow, then walk that stack back up to update subtree sizes and balance factors, rewriting
+ *   the link of any subtree they rotate. The height bound means 48 entries are enough for any tree of up to 2^32
+ *   keys, which is also the limit set by the 32-bit subtree sizes.
+ *
+ *   The balance factor takes a single byte and shares a word with the subtree size, so a node is two child pointers
+ *   and one word of bookkeeping ahead of the key and value. Nodes come from a slab pool owned by the tree (see
+ *   linked_list.h), which keeps them close together and reuses freed ones without going to the allocator.
+ *
+ *   Iterators hold just a node, so advancing one searches from the root for the next key, in O(log n).
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_AVL_TREE_H
 #define DATA_STRUCTURES_AVL_TREE_H
 
 
+#include "../linear/lists/linked_list.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+template <typename K, typename V, typename Compare = std::less<K>>
 class avl_tree {
+    struct node {
+        node *child[2];
+        uint32_t count;
+        // Height of the right subtree minus height of the left one
+        int8_t balance;
+        K key;
+        V value;
+
+        node(const K& key, const V& value) : child{nullptr, nullptr}, count(1), balance(0), key(key), value(value) {}
+    };
+
+public:
+    class iterator {
+    public:
+        iterator() = default;
+
+        const K& key() const { return current->key; }
+        V& value() const { return current->value; }
+
+        iterator& operator++() {
+            current = tree->upper_node(current->key);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+
+    private:
+        friend class avl_tree;
+        iterator(const avl_tree *tree, node *current) : tree(tree), current(current) {}
+
+        const avl_tree *tree = nullptr;
+        node *current = nullptr;
+    };
+
+    avl_tree() = default;
+    avl_tree(const avl_tree& other) : comp(other.comp) {
+        root = copy(other.root);
+    }
+    avl_tree(avl_tree&& other) noexcept { swap(other); }
+    ~avl_tree() { clear(); }
+
+    avl_tree& operator=(avl_tree other) {
+        swap(other);
+        return *this;
+    }
+
+    void swap(avl_tree& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(comp, other.comp);
+        pool.swap(other.pool);
+    }
+
 
+    /**
+     * Inserts `key` -> `value` if `key` is not already present.
+     *
+     * @return true if the pair was inserted, false if the key already existed
+     * @throws std::length_error if the tree already holds 2^32 - 1 keys
+     */
+    bool insert(const K& key, const V& value) { return insert_node(key, value).second; }
+    /**
+     * @return a reference to the value mapped to `key`, default constructing it if needed
+     */
+    V& operator[](const K& key) { return insert_node(key, V()).first->value; }
+    /**
+     * Removes `key` from the tree.
+     *
+     * @return true if the key was present
+     */
+    bool erase(const K& key);
+    /**
+     * Removes every pair from the tree.
+     */
+    void clear();
+
+
+    /**
+     * @return an iterator to `key`, or end() if it isn't present
+     */
+    iterator find(const K& key) const;
+    /**
+     * @return an iterator to the first key not less than `key`
+     */
+    iterator lower_bound(const K& key) const;
+    /**
+     * @return an iterator to the first key greater than `key`
+     */
+    iterator upper_bound(const K& key) const { return iterator(this, upper_node(key)); }
+    size_t count(const K& key) const { return find(key) != end() ? 1 : 0; }
+
+    /**
+     * @return an iterator to the key of rank `index`, the index-th smallest, counting from 0
+     * @throws std::out_of_range if index >= size()
+     */
+    iterator select(size_t index) const;
+    /**
+     * @return the number of keys less than `key`
+     */
+    size_t rank(const K& key) const;
+
+
+    iterator begin() const;
+    iterator end() const { return iterator(this, nullptr); }
+
+    size_t size() const { return root ? root->count : 0; }
+    bool empty() const { return root == nullptr; }
+    /**
+     * @return the number of levels in the tree (0 when empty)
+     */
+    size_t height() const;
+
+private:
+    // 1.44 log2(2^32) rounded up, with room to spare
+    static const size_t MAX_HEIGHT = 48;
+
+    node *root = nullptr;
+    Compare comp;
+    linked_list_detail::slab_pool<node> pool;
+
+    static size_t count_of(const node *n) { return n ? n->count : 0; }
+    /**
+     * Lifts n->child[side] above n.
+     *
+     * @return the new root of the subtree
+     */
+    static node *rotate(node *n, int side);
+    /**
+     * Restores the balance of a node whose balance factor is +-2.
+     *
+     * @return the new root of the subtree, whose balance factor is 0 exactly when the subtree got shorter
+     */
+    static node *rebalance(node *n);
+
+    std::pair<node*, bool> insert_node(const K& key, const V& value);
+    node *upper_node(const K& key) const;
+    node *copy(const node *n);
+    void destroy(node *n);
 };
 
 
+// Define avl_tree
+
+template <typename K, typename V, typename C>
+typename avl_tree<K, V, C>::node *avl_tree<K, V, C>::rotate(node *n, int side) {
+    node *lifted = n->child[side];
+    n->child[side] = lifted->child[1 - side];
+    lifted->child[1 - side] = n;
+    lifted->count = n->count;
+    n->count = static_cast<uint32_t>(1 + count_of(n->child[0]) + count_of(n->child[1]));
+    return lifted;
+}
+
+template <typename K, typename V, typename C>
+typename avl_tree<K, V, C>::node *avl_tree<K, V, C>::rebalance(node *n) {
+    int side = n->balance > 0 ? 1 : 0;
+    int8_t heavy = side ? 1 : -1;
+    node *c = n->child[side];
+
+    if(c->balance == -heavy) {
+        // The child leans the other way: lift the grandchild between them over both
+        node *g = c->child[1 - side];
+        n->child[side] = rotate(c, 1 - side);
+        rotate(n, side);
+        n->balance = g->balance == heavy ? -heavy : 0;
+        c->balance = g->balance == -heavy ? heavy : 0;
+        g->balance = 0;
+        return g;
+    }
+
+    rotate(n, side);
+    if(c->balance == 0) {
+        // Only after an erasure: the subtree keeps its height
+        n->balance = heavy;
+        c->balance = -heavy;
+    } else {
+        n->balance = c->balance = 0;
+    }
+    return c;
+}
+
+template <typename K, typename V, typename C>
+std::pair<typename avl_tree<K, V, C>::node*, bool> avl_tree<K, V, C>::insert_node(const K& key, const V& value) {
+    node **link[MAX_HEIGHT];
+    int side[MAX_HEIGHT];
+    size_t depth = 0;
+
+    node **current = &root;
+    while(*current) {
+        node *n = *current;
+        if(comp(key, n->key))
+            side[depth] = 0;
+        else if(comp(n->key, key))
+            side[depth] = 1;
+        else
+            return std::make_pair(n, false);
+        link[depth++] = current;
+        current = &n->child[side[depth - 1]];
+    }
+
+    if(size() == UINT32_MAX)
+        throw std::length_error("avl_tree: too many keys");
+    node *inserted = pool.create(key, value);
+    *current = inserted;
+    for(size_t i = 0; i < depth; i++)
+        (*link[i])->count++;
+
+    // Retrace until a subtree's height stops changing; after an insertion, a rotation always ends it
+    for(size_t i = depth; i-- > 0;) {
+        node *n = *link[i];
+        n->balance += side[i] ? 1 : -1;
+        if(n->balance == 0)
+            break;
+        if(n->balance == 2 || n->balance == -2) {
+            *link[i] = rebalance(n);
+            break;
+        }
+    }
+    return std::make_pair(inserted, true);
+}
+
+template <typename K, typename V, typename C>
+bool avl_tree<K, V, C>::erase(const K& key) {
+    node **link[MAX_HEIGHT];
+    int side[MAX_HEIGHT];
+    size_t depth = 0;
+
+    node **current = &root;
+    while(*current) {
+        node *n = *current;
+        if(comp(key, n->key))
+            side[depth] = 0;
+        else if(comp(n->key, key))
+            side[depth] = 1;
+        else
+            break;
+        link[depth++] = current;
+        current = &n->child[side[depth - 1]];
+    }
+    node *target = *current;
+    if(!target)
+        return false;
+
+    if(target->child[0] && target->child[1]) {
+        // Unlink the successor, the leftmost node of the right subtree, and put it in the target's place
+        size_t target_depth = depth;
+        link[depth] = current;
+        side[depth++] = 1;
+        node **successor_link = &target->child[1];
+        while((*successor_link)->child[0]) {
+            link[depth] = successor_link;
+            side[depth++] = 0;
+            successor_link = &(*successor_link)->child[0];
+        }
+
+        node *successor = *successor_link;
+        *successor_link = successor->child[1];
+        successor->child[0] = target->child[0];
+        successor->child[1] = target->child[1];
+        successor->count = target->count;
+        successor->balance = target->balance;
+        *current = successor;
+        // The path went through the target's right link, which is now the successor's
+        if(depth > target_depth + 1)
+            link[target_depth + 1] = &successor->child[1];
+    } else {
+        *current = target->child[target->child[0] ? 0 : 1];
+    }
+    pool.destroy(target);
+    for(size_t i = 0; i < depth; i++)
+        (*link[i])->count--;
+
+    // Retrace while subtrees keep getting shorter
+    for(size_t i = depth; i-- > 0;) {
+        node *n = *link[i];
+        n->balance -= side[i] ? 1 : -1;
+        if(n->balance == 1 || n->balance == -1)
+            break;
+        if(n->balance != 0) {
+            n = *link[i] = rebalance(n);
+            if(n->balance != 0)
+                break;
+        }
+    }
+    return true;
+}
+
+template <typename K, typename V, typename C>
+void avl_tree<K, V, C>::clear() {
+    destroy(root);
+    root = nullptr;
+    pool.release();
+}
+
+template <typename K, typename V, typename C>
+typename avl_tree<K, V, C>::iterator avl_tree<K, V, C>::find(const K& key) const {
+    node *n = root;
+    while(n) {
+        if(comp(key, n->key))
+            n = n->child[0];
+        else if(comp(n->key, key))
+            n = n->child[1];
+        else
+            break;
+    }
+    return iterator(this, n);
+}
+
+template <typename K, typename V, typename C>
+typename avl_tree<K, V, C>::iterator avl_tree<K, V, C>::lower_bound(const K& key) const {
+    node *n = root, *found = nullptr;
+    while(n) {
+        if(comp(n->key, key)) {
+            n = n->child[1];
+        } else {
+            found = n;
+            n = n->child[0];
+        }
+    }
+    return iterator(this, found);
+}
+
+template <typename K, typename V, typename C>
+typename avl_tree<K, V, C>::node *avl_tree<K, V, C>::upper_node(const K& key) const {
+    node *n = root, *found = nullptr;
+    while(n) {
+        if(comp(key, n->key)) {
+            found = n;
+            n = n->child[0];
+        } else {
+            n = n->child[1];
+        }
+    }
+    return found;
+}
+
+template <typename K, typename V, typename C>
+typename avl_tree<K, V, C>::iterator avl_tree<K, V, C>::select(size_t index) const {
+    if(index >= size())
+        throw std::out_of_range("avl_tree: select past the end");
+    node *n = root;
+    for(;;) {
+        size_t left = count_of(n->child[0]);
+        if(index < left) {
+            n = n->child[0];
+        } else if(index == left) {
+            return iterator(this, n);
+        } else {
+            index -= left + 1;
+            n = n->child[1];
+        }
+    }
+}
+
+template <typename K, typename V, typename C>
+size_t avl_tree<K, V, C>::rank(const K& key) const {
+    size_t below = 0;
+    node *n = root;
+    while(n) {
+        if(comp(n->key, key)) {
+            below += count_of(n->child[0]) + 1;
+            n = n->child[1];
+        } else {
+            n = n->child[0];
+        }
+    }
+    return below;
+}
+
+template <typename K, typename V, typename C>
+typename avl_tree<K, V, C>::iterator avl_tree<K, V, C>::begin() const {
+    node *n = root;
+    while(n && n->child[0])
+        n = n->child[0];
+    return iterator(this, n);
+}
+
+template <typename K, typename V, typename C>
+size_t avl_tree<K, V, C>::height() const {
+    // The taller side of every node is known from its balance factor
+    size_t levels = 0;
+    for(node *n = root; n; n = n->child[n->balance > 0 ? 1 : 0])
+        levels++;
+    return levels;
+}
+
+template <typename K, typename V, typename C>
+typename avl_tree<K, V, C>::node *avl_tree<K, V, C>::copy(const node *n) {
+    if(!n)
+        return nullptr;
+    node *fresh = pool.create(n->key, n->value);
+    fresh->count = n->count;
+    fresh->balance = n->balance;
+    try {
+        fresh->child[0] = copy(n->child[0]);
+        fresh->child[1] = copy(n->child[1]);
+    } catch(...) {
+        destroy(fresh);
+        throw;
+    }
+    return fresh;
+}
+
+template <typename K, typename V, typename C>
+void avl_tree<K, V, C>::destroy(node *n) {
+    // Recursion is bounded by the height
+    if(!n)
+        return;
+    destroy(n->child[0]);
+    destroy(n->child[1]);
+    pool.destroy(n);
+}
+
+// End of avl_tree definitions
+
+
 #endif //DATA_STRUCTURES_AVL_TREE_H
@@ -1,14 +1,499 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * An ordered map implemented as a randomized binary search tree, with order statistics and a parallel bulk build.
+ *
+ * What is a randomized binary search tree?
+ *   A binary search tree kept in the shape of one built by inserting its keys in uniformly random order, whatever the
+ *   order they actually arrive in (Martinez and Roura, "Randomized Binary Search Trees"). Every node stores the size
+ *   of its subtree. A key inserted into a subtree of n nodes becomes its root with probability 1 / (n + 1), by
+ *   splitting the subtree around it, and otherwise goes down to the child it belongs in. Erasing a node joins its two
+ *   subtrees, picking the root of either one with probability proportional to its size. Both preserve the random
+ *   shape, so every operation is O(log n) in expectation, with no balance information and no adversarial inputs.
+ *
+ * Why is this useful?
+ *   The guarantees come from the tree's own coin flips, not from the input, so sorted or otherwise patterned keys
+ *   cost the same as random ones. The subtree sizes needed for the coin flips also give order statistics: the i-th
+ *   smallest key (`select`) and the number of keys below a key (`rank`) in O(log n).
+ *
+ * How is it implemented?
+ *   Updates draw one random number per level they visit, so the generator is on the hot path. They use the calling
+ *   thread's xorshift64_star, which needs no locking, and its `below`, which avoids a division.
+ *
+ *   Sorted input can be loaded in O(n) without any search: the root of a random tree over n sorted keys is a
+ *   uniformly random one of them, and its two subtrees are random trees over the keys on either side. Those two are
+ *   built independently, so the bulk constructor forks one of them onto a new std::thread, splitting the thread
+ *   budget between them as it recurses, until the budget or the subproblem runs out. Nodes are allocated with new so
+ *   that the threads can allocate them concurrently.
+ *
+ *   Iterators hold just a node, so advancing one searches from the root for the next key, in O(log n).
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_RANDOMIZED_BINARY_SEARCH_TREE_H
 #define DATA_STRUCTURES_RANDOMIZED_BINARY_SEARCH_TREE_H
 
 
+#include "../primitives/xorshift.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+template <typename K, typename V, typename Compare = std::less<K>>
 class randomized_binary_search_tree {
+    struct node {
+        node *left = nullptr, *right = nullptr;
+        size_t size = 1;
+        K key;
+        V value;
+
+        node(const K& key, const V& value) : key(key), value(value) {}
+    };
+
+public:
+    class iterator {
+    public:
+        iterator() = default;
+
+        const K& key() const { return current->key; }
+        V& value() const { return current->value; }
+
+        iterator& operator++() {
+            current = tree->upper_node(current->key);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+
+    private:
+        friend class randomized_binary_search_tree;
+        iterator(const randomized_binary_search_tree *tree, node *current) : tree(tree), current(current) {}
+
+        const randomized_binary_search_tree *tree = nullptr;
+        node *current = nullptr;
+    };
+
+    randomized_binary_search_tree() = default;
+    /**
+     * Builds the tree from the key/value pairs in [first, last) in O(n), without comparing keys beyond checking the
+     *   order.
+     *
+     * The input must be sorted by key with no duplicates, and `It` a random access iterator.
+     *
+     * @param threads how many threads may work on it, the calling one included; 0 means one per hardware thread
+     * @throws std::invalid_argument if the input is not strictly increasing
+     */
+    template <typename It>
+    randomized_binary_search_tree(It first, It last, unsigned threads = 1);
+    randomized_binary_search_tree(const randomized_binary_search_tree& other) : comp(other.comp) {
+        root = copy(other.root);
+    }
+    randomized_binary_search_tree(randomized_binary_search_tree&& other) noexcept { swap(other); }
+    ~randomized_binary_search_tree() { clear(); }
+
+    randomized_binary_search_tree& operator=(randomized_binary_search_tree other) {
+        swap(other);
+        return *this;
+    }
+
+    void swap(randomized_binary_search_tree& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(comp, other.comp);
+    }
+
 
+    /**
+     * Inserts `key` -> `value` if `key` is not already present.
+     *
+     * @return true if the pair was inserted, false if the key already existed
+     */
+    bool insert(const K& key, const V& value);
+    /**
+     * @return a reference to the value mapped to `key`, default constructing it if needed
+     */
+    V& operator[](const K& key);
+    /**
+     * Removes `key` from the tree.
+     *
+     * @return true if the key was present
+     */
+    bool erase(const K& key);
+    void clear();
+
+
+    /**
+     * @return an iterator to `key`, or end() if it isn't present
+     */
+    iterator find(const K& key) const;
+    /**
+     * @return an iterator to the first key not less than `key`
+     */
+    iterator lower_bound(const K& key) const;
+    /**
+     * @return an iterator to the first key greater than `key`
+     */
+    iterator upper_bound(const K& key) const { return iterator(this, upper_node(key)); }
+    size_t count(const K& key) const { return find(key) != end() ? 1 : 0; }
+
+    /**
+     * @return an iterator to the key of rank `index`, the index-th smallest, counting from 0
+     * @throws std::out_of_range if index >= size()
+     */
+    iterator select(size_t index) const;
+    /**
+     * @return the number of keys less than `key`
+     */
+    size_t rank(const K& key) const;
+
+
+    iterator begin() const;
+    iterator end() const { return iterator(this, nullptr); }
+
+    size_t size() const { return size_of(root); }
+    bool empty() const { return root == nullptr; }
+    /**
+     * @return the number of levels in the tree (0 when empty)
+     */
+    size_t height() const { return height_of(root); }
+
+private:
+    // Subproblems smaller than this many keys are not worth starting a thread for
+    static const size_t PARALLEL_CUTOFF = 4096;
+
+    node *root = nullptr;
+    Compare comp;
+
+    static size_t size_of(const node *n) { return n ? n->size : 0; }
+    static size_t height_of(const node *n);
+    static void update(node *n) { n->size = 1 + size_of(n->left) + size_of(n->right); }
+
+    /**
+     * Inserts the absent key of `fresh` into `t`.
+     *
+     * @return the new root of `t`
+     */
+    node *insert_into(node *t, node *fresh) const;
+    /**
+     * Splits `t` around `key`, which it does not hold.
+     */
+    void split(node *t, const K& key, node *&left, node *&right) const;
+    /**
+     * Joins `left` and `right`, every key of which is greater, preserving the random shape.
+     */
+    static node *join(node *left, node *right);
+    node *erase_from(node *t, const K& key) const;
+
+    template <typename It>
+    static node *build(It first, size_t count, unsigned threads);
+    node *upper_node(const K& key) const;
+    static node *copy(const node *n);
+    static void destroy(node *n);
 };
 
 
+// Define randomized_binary_search_tree
+
+template <typename K, typename V, typename C>
+template <typename It>
+randomized_binary_search_tree<K, V, C>::randomized_binary_search_tree(It first, It last, unsigned threads) {
+    size_t count = static_cast<size_t>(std::distance(first, last));
+    for(size_t i = 1; i < count; i++)
+        if(!comp(first[i - 1].first, first[i].first))
+            throw std::invalid_argument("randomized_binary_search_tree: bulk input must be strictly increasing");
+    if(threads == 0)
+        threads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    root = build(first, count, threads);
+}
+
+template <typename K, typename V, typename C>
+template <typename It>
+typename randomized_binary_search_tree<K, V, C>::node *randomized_binary_search_tree<K, V, C>::build(
+        It first, size_t count, unsigned threads) {
+    if(count == 0)
+        return nullptr;
+
+    size_t pick = xorshift64_star::for_this_thread().below(count);
+    node *n = new node(first[pick].first, first[pick].second);
+    n->size = count;
+
+    // Each side catches its own failure, so that a throw on the forked thread does not terminate the program
+    std::exception_ptr left_failure, right_failure;
+    auto build_left = [&](unsigned share) {
+        try {
+            n->left = build(first, pick, share);
+        } catch(...) {
+            left_failure = std::current_exception();
+        }
+    };
+    auto build_right = [&](unsigned share) {
+        try {
+            n->right = build(first + pick + 1, count - pick - 1, share);
+        } catch(...) {
+            right_failure = std::current_exception();
+        }
+    };
+
+    std::thread helper;
+    unsigned half = threads / 2;
+    if(threads >= 2 && count >= PARALLEL_CUTOFF) {
+        try {
+            helper = std::thread(build_left, half);
+        } catch(const std::system_error&) {
+            // Out of threads: carry on with this one
+        }
+    }
+    if(helper.joinable()) {
+        build_right(threads - half);
+        helper.join();
+    } else {
+        build_left(1);
+        build_right(1);
+    }
+
+    if(left_failure || right_failure) {
+        destroy(n);
+        std::rethrow_exception(left_failure ? left_failure : right_failure);
+    }
+    return n;
+}
+
+template <typename K, typename V, typename C>
+size_t randomized_binary_search_tree<K, V, C>::height_of(const node *n) {
+    if(!n)
+        return 0;
+    size_t left = height_of(n->left), right = height_of(n->right);
+    return 1 + (left > right ? left : right);
+}
+
+template <typename K, typename V, typename C>
+void randomized_binary_search_tree<K, V, C>::split(node *t, const K& key, node *&left, node *&right) const {
+    if(!t) {
+        left = right = nullptr;
+        return;
+    }
+    if(comp(key, t->key)) {
+        split(t->left, key, left, t->left);
+        right = t;
+    } else {
+        split(t->right, key, t->right, right);
+        left = t;
+    }
+    update(t);
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::node *randomized_binary_search_tree<K, V, C>::insert_into(
+        node *t, node *fresh) const {
+    if(!t)
+        return fresh;
+    if(xorshift64_star::for_this_thread().below(t->size + 1) == 0) {
+        // The new key is the root of this subtree with probability 1 / (size + 1)
+        split(t, fresh->key, fresh->left, fresh->right);
+        update(fresh);
+        return fresh;
+    }
+
+    if(comp(fresh->key, t->key))
+        t->left = insert_into(t->left, fresh);
+    else
+        t->right = insert_into(t->right, fresh);
+    t->size++;
+    return t;
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::node *randomized_binary_search_tree<K, V, C>::join(node *left,
+                                                                                                    node *right) {
+    if(!left)
+        return right;
+    if(!right)
+        return left;
+
+    if(xorshift64_star::for_this_thread().below(left->size + right->size) < left->size) {
+        left->right = join(left->right, right);
+        update(left);
+        return left;
+    }
+    right->left = join(left, right->left);
+    update(right);
+    return right;
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::node *randomized_binary_search_tree<K, V, C>::erase_from(
+        node *t, const K& key) const {
+    // The key is known to be present
+    if(comp(key, t->key)) {
+        t->left = erase_from(t->left, key);
+    } else if(comp(t->key, key)) {
+        t->right = erase_from(t->right, key);
+    } else {
+        node *joined = join(t->left, t->right);
+        delete t;
+        return joined;
+    }
+    t->size--;
+    return t;
+}
+
+template <typename K, typename V, typename C>
+bool randomized_binary_search_tree<K, V, C>::insert(const K& key, const V& value) {
+    if(find(key) != end())
+        return false;
+    root = insert_into(root, new node(key, value));
+    return true;
+}
+
+template <typename K, typename V, typename C>
+V& randomized_binary_search_tree<K, V, C>::operator[](const K& key) {
+    iterator found = find(key);
+    if(found != end())
+        return found.value();
+    node *fresh = new node(key, V());
+    root = insert_into(root, fresh);
+    return fresh->value;
+}
+
+template <typename K, typename V, typename C>
+bool randomized_binary_search_tree<K, V, C>::erase(const K& key) {
+    if(find(key) == end())
+        return false;
+    root = erase_from(root, key);
+    return true;
+}
+
+template <typename K, typename V, typename C>
+void randomized_binary_search_tree<K, V, C>::clear() {
+    destroy(root);
+    root = nullptr;
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::iterator randomized_binary_search_tree<K, V, C>::find(
+        const K& key) const {
+    node *n = root;
+    while(n) {
+        if(comp(key, n->key))
+            n = n->left;
+        else if(comp(n->key, key))
+            n = n->right;
+        else
+            break;
+    }
+    return iterator(this, n);
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::iterator randomized_binary_search_tree<K, V, C>::lower_bound(
+        const K& key) const {
+    node *n = root, *found = nullptr;
+    while(n) {
+        if(comp(n->key, key)) {
+            n = n->right;
+        } else {
+            found = n;
+            n = n->left;
+        }
+    }
+    return iterator(this, found);
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::node *randomized_binary_search_tree<K, V, C>::upper_node(
+        const K& key) const {
+    node *n = root, *found = nullptr;
+    while(n) {
+        if(comp(key, n->key)) {
+            found = n;
+            n = n->left;
+        } else {
+            n = n->right;
+        }
+    }
+    return found;
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::iterator randomized_binary_search_tree<K, V, C>::select(
+        size_t index) const {
+    if(index >= size())
+        throw std::out_of_range("randomized_binary_search_tree: select past the end");
+    node *n = root;
+    for(;;) {
+        size_t left = size_of(n->left);
+        if(index < left) {
+            n = n->left;
+        } else if(index == left) {
+            return iterator(this, n);
+        } else {
+            index -= left + 1;
+            n = n->right;
+        }
+    }
+}
+
+template <typename K, typename V, typename C>
+size_t randomized_binary_search_tree<K, V, C>::rank(const K& key) const {
+    size_t below = 0;
+    node *n = root;
+    while(n) {
+        if(comp(n->key, key)) {
+            below += size_of(n->left) + 1;
+            n = n->right;
+        } else {
+            n = n->left;
+        }
+    }
+    return below;
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::iterator randomized_binary_search_tree<K, V, C>::begin() const {
+    node *n = root;
+    while(n && n->left)
+        n = n->left;
+    return iterator(this, n);
+}
+
+template <typename K, typename V, typename C>
+typename randomized_binary_search_tree<K, V, C>::node *randomized_binary_search_tree<K, V, C>::copy(const node *n) {
+    if(!n)
+        return nullptr;
+    node *fresh = new node(n->key, n->value);
+    fresh->size = n->size;
+    try {
+        fresh->left = copy(n->left);
+        fresh->right = copy(n->right);
+    } catch(...) {
+        destroy(fresh);
+        throw;
+    }
+    return fresh;
+}
+
+template <typename K, typename V, typename C>
+void randomized_binary_search_tree<K, V, C>::destroy(node *n) {
+    // Recursion is bounded by the height, O(log n) in expectation
+    if(!n)
+        return;
+    destroy(n->left);
+    destroy(n->right);
+    delete n;
+}
+
+// End of randomized_binary_search_tree definitions
+
+
 #endif //DATA_STRUCTURES_RANDOMIZED_BINARY_SEARCH_TREE_H
@@ -1,14 +1,643 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * An ordered set implemented as a red-black tree, with split, join and parallel set algebra.
+ *
+ * What is a red-black tree?
+ *   A binary search tree whose nodes are colored red or black so that no red node has a red child and every path
+ *   from a node down to a leaf crosses the same number of black nodes, its black height. The longest path is then at
+ *   most twice the shortest, so the height stays below 2 log2(n + 1).
+ *
+ * Why is this useful?
+ *   Besides O(log n) insert, erase and lookup, a red-black tree can be joined and split cheaply: `join` concatenates
+ *   two sets where every key of one is below every key of the other in O(log n), and `split` cuts a set at a key in
+ *   O(log n). Union, intersection and difference built on those two are O(m log(n / m + 1)) for sets of sizes
+ *   m <= n, which is optimal, and their two recursive halves are independent, so they run in parallel.
+ *
+ * How is it implemented?
+ *   Every operation is built on join, following Blelloch, Ferizovic and Sun, "Just Join for Parallel Ordered Sets".
+ *   Joining L, k and R walks down the right spine of the taller of L and R to a black node of the other's black
+ *   height, hangs a red k there with the shorter tree as its sibling, and fixes any red-red pair with one rotation
+ *   on the way back up. Split walks down to the key and joins the pieces it cuts off on the way back up. Insert and
+ *   erase are a split followed by a join. Nodes store their black height and subtree size, and are reused by splits
+ *   and joins rather than reallocated.
+ *
+ *   The set operations split the second tree at the root of the first, recurse on the two halves, and join the
+ *   results around the root. They fork the left half onto a new std::thread while the calling thread takes the right
+ *   half, splitting the thread budget between them, until the budget is down to one thread or the subproblem is too
+ *   small to be worth a thread; below that they run sequentially. The comparison must not throw.
+ *
+ *   Iterators hold just a node, so advancing one searches from the root for the next key, in O(log n).
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_RED_BLACK_TREE_H
 #define DATA_STRUCTURES_RED_BLACK_TREE_H
 
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+template <typename K, typename Compare = std::less<K>>
 class red_black_tree {
+    struct node {
+        node *left = nullptr, *right = nullptr;
+        size_t size = 1;
+        // Black nodes on a path from this node down to a leaf, itself included
+        uint8_t black_height = 0;
+        bool red = true;
+        K key;
+
+        explicit node(const K& key) : key(key) {}
+    };
+
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef K value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const K *pointer;
+        typedef const K& reference;
+
+        iterator() = default;
+
+        const K& operator*() const { return current->key; }
+        const K *operator->() const { return &current->key; }
+
+        iterator& operator++() {
+            current = tree->upper_node(current->key);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+
+    private:
+        friend class red_black_tree;
+        iterator(const red_black_tree *tree, node *current) : tree(tree), current(current) {}
+
+        const red_black_tree *tree = nullptr;
+        node *current = nullptr;
+    };
+
+    red_black_tree() = default;
+    red_black_tree(const red_black_tree& other) : comp(other.comp) {
+        root = copy(other.root);
+    }
+    red_black_tree(red_black_tree&& other) noexcept { swap(other); }
+    ~red_black_tree() { clear(); }
+
+    red_black_tree& operator=(red_black_tree other) {
+        swap(other);
+        return *this;
+    }
+
+    void swap(red_black_tree& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(comp, other.comp);
+    }
+
+
+    /**
+     * @return true if `key` was inserted, false if it was already present
+     */
+    bool insert(const K& key);
+    /**
+     * @return true if `key` was present
+     */
+    bool erase(const K& key);
+    void clear();
+
+
+    /**
+     * Moves the keys below `key` into `below` and those above it into `above`, leaving this set empty, in O(log n).
+     *   Whatever `below` and `above` held is discarded.
+     *
+     * @return true if `key` itself was present; it is dropped
+     */
+    bool split(const K& key, red_black_tree& below, red_black_tree& above);
+    /**
+     * Appends every key of `above` to this set, in O(log n).
+     *
+     * @throws std::invalid_argument unless every key of `above` is greater than every key of this set
+     */
+    void join(red_black_tree above);
+    /**
+     * Appends `key` and then every key of `above` to this set, in O(log n).
+     *
+     * @throws std::invalid_argument unless every key here is less than `key`, which is less than every key of `above`
+     */
+    void join(const K& key, red_black_tree above);
+
+
+    /**
+     * Adds every key of `other` to this set.
+     *
+     * @param threads how many threads may work on it, the calling one included; 0 means one per hardware thread
+     */
+    void unite(red_black_tree other, unsigned threads = 1);
+    /**
+     * Removes every key that is not also in `other`.
+     *
+     * @param threads how many threads may work on it, the calling one included; 0 means one per hardware thread
+     */
+    void intersect(red_black_tree other, unsigned threads = 1);
+    /**
+     * Removes every key that is in `other`.
+     *
+     * @param threads how many threads may work on it, the calling one included; 0 means one per hardware thread
+     */
+    void subtract(red_black_tree other, unsigned threads = 1);
 
+
+    iterator find(const K& key) const;
+    iterator lower_bound(const K& key) const;
+    iterator upper_bound(const K& key) const { return iterator(this, upper_node(key)); }
+    size_t count(const K& key) const { return find(key) != end() ? 1 : 0; }
+
+    iterator begin() const;
+    iterator end() const { return iterator(this, nullptr); }
+
+    size_t size() const { return size_of(root); }
+    bool empty() const { return root == nullptr; }
+    /**
+     * @return the number of levels in the tree (0 when empty)
+     */
+    size_t height() const { return height_of(root); }
+
+private:
+    // Subproblems smaller than this many keys are not worth starting a thread for
+    static const size_t PARALLEL_CUTOFF = 4096;
+
+    node *root = nullptr;
+    Compare comp;
+
+    static size_t size_of(const node *n) { return n ? n->size : 0; }
+    static int black_height(const node *n) { return n ? n->black_height : 0; }
+    static bool is_red(const node *n) { return n && n->red; }
+    static size_t height_of(const node *n);
+    /**
+     * Recomputes the size and black height of `n` from its children and color.
+     */
+    static void update(node *n);
+    static node *rotate_left(node *n);
+    static node *rotate_right(node *n);
+    static node *blacken(node *n);
+
+    static node *join_right(node *left, node *middle, node *right);
+    static node *join_left(node *left, node *middle, node *right);
+    /**
+     * Joins the trees `left` and `right` around the single node `middle`, whose key lies between them.
+     */
+    static node *join(node *left, node *middle, node *right);
+    /**
+     * Detaches the last node of `n`, leaving the rest of it in `rest`.
+     */
+    static node *split_last(node *n, node *&rest);
+    static node *join_pair(node *left, node *right);
+    /**
+     * Splits `n` into the keys below `key` and those above it.
+     *
+     * @return the node holding `key`, detached, or nullptr
+     */
+    node *split_at(node *n, const K& key, node *&left, node *&right) const;
+
+    /**
+     * Runs `first` and `second`, on two threads if `threads` allows it and there is enough `work` for two. Each is
+     *   given the number of threads it may use in turn.
+     */
+    template <typename F, typename G>
+    static void fork(unsigned threads, size_t work, F&& first, G&& second);
+    node *unite_nodes(node *a, node *b, unsigned threads) const;
+    node *intersect_nodes(node *a, node *b, unsigned threads) const;
+    node *subtract_nodes(node *a, node *b, unsigned threads) const;
+
+    node *upper_node(const K& key) const;
+    node *last_node() const;
+    static node *copy(const node *n);
+    static void destroy(node *n);
 };
 
 
+// Define red_black_tree
+
+template <typename K, typename C>
+size_t red_black_tree<K, C>::height_of(const node *n) {
+    if(!n)
+        return 0;
+    size_t left = height_of(n->left), right = height_of(n->right);
+    return 1 + (left > right ? left : right);
+}
+
+template <typename K, typename C>
+void red_black_tree<K, C>::update(node *n) {
+    n->size = 1 + size_of(n->left) + size_of(n->right);
+    n->black_height = static_cast<uint8_t>(black_height(n->left) + (n->red ? 0 : 1));
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::rotate_left(node *n) {
+    node *lifted = n->right;
+    n->right = lifted->left;
+    lifted->left = n;
+    update(n);
+    update(lifted);
+    return lifted;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::rotate_right(node *n) {
+    node *lifted = n->left;
+    n->left = lifted->right;
+    lifted->right = n;
+    update(n);
+    update(lifted);
+    return lifted;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::blacken(node *n) {
+    if(n && n->red) {
+        n->red = false;
+        update(n);
+    }
+    return n;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::join_right(node *left, node *middle, node *right) {
+    if(!is_red(left) && black_height(left) == black_height(right)) {
+        middle->left = left;
+        middle->right = right;
+        middle->red = true;
+        update(middle);
+        return middle;
+    }
+
+    left->right = join_right(left->right, middle, right);
+    update(left);
+    if(!left->red && is_red(left->right) && is_red(left->right->right)) {
+        left->right->right->red = false;
+        update(left->right->right);
+        return rotate_left(left);
+    }
+    return left;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::join_left(node *left, node *middle, node *right) {
+    if(!is_red(right) && black_height(right) == black_height(left)) {
+        middle->left = left;
+        middle->right = right;
+        middle->red = true;
+        update(middle);
+        return middle;
+    }
+
+    right->left = join_left(left, middle, right->left);
+    update(right);
+    if(!right->red && is_red(right->left) && is_red(right->left->left)) {
+        right->left->left->red = false;
+        update(right->left->left);
+        return rotate_right(right);
+    }
+    return right;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::join(node *left, node *middle, node *right) {
+    if(black_height(left) > black_height(right)) {
+        node *joined = join_right(left, middle, right);
+        if(joined->red && is_red(joined->right))
+            blacken(joined);
+        return joined;
+    }
+    if(black_height(right) > black_height(left)) {
+        node *joined = join_left(left, middle, right);
+        if(joined->red && is_red(joined->left))
+            blacken(joined);
+        return joined;
+    }
+
+    middle->left = left;
+    middle->right = right;
+    middle->red = !is_red(left) && !is_red(right);
+    update(middle);
+    return middle;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::split_last(node *n, node *&rest) {
+    if(!n->right) {
+        rest = n->left;
+        n->left = nullptr;
+        return n;
+    }
+    node *remainder;
+    node *last = split_last(n->right, remainder);
+    rest = join(n->left, n, remainder);
+    return last;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::join_pair(node *left, node *right) {
+    if(!left)
+        return right;
+    node *rest;
+    node *middle = split_last(left, rest);
+    return join(rest, middle, right);
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::split_at(node *n, const K& key, node *&left,
+                                                                    node *&right) const {
+    if(!n) {
+        left = right = nullptr;
+        return nullptr;
+    }
+
+    node *below = n->left, *above = n->right;
+    if(comp(key, n->key)) {
+        node *inner;
+        node *found = split_at(below, key, left, inner);
+        right = join(inner, n, above);
+        return found;
+    }
+    if(comp(n->key, key)) {
+        node *inner;
+        node *found = split_at(above, key, inner, right);
+        left = join(below, n, inner);
+        return found;
+    }
+
+    left = below;
+    right = above;
+    n->left = n->right = nullptr;
+    return n;
+}
+
+template <typename K, typename C>
+bool red_black_tree<K, C>::insert(const K& key) {
+    if(find(key) != end())
+        return false;
+    node *fresh = new node(key);
+    node *left, *right;
+    split_at(root, key, left, right);
+    root = blacken(join(left, fresh, right));
+    return true;
+}
+
+template <typename K, typename C>
+bool red_black_tree<K, C>::erase(const K& key) {
+    if(find(key) == end())
+        return false;
+    node *left, *right;
+    delete split_at(root, key, left, right);
+    root = blacken(join_pair(left, right));
+    return true;
+}
+
+template <typename K, typename C>
+void red_black_tree<K, C>::clear() {
+    destroy(root);
+    root = nullptr;
+}
+
+template <typename K, typename C>
+bool red_black_tree<K, C>::split(const K& key, red_black_tree& below, red_black_tree& above) {
+    below.clear();
+    above.clear();
+    below.comp = above.comp = comp;
+
+    node *left, *right;
+    node *found = split_at(root, key, left, right);
+    root = nullptr;
+    below.root = blacken(left);
+    above.root = blacken(right);
+    delete found;
+    return found != nullptr;
+}
+
+template <typename K, typename C>
+void red_black_tree<K, C>::join(red_black_tree above) {
+    if(root && above.root && !comp(last_node()->key, *above.begin()))
+        throw std::invalid_argument("red_black_tree: joined sets overlap");
+    root = blacken(join_pair(root, above.root));
+    above.root = nullptr;
+}
+
+template <typename K, typename C>
+void red_black_tree<K, C>::join(const K& key, red_black_tree above) {
+    if((root && !comp(last_node()->key, key)) || (above.root && !comp(key, *above.begin())))
+        throw std::invalid_argument("red_black_tree: joined sets overlap");
+    root = blacken(join(root, new node(key), above.root));
+    above.root = nullptr;
+}
+
+template <typename K, typename C>
+template <typename F, typename G>
+void red_black_tree<K, C>::fork(unsigned threads, size_t work, F&& first, G&& second) {
+    if(threads < 2 || work < PARALLEL_CUTOFF) {
+        first(1);
+        second(1);
+        return;
+    }
+
+    unsigned half = threads / 2;
+    std::thread helper;
+    try {
+        helper = std::thread([&] { first(half); });
+    } catch(const std::system_error&) {
+        // Out of threads: carry on with this one
+        first(1);
+        second(threads - half);
+        return;
+    }
+    second(threads - half);
+    helper.join();
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::unite_nodes(node *a, node *b, unsigned threads) const {
+    if(!a)
+        return b;
+    if(!b)
+        return a;
+
+    size_t work = a->size + b->size;
+    node *below, *above;
+    delete split_at(b, a->key, below, above);
+    node *left = a->left, *right = a->right;
+    fork(threads, work,
+         [&](unsigned share) { left = unite_nodes(left, below, share); },
+         [&](unsigned share) { right = unite_nodes(right, above, share); });
+    return join(left, a, right);
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::intersect_nodes(node *a, node *b, unsigned threads) const {
+    if(!a || !b) {
+        destroy(a);
+        destroy(b);
+        return nullptr;
+    }
+
+    size_t work = a->size + b->size;
+    node *below, *above;
+    node *found = split_at(b, a->key, below, above);
+    node *left = a->left, *right = a->right;
+    fork(threads, work,
+         [&](unsigned share) { left = intersect_nodes(left, below, share); },
+         [&](unsigned share) { right = intersect_nodes(right, above, share); });
+    if(found) {
+        delete found;
+        return join(left, a, right);
+    }
+    delete a;
+    return join_pair(left, right);
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::subtract_nodes(node *a, node *b, unsigned threads) const {
+    if(!a || !b) {
+        destroy(b);
+        return a;
+    }
+
+    size_t work = a->size + b->size;
+    node *below, *above;
+    delete split_at(a, b->key, below, above);
+    node *left = b->left, *right = b->right;
+    delete b;
+    fork(threads, work,
+         [&](unsigned share) { left = subtract_nodes(below, left, share); },
+         [&](unsigned share) { right = subtract_nodes(above, right, share); });
+    return join_pair(left, right);
+}
+
+template <typename K, typename C>
+void red_black_tree<K, C>::unite(red_black_tree other, unsigned threads) {
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    root = blacken(unite_nodes(root, other.root, threads));
+    other.root = nullptr;
+}
+
+template <typename K, typename C>
+void red_black_tree<K, C>::intersect(red_black_tree other, unsigned threads) {
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    root = blacken(intersect_nodes(root, other.root, threads));
+    other.root = nullptr;
+}
+
+template <typename K, typename C>
+void red_black_tree<K, C>::subtract(red_black_tree other, unsigned threads) {
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    root = blacken(subtract_nodes(root, other.root, threads));
+    other.root = nullptr;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::iterator red_black_tree<K, C>::find(const K& key) const {
+    node *n = root;
+    while(n) {
+        if(comp(key, n->key))
+            n = n->left;
+        else if(comp(n->key, key))
+            n = n->right;
+        else
+            break;
+    }
+    return iterator(this, n);
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::iterator red_black_tree<K, C>::lower_bound(const K& key) const {
+    node *n = root, *found = nullptr;
+    while(n) {
+        if(comp(n->key, key)) {
+            n = n->right;
+        } else {
+            found = n;
+            n = n->left;
+        }
+    }
+    return iterator(this, found);
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::upper_node(const K& key) const {
+    node *n = root, *found = nullptr;
+    while(n) {
+        if(comp(key, n->key)) {
+            found = n;
+            n = n->left;
+        } else {
+            n = n->right;
+        }
+    }
+    return found;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::iterator red_black_tree<K, C>::begin() const {
+    node *n = root;
+    while(n && n->left)
+        n = n->left;
+    return iterator(this, n);
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::last_node() const {
+    node *n = root;
+    while(n && n->right)
+        n = n->right;
+    return n;
+}
+
+template <typename K, typename C>
+typename red_black_tree<K, C>::node *red_black_tree<K, C>::copy(const node *n) {
+    if(!n)
+        return nullptr;
+    node *fresh = new node(n->key);
+    fresh->size = n->size;
+    fresh->black_height = n->black_height;
+    fresh->red = n->red;
+    try {
+        fresh->left = copy(n->left);
+        fresh->right = copy(n->right);
+    } catch(...) {
+        destroy(fresh);
+        throw;
+    }
+    return fresh;
+}
+
+template <typename K, typename C>
+void red_black_tree<K, C>::destroy(node *n) {
+    // Recursion is bounded by the height
+    if(!n)
+        return;
+    destroy(n->left);
+    destroy(n->right);
+    delete n;
+}
+
+// End of red_black_tree definitions
+
+
 #endif //DATA_STRUCTURES_RED_BLACK_TREE_H
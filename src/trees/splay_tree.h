@@ -1,14 +1,469 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * An ordered map implemented as a splay tree, with options to restructure less on lookups.
+ *
+ * What is a splay tree?
+ *   A binary search tree that keeps no balance information at all. Instead, every access moves the node it reaches
+ *   to the root with a sequence of rotations, a splay, which also roughly halves the depth of every node on the way.
+ *   Any sequence of m accesses costs O(m log n) in total, even though a single one may cost O(n).
+ *
+ * Why is this useful?
+ *   Recently used keys sit near the root, so when lookups have temporal locality (a small working set that changes
+ *   slowly, or a few very popular keys) they are found after a handful of comparisons, often fewer than in a
+ *   balanced tree of the same size. Nodes carry no bookkeeping beyond their two children.
+ *
+ *   The price is that every lookup writes to the tree. On read-heavy loads whose working set is already near the
+ *   root, those writes are mostly wasted; the splaying options below trade some adaptivity for fewer of them.
+ *
+ * How is it implemented?
+ *   Splaying is top-down: the search for a key dismantles the path into a tree of smaller keys and a tree of larger
+ *   ones, rotating at every second step, and reassembles them under the node it stops at. It needs neither parent
+ *   pointers nor recursion nor a stack, and makes a single pass.
+ *
+ *   Lookups can be made cheaper in two ways, which combine:
+ *   - `period` k: only one lookup in k splays, and the others are read-only searches. Insertions and erasures always
+ *     splay.
+ *   - `mode::semi`: semi-splaying (Sleator and Tarjan). Where a splay would do two rotations in a row on the same
+ *     side, a semi-splay does only the upper one and carries on from the node it lifted, so the node found climbs
+ *     only about halfway to the root, with about half the rotations. It runs bottom-up over the links recorded on
+ *     the way down, in a stack kept by the tree between lookups.
+ *
+ *   Nodes come from a slab pool owned by the tree (see linked_list.h). A splay tree can be a path of n nodes, so
+ *   everything that walks the whole tree (copying, clearing, height) does so without recursion.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_SPLAY_TREE_H
 #define DATA_STRUCTURES_SPLAY_TREE_H
 
 
+#include "../linear/lists/linked_list.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+template <typename K, typename V, typename Compare = std::less<K>>
 class splay_tree {
+    struct node {
+        node *left = nullptr, *right = nullptr;
+        K key;
+        V value;
+
+        node(const K& key, const V& value) : key(key), value(value) {}
+    };
+
+public:
+    /**
+     * How lookups restructure the tree.
+     */
+    enum class mode {
+        full,
+        semi
+    };
+
+    class iterator {
+    public:
+        iterator() = default;
+
+        const K& key() const { return current->key; }
+        V& value() const { return current->value; }
+
+        iterator& operator++() {
+            current = tree->upper_node(current->key);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const { return current == other.current; }
+        bool operator!=(const iterator& other) const { return current != other.current; }
+
+    private:
+        friend class splay_tree;
+        iterator(const splay_tree *tree, node *current) : tree(tree), current(current) {}
+
+        const splay_tree *tree = nullptr;
+        node *current = nullptr;
+    };
+
+    /**
+     * @param splaying how lookups splay
+     * @param period splay on one lookup in `period`; 0 and 1 both splay on every lookup
+     */
+    explicit splay_tree(mode splaying = mode::full, unsigned period = 1)
+            : splaying(splaying), period(period > 1 ? period : 1) {}
+    splay_tree(const splay_tree& other);
+    splay_tree(splay_tree&& other) noexcept : splay_tree() { swap(other); }
+    ~splay_tree() { clear(); }
 
+    splay_tree& operator=(splay_tree other) {
+        swap(other);
+        return *this;
+    }
+
+    void swap(splay_tree& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(length, other.length);
+        std::swap(comp, other.comp);
+        std::swap(splaying, other.splaying);
+        std::swap(period, other.period);
+        std::swap(accesses, other.accesses);
+        pool.swap(other.pool);
+        path.swap(other.path);
+    }
+
+
+    /**
+     * Inserts `key` -> `value` if `key` is not already present. Either way, `key` ends up at the root.
+     *
+     * @return true if the pair was inserted, false if the key already existed
+     */
+    bool insert(const K& key, const V& value) { return insert_node(key, value).second; }
+    /**
+     * @return a reference to the value mapped to `key`, default constructing it if needed
+     */
+    V& operator[](const K& key) { return insert_node(key, V()).first->value; }
+    /**
+     * Removes `key` from the tree.
+     *
+     * @return true if the key was present
+     */
+    bool erase(const K& key);
+    void clear();
+
+
+    /**
+     * Looks `key` up, splaying as the mode and period say.
+     *
+     * @return an iterator to `key`, or end() if it isn't present
+     */
+    iterator find(const K& key);
+    size_t count(const K& key) { return find(key) != end() ? 1 : 0; }
+    /**
+     * Looks `key` up without restructuring the tree.
+     */
+    iterator peek(const K& key) const;
+
+    /**
+     * Iteration does not splay.
+     */
+    iterator begin() const;
+    iterator end() const { return iterator(this, nullptr); }
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    /**
+     * @return the number of levels in the tree (0 when empty), in O(n)
+     */
+    size_t height() const;
+
+private:
+    node *root = nullptr;
+    size_t length = 0;
+    Compare comp;
+    mode splaying;
+    unsigned period;
+    unsigned accesses = 0;
+    linked_list_detail::slab_pool<node> pool;
+    // The links followed by the last semi-splay, kept to avoid reallocating it
+    std::vector<node**> path;
+
+    /**
+     * Splays the node holding `key`, or the last node on its search path, to the root of `t`.
+     *
+     * @return the new root
+     */
+    node *splay(node *t, const K& key) const;
+    /**
+     * Semi-splays the node holding `key`, or the last node on its search path.
+     *
+     * @return the node holding `key`, or nullptr
+     */
+    node *semi_splay(const K& key);
+    std::pair<node*, bool> insert_node(const K& key, const V& value);
+    node *upper_node(const K& key) const;
 };
 
 
+// Define splay_tree
+
+template <typename K, typename V, typename C>
+splay_tree<K, V, C>::splay_tree(const splay_tree& other)
+        : comp(other.comp), splaying(other.splaying), period(other.period) {
+    // Copy the shape as well, walking the tree with an explicit stack since it may be a long path
+    std::vector<std::pair<const node*, node**>> pending;
+    pending.emplace_back(other.root, &root);
+    try {
+        while(!pending.empty()) {
+            std::pair<const node*, node**> next = pending.back();
+            pending.pop_back();
+            if(!next.first)
+                continue;
+            node *fresh = pool.create(next.first->key, next.first->value);
+            *next.second = fresh;
+            length++;
+            pending.emplace_back(next.first->left, &fresh->left);
+            pending.emplace_back(next.first->right, &fresh->right);
+        }
+    } catch(...) {
+        clear();
+        throw;
+    }
+}
+
+template <typename K, typename V, typename C>
+typename splay_tree<K, V, C>::node *splay_tree<K, V, C>::splay(node *t, const K& key) const {
+    if(!t)
+        return nullptr;
+
+    // Nodes found to be smaller than `key` hang off the right spine of `smaller`, larger ones off the left spine of
+    //   `larger`; the hooks are where the next one goes
+    node *smaller = nullptr, *larger = nullptr;
+    node **smaller_hook = &smaller, **larger_hook = &larger;
+    for(;;) {
+        if(comp(key, t->key)) {
+            if(!t->left)
+                break;
+            if(comp(key, t->left->key)) {
+                node *lifted = t->left;
+                t->left = lifted->right;
+                lifted->right = t;
+                t = lifted;
+                if(!t->left)
+                    break;
+            }
+            *larger_hook = t;
+            larger_hook = &t->left;
+            t = t->left;
+        } else if(comp(t->key, key)) {
+            if(!t->right)
+                break;
+            if(comp(t->right->key, key)) {
+                node *lifted = t->right;
+                t->right = lifted->left;
+                lifted->left = t;
+                t = lifted;
+                if(!t->right)
+                    break;
+            }
+            *smaller_hook = t;
+            smaller_hook = &t->right;
+            t = t->right;
+        } else {
+            break;
+        }
+    }
+
+    *smaller_hook = t->left;
+    *larger_hook = t->right;
+    t->left = smaller;
+    t->right = larger;
+    return t;
+}
+
+template <typename K, typename V, typename C>
+typename splay_tree<K, V, C>::node *splay_tree<K, V, C>::semi_splay(const K& key) {
+    if(!root)
+        return nullptr;
+
+    path.clear();
+    node **link = &root;
+    node *found = nullptr;
+    for(;;) {
+        path.push_back(link);
+        node *n = *link;
+        if(comp(key, n->key))
+            link = &n->left;
+        else if(comp(n->key, key))
+            link = &n->right;
+        else
+            found = n;
+        if(found || !*link)
+            break;
+    }
+
+    // path[i] links to the current node, path[i - 1] to its parent and path[i - 2] to its grandparent
+    size_t i = path.size() - 1;
+    while(i >= 2) {
+        node *x = *path[i], *y = *path[i - 1], *z = *path[i - 2];
+        bool x_left = y->left == x, y_left = z->left == y;
+        if(x_left == y_left) {
+            // Lift y over z and carry on from y
+            if(y_left) {
+                z->left = y->right;
+                y->right = z;
+            } else {
+                z->right = y->left;
+                y->left = z;
+            }
+            *path[i - 2] = y;
+        } else {
+            // Lift x over both, as a splay would, and carry on from x
+            if(x_left) {
+                y->left = x->right;
+                z->right = x->left;
+                x->right = y;
+                x->left = z;
+            } else {
+                y->right = x->left;
+                z->left = x->right;
+                x->left = y;
+                x->right = z;
+            }
+            *path[i - 2] = x;
+        }
+        i -= 2;
+    }
+    if(i == 1) {
+        node *x = *path[1], *y = root;
+        if(y->left == x) {
+            y->left = x->right;
+            x->right = y;
+        } else {
+            y->right = x->left;
+            x->left = y;
+        }
+        root = x;
+    }
+    return found;
+}
+
+template <typename K, typename V, typename C>
+std::pair<typename splay_tree<K, V, C>::node*, bool> splay_tree<K, V, C>::insert_node(const K& key, const V& value) {
+    root = splay(root, key);
+    if(root && !comp(key, root->key) && !comp(root->key, key))
+        return std::make_pair(root, false);
+
+    node *fresh = pool.create(key, value);
+    if(root) {
+        if(comp(key, root->key)) {
+            fresh->left = root->left;
+            fresh->right = root;
+            root->left = nullptr;
+        } else {
+            fresh->right = root->right;
+            fresh->left = root;
+            root->right = nullptr;
+        }
+    }
+    root = fresh;
+    length++;
+    return std::make_pair(fresh, true);
+}
+
+template <typename K, typename V, typename C>
+bool splay_tree<K, V, C>::erase(const K& key) {
+    root = splay(root, key);
+    if(!root || comp(key, root->key) || comp(root->key, key))
+        return false;
+
+    node *removed = root;
+    if(!removed->left) {
+        root = removed->right;
+    } else {
+        // Every key on the left is smaller, so this brings the largest of them up, with no right child
+        root = splay(removed->left, key);
+        root->right = removed->right;
+    }
+    pool.destroy(removed);
+    length--;
+    return true;
+}
+
+template <typename K, typename V, typename C>
+void splay_tree<K, V, C>::clear() {
+    // Rotate left children up until the root has none, then drop it
+    while(root) {
+        if(root->left) {
+            node *lifted = root->left;
+            root->left = lifted->right;
+            lifted->right = root;
+            root = lifted;
+        } else {
+            node *next = root->right;
+            pool.destroy(root);
+            root = next;
+        }
+    }
+    length = 0;
+    pool.release();
+}
+
+template <typename K, typename V, typename C>
+typename splay_tree<K, V, C>::iterator splay_tree<K, V, C>::find(const K& key) {
+    if(period > 1 && ++accesses % period != 0)
+        return peek(key);
+
+    if(splaying == mode::semi)
+        return iterator(this, semi_splay(key));
+    root = splay(root, key);
+    if(root && !comp(key, root->key) && !comp(root->key, key))
+        return iterator(this, root);
+    return end();
+}
+
+template <typename K, typename V, typename C>
+typename splay_tree<K, V, C>::iterator splay_tree<K, V, C>::peek(const K& key) const {
+    node *n = root;
+    while(n) {
+        if(comp(key, n->key))
+            n = n->left;
+        else if(comp(n->key, key))
+            n = n->right;
+        else
+            break;
+    }
+    return iterator(this, n);
+}
+
+template <typename K, typename V, typename C>
+typename splay_tree<K, V, C>::node *splay_tree<K, V, C>::upper_node(const K& key) const {
+    node *n = root, *found = nullptr;
+    while(n) {
+        if(comp(key, n->key)) {
+            found = n;
+            n = n->left;
+        } else {
+            n = n->right;
+        }
+    }
+    return found;
+}
+
+template <typename K, typename V, typename C>
+typename splay_tree<K, V, C>::iterator splay_tree<K, V, C>::begin() const {
+    node *n = root;
+    while(n && n->left)
+        n = n->left;
+    return iterator(this, n);
+}
+
+template <typename K, typename V, typename C>
+size_t splay_tree<K, V, C>::height() const {
+    size_t levels = 0;
+    std::vector<std::pair<const node*, size_t>> pending;
+    if(root)
+        pending.emplace_back(root, 1);
+    while(!pending.empty()) {
+        std::pair<const node*, size_t> next = pending.back();
+        pending.pop_back();
+        if(next.second > levels)
+            levels = next.second;
+        if(next.first->left)
+            pending.emplace_back(next.first->left, next.second + 1);
+        if(next.first->right)
+            pending.emplace_back(next.first->right, next.second + 1);
+    }
+    return levels;
+}
+
+// End of splay_tree definitions
+
+
 #endif //DATA_STRUCTURES_SPLAY_TREE_H
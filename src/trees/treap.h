@@ -1,14 +1,472 @@
-//
-// Created by Jean-Claude Paquin on 8/21/17.
-//
+/**
+ * A sequence of numbers stored as an implicit treap, with O(log n) editing, range reversal and range queries.
+ *
+ * What is a treap?
+ *   A binary tree that is a search tree by key and a heap by a random priority drawn for every node, which makes its
+ *   shape that of a binary search tree built by inserting the keys in random order: O(log n) deep, in expectation.
+ *   Two operations do all the work. Split cuts a treap into the nodes before and after a key, and merge joins two
+ *   treaps whose keys do not interleave; both walk a single path, so both are O(log n).
+ *
+ *   An implicit treap has no stored keys: a node's key is its position in the sequence, which is the size of
+ *   everything to its left, so each node stores the size of its subtree and split cuts by position. Inserting,
+ *   erasing or moving a whole range anywhere in the sequence are then a few splits and merges.
+ *
+ * Why is this useful?
+ *   std::vector inserts and erases in the middle in O(n). A treap does it in O(log n), can move or reverse any range
+ *   in O(log n), and keeps aggregates of every subtree, so the sum, minimum and maximum of a range, and adding a
+ *   constant to a whole range, are O(log n) as well.
+ *
+ * How is it implemented?
+ *   Nodes live in one contiguous arena (a std::vector) and refer to each other by 32-bit index, with index 0 as the
+ *   null link, so a node is smaller than with pointers and the whole treap copies and moves like a vector. Erased
+ *   nodes are chained into a free list through their left link and reused first.
+ *
+ *   Reversal and addition are lazy. Reversing a range splits it out and flags its root; the flag is pushed down to
+ *   the children, swapping them, only when a later operation walks through that node. Adding works the same way,
+ *   with the node's own value and aggregates updated at once and the children's deferred. Reading an element or the
+ *   whole sequence accounts for pending flags and additions on the way down instead of pushing them, so it is const.
+ *
+ *   T must be an arithmetic type. Sums are computed in T, and overflow like it.
+ *
+ * @author Jean-Claude Paquin
+ **/
 
 #ifndef DATA_STRUCTURES_TREAP_H
 #define DATA_STRUCTURES_TREAP_H
 
 
+#include "../primitives/xorshift.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename T>
 class treap {
+    static_assert(std::is_arithmetic<T>::value, "treap aggregates need an arithmetic element type");
+
+    struct node {
+        T value, sum, min, max;
+        // Added to value and the aggregates already, still to be added to the children
+        T pending;
+        uint32_t left, right, size, priority;
+        // The children are still to be swapped, and their subtrees reversed
+        bool reversed;
+    };
+
+public:
+    treap() : nodes(1) {}
+    /**
+     * Builds the sequence [first, last) in O(n).
+     */
+    template <typename It>
+    treap(It first, It last) : treap() { root = build(first, last); }
+
+
+    /**
+     * Inserts `value` before `position`.
+     *
+     * @throws std::out_of_range if position > size()
+     */
+    void insert(size_t position, const T& value) { insert(position, &value, &value + 1); }
+    /**
+     * Inserts [first, last) before `position`, in O(k + log n) for k values.
+     *
+     * @throws std::out_of_range if position > size()
+     */
+    template <typename It>
+    void insert(size_t position, It first, It last);
+    void push_back(const T& value) { insert(size(), value); }
+    /**
+     * @throws std::out_of_range if position >= size()
+     */
+    void erase(size_t position) { erase(position, position + 1); }
+    /**
+     * Erases [first, last).
+     *
+     * @throws std::out_of_range if first > last or last > size()
+     */
+    void erase(size_t first, size_t last);
+    /**
+     * Moves [first, last) so that it starts at `position` in what is left once it is taken out.
+     *
+     * @throws std::out_of_range if first > last, last > size() or position > size() - (last - first)
+     */
+    void move(size_t first, size_t last, size_t position);
+    /**
+     * Reverses [first, last).
+     *
+     * @throws std::out_of_range if first > last or last > size()
+     */
+    void reverse(size_t first, size_t last);
+    /**
+     * Adds `delta` to every element of [first, last).
+     *
+     * @throws std::out_of_range if first > last or last > size()
+     */
+    void add(size_t first, size_t last, const T& delta);
+    void clear();
+
+
+    /**
+     * @return the sum of [first, last), T() if it is empty
+     * @throws std::out_of_range if first > last or last > size()
+     */
+    T sum(size_t first, size_t last) { return query(first, last, &node::sum); }
+    /**
+     * @throws std::out_of_range if first >= last or last > size()
+     */
+    T min(size_t first, size_t last) { return query(first, last, &node::min); }
+    /**
+     * @throws std::out_of_range if first >= last or last > size()
+     */
+    T max(size_t first, size_t last) { return query(first, last, &node::max); }
+
+    /**
+     * @return the element at `index`, in O(log n)
+     * @throws std::out_of_range if index >= size()
+     */
+    T operator[](size_t index) const;
+    std::vector<T> to_vector() const;
+
+    size_t size() const { return nodes[root].size; }
+    bool empty() const { return root == 0; }
+    /**
+     * @return the number of nodes the arena holds, free ones included
+     */
+    size_t capacity() const { return nodes.size() - 1; }
+
+private:
+    // nodes[0] is the null link: empty, with size 0
+    std::vector<node> nodes;
+    uint32_t root = 0;
+    uint32_t free_nodes = 0;
+    xorshift64_star random{0x2545f4914f6cdd1dull};
 
+    uint32_t allocate(const T& value);
+    void release(uint32_t t);
+
+    void pull(uint32_t t);
+    void apply_add(uint32_t t, const T& delta);
+    void push(uint32_t t);
+    /**
+     * Splits `t` into its first `count` elements and the rest.
+     */
+    void split(uint32_t t, size_t count, uint32_t& left, uint32_t& right);
+    uint32_t merge(uint32_t left, uint32_t right);
+    template <typename It>
+    uint32_t build(It first, It last);
+
+    void check_range(size_t first, size_t last) const;
+    T query(size_t first, size_t last, T node::*aggregate);
+    void collect(uint32_t t, T added, bool flipped, std::vector<T>& out) const;
 };
 
 
+// Define treap
+
+template <typename T>
+uint32_t treap<T>::allocate(const T& value) {
+    uint32_t t;
+    if(free_nodes) {
+        t = free_nodes;
+        free_nodes = nodes[t].left;
+    } else {
+        if(nodes.size() > UINT32_MAX - 1)
+            throw std::length_error("treap indices are 32 bits");
+        nodes.emplace_back();
+        t = static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    node& n = nodes[t];
+    n.value = n.sum = n.min = n.max = value;
+    n.pending = T();
+    n.left = n.right = 0;
+    n.size = 1;
+    n.priority = random.next32();
+    n.reversed = false;
+    return t;
+}
+
+template <typename T>
+void treap<T>::release(uint32_t t) {
+    // Recursion is bounded by the height
+    if(!t)
+        return;
+    release(nodes[t].left);
+    release(nodes[t].right);
+    nodes[t].left = free_nodes;
+    free_nodes = t;
+}
+
+template <typename T>
+void treap<T>::pull(uint32_t t) {
+    node& n = nodes[t];
+    const node& l = nodes[n.left];
+    const node& r = nodes[n.right];
+    n.size = 1 + l.size + r.size;
+    n.sum = n.value;
+    n.min = n.max = n.value;
+    if(n.left) {
+        n.sum += l.sum;
+        n.min = l.min < n.min ? l.min : n.min;
+        n.max = l.max > n.max ? l.max : n.max;
+    }
+    if(n.right) {
+        n.sum += r.sum;
+        n.min = r.min < n.min ? r.min : n.min;
+        n.max = r.max > n.max ? r.max : n.max;
+    }
+}
+
+template <typename T>
+void treap<T>::apply_add(uint32_t t, const T& delta) {
+    node& n = nodes[t];
+    n.value += delta;
+    n.sum += static_cast<T>(delta * static_cast<T>(n.size));
+    n.min += delta;
+    n.max += delta;
+    n.pending += delta;
+}
+
+template <typename T>
+void treap<T>::push(uint32_t t) {
+    node& n = nodes[t];
+    if(n.reversed) {
+        std::swap(n.left, n.right);
+        if(n.left)
+            nodes[n.left].reversed = !nodes[n.left].reversed;
+        if(n.right)
+            nodes[n.right].reversed = !nodes[n.right].reversed;
+        n.reversed = false;
+    }
+    if(n.pending != T()) {
+        if(n.left)
+            apply_add(n.left, n.pending);
+        if(n.right)
+            apply_add(n.right, n.pending);
+        n.pending = T();
+    }
+}
+
+template <typename T>
+void treap<T>::split(uint32_t t, size_t count, uint32_t& left, uint32_t& right) {
+    if(!t) {
+        left = right = 0;
+        return;
+    }
+
+    push(t);
+    size_t before = nodes[nodes[t].left].size;
+    if(count <= before) {
+        uint32_t inner;
+        split(nodes[t].left, count, left, inner);
+        nodes[t].left = inner;
+        right = t;
+    } else {
+        uint32_t inner;
+        split(nodes[t].right, count - before - 1, inner, right);
+        nodes[t].right = inner;
+        left = t;
+    }
+    pull(t);
+}
+
+template <typename T>
+uint32_t treap<T>::merge(uint32_t left, uint32_t right) {
+    if(!left)
+        return right;
+    if(!right)
+        return left;
+
+    if(nodes[left].priority > nodes[right].priority) {
+        push(left);
+        uint32_t inner = merge(nodes[left].right, right);
+        nodes[left].right = inner;
+        pull(left);
+        return left;
+    }
+    push(right);
+    uint32_t inner = merge(left, nodes[right].left);
+    nodes[right].left = inner;
+    pull(right);
+    return right;
+}
+
+template <typename T>
+template <typename It>
+uint32_t treap<T>::build(It first, It last) {
+    // The right spine of the treap built so far; each new node goes at the bottom of it, taking as its left subtree
+    //   the nodes of lower priority it displaces, which are complete and can be pulled
+    std::vector<uint32_t> spine;
+    try {
+        for(; first != last; ++first) {
+            // Make room first, so that a node once allocated is always reachable from the bottom of the spine
+            spine.reserve(spine.size() + 1);
+            uint32_t t = allocate(*first);
+            uint32_t displaced = 0;
+            while(!spine.empty() && nodes[spine.back()].priority < nodes[t].priority) {
+                displaced = spine.back();
+                spine.pop_back();
+                pull(displaced);
+            }
+            nodes[t].left = displaced;
+            if(!spine.empty())
+                nodes[spine.back()].right = t;
+            spine.push_back(t);
+        }
+    } catch(...) {
+        // Every node built so far hangs off the spine: hand them all back
+        if(!spine.empty())
+            release(spine.front());
+        throw;
+    }
+
+    while(spine.size() > 1) {
+        pull(spine.back());
+        spine.pop_back();
+    }
+    if(spine.empty())
+        return 0;
+    pull(spine.back());
+    return spine.back();
+}
+
+template <typename T>
+void treap<T>::check_range(size_t first, size_t last) const {
+    if(first > last || last > size())
+        throw std::out_of_range("treap: range out of bounds");
+}
+
+template <typename T>
+template <typename It>
+void treap<T>::insert(size_t position, It first, It last) {
+    if(position > size())
+        throw std::out_of_range("treap: insertion past the end");
+    uint32_t inserted = build(first, last);
+    uint32_t left, right;
+    split(root, position, left, right);
+    root = merge(merge(left, inserted), right);
+}
+
+template <typename T>
+void treap<T>::erase(size_t first, size_t last) {
+    check_range(first, last);
+    uint32_t left, middle, right;
+    split(root, first, left, right);
+    split(right, last - first, middle, right);
+    release(middle);
+    root = merge(left, right);
+}
+
+template <typename T>
+void treap<T>::move(size_t first, size_t last, size_t position) {
+    check_range(first, last);
+    if(position > size() - (last - first))
+        throw std::out_of_range("treap: move past the end");
+    uint32_t left, middle, right;
+    split(root, first, left, right);
+    split(right, last - first, middle, right);
+    root = merge(left, right);
+    split(root, position, left, right);
+    root = merge(merge(left, middle), right);
+}
+
+template <typename T>
+void treap<T>::reverse(size_t first, size_t last) {
+    check_range(first, last);
+    uint32_t left, middle, right;
+    split(root, first, left, right);
+    split(right, last - first, middle, right);
+    if(middle)
+        nodes[middle].reversed = !nodes[middle].reversed;
+    root = merge(merge(left, middle), right);
+}
+
+template <typename T>
+void treap<T>::add(size_t first, size_t last, const T& delta) {
+    check_range(first, last);
+    uint32_t left, middle, right;
+    split(root, first, left, right);
+    split(right, last - first, middle, right);
+    if(middle)
+        apply_add(middle, delta);
+    root = merge(merge(left, middle), right);
+}
+
+template <typename T>
+void treap<T>::clear() {
+    nodes.resize(1);
+    root = free_nodes = 0;
+}
+
+template <typename T>
+T treap<T>::query(size_t first, size_t last, T node::*aggregate) {
+    check_range(first, last);
+    if(first == last) {
+        if(aggregate == &node::sum)
+            return T();
+        throw std::out_of_range("treap: empty range has no minimum or maximum");
+    }
+
+    uint32_t left, middle, right;
+    split(root, first, left, right);
+    split(right, last - first, middle, right);
+    T result = nodes[middle].*aggregate;
+    root = merge(merge(left, middle), right);
+    return result;
+}
+
+template <typename T>
+T treap<T>::operator[](size_t index) const {
+    if(index >= size())
+        throw std::out_of_range("treap: index out of bounds");
+
+    // Pending additions of the ancestors, and whether an odd number of their reversal flags is pending
+    T added = T();
+    bool flipped = false;
+    uint32_t t = root;
+    for(;;) {
+        const node& n = nodes[t];
+        flipped ^= n.reversed;
+        uint32_t first = flipped ? n.right : n.left, second = flipped ? n.left : n.right;
+        size_t before = nodes[first].size;
+        if(index < before) {
+            added += n.pending;
+            t = first;
+        } else if(index == before) {
+            return n.value + added;
+        } else {
+            index -= before + 1;
+            added += n.pending;
+            t = second;
+        }
+    }
+}
+
+template <typename T>
+std::vector<T> treap<T>::to_vector() const {
+    std::vector<T> out;
+    out.reserve(size());
+    collect(root, T(), false, out);
+    return out;
+}
+
+template <typename T>
+void treap<T>::collect(uint32_t t, T added, bool flipped, std::vector<T>& out) const {
+    if(!t)
+        return;
+    const node& n = nodes[t];
+    flipped ^= n.reversed;
+    collect(flipped ? n.right : n.left, added + n.pending, flipped, out);
+    out.push_back(n.value + added);
+    collect(flipped ? n.left : n.right, added + n.pending, flipped, out);
+}
+
+// End of treap definitions
+
+
 #endif //DATA_STRUCTURES_TREAP_H
@@ -0,0 +1,110 @@
+/**
+ * Tests of associative_map.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/map/associative_map.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+TEST_CASE("Empty associative_map", "[associative_map]") {
+    associative_map<int, std::string> map;
+
+    REQUIRE(map.empty());
+    REQUIRE(map.begin() == map.end());
+    REQUIRE(map.find(1) == map.end());
+    REQUIRE(map.lower_bound(1) == map.end());
+    REQUIRE(!map.erase(1));
+}
+
+TEST_CASE("associative_map single insertions", "[associative_map]") {
+    associative_map<std::string, int> map;
+
+    REQUIRE(map.insert("pear", 3));
+    REQUIRE(map.insert("apple", 1));
+    REQUIRE(map.insert("fig", 2));
+    REQUIRE(!map.insert("fig", 20));
+
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.find("fig").value() == 2);
+    REQUIRE(map.find("kiwi") == map.end());
+
+    std::vector<std::string> order;
+    for(auto it = map.begin(); it != map.end(); ++it)
+        order.push_back(it.key());
+    REQUIRE(order == std::vector<std::string>({"apple", "fig", "pear"}));
+
+    map["kiwi"] = 7;
+    REQUIRE(map.find("kiwi").value() == 7);
+    REQUIRE(map.erase("apple"));
+    REQUIRE(map.begin().key() == "fig");
+}
+
+TEST_CASE("associative_map bounds", "[associative_map]") {
+    associative_map<int, int> map;
+    for(int i = 0; i < 64; i++)
+        map.insert(i * 2, i);
+
+    REQUIRE(map.lower_bound(10).key() == 10);
+    REQUIRE(map.lower_bound(11).key() == 12);
+    REQUIRE(map.upper_bound(10).key() == 12);
+    REQUIRE(map.lower_bound(-1).key() == 0);
+    REQUIRE(map.upper_bound(126) == map.end());
+
+    for(int i = -1; i < 130; i++) {
+        if(i >= 0 && i % 2 == 0 && i < 128)
+            REQUIRE(map.find(i) != map.end());
+        else
+            REQUIRE(map.find(i) == map.end());
+    }
+}
+
+TEST_CASE("associative_map batched insertion", "[associative_map]") {
+    associative_map<int, int> map;
+    std::map<int, int> reference;
+
+    for(int i = 0; i < 50; i++) {
+        map.insert(i * 4, -1);
+        reference.emplace(i * 4, -1);
+    }
+
+    SECTION("Batch with duplicates and existing keys") {
+        std::vector<std::pair<int, int>> batch;
+        std::mt19937 rng(3);
+        for(int i = 0; i < 300; i++)
+            batch.emplace_back(static_cast<int>(rng() % 400) - 50, i);
+
+        size_t expected = 0;
+        for(auto& kv : batch)
+            expected += reference.emplace(kv.first, kv.second).second ? 1 : 0;
+
+        REQUIRE(map.insert_range(batch.begin(), batch.end()) == expected);
+        REQUIRE(map.size() == reference.size());
+
+        auto ref = reference.begin();
+        for(auto it = map.begin(); it != map.end(); ++it, ++ref) {
+            REQUIRE(it.key() == ref->first);
+            REQUIRE(it.value() == ref->second);
+        }
+    }
+
+    SECTION("Batch of only existing keys") {
+        std::vector<std::pair<int, int>> batch = {{0, 5}, {4, 5}};
+
+        REQUIRE(map.insert_range(batch.begin(), batch.end()) == 0);
+        REQUIRE(map.find(4).value() == -1);
+    }
+
+    SECTION("Batch into an empty map") {
+        associative_map<int, int> empty;
+        std::vector<std::pair<int, int>> batch = {{3, 3}, {1, 1}, {2, 2}, {1, 9}};
+
+        REQUIRE(empty.insert_range(batch.begin(), batch.end()) == 3);
+        REQUIRE(empty.begin().key() == 1);
+        REQUIRE(empty.find(1).value() == 1);
+    }
+}
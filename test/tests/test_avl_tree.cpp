@@ -0,0 +1,108 @@
+/**
+ * Tests of avl_tree.
+ **/
+
+#include <catch.hpp>
+#include <trees/avl_tree.h>
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("Empty avl_tree", "[avl_tree]") {
+    avl_tree<int, std::string> tree;
+
+    REQUIRE(tree.empty());
+    REQUIRE(tree.size() == 0);
+    REQUIRE(tree.height() == 0);
+    REQUIRE(tree.begin() == tree.end());
+    REQUIRE(tree.find(3) == tree.end());
+    REQUIRE(tree.lower_bound(3) == tree.end());
+    REQUIRE(tree.rank(3) == 0);
+    REQUIRE(!tree.erase(3));
+    REQUIRE_THROWS_AS(tree.select(0), std::out_of_range);
+}
+
+TEST_CASE("avl_tree insertion, lookup and order statistics", "[avl_tree]") {
+    avl_tree<int, std::string> tree;
+
+    // Sorted insertions are the worst case for an unbalanced tree
+    for(int i = 0; i < 1000; i++)
+        REQUIRE(tree.insert(2 * i, std::to_string(i)));
+    REQUIRE(tree.size() == 1000);
+    REQUIRE(tree.height() <= 11);
+    REQUIRE(!tree.insert(10, "duplicate"));
+    REQUIRE(tree.find(10).value() == "5");
+
+    REQUIRE(tree.find(11) == tree.end());
+    REQUIRE(tree.lower_bound(11).key() == 12);
+    REQUIRE(tree.upper_bound(12).key() == 14);
+    REQUIRE(tree.upper_bound(1998) == tree.end());
+
+    REQUIRE(tree.select(0).key() == 0);
+    REQUIRE(tree.select(500).key() == 1000);
+    REQUIRE(tree.select(999).key() == 1998);
+    REQUIRE(tree.rank(0) == 0);
+    REQUIRE(tree.rank(1000) == 500);
+    REQUIRE(tree.rank(1001) == 501);
+    REQUIRE(tree.rank(5000) == 1000);
+
+    int expected = 0;
+    for(auto it = tree.begin(); it != tree.end(); ++it, expected += 2)
+        REQUIRE(it.key() == expected);
+    REQUIRE(expected == 2000);
+
+    tree[3] = "three";
+    tree[4] += "!";
+    REQUIRE(tree.size() == 1001);
+    REQUIRE(tree.find(3).value() == "three");
+    REQUIRE(tree.find(4).value() == "2!");
+}
+
+TEST_CASE("avl_tree matches std::map", "[avl_tree]") {
+    avl_tree<int, int> tree;
+    std::map<int, int> model;
+    std::mt19937 rng(5);
+
+    for(int step = 0; step < 40000; step++) {
+        int key = static_cast<int>(rng() % 2000);
+        if(rng() % 3 == 0) {
+            REQUIRE(tree.erase(key) == (model.erase(key) == 1));
+        } else {
+            REQUIRE(tree.insert(key, step) == model.emplace(key, step).second);
+        }
+        REQUIRE(tree.size() == model.size());
+
+        if(step % 1000 == 0) {
+            // An AVL tree is never taller than 1.44 log2(n + 2)
+            REQUIRE(tree.height() <= 1.4405 * std::log2(model.size() + 2.0));
+
+            auto expected = model.begin();
+            size_t index = 0;
+            for(auto it = tree.begin(); it != tree.end(); ++it, ++expected, ++index) {
+                REQUIRE(it.key() == expected->first);
+                REQUIRE(it.value() == expected->second);
+                REQUIRE(tree.rank(it.key()) == index);
+                REQUIRE(tree.select(index) == it);
+            }
+            REQUIRE(expected == model.end());
+        }
+    }
+
+    avl_tree<int, int> copy(tree);
+    tree.clear();
+    REQUIRE(tree.empty());
+    REQUIRE(copy.size() == model.size());
+    auto expected = model.begin();
+    for(auto it = copy.begin(); it != copy.end(); ++it, ++expected)
+        REQUIRE(it.key() == expected->first);
+
+    // The pool is reused after clearing
+    for(int i = 0; i < 100; i++)
+        tree.insert(i, i);
+    REQUIRE(tree.size() == 100);
+    REQUIRE(tree.select(42).value() == 42);
+}
@@ -0,0 +1,343 @@
+/**
+ * Tests of circular_buffer and flight_recorder.
+ **/
+
+#include <catch.hpp>
+#include <linear/arrays/circular_buffer.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint8_t PADDING = 0xff;
+
+bool write(circular_buffer& ring, const std::string& bytes) {
+    circular_buffer::region space = ring.reserve(bytes.size());
+    if(space.size != bytes.size())
+        return false;
+    std::memcpy(space.data, bytes.data(), bytes.size());
+    ring.commit(space);
+    return true;
+}
+
+std::string read_all(circular_buffer& ring) {
+    std::string out;
+    while(circular_buffer::region data = ring.peek()) {
+        out.append(reinterpret_cast<const char*>(data.data), data.size);
+        ring.consume(data.size);
+    }
+    return out;
+}
+
+/**
+ * Has `writers` threads each send `records` records of varying sizes, and checks that every record arrives whole and
+ *   in order per writer.
+ *
+ * A record is [writer id][sequence number, 4 bytes][length][length payload bytes]. A writer given a region too short
+ *   for its record fills it with padding and commits it anyway, which is how a plain ring is used with several
+ *   producers: the region is claimed, so it has to be committed.
+ */
+void stream(circular_buffer& ring, unsigned writers, uint32_t records) {
+    std::vector<std::thread> threads;
+    for(unsigned id = 0; id < writers; id++) {
+        threads.emplace_back([&ring, id, records]() {
+            for(uint32_t sequence = 0; sequence < records; sequence++) {
+                uint8_t length = static_cast<uint8_t>(sequence % 23);
+                size_t size = 6u + length;
+
+                circular_buffer::region space = ring.reserve(size);
+                while(space.size < size) {
+                    if(space) {
+                        std::memset(space.data, PADDING, space.size);
+                        ring.commit(space);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                    space = ring.reserve(size);
+                }
+
+                space.data[0] = static_cast<uint8_t>(id);
+                std::memcpy(space.data + 1, &sequence, 4);
+                space.data[5] = length;
+                for(uint8_t i = 0; i < length; i++)
+                    space.data[6 + i] = static_cast<uint8_t>(sequence + i);
+                ring.commit(space);
+            }
+        });
+    }
+
+    std::vector<uint32_t> expected(writers, 0);
+    std::vector<uint8_t> pending;
+    uint64_t received = 0;
+    while(received < uint64_t(writers) * records) {
+        circular_buffer::region data = ring.peek();
+        if(!data) {
+            std::this_thread::yield();
+            continue;
+        }
+        pending.insert(pending.end(), data.data, data.data + data.size);
+        ring.consume(data.size);
+
+        size_t offset = 0;
+        for(;;) {
+            while(offset < pending.size() && pending[offset] == PADDING)
+                offset++;
+            if(pending.size() - offset < 6 || pending.size() - offset < 6u + pending[offset + 5])
+                break;
+
+            uint8_t id = pending[offset];
+            uint32_t sequence;
+            std::memcpy(&sequence, &pending[offset + 1], 4);
+            uint8_t length = pending[offset + 5];
+            REQUIRE(id < writers);
+            REQUIRE(sequence == expected[id]);
+            REQUIRE(length == sequence % 23);
+            for(uint8_t i = 0; i < length; i++)
+                REQUIRE(pending[offset + 6 + i] == static_cast<uint8_t>(sequence + i));
+
+            expected[id]++;
+            received++;
+            offset += 6u + length;
+        }
+        pending.erase(pending.begin(), pending.begin() + offset);
+    }
+
+    for(std::thread& thread : threads)
+        thread.join();
+    REQUIRE(read_all(ring).find_first_not_of(static_cast<char>(PADDING)) == std::string::npos);
+    REQUIRE(pending.empty());
+}
+
+}
+
+TEST_CASE("circular_buffer basics", "[circular_buffer]") {
+    circular_buffer ring(100);
+    REQUIRE(ring.capacity() == 128);
+    REQUIRE(ring.empty());
+    REQUIRE(!ring.peek());
+    REQUIRE_THROWS_AS(circular_buffer(0), std::invalid_argument);
+
+    REQUIRE(write(ring, "hello, "));
+    REQUIRE(write(ring, "world"));
+    REQUIRE(ring.size() == 12);
+
+    circular_buffer::region data = ring.peek();
+    REQUIRE(std::string(reinterpret_cast<const char*>(data.data), data.size) == "hello, world");
+    ring.consume(7);
+    REQUIRE(ring.size() == 5);
+    REQUIRE(read_all(ring) == "world");
+    REQUIRE(ring.empty());
+
+    // Bytes are only published by commit, and only as many as committed
+    circular_buffer::region space = ring.reserve(4);
+    REQUIRE(space.size == 4);
+    std::memcpy(space.data, "abcd", 4);
+    REQUIRE(!ring.peek());
+    ring.commit(2);
+    REQUIRE(read_all(ring) == "ab");
+
+    circular_buffer shared(64, circular_buffer::producers::multiple);
+    REQUIRE_THROWS_AS(shared.commit(1), std::logic_error);
+    REQUIRE(write(shared, "abc"));
+    REQUIRE(read_all(shared) == "abc");
+}
+
+TEST_CASE("circular_buffer plain wraparound", "[circular_buffer]") {
+    circular_buffer ring(16);
+    REQUIRE(write(ring, std::string(10, '.')));
+    REQUIRE(!write(ring, std::string(7, '!')));
+    REQUIRE(read_all(ring) == std::string(10, '.'));
+
+    // Six bytes are left before the end of the array, so a longer reservation stops there
+    circular_buffer::region space = ring.reserve(12);
+    REQUIRE(space.size == 6);
+    std::memcpy(space.data, "abcdef", 6);
+    ring.commit(space);
+
+    // The rest starts over at the front of the array, and is limited by what is free
+    space = ring.reserve(12);
+    REQUIRE(space.size == 10);
+    std::memcpy(space.data, "ghij", 4);
+    ring.commit(4);
+    REQUIRE(ring.size() == 10);
+
+    circular_buffer::region data = ring.peek();
+    REQUIRE(std::string(reinterpret_cast<const char*>(data.data), data.size) == "abcdef");
+    ring.consume(data.size);
+    data = ring.peek();
+    REQUIRE(std::string(reinterpret_cast<const char*>(data.data), data.size) == "ghij");
+    ring.consume(data.size);
+    REQUIRE(ring.empty());
+
+    // A full ring has no room until bytes are consumed
+    REQUIRE(write(ring, std::string(12, 'x')));
+    REQUIRE(write(ring, "yyyy"));
+    REQUIRE(!ring.reserve(1));
+    ring.consume(2);
+    REQUIRE(ring.reserve(5).size == 2);
+}
+
+TEST_CASE("circular_buffer magic ring", "[circular_buffer]") {
+    circular_buffer ring(100, circular_buffer::producers::single, circular_buffer::mapping::magic);
+    REQUIRE(ring.is_magic());
+    size_t capacity = ring.capacity();
+    REQUIRE(capacity >= 4096);
+    REQUIRE((capacity & (capacity - 1)) == 0);
+
+    REQUIRE(write(ring, std::string(capacity - 100, '.')));
+    read_all(ring);
+
+    // A region crossing the end of the array is still contiguous
+    std::string record;
+    for(int i = 0; i < 300; i++)
+        record += static_cast<char>('a' + i % 26);
+    circular_buffer::region space = ring.reserve(record.size());
+    REQUIRE(space.size == record.size());
+    std::memcpy(space.data, record.data(), record.size());
+    ring.commit(space);
+
+    circular_buffer::region data = ring.peek();
+    REQUIRE(data.data == space.data);
+    REQUIRE(std::string(reinterpret_cast<const char*>(data.data), data.size) == record);
+    ring.consume(data.size);
+
+    // The bytes written past the end of the array are the ones at its start
+    space = ring.reserve(1);
+    REQUIRE(space.data == data.data + record.size() - capacity);
+    REQUIRE(std::memcmp(space.data - 200, record.data() + 100, 200) == 0);
+
+    // Any free space can be reserved at once
+    REQUIRE(ring.reserve(capacity).size == capacity);
+}
+
+TEST_CASE("circular_buffer single producer stream", "[circular_buffer]") {
+    circular_buffer plain(256);
+    stream(plain, 1, 50000);
+
+    circular_buffer magic(256, circular_buffer::producers::single, circular_buffer::mapping::magic);
+    stream(magic, 1, 50000);
+}
+
+TEST_CASE("circular_buffer multiple producer stream", "[circular_buffer]") {
+    circular_buffer plain(256, circular_buffer::producers::multiple);
+    stream(plain, 4, 20000);
+
+    circular_buffer magic(256, circular_buffer::producers::multiple, circular_buffer::mapping::magic);
+    stream(magic, 4, 20000);
+}
+
+TEST_CASE("flight_recorder keeps the most recent records", "[flight_recorder]") {
+    REQUIRE_THROWS_AS(flight_recorder(0), std::invalid_argument);
+
+    flight_recorder recorder(1000);
+    REQUIRE(recorder.capacity() == 16 * flight_recorder::SLOT_BYTES);
+    REQUIRE(recorder.max_record() == 16 * flight_recorder::SLOT_PAYLOAD);
+    REQUIRE(recorder.snapshot().empty());
+    REQUIRE_THROWS_AS(recorder.append("", recorder.max_record() + 1), std::length_error);
+
+    REQUIRE(recorder.append("first", 5) == 0);
+    REQUIRE(recorder.append("", 0) == 1);
+    std::string long_record(100, 'x');
+    REQUIRE(recorder.append(long_record.data(), long_record.size()) == 2);
+    REQUIRE(recorder.appended() == 5);
+
+    std::vector<flight_recorder::record> records = recorder.snapshot();
+    REQUIRE(records.size() == 3);
+    REQUIRE(records[0].sequence == 0);
+    REQUIRE(std::string(records[0].bytes.begin(), records[0].bytes.end()) == "first");
+    REQUIRE(records[1].bytes.empty());
+    REQUIRE(records[2].sequence == 2);
+    REQUIRE(std::string(records[2].bytes.begin(), records[2].bytes.end()) == long_record);
+
+    // Filling the ring overwrites the oldest records, including part of the long one, which is then dropped whole
+    for(int i = 0; i < 14; i++) {
+        std::string line = "line " + std::to_string(i);
+        recorder.append(line.data(), line.size());
+    }
+    records = recorder.snapshot();
+    REQUIRE(records.size() == 14);
+    REQUIRE(records.front().sequence == 5);
+    REQUIRE(std::string(records.back().bytes.begin(), records.back().bytes.end()) == "line 13");
+
+    // Records that wrap around the end of the array come back whole
+    while((recorder.appended() & 15) != 14)
+        recorder.append("pad", 3);
+    std::string wrapping;
+    for(int i = 0; i < 200; i++)
+        wrapping += static_cast<char>('a' + i % 26);
+    uint64_t sequence = recorder.append(wrapping.data(), wrapping.size());
+    records = recorder.snapshot();
+    REQUIRE(records.back().sequence == sequence);
+    REQUIRE(std::string(records.back().bytes.begin(), records.back().bytes.end()) == wrapping);
+
+    // A record may take the whole ring
+    std::string huge(recorder.max_record(), 'h');
+    recorder.append(huge.data(), huge.size());
+    records = recorder.snapshot();
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0].bytes.size() == huge.size());
+}
+
+TEST_CASE("flight_recorder snapshots while writers append", "[flight_recorder]") {
+    flight_recorder recorder(4096);
+    const unsigned writers = 4;
+    const uint32_t records_each = 50000;
+
+    // A record is [writer id][sequence number, 4 bytes][payload derived from both], of a varying size
+    std::vector<std::thread> threads;
+    for(unsigned id = 0; id < writers; id++) {
+        threads.emplace_back([&recorder, id, records_each]() {
+            uint8_t record[128];
+            for(uint32_t sequence = 0; sequence < records_each; sequence++) {
+                size_t size = 5 + sequence % 120;
+                record[0] = static_cast<uint8_t>(id);
+                std::memcpy(record + 1, &sequence, 4);
+                for(size_t i = 5; i < size; i++)
+                    record[i] = static_cast<uint8_t>(id * 31 + sequence + i);
+                recorder.append(record, size);
+            }
+        });
+    }
+
+    auto check = [writers](const std::vector<flight_recorder::record>& records) {
+        std::vector<int64_t> last(writers, -1);
+        uint64_t previous = 0;
+        for(const flight_recorder::record& record : records) {
+            REQUIRE(record.bytes.size() >= 5);
+            REQUIRE(record.sequence >= previous);
+            previous = record.sequence + 1;
+
+            uint8_t id = record.bytes[0];
+            uint32_t sequence;
+            std::memcpy(&sequence, &record.bytes[1], 4);
+            REQUIRE(id < writers);
+            REQUIRE(record.bytes.size() == 5 + sequence % 120);
+            for(size_t i = 5; i < record.bytes.size(); i++)
+                REQUIRE(record.bytes[i] == static_cast<uint8_t>(id * 31 + sequence + i));
+            // Each writer's records are appended in order
+            REQUIRE(int64_t(sequence) > last[id]);
+            last[id] = sequence;
+        }
+    };
+
+    size_t snapshots = 0;
+    while(recorder.appended() < 100000 || snapshots < 100) {
+        check(recorder.snapshot());
+        snapshots++;
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+
+    std::vector<flight_recorder::record> records = recorder.snapshot();
+    check(records);
+    // Once the writers are done, every slot holds a finished record: only the oldest one can be cut off
+    size_t slots = 0;
+    for(const flight_recorder::record& record : records)
+        slots += (record.bytes.size() + flight_recorder::SLOT_PAYLOAD - 1) / flight_recorder::SLOT_PAYLOAD;
+    REQUIRE(slots + 3 > 4096 / flight_recorder::SLOT_BYTES);
+}
@@ -0,0 +1,106 @@
+/**
+ * Tests of disjoint_set and concurrent_disjoint_set.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/set/disjoint_set.h>
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST_CASE("disjoint_set basics", "[disjoint_set]") {
+    disjoint_set sets(6);
+
+    REQUIRE(sets.count() == 6);
+    REQUIRE(!sets.connected(0, 1));
+
+    REQUIRE(sets.unite(0, 1));
+    REQUIRE(sets.unite(2, 3));
+    REQUIRE(!sets.unite(1, 0));
+    REQUIRE(sets.count() == 4);
+
+    REQUIRE(sets.connected(0, 1));
+    REQUIRE(!sets.connected(1, 2));
+
+    REQUIRE(sets.unite(1, 3));
+    REQUIRE(sets.connected(0, 2));
+    REQUIRE(sets.set_size(3) == 4);
+    REQUIRE(sets.set_size(5) == 1);
+
+    SECTION("Growing the set") {
+        size_t x = sets.make_set();
+        REQUIRE(x == 6);
+        REQUIRE(sets.count() == 4);
+        REQUIRE(sets.unite(x, 5));
+        REQUIRE(sets.set_size(5) == 2);
+    }
+
+    SECTION("Out of range elements") {
+        REQUIRE_THROWS_AS(sets.find(6), std::out_of_range);
+        REQUIRE_THROWS_AS(sets.unite(0, 100), std::out_of_range);
+    }
+
+    SECTION("Too many elements") {
+        // Rejected before anything is allocated for them
+        if(SIZE_MAX > UINT32_MAX) {
+            size_t too_many = static_cast<size_t>(UINT32_MAX) + 1;
+            REQUIRE_THROWS_AS(disjoint_set(too_many), std::invalid_argument);
+            REQUIRE_THROWS_AS(concurrent_disjoint_set(too_many), std::invalid_argument);
+        }
+    }
+}
+
+TEST_CASE("disjoint_set long chains", "[disjoint_set]") {
+    const size_t n = 100000;
+    disjoint_set sets(n);
+
+    for(size_t i = 1; i < n; i++)
+        sets.unite(i - 1, i);
+
+    REQUIRE(sets.count() == 1);
+    REQUIRE(sets.set_size(0) == n);
+    REQUIRE(sets.connected(0, n - 1));
+}
+
+TEST_CASE("concurrent_disjoint_set matches disjoint_set", "[disjoint_set]") {
+    const size_t n = 20000, edges = 15000;
+
+    std::mt19937 rng(5);
+    std::vector<std::pair<size_t, size_t>> pairs(edges);
+    for(auto& edge : pairs)
+        edge = std::make_pair(rng() % n, rng() % n);
+
+    disjoint_set expected(n);
+    for(auto& edge : pairs)
+        expected.unite(edge.first, edge.second);
+
+    concurrent_disjoint_set sets(n);
+
+    SECTION("Single thread") {
+        for(auto& edge : pairs)
+            sets.unite(edge.first, edge.second);
+    }
+
+    SECTION("Many threads") {
+        const size_t threads = 8;
+        std::vector<std::thread> workers;
+        for(size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                for(size_t i = t; i < pairs.size(); i += threads)
+                    sets.unite(pairs[i].first, pairs[i].second);
+            });
+        }
+        for(auto& worker : workers)
+            worker.join();
+    }
+
+    REQUIRE(sets.count() == expected.count());
+    for(size_t i = 0; i < n; i += 7) {
+        size_t j = (i * 31 + 11) % n;
+        REQUIRE(sets.connected(i, j) == expected.connected(i, j));
+    }
+}
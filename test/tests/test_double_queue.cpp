@@ -0,0 +1,176 @@
+/**
+ * Tests of double_queue and work_stealing_deque.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/queue/double_queue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("double_queue basics", "[double_queue]") {
+    double_queue<int> queue;
+    REQUIRE(queue.empty());
+
+    queue.push_back(2);
+    queue.push_back(3);
+    queue.push_front(1);
+    queue.push_front(0);
+
+    REQUIRE(queue.size() == 4);
+    REQUIRE(queue.front() == 0);
+    REQUIRE(queue.back() == 3);
+    for(int i = 0; i < 4; i++)
+        REQUIRE(queue[i] == i);
+    REQUIRE_THROWS_AS(queue.at(4), std::out_of_range);
+
+    queue.pop_front();
+    queue.pop_back();
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.front() == 1);
+    REQUIRE(queue.back() == 2);
+
+    SECTION("Iteration") {
+        std::vector<int> seen(queue.begin(), queue.end());
+        REQUIRE(seen == std::vector<int>({1, 2}));
+        REQUIRE(queue.end() - queue.begin() == 2);
+    }
+
+    SECTION("Copying") {
+        double_queue<int> copy = queue;
+        copy.push_back(9);
+        REQUIRE(copy.size() == 3);
+        REQUIRE(queue.size() == 2);
+        REQUIRE(copy[2] == 9);
+    }
+}
+
+TEST_CASE("double_queue matches std::deque", "[double_queue]") {
+    double_queue<std::string, 64> queue;
+    std::deque<std::string> expected;
+    std::mt19937 rng(7);
+
+    // Small blocks, many operations: exercises block crossings in both directions and map growth
+    for(int step = 0; step < 100000; step++) {
+        unsigned op = rng() % 10;
+        std::string value = std::to_string(step);
+        if(op < 3) {
+            queue.push_back(value);
+            expected.push_back(value);
+        } else if(op < 6) {
+            queue.push_front(value);
+            expected.push_front(value);
+        } else if(op < 8 && !expected.empty()) {
+            queue.pop_back();
+            expected.pop_back();
+        } else if(!expected.empty()) {
+            queue.pop_front();
+            expected.pop_front();
+        }
+    }
+
+    REQUIRE(queue.size() == expected.size());
+    REQUIRE(std::equal(expected.begin(), expected.end(), queue.begin()));
+}
+
+TEST_CASE("double_queue reuses pooled blocks", "[double_queue]") {
+    double_queue<int, 64> queue;
+    const size_t block = double_queue<int, 64>::block_capacity;
+
+    for(size_t i = 0; i < 4 * block; i++)
+        queue.push_back(static_cast<int>(i));
+    while(!queue.empty())
+        queue.pop_front();
+    REQUIRE(queue.pooled_blocks() == 4);
+
+    // A steady-state FIFO never needs more than two blocks at once
+    for(size_t i = 0; i < 100 * block; i++) {
+        queue.push_back(static_cast<int>(i));
+        queue.pop_front();
+    }
+    REQUIRE(queue.pooled_blocks() == 4);
+
+    queue.shrink_to_fit();
+    REQUIRE(queue.pooled_blocks() == 0);
+}
+
+TEST_CASE("double_queue destroys its elements", "[double_queue]") {
+    auto tracked = std::make_shared<int>(0);
+    {
+        double_queue<std::shared_ptr<int>, 64> queue;
+        for(int i = 0; i < 100; i++)
+            queue.push_front(tracked);
+        queue.pop_back();
+        REQUIRE(tracked.use_count() == 100);
+    }
+    REQUIRE(tracked.use_count() == 1);
+}
+
+TEST_CASE("work_stealing_deque single thread", "[double_queue]") {
+    work_stealing_deque<int> deque(2);
+
+    for(int i = 0; i < 10; i++)
+        deque.push(i);
+    REQUIRE(deque.size() == 10);
+    REQUIRE(deque.capacity() >= 10);
+
+    int value = -1;
+    REQUIRE(deque.pop(value));
+    REQUIRE(value == 9);
+    REQUIRE(deque.steal(value));
+    REQUIRE(value == 0);
+
+    while(deque.pop(value)) {}
+    REQUIRE(value == 1);
+    REQUIRE(deque.empty());
+    REQUIRE(!deque.steal(value));
+}
+
+TEST_CASE("work_stealing_deque with thieves", "[double_queue]") {
+    const int tasks = 100000, thieves = 3;
+    work_stealing_deque<int> deque;
+    std::vector<std::atomic<int>> runs(tasks);
+    for(auto& count : runs)
+        count.store(0);
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> workers;
+    for(int t = 0; t < thieves; t++) {
+        workers.emplace_back([&] {
+            int task;
+            while(!done.load()) {
+                if(deque.steal(task))
+                    runs[task]++;
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // The owner mixes pushes with pops, like a worker spawning and running tasks
+    int task;
+    for(int i = 0; i < tasks; i++) {
+        deque.push(i);
+        if(i % 3 == 0 && deque.pop(task))
+            runs[task]++;
+    }
+    while(deque.pop(task))
+        runs[task]++;
+    while(!deque.empty())
+        std::this_thread::yield();
+
+    done = true;
+    for(auto& worker : workers)
+        worker.join();
+
+    bool exactly_once = true;
+    for(auto& count : runs)
+        exactly_once &= count.load() == 1;
+    REQUIRE(exactly_once);
+}
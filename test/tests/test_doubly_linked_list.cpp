@@ -0,0 +1,148 @@
+/**
+ * Tests of intrusive_doubly_linked_list and doubly_linked_list.
+ **/
+
+#include <catch.hpp>
+#include <linear/lists/doubly_linked_list.h>
+
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct entry {
+    int key;
+    doubly_linked_list_hook recency;
+
+    explicit entry(int key) : key(key) {}
+};
+
+typedef intrusive_doubly_linked_list<entry, &entry::recency> recency_list;
+
+std::vector<int> keys(recency_list& list) {
+    std::vector<int> result;
+    for(auto& e : list)
+        result.push_back(e.key);
+    return result;
+}
+
+}
+
+TEST_CASE("intrusive_doubly_linked_list basics", "[doubly_linked_list]") {
+    std::vector<entry> entries;
+    for(int i = 0; i < 6; i++)
+        entries.emplace_back(i);
+
+    recency_list list;
+    for(int i = 0; i < 4; i++)
+        list.push_back(entries[i]);
+    REQUIRE(keys(list) == std::vector<int>({0, 1, 2, 3}));
+    REQUIRE(entries[2].recency.is_linked());
+    REQUIRE(!entries[5].recency.is_linked());
+
+    // Touching an entry moves it to the front
+    list.splice(list.begin(), list, list.iterator_to(entries[2]));
+    REQUIRE(keys(list) == std::vector<int>({2, 0, 1, 3}));
+    list.splice(list.begin(), list, list.begin());
+    REQUIRE(keys(list) == std::vector<int>({2, 0, 1, 3}));
+
+    list.erase(entries[0]);
+    REQUIRE(!entries[0].recency.is_linked());
+    REQUIRE(keys(list) == std::vector<int>({2, 1, 3}));
+    list.pop_back();
+    list.push_front(entries[4]);
+    REQUIRE(keys(list) == std::vector<int>({4, 2, 1}));
+    REQUIRE(list.back().key == 1);
+
+    std::vector<int> backwards;
+    for(auto it = list.end(); it != list.begin();)
+        backwards.push_back((--it)->key);
+    REQUIRE(backwards == std::vector<int>({1, 2, 4}));
+
+    SECTION("Splicing between lists") {
+        recency_list other;
+        other.push_back(entries[0]);
+        other.push_back(entries[3]);
+        other.push_back(entries[5]);
+
+        list.splice(list.end(), other, other.begin());
+        REQUIRE(keys(list) == std::vector<int>({4, 2, 1, 0}));
+        REQUIRE(other.size() == 2);
+
+        list.splice(list.begin(), other, other.begin(), other.end());
+        REQUIRE(keys(list) == std::vector<int>({3, 5, 4, 2, 1, 0}));
+        REQUIRE(other.empty());
+        REQUIRE(list.size() == 6);
+
+        other.splice(other.end(), list);
+        REQUIRE(list.empty());
+        REQUIRE(keys(other) == std::vector<int>({3, 5, 4, 2, 1, 0}));
+    }
+
+    SECTION("Moving") {
+        recency_list moved(std::move(list));
+        REQUIRE(list.empty());
+        REQUIRE(keys(moved) == std::vector<int>({4, 2, 1}));
+        moved.clear();
+        REQUIRE(!entries[4].recency.is_linked());
+    }
+}
+
+TEST_CASE("doubly_linked_list basics", "[doubly_linked_list]") {
+    doubly_linked_list<std::string> list;
+    list.push_back("b");
+    list.push_front("a");
+    list.push_back("c");
+    REQUIRE(std::vector<std::string>(list.begin(), list.end()) == std::vector<std::string>({"a", "b", "c"}));
+
+    list.splice(list.begin(), --list.end());
+    REQUIRE(std::vector<std::string>(list.begin(), list.end()) == std::vector<std::string>({"c", "a", "b"}));
+    list.splice(list.end(), list.begin(), std::next(list.begin(), 2));
+    REQUIRE(std::vector<std::string>(list.begin(), list.end()) == std::vector<std::string>({"b", "c", "a"}));
+
+    doubly_linked_list<std::string> copy = list;
+    copy.pop_front();
+    REQUIRE(copy.size() == 2);
+    REQUIRE(list.size() == 3);
+
+    list.splice(std::next(list.begin()), copy);
+    REQUIRE(copy.empty());
+    REQUIRE(std::vector<std::string>(list.begin(), list.end()) ==
+            std::vector<std::string>({"b", "c", "a", "c", "a"}));
+    REQUIRE(list.back() == "a");
+}
+
+TEST_CASE("doubly_linked_list matches std::list", "[doubly_linked_list]") {
+    doubly_linked_list<int> list;
+    std::list<int> expected;
+    std::mt19937 rng(23);
+
+    for(int step = 0; step < 20000; step++) {
+        size_t size = list.size();
+        size_t index = rng() % (size + 1);
+        auto position = std::next(list.begin(), index);
+        auto expected_position = std::next(expected.begin(), index);
+
+        switch(size == 0 ? 0 : rng() % 3) {
+            case 0:
+                list.insert(position, step);
+                expected.insert(expected_position, step);
+                break;
+            case 1:
+                if(index < size) {
+                    list.erase(position);
+                    expected.erase(expected_position);
+                }
+                break;
+            default:
+                // Move the front element before the chosen position
+                list.splice(position, list.begin());
+                expected.splice(expected_position, expected, expected.begin());
+                break;
+        }
+        REQUIRE(list.size() == expected.size());
+    }
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == std::vector<int>(expected.begin(), expected.end()));
+}
@@ -0,0 +1,193 @@
+/**
+ * Tests of gap_buffer.
+ **/
+
+#include <catch.hpp>
+#include <linear/arrays/gap_buffer.h>
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("gap_buffer editing at one cursor", "[gap_buffer]") {
+    gap_buffer text("hello world");
+    REQUIRE(text.size() == 11);
+    REQUIRE(text.cursor_count() == 1);
+    REQUIRE(text.position(0) == 11);
+    REQUIRE(text.before(0).str() == "hello world");
+    REQUIRE(text.after(0).empty());
+
+    text.insert(0, "!");
+    text.move(0, 5);
+    text.insert(0, ",");
+    REQUIRE(text.to_string() == "hello, world!");
+    REQUIRE(text.position(0) == 6);
+
+    // With one cursor, the two runs around it are the two halves of the text
+    REQUIRE(text.before(0).str() == "hello,");
+    REQUIRE(text.after(0).str() == " world!");
+    REQUIRE(text[0] == 'h');
+    REQUIRE(text[6] == ' ');
+    REQUIRE(text[12] == '!');
+
+    REQUIRE(text.erase_before(0, 3) == 3);
+    REQUIRE(text.erase_after(0, 1) == 1);
+    REQUIRE(text.to_string() == "helworld!");
+    REQUIRE(text.erase_before(0, 100) == 3);
+    REQUIRE(text.erase_after(0, 100) == 6);
+    REQUIRE(text.empty());
+    REQUIRE(text.to_string().empty());
+
+    REQUIRE_THROWS_AS(text.move(0, 1), std::out_of_range);
+    REQUIRE_THROWS_AS(text.insert(1, "x"), std::out_of_range);
+    REQUIRE_THROWS_AS(text.remove_cursor(0), std::logic_error);
+}
+
+TEST_CASE("gap_buffer grows and shrinks geometrically", "[gap_buffer]") {
+    gap_buffer text;
+    size_t capacity = text.capacity();
+    size_t reallocations = 0;
+    std::string expected;
+    for(int i = 0; i < 100000; i++) {
+        char c = static_cast<char>('a' + i % 26);
+        text.insert(0, &c, 1);
+        expected += c;
+        if(text.capacity() != capacity) {
+            REQUIRE(text.capacity() >= 2 * capacity);
+            capacity = text.capacity();
+            reallocations++;
+        }
+    }
+    REQUIRE(text.to_string() == expected);
+    REQUIRE(reallocations < 20);
+
+    // Erasing most of the text gives the memory back
+    text.move(0, 50000);
+    text.erase_before(0, 49000);
+    text.erase_after(0, 49000);
+    REQUIRE(text.to_string() == expected.substr(0, 1000) + expected.substr(99000));
+    REQUIRE(text.capacity() <= 8 * text.size());
+
+    // A gap large enough for a whole insertion is made in one step
+    std::string big(1 << 20, 'x');
+    text.insert(0, big);
+    REQUIRE(text.before(0).str().substr(1000) == big);
+}
+
+TEST_CASE("gap_buffer multiple cursors", "[gap_buffer]") {
+    gap_buffer text("one two three");
+    gap_buffer::cursor first = 0;
+    text.move(first, 3);
+    gap_buffer::cursor second = text.add_cursor(7);
+    gap_buffer::cursor third = text.add_cursor(13);
+    REQUIRE(text.cursor_count() == 3);
+    REQUIRE(text.position(second) == 7);
+
+    // Typing at each cursor in turn does not move any gap
+    for(int i = 0; i < 3; i++) {
+        text.insert(first, "!");
+        text.insert(second, "?");
+        text.insert(third, ".");
+    }
+    REQUIRE(text.to_string() == "one!!! two??? three...");
+    REQUIRE(text.position(first) == 6);
+    REQUIRE(text.position(second) == 13);
+    REQUIRE(text.position(third) == 22);
+    REQUIRE(text.before(second).str() == " two???");
+    REQUIRE(text.after(first).str() == " two???");
+
+    // Cursors pass each other
+    text.move(first, 19);
+    REQUIRE(text.position(first) == 19);
+    REQUIRE(text.position(third) == 22);
+    text.insert(first, "-");
+    REQUIRE(text.to_string() == "one!!! two??? three-...");
+    text.move(third, 0);
+    text.insert(third, ">");
+    REQUIRE(text.to_string() == ">one!!! two??? three-...");
+    REQUIRE(text.position(second) == 14);
+
+    // Erasing runs into other cursors' gaps and carries on past them
+    text.move(first, 15);
+    REQUIRE(text.erase_before(first, 8) == 8);
+    REQUIRE(text.to_string() == ">one!!!three-...");
+    REQUIRE(text.position(second) == 7);
+
+    text.remove_cursor(second);
+    REQUIRE(text.cursor_count() == 2);
+    REQUIRE_THROWS_AS(text.position(second), std::out_of_range);
+    REQUIRE(text.to_string() == ">one!!!three-...");
+    REQUIRE(text.add_cursor(4) == second);
+    text.insert(second, " ");
+    REQUIRE(text.to_string() == ">one !!!three-...");
+
+    std::string joined;
+    for(const gap_buffer::view& run : text.segments())
+        joined += run.str();
+    REQUIRE(joined == text.to_string());
+    REQUIRE(text.segments().size() == 4);
+}
+
+TEST_CASE("gap_buffer matches std::string on random edits", "[gap_buffer]") {
+    std::mt19937 rng(7);
+    gap_buffer text("the quick brown fox");
+    std::string model = "the quick brown fox";
+    std::vector<gap_buffer::cursor> cursors = {0};
+
+    for(int step = 0; step < 20000; step++) {
+        gap_buffer::cursor id = cursors[rng() % cursors.size()];
+        size_t position = text.position(id);
+        switch(rng() % 8) {
+            case 0:
+            case 1:
+            case 2: {
+                std::string typed(rng() % 5 + 1, static_cast<char>('a' + rng() % 26));
+                text.insert(id, typed);
+                model.insert(position, typed);
+                REQUIRE(text.position(id) == position + typed.size());
+                break;
+            }
+            case 3: {
+                size_t n = rng() % 4;
+                size_t erased = text.erase_before(id, n);
+                REQUIRE(erased == std::min(n, position));
+                model.erase(position - erased, erased);
+                break;
+            }
+            case 4: {
+                size_t n = rng() % 4;
+                size_t erased = text.erase_after(id, n);
+                REQUIRE(erased == std::min(n, model.size() - position));
+                model.erase(position, erased);
+                break;
+            }
+            case 5:
+                text.move(id, rng() % (model.size() + 1));
+                break;
+            case 6:
+                if(cursors.size() < 8)
+                    cursors.push_back(text.add_cursor(rng() % (model.size() + 1)));
+                break;
+            case 7:
+                if(cursors.size() > 1) {
+                    size_t which = rng() % cursors.size();
+                    text.remove_cursor(cursors[which]);
+                    cursors.erase(cursors.begin() + which);
+                }
+                break;
+        }
+
+        REQUIRE(text.size() == model.size());
+        for(gap_buffer::cursor c : cursors) {
+            size_t at = text.position(c);
+            REQUIRE(at <= model.size());
+            gap_buffer::view left = text.before(c), right = text.after(c);
+            REQUIRE(left.str() == model.substr(at - left.size, left.size));
+            REQUIRE(right.str() == model.substr(at, right.size));
+        }
+        if(step % 100 == 0)
+            REQUIRE(text.to_string() == model);
+    }
+    REQUIRE(text.to_string() == model);
+}
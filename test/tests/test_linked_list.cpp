@@ -0,0 +1,156 @@
+/**
+ * Tests of intrusive_linked_list and linked_list.
+ **/
+
+#include <catch.hpp>
+#include <linear/lists/linked_list.h>
+
+#include <forward_list>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct task {
+    int id;
+    // The same object can be on two lists at once
+    linked_list_hook queued;
+    linked_list_hook all;
+
+    explicit task(int id) : id(id) {}
+};
+
+typedef intrusive_linked_list<task, &task::queued> queue_list;
+typedef intrusive_linked_list<task, &task::all> all_list;
+
+template <typename List>
+std::vector<int> ids(List& list) {
+    std::vector<int> result;
+    for(auto& t : list)
+        result.push_back(t.id);
+    return result;
+}
+
+}
+
+TEST_CASE("intrusive_linked_list basics", "[linked_list]") {
+    std::vector<std::unique_ptr<task>> tasks;
+    for(int i = 0; i < 5; i++)
+        tasks.emplace_back(new task(i));
+
+    queue_list queue;
+    all_list all;
+    REQUIRE(queue.empty());
+
+    for(auto& t : tasks) {
+        all.push_front(*t);
+        if(t->id % 2 == 0)
+            queue.push_back(*t);
+    }
+    REQUIRE(ids(all) == std::vector<int>({4, 3, 2, 1, 0}));
+    REQUIRE(ids(queue) == std::vector<int>({0, 2, 4}));
+    REQUIRE(queue.size() == 3);
+    REQUIRE(queue.back().id == 4);
+
+    queue.erase_after(queue.iterator_to(*tasks[0]));
+    REQUIRE(ids(queue) == std::vector<int>({0, 4}));
+    queue.insert_after(queue.iterator_to(*tasks[4]), *tasks[3]);
+    REQUIRE(queue.back().id == 3);
+    queue.pop_front();
+    REQUIRE(ids(queue) == std::vector<int>({4, 3}));
+    REQUIRE(all.size() == 5);
+
+    SECTION("Splicing") {
+        queue_list other;
+        other.push_back(*tasks[0]);
+        other.push_back(*tasks[1]);
+        queue.splice_after(queue.begin(), other);
+        REQUIRE(other.empty());
+        REQUIRE(ids(queue) == std::vector<int>({4, 0, 1, 3}));
+
+        queue_list tail;
+        tail.push_back(*tasks[2]);
+        queue.splice_after(queue.iterator_to(queue.back()), tail);
+        REQUIRE(queue.back().id == 2);
+        REQUIRE(queue.size() == 5);
+    }
+
+    SECTION("Moving") {
+        queue_list moved(std::move(queue));
+        REQUIRE(queue.empty());
+        REQUIRE(ids(moved) == std::vector<int>({4, 3}));
+        queue.push_back(*tasks[2]);
+        REQUIRE(ids(queue) == std::vector<int>({2}));
+    }
+}
+
+TEST_CASE("linked_list basics", "[linked_list]") {
+    linked_list<std::string> list;
+    REQUIRE(list.empty());
+
+    list.push_back("b");
+    list.push_front("a");
+    list.push_back("d");
+    list.insert_after(std::next(list.begin()), "c");
+    REQUIRE(std::vector<std::string>(list.begin(), list.end()) == std::vector<std::string>({"a", "b", "c", "d"}));
+    REQUIRE(list.front() == "a");
+    REQUIRE(list.back() == "d");
+
+    list.erase_after(list.begin());
+    list.pop_front();
+    REQUIRE(std::vector<std::string>(list.begin(), list.end()) == std::vector<std::string>({"c", "d"}));
+
+    SECTION("Copying") {
+        linked_list<std::string> copy = list;
+        copy.push_back("e");
+        REQUIRE(copy.size() == 3);
+        REQUIRE(list.size() == 2);
+        REQUIRE(copy.back() == "e");
+    }
+
+    SECTION("Splicing adopts the other pool") {
+        linked_list<std::string> other;
+        for(int i = 0; i < 100; i++)
+            other.push_back(std::to_string(i));
+        for(int i = 0; i < 50; i++)
+            other.pop_front();
+        list.splice_after(list.begin(), other);
+        REQUIRE(other.empty());
+        REQUIRE(list.size() == 52);
+        REQUIRE(*std::next(list.begin()) == "50");
+        REQUIRE(list.back() == "d");
+
+        // The spliced nodes are now freed by this list, and the other list can start afresh
+        list.clear();
+        other.push_back("x");
+        REQUIRE(other.front() == "x");
+    }
+}
+
+TEST_CASE("linked_list matches std::forward_list", "[linked_list]") {
+    linked_list<int> list;
+    std::forward_list<int> expected;
+    std::mt19937 rng(17);
+
+    for(int step = 0; step < 20000; step++) {
+        size_t size = list.size();
+        size_t index = rng() % (size + 1);
+        auto position = list.before_begin();
+        auto expected_position = expected.before_begin();
+        for(size_t i = 0; i < index && i + 1 < size; i++) {
+            ++position;
+            ++expected_position;
+        }
+
+        if(size == 0 || rng() % 3) {
+            list.insert_after(position, step);
+            expected.insert_after(expected_position, step);
+        } else {
+            list.erase_after(position);
+            expected.erase_after(expected_position);
+        }
+    }
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == std::vector<int>(expected.begin(), expected.end()));
+}
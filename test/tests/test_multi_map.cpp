@@ -0,0 +1,100 @@
+/**
+ * Tests of multi_map.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/map/multi_map.h>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+TEST_CASE("Empty multi_map", "[multi_map]") {
+    multi_map<int, int> map;
+
+    REQUIRE(map.empty());
+    REQUIRE(map.equal_range(1).empty());
+    REQUIRE(map.count(1) == 0);
+    REQUIRE(map.erase(1) == 0);
+    REQUIRE(map.begin() == map.end());
+}
+
+TEST_CASE("multi_map insertion", "[multi_map]") {
+    multi_map<std::string, int> map;
+
+    map.insert("a", 1);
+    map.insert("b", 2);
+    map.insert("a", 3);
+
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.key_count() == 2);
+
+    auto range = map.equal_range("a");
+    REQUIRE(range.size() == 2);
+    REQUIRE(range[0] == 1);
+    REQUIRE(range[1] == 3);
+
+    SECTION("insert_many from a random access range") {
+        std::vector<int> values = {4, 5, 6};
+        map.insert_many("b", values.begin(), values.end());
+
+        REQUIRE(map.count("b") == 4);
+        REQUIRE(std::vector<int>(map.equal_range("b").begin(), map.equal_range("b").end()) ==
+                std::vector<int>({2, 4, 5, 6}));
+        REQUIRE(map.size() == 6);
+    }
+
+    SECTION("insert_many from a list") {
+        std::list<int> values = {7, 8};
+        map.insert_many("c", values.begin(), values.end());
+        map.insert_many("d", values.end(), values.end());
+
+        REQUIRE(map.count("c") == 2);
+        REQUIRE(map.count("d") == 0);
+        REQUIRE(map.key_count() == 3);
+    }
+
+    SECTION("Erase a key") {
+        REQUIRE(map.erase("a") == 2);
+        REQUIRE(map.size() == 1);
+        REQUIRE(map.equal_range("a").empty());
+    }
+}
+
+TEST_CASE("multi_map erasure releases the values", "[multi_map]") {
+    multi_map<int, std::shared_ptr<int>> map;
+    std::shared_ptr<int> value = std::make_shared<int>(1);
+    map.insert(1, value);
+    map.insert(2, value);
+    map.insert(2, value);
+    REQUIRE(value.use_count() == 4);
+
+    // Key 2 is the last of its leaf, so its block is not shifted over
+    REQUIRE(map.erase(2) == 2);
+    REQUIRE(value.use_count() == 2);
+    REQUIRE(map.erase(1) == 1);
+    REQUIRE(value.use_count() == 1);
+}
+
+TEST_CASE("multi_map iteration", "[multi_map]") {
+    multi_map<int, int> map;
+    for(int key = 0; key < 200; key++) {
+        for(int value = 0; value < key % 7; value++)
+            map.insert(key, key * 100 + value);
+    }
+
+    int last = -1;
+    size_t values = 0;
+    for(auto it = map.begin(); it != map.end(); ++it) {
+        REQUIRE(it.key() > last);
+        last = it.key();
+
+        int expected = it.key() * 100;
+        for(int value : it.values())
+            REQUIRE(value == expected++);
+        values += it.values().size();
+    }
+
+    REQUIRE(values == map.size());
+}
@@ -0,0 +1,160 @@
+/**
+ * Tests of multi_set and the approximate counting structures.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/set/multi_set.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("multi_set counting", "[multi_set]") {
+    multi_set<std::string> bag;
+
+    REQUIRE(bag.empty());
+    REQUIRE(bag.count("x") == 0);
+
+    REQUIRE(bag.insert("x") == 1);
+    REQUIRE(bag.insert("x") == 2);
+    REQUIRE(bag.insert("y", 5) == 5);
+
+    REQUIRE(bag.size() == 7);
+    REQUIRE(bag.distinct_size() == 2);
+    REQUIRE(bag.count("y") == 5);
+
+    REQUIRE(bag.erase("y", 2) == 2);
+    REQUIRE(bag.count("y") == 3);
+    REQUIRE(bag.erase("y", 10) == 3);
+    REQUIRE(!bag.contains("y"));
+    REQUIRE(bag.erase("y") == 0);
+    REQUIRE(bag.size() == 2);
+    REQUIRE(bag.distinct_size() == 1);
+}
+
+TEST_CASE("multi_set large counts spill out of line", "[multi_set]") {
+    multi_set<int> bag;
+    const uint64_t big = uint64_t(1) << 40;
+
+    REQUIRE(bag.insert(1, big) == big);
+    REQUIRE(bag.insert(1, 3) == big + 3);
+    REQUIRE(bag.count(1) == big + 3);
+
+    REQUIRE(bag.erase(1, big) == big);
+    REQUIRE(bag.count(1) == 3);
+
+    REQUIRE(bag.insert(2, big) == big);
+    REQUIRE(bag.erase_all(2) == big);
+    REQUIRE(bag.insert(3, big) == big);
+    REQUIRE(bag.count(3) == big);
+    REQUIRE(bag.size() == big + 3);
+}
+
+TEST_CASE("multi_set matches std::map under churn", "[multi_set]") {
+    multi_set<int> bag;
+    std::map<int, uint64_t> reference;
+    std::mt19937 rng(11);
+
+    for(int i = 0; i < 50000; i++) {
+        int value = static_cast<int>(rng() % 3000);
+        uint64_t n = rng() % 4 + 1;
+
+        if(rng() % 3 == 0) {
+            uint64_t removed = std::min<uint64_t>(n, reference[value]);
+            REQUIRE(bag.erase(value, n) == removed);
+            if((reference[value] -= removed) == 0)
+                reference.erase(value);
+        } else {
+            REQUIRE(bag.insert(value, n) == (reference[value] += n));
+        }
+    }
+
+    REQUIRE(bag.distinct_size() == reference.size());
+    for(auto& kv : reference)
+        REQUIRE(bag.count(kv.first) == kv.second);
+
+    size_t visited = 0;
+    for(auto it = bag.begin(); it != bag.end(); ++it, visited++)
+        REQUIRE(reference.at(it.key()) == it.count());
+    REQUIRE(visited == reference.size());
+
+    SECTION("Merging") {
+        multi_set<int> other;
+        other.insert(-1, 4);
+        other.insert(reference.begin()->first, 2);
+        bag.merge(other);
+
+        REQUIRE(bag.count(-1) == 4);
+        REQUIRE(bag.count(reference.begin()->first) == reference.begin()->second + 2);
+    }
+}
+
+TEST_CASE("count_min_sketch estimates", "[multi_set]") {
+    count_min_sketch<int> sketch(1024, 4);
+    std::map<int, uint64_t> exact;
+    std::mt19937 rng(1);
+
+    for(int i = 0; i < 20000; i++) {
+        int value = static_cast<int>(rng() % 2000);
+        sketch.insert(value);
+        exact[value]++;
+    }
+
+    // Never below the truth, and within 2N/width of it for nearly every element
+    size_t within = 0;
+    for(auto& kv : exact) {
+        REQUIRE(sketch.estimate(kv.first) >= kv.second);
+        within += sketch.estimate(kv.first) - kv.second <= 2 * 20000 / 1024 ? 1 : 0;
+    }
+    REQUIRE(within >= exact.size() * 9 / 10);
+
+    count_min_sketch<int> wrong(512, 4);
+    REQUIRE_THROWS_AS(sketch.merge(wrong), std::invalid_argument);
+}
+
+TEST_CASE("space_saving finds heavy hitters", "[multi_set]") {
+    space_saving<int> summary(50);
+    std::mt19937 rng(2);
+
+    // Elements 0-4 make up half the stream; the rest is noise over 1000 elements
+    for(int i = 0; i < 20000; i++) {
+        if(i % 2 == 0)
+            summary.insert(i % 10 / 2);
+        else
+            summary.insert(100 + static_cast<int>(rng() % 1000));
+    }
+
+    auto top = summary.top();
+    REQUIRE(top.size() == 50);
+    for(int i = 0; i < 5; i++) {
+        REQUIRE(top[i].value < 5);
+        REQUIRE(top[i].count >= 2000);
+        REQUIRE(top[i].count - top[i].error <= 2000);
+    }
+}
+
+TEST_CASE("approximate_multi_set merges across threads", "[multi_set]") {
+    const size_t threads = 4, per_thread = 20000;
+    std::vector<approximate_multi_set<int>> partials(threads, approximate_multi_set<int>(2048, 4, 16));
+
+    std::vector<std::thread> workers;
+    for(size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&partials, t] {
+            std::mt19937 rng(static_cast<unsigned>(t));
+            for(size_t i = 0; i < per_thread; i++)
+                partials[t].insert(i % 4 == 0 ? 7 : static_cast<int>(rng() % 5000));
+        });
+    }
+    for(auto& worker : workers)
+        worker.join();
+
+    approximate_multi_set<int> merged = partials[0];
+    for(size_t t = 1; t < threads; t++)
+        merged.merge(partials[t]);
+
+    REQUIRE(merged.size() == threads * per_thread);
+    REQUIRE(merged.count(7) >= threads * per_thread / 4);
+    REQUIRE(merged.heavy_hitters().front().value == 7);
+}
@@ -0,0 +1,183 @@
+/**
+ * Tests of piece_table.
+ **/
+
+#include <catch.hpp>
+#include <linear/arrays/piece_table.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+TEST_CASE("piece_table editing", "[piece_table]") {
+    piece_table text("hello world");
+    REQUIRE(text.size() == 11);
+    REQUIRE(text.piece_count() == 1);
+    REQUIRE(!text.can_undo());
+
+    text.insert(5, ",");
+    text.insert(12, "!");
+    REQUIRE(text.to_string() == "hello, world!");
+    REQUIRE(text.piece_count() == 4);
+    REQUIRE(text[5] == ',');
+    REQUIRE(text[12] == '!');
+    REQUIRE(text.substr(7, 5) == "world");
+
+    // The runs point into the original and the add buffer
+    std::vector<piece_table::view> runs = text.views(3, 6);
+    REQUIRE(runs.size() == 3);
+    REQUIRE(runs[0].str() == "lo");
+    REQUIRE(runs[1].str() == ",");
+    REQUIRE(runs[2].str() == " wo");
+
+    text.erase(0, 7);
+    REQUIRE(text.to_string() == "world!");
+    text.erase(3, 100);
+    REQUIRE(text.to_string() == "wor");
+    REQUIRE_THROWS_AS(text.insert(4, "x"), std::out_of_range);
+    REQUIRE_THROWS_AS(text.erase(4, 1), std::out_of_range);
+
+    piece_table empty;
+    REQUIRE(empty.empty());
+    REQUIRE(empty.to_string().empty());
+    empty.insert(0, "x");
+    REQUIRE(empty.to_string() == "x");
+}
+
+TEST_CASE("piece_table typing extends a single piece", "[piece_table]") {
+    piece_table text("0123456789");
+    for(char c : std::string("typing"))
+        text.insert(5 + text.added_bytes(), &c, 1);
+    REQUIRE(text.to_string() == "01234typing56789");
+    REQUIRE(text.piece_count() == 3);
+    REQUIRE(text.added_bytes() == 6);
+
+    // Every keystroke is still its own undo step
+    text.undo();
+    REQUIRE(text.to_string() == "01234typin56789");
+    text.insert(10, "g!");
+    REQUIRE(text.to_string() == "01234typing!56789");
+}
+
+TEST_CASE("piece_table undo and redo", "[piece_table]") {
+    piece_table text("abc");
+    text.insert(3, "def");
+    text.erase(0, 1);
+    text.insert(0, "A");
+    REQUIRE(text.to_string() == "Abcdef");
+
+    REQUIRE(text.undo());
+    REQUIRE(text.to_string() == "bcdef");
+    REQUIRE(text.undo());
+    REQUIRE(text.to_string() == "abcdef");
+    REQUIRE(text.undo());
+    REQUIRE(text.to_string() == "abc");
+    REQUIRE(!text.undo());
+    REQUIRE(text.to_string() == "abc");
+
+    REQUIRE(text.redo());
+    REQUIRE(text.redo());
+    REQUIRE(text.to_string() == "bcdef");
+    REQUIRE(text.can_redo());
+
+    // Editing after undoing drops what could be redone
+    text.insert(0, "X");
+    REQUIRE(!text.can_redo());
+    REQUIRE(!text.redo());
+    REQUIRE(text.to_string() == "Xbcdef");
+    REQUIRE(text.undo());
+    REQUIRE(text.to_string() == "bcdef");
+}
+
+TEST_CASE("piece_table matches std::string on random edits", "[piece_table]") {
+    std::mt19937 rng(11);
+    std::string initial(1000, ' ');
+    for(size_t i = 0; i < initial.size(); i++)
+        initial[i] = static_cast<char>('A' + i % 26);
+    piece_table text(initial);
+    std::vector<std::string> history = {initial};
+    size_t current = 0;
+
+    for(int step = 0; step < 5000; step++) {
+        std::string model = history[current];
+        unsigned roll = rng() % 10;
+        if(roll < 5) {
+            size_t position = rng() % (model.size() + 1);
+            std::string typed(rng() % 6 + 1, static_cast<char>('a' + rng() % 26));
+            text.insert(position, typed);
+            model.insert(position, typed);
+        } else if(roll < 8) {
+            size_t position = rng() % (model.size() + 1);
+            size_t length = rng() % 10;
+            text.erase(position, length);
+            model.erase(position, length);
+        } else if(roll < 9) {
+            REQUIRE(text.undo() == (current > 0));
+            if(current > 0)
+                current--;
+            REQUIRE(text.to_string() == history[current]);
+            continue;
+        } else {
+            REQUIRE(text.redo() == (current + 1 < history.size()));
+            if(current + 1 < history.size())
+                current++;
+            REQUIRE(text.to_string() == history[current]);
+            continue;
+        }
+
+        if(model != history[current]) {
+            history.resize(current + 1);
+            history.push_back(model);
+            current++;
+        }
+        REQUIRE(text.size() == model.size());
+        if(step % 50 == 0) {
+            REQUIRE(text.to_string() == model);
+            size_t position = rng() % (model.size() + 1);
+            REQUIRE(text.substr(position, 40) == model.substr(position, 40));
+            if(!model.empty()) {
+                size_t index = rng() % model.size();
+                REQUIRE(text[index] == model[index]);
+            }
+        }
+    }
+    REQUIRE(text.to_string() == history[current]);
+}
+
+TEST_CASE("piece_table opens files without copying them", "[piece_table]") {
+    const char *path = "piece_table_test.txt";
+    std::string contents;
+    for(int line = 0; line < 1000; line++)
+        contents += "line " + std::to_string(line) + "\n";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << contents;
+    }
+
+    {
+        piece_table text = piece_table::open(path);
+        REQUIRE(text.size() == contents.size());
+        REQUIRE(text.added_bytes() == 0);
+        REQUIRE(text.substr(0, 7) == "line 0\n");
+
+        text.insert(7, "inserted\n");
+        text.erase(0, 7);
+        REQUIRE(text.to_string() == "inserted\n" + contents.substr(7));
+        text.undo();
+        text.undo();
+        REQUIRE(text.to_string() == contents);
+    }
+    std::remove(path);
+
+    {
+        std::ofstream out(path, std::ios::binary);
+    }
+    REQUIRE(piece_table::open(path).empty());
+    std::remove(path);
+
+    REQUIRE_THROWS_AS(piece_table::open("no/such/piece_table_file"), std::system_error);
+}
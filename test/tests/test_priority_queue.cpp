@@ -0,0 +1,181 @@
+/**
+ * Tests of the d-ary heap priority_queue and pairing_heap.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/queue/priority_queue.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST_CASE("priority_queue basics", "[priority_queue]") {
+    priority_queue<int> queue;
+    REQUIRE(queue.empty());
+
+    auto five = queue.push(5);
+    auto three = queue.push(3);
+    auto eight = queue.push(8);
+    queue.push(1);
+
+    REQUIRE(queue.size() == 4);
+    REQUIRE(queue.top() == 1);
+
+    queue.decrease_key(eight, 0);
+    REQUIRE(queue.top() == 0);
+    REQUIRE(queue.top_handle() == eight);
+
+    queue.erase(three);
+    REQUIRE(!queue.contains(three));
+    REQUIRE(queue.contains(five));
+
+    queue.update(five, 10);
+    REQUIRE(queue.value(five) == 10);
+
+    std::vector<int> order;
+    while(!queue.empty()) {
+        order.push_back(queue.top());
+        queue.pop();
+    }
+    REQUIRE(order == std::vector<int>({0, 1, 10}));
+
+    SECTION("Max heap") {
+        priority_queue<std::string, std::greater<std::string>, 2> max;
+        max.push("b");
+        max.push("c");
+        max.push("a");
+        REQUIRE(max.top() == "c");
+    }
+
+    SECTION("Values need not be default constructible") {
+        struct distance {
+            explicit distance(int meters) : meters(meters) {}
+            bool operator<(const distance& other) const { return meters < other.meters; }
+            int meters;
+        };
+        priority_queue<distance> distances;
+        for(int meters : {7, 2, 9, 4})
+            distances.push(distance(meters));
+        REQUIRE(distances.top().meters == 2);
+        distances.pop();
+        REQUIRE(distances.top().meters == 4);
+    }
+}
+
+TEST_CASE("priority_queue matches a reference under random operations", "[priority_queue]") {
+    priority_queue<int, std::less<int>, 3> queue;
+    std::set<std::pair<int, unsigned>> expected;
+    std::vector<std::pair<unsigned, int>> live;
+    std::mt19937 rng(11);
+
+    for(int step = 0; step < 50000; step++) {
+        unsigned op = rng() % 6;
+        if(op < 2 || live.empty()) {
+            int value = static_cast<int>(rng() % 100000);
+            unsigned h = queue.push(value);
+            expected.insert({value, h});
+            live.push_back({h, value});
+        } else if(op == 2) {
+            auto top = *expected.begin();
+            REQUIRE(queue.top() == top.first);
+            queue.pop();
+            expected.erase(expected.begin());
+            live.erase(std::find_if(live.begin(), live.end(), [&](const std::pair<unsigned, int>& item) {
+                return item.first == top.second;
+            }));
+        } else {
+            size_t index = rng() % live.size();
+            auto item = live[index];
+            expected.erase({item.second, item.first});
+            if(op == 3) {
+                queue.erase(item.first);
+                live.erase(live.begin() + index);
+            } else {
+                int value = op == 4 ? item.second - static_cast<int>(rng() % 1000) : static_cast<int>(rng() % 100000);
+                if(op == 4)
+                    queue.decrease_key(item.first, value);
+                else
+                    queue.update(item.first, value);
+                live[index].second = value;
+                expected.insert({value, item.first});
+            }
+        }
+
+        REQUIRE(queue.size() == expected.size());
+        if(!expected.empty())
+            REQUIRE(queue.top() == expected.begin()->first);
+    }
+}
+
+TEST_CASE("pairing_heap basics", "[priority_queue]") {
+    pairing_heap<int> heap;
+
+    auto seven = heap.push(7);
+    heap.push(4);
+    auto nine = heap.push(9);
+    heap.push(2);
+    REQUIRE(heap.top() == 2);
+    REQUIRE(heap.size() == 4);
+
+    heap.decrease_key(nine, 1);
+    REQUIRE(heap.top() == 1);
+    REQUIRE(heap.top_handle() == nine);
+
+    heap.erase(seven);
+    REQUIRE(heap.size() == 3);
+
+    pairing_heap<int> other;
+    other.push(3);
+    auto zero = other.push(0);
+    heap.meld(other);
+    REQUIRE(other.empty());
+    REQUIRE(heap.size() == 5);
+    REQUIRE(heap.top() == 0);
+    REQUIRE(heap.value(zero) == 0);
+
+    std::vector<int> order;
+    while(!heap.empty()) {
+        order.push_back(heap.top());
+        heap.pop();
+    }
+    REQUIRE(order == std::vector<int>({0, 1, 2, 3, 4}));
+}
+
+TEST_CASE("pairing_heap sorts and handles random decrease_key/erase", "[priority_queue]") {
+    pairing_heap<long> heap;
+    std::multiset<long> expected;
+    std::vector<std::pair<pairing_heap<long>::handle, long>> handles;
+    std::mt19937 rng(5);
+
+    for(int i = 0; i < 20000; i++) {
+        long value = static_cast<long>(rng() % 1000000);
+        handles.push_back({heap.push(value), value});
+        expected.insert(value);
+    }
+
+    // Decrease or erase a random third of the elements
+    std::shuffle(handles.begin(), handles.end(), rng);
+    for(size_t i = 0; i < handles.size() / 3; i++) {
+        expected.erase(expected.find(handles[i].second));
+        if(i % 2) {
+            heap.erase(handles[i].first);
+        } else {
+            long value = handles[i].second - static_cast<long>(rng() % 5000);
+            heap.decrease_key(handles[i].first, value);
+            expected.insert(value);
+        }
+    }
+
+    REQUIRE(heap.size() == expected.size());
+    bool sorted = true;
+    for(long value : expected) {
+        sorted &= heap.top() == value;
+        heap.pop();
+    }
+    REQUIRE(sorted);
+    REQUIRE(heap.empty());
+}
@@ -0,0 +1,209 @@
+/**
+ * Tests of spsc_queue and mpmc_queue.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/queue/queue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+TEST_CASE("spsc_queue basics", "[queue]") {
+    spsc_queue<int> queue(5);
+    REQUIRE(queue.capacity() == 8);
+    REQUIRE(queue.empty());
+
+    int value = 0;
+    REQUIRE(!queue.try_pop(value));
+
+    for(int i = 0; i < 8; i++)
+        REQUIRE(queue.try_push(i));
+    REQUIRE(!queue.try_push(8));
+    REQUIRE(queue.size() == 8);
+
+    for(int i = 0; i < 8; i++) {
+        REQUIRE(queue.try_pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE(!queue.try_pop(value));
+
+    SECTION("Batches wrap around the ring") {
+        std::vector<int> in(20);
+        std::iota(in.begin(), in.end(), 0);
+
+        REQUIRE(queue.try_push_n(in.begin(), 5) == 5);
+        std::vector<int> out(3);
+        REQUIRE(queue.try_pop_n(out.begin(), 3) == 3);
+        REQUIRE(out == std::vector<int>({0, 1, 2}));
+
+        // 2 queued, so only 6 fit
+        REQUIRE(queue.try_push_n(in.begin() + 5, 10) == 6);
+        out.assign(20, -1);
+        REQUIRE(queue.try_pop_n(out.begin(), 20) == 8);
+        REQUIRE(std::equal(out.begin(), out.begin() + 8, in.begin() + 3));
+        REQUIRE(queue.empty());
+    }
+}
+
+TEST_CASE("spsc_queue destroys queued items", "[queue]") {
+    auto tracked = std::make_shared<int>(0);
+    {
+        spsc_queue<std::shared_ptr<int>> queue(4);
+        queue.try_push(tracked);
+        queue.try_push(tracked);
+        REQUIRE(tracked.use_count() == 3);
+
+        std::shared_ptr<int> out;
+        REQUIRE(queue.try_pop(out));
+        REQUIRE(tracked.use_count() == 3);
+    }
+    REQUIRE(tracked.use_count() == 1);
+}
+
+TEST_CASE("spsc_queue across two threads", "[queue]") {
+    const size_t count = 200000;
+    spsc_queue<size_t> queue(64);
+    std::vector<size_t> received;
+    received.reserve(count);
+
+    std::thread producer([&] {
+        for(size_t i = 0; i < count;) {
+            size_t batch[16];
+            size_t n = std::min<size_t>(16, count - i);
+            for(size_t j = 0; j < n; j++)
+                batch[j] = i + j;
+            size_t pushed = queue.try_push_n(batch, n);
+            // The unpushed tail of the batch is rebuilt on the next iteration
+            i += pushed;
+            if(!pushed)
+                std::this_thread::yield();
+        }
+    });
+
+    // A third thread sees both ends move under it
+    std::atomic<bool> done(false);
+    bool sizes_in_range = true;
+    std::thread observer([&] {
+        while(!done.load())
+            sizes_in_range &= queue.size() <= queue.capacity();
+    });
+
+    while(received.size() < count) {
+        size_t value;
+        if(queue.try_pop(value))
+            received.push_back(value);
+        else
+            std::this_thread::yield();
+    }
+    producer.join();
+    done.store(true);
+    observer.join();
+    REQUIRE(sizes_in_range);
+
+    bool in_order = true;
+    for(size_t i = 0; i < count; i++)
+        in_order &= received[i] == i;
+    REQUIRE(in_order);
+}
+
+TEST_CASE("mpmc_queue basics", "[queue]") {
+    mpmc_queue<int> queue(1);
+    REQUIRE(queue.capacity() == 2);
+
+    REQUIRE(queue.try_push(1));
+    REQUIRE(queue.try_push(2));
+    REQUIRE(!queue.try_push(3));
+
+    int value = 0;
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 1);
+    REQUIRE(queue.try_push(3));
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 2);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == 3);
+    REQUIRE(!queue.try_pop(value));
+
+    SECTION("Batches") {
+        mpmc_queue<int> big(8);
+        std::vector<int> in(12);
+        std::iota(in.begin(), in.end(), 0);
+
+        REQUIRE(big.try_push_n(in.begin(), 12) == 8);
+        REQUIRE(big.try_push_n(in.begin(), 1) == 0);
+
+        std::vector<int> out(5);
+        REQUIRE(big.try_pop_n(out.begin(), 5) == 5);
+        REQUIRE(out == std::vector<int>({0, 1, 2, 3, 4}));
+        REQUIRE(big.try_push_n(in.begin() + 8, 4) == 4);
+
+        out.assign(10, -1);
+        REQUIRE(big.try_pop_n(out.begin(), 10) == 7);
+        REQUIRE(std::equal(out.begin(), out.begin() + 7, in.begin() + 5));
+        REQUIRE(big.try_pop_n(out.begin(), 0) == 0);
+    }
+}
+
+TEST_CASE("mpmc_queue across many threads", "[queue]") {
+    const size_t producers = 4, consumers = 4, per_producer = 50000;
+    mpmc_queue<size_t> queue(128);
+    std::vector<std::vector<size_t>> received(consumers);
+    std::atomic<size_t> remaining(producers * per_producer);
+
+    std::vector<std::thread> threads;
+    for(size_t p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            // Alternate single and batched pushes
+            for(size_t i = 0; i < per_producer;) {
+                size_t batch[8];
+                size_t n = std::min<size_t>(i % 2 ? 8 : 1, per_producer - i);
+                for(size_t j = 0; j < n; j++)
+                    batch[j] = p * per_producer + i + j;
+                size_t pushed = queue.try_push_n(batch, n);
+                i += pushed;
+                if(!pushed)
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for(size_t c = 0; c < consumers; c++) {
+        threads.emplace_back([&, c] {
+            size_t batch[8];
+            while(remaining.load() > 0) {
+                size_t popped = queue.try_pop_n(batch, c % 2 ? 8 : 1);
+                received[c].insert(received[c].end(), batch, batch + popped);
+                remaining -= popped;
+                if(!popped)
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+
+    // Every value arrives exactly once, and each consumer sees each producer's values in order
+    std::vector<size_t> all;
+    for(auto& values : received) {
+        std::vector<size_t> last(producers, 0);
+        bool ordered = true;
+        for(size_t value : values) {
+            size_t p = value / per_producer;
+            ordered &= value + 1 > last[p];
+            last[p] = value + 1;
+        }
+        REQUIRE(ordered);
+        all.insert(all.end(), values.begin(), values.end());
+    }
+
+    std::sort(all.begin(), all.end());
+    REQUIRE(all.size() == producers * per_producer);
+    bool exact = true;
+    for(size_t i = 0; i < all.size(); i++)
+        exact &= all[i] == i;
+    REQUIRE(exact);
+    REQUIRE(queue.empty());
+}
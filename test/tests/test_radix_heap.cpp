@@ -0,0 +1,72 @@
+/**
+ * Tests of radix_heap.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/queue/radix_heap.h>
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE("radix_heap basics", "[radix_heap]") {
+    radix_heap<std::string> heap;
+    REQUIRE(heap.empty());
+
+    heap.push(10, "ten");
+    heap.push(3, "three");
+    heap.push(1000000, "million");
+    heap.push(3, "three again");
+
+    REQUIRE(heap.size() == 4);
+    REQUIRE(heap.top_key() == 3);
+    heap.pop();
+    REQUIRE(heap.top_key() == 3);
+    heap.pop();
+
+    REQUIRE(heap.top_key() == 10);
+    REQUIRE(heap.top_value() == "ten");
+
+    // Keys below the last reported minimum are rejected
+    REQUIRE_THROWS_AS(heap.push(9, "nine"), std::invalid_argument);
+    heap.push(10, "ten again");
+    heap.push(11, "eleven");
+
+    std::vector<uint64_t> keys;
+    while(!heap.empty()) {
+        keys.push_back(heap.top_key());
+        heap.pop();
+    }
+    REQUIRE(keys == std::vector<uint64_t>({10, 10, 11, 1000000}));
+}
+
+TEST_CASE("radix_heap matches a binary heap on a monotone workload", "[radix_heap]") {
+    radix_heap<uint32_t> heap;
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> expected;
+    std::mt19937_64 rng(2);
+
+    uint64_t minimum = 0;
+    for(int step = 0; step < 200000; step++) {
+        if(expected.empty() || rng() % 3) {
+            // Mix of small and huge increments, as in shortest paths with wide weight ranges
+            uint64_t key = minimum + (rng() % 4 ? rng() % 100 : rng() >> 20);
+            heap.push(key, static_cast<uint32_t>(step));
+            expected.push(key);
+        } else {
+            REQUIRE(heap.top_key() == expected.top());
+            minimum = expected.top();
+            heap.pop();
+            expected.pop();
+        }
+    }
+    while(!expected.empty()) {
+        REQUIRE(heap.top_key() == expected.top());
+        heap.pop();
+        expected.pop();
+    }
+    REQUIRE(heap.empty());
+}
@@ -0,0 +1,114 @@
+/**
+ * Tests of randomized_binary_search_tree.
+ **/
+
+#include <catch.hpp>
+#include <trees/randomized_binary_search_tree.h>
+
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+typedef randomized_binary_search_tree<int, int> rbst;
+
+TEST_CASE("randomized_binary_search_tree matches std::map on random operations", "[randomized_binary_search_tree]") {
+    rbst tree;
+    REQUIRE(tree.empty());
+    REQUIRE(tree.begin() == tree.end());
+    REQUIRE_THROWS_AS(tree.select(0), std::out_of_range);
+
+    std::mt19937 rng(50);
+    std::map<int, int> model;
+    for(int step = 0; step < 20000; step++) {
+        int key = static_cast<int>(rng() % 2000);
+        switch(rng() % 4) {
+            case 0:
+            case 1:
+                REQUIRE(tree.insert(key, step) == model.emplace(key, step).second);
+                break;
+            case 2:
+                REQUIRE(tree.erase(key) == (model.erase(key) == 1));
+                break;
+            default: {
+                auto expected = model.lower_bound(key);
+                auto found = tree.lower_bound(key);
+                if(expected == model.end()) {
+                    REQUIRE(found == tree.end());
+                } else {
+                    REQUIRE(found.key() == expected->first);
+                    REQUIRE(found.value() == expected->second);
+                }
+                REQUIRE(tree.rank(key) == static_cast<size_t>(std::distance(model.begin(), expected)));
+                break;
+            }
+        }
+        REQUIRE(tree.size() == model.size());
+    }
+
+    size_t index = 0;
+    auto expected = model.begin();
+    for(auto it = tree.begin(); it != tree.end(); ++it, ++expected, index++) {
+        REQUIRE(it.key() == expected->first);
+        REQUIRE(tree.select(index) == it);
+    }
+    REQUIRE(expected == model.end());
+    REQUIRE(tree.upper_bound(model.rbegin()->first) == tree.end());
+
+    tree[-1] += 7;
+    REQUIRE(tree.find(-1).value() == 7);
+    REQUIRE(tree.count(-1) == 1);
+
+    rbst copy(tree);
+    tree.clear();
+    REQUIRE(tree.empty());
+    REQUIRE(copy.size() == model.size() + 1);
+}
+
+TEST_CASE("randomized_binary_search_tree stays shallow on sorted input", "[randomized_binary_search_tree]") {
+    rbst tree;
+    for(int i = 0; i < 100000; i++)
+        tree.insert(i, i);
+    // A random tree is about 3 log2 n deep; a degenerate one would be n deep
+    REQUIRE(tree.height() < 6 * std::log2(100000.0));
+    for(int i = 0; i < 100000; i += 2)
+        tree.erase(i);
+    REQUIRE(tree.size() == 50000);
+    REQUIRE(tree.height() < 6 * std::log2(50000.0));
+    REQUIRE(tree.select(0).key() == 1);
+}
+
+TEST_CASE("randomized_binary_search_tree bulk construction", "[randomized_binary_search_tree]") {
+    std::vector<std::pair<int, int>> sorted;
+    for(int i = 0; i < 50000; i++)
+        sorted.emplace_back(3 * i, i);
+
+    for(unsigned threads : {1u, 2u, 3u, 8u, 0u}) {
+        rbst tree(sorted.begin(), sorted.end(), threads);
+        REQUIRE(tree.size() == sorted.size());
+        REQUIRE(tree.height() < 6 * std::log2(50000.0));
+        size_t i = 0;
+        for(auto it = tree.begin(); it != tree.end(); ++it, i++) {
+            REQUIRE(it.key() == sorted[i].first);
+            REQUIRE(it.value() == sorted[i].second);
+        }
+        REQUIRE(i == sorted.size());
+
+        // It remains an ordinary tree afterwards
+        REQUIRE(tree.insert(1, -1));
+        REQUIRE(tree.rank(3) == 2);
+        REQUIRE(tree.erase(0));
+        REQUIRE(tree.select(0).key() == 1);
+    }
+
+    rbst empty(sorted.begin(), sorted.begin());
+    REQUIRE(empty.empty());
+
+    std::swap(sorted[10], sorted[11]);
+    REQUIRE_THROWS_AS(rbst(sorted.begin(), sorted.end()), std::invalid_argument);
+    sorted[11] = sorted[10];
+    REQUIRE_THROWS_AS(rbst(sorted.begin(), sorted.end()), std::invalid_argument);
+}
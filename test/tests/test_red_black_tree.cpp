@@ -0,0 +1,149 @@
+/**
+ * Tests of red_black_tree.
+ **/
+
+#include <catch.hpp>
+#include <trees/red_black_tree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+std::vector<int> contents(const red_black_tree<int>& tree) {
+    return std::vector<int>(tree.begin(), tree.end());
+}
+
+bool balanced(const red_black_tree<int>& tree) {
+    return tree.height() <= 2 * std::log2(tree.size() + 1.0);
+}
+
+red_black_tree<int> random_set(size_t count, int range, std::mt19937& rng, std::set<int>& model) {
+    red_black_tree<int> tree;
+    for(size_t i = 0; i < count; i++) {
+        int key = static_cast<int>(rng() % range);
+        tree.insert(key);
+        model.insert(key);
+    }
+    return tree;
+}
+
+}
+
+TEST_CASE("red_black_tree insertion and erasure", "[red_black_tree]") {
+    red_black_tree<int> tree;
+    REQUIRE(tree.empty());
+    REQUIRE(tree.begin() == tree.end());
+    REQUIRE(!tree.erase(1));
+
+    std::set<int> model;
+    std::mt19937 rng(3);
+    for(int step = 0; step < 20000; step++) {
+        int key = static_cast<int>(rng() % 3000);
+        if(rng() % 3 == 0)
+            REQUIRE(tree.erase(key) == (model.erase(key) == 1));
+        else
+            REQUIRE(tree.insert(key) == model.insert(key).second);
+        REQUIRE(tree.size() == model.size());
+        if(step % 1000 == 0) {
+            REQUIRE(balanced(tree));
+            REQUIRE(contents(tree) == std::vector<int>(model.begin(), model.end()));
+        }
+    }
+
+    REQUIRE(*tree.lower_bound(1500) == *model.lower_bound(1500));
+    REQUIRE(*tree.upper_bound(1500) == *model.upper_bound(1500));
+    REQUIRE(tree.count(*model.begin()) == 1);
+
+    // Sorted insertions
+    red_black_tree<int> sorted;
+    for(int i = 0; i < 10000; i++)
+        sorted.insert(i);
+    REQUIRE(balanced(sorted));
+    red_black_tree<int> copy(sorted);
+    sorted.clear();
+    REQUIRE(copy.size() == 10000);
+    REQUIRE(*copy.begin() == 0);
+}
+
+TEST_CASE("red_black_tree split and join", "[red_black_tree]") {
+    red_black_tree<int> tree, below, above;
+    for(int i = 0; i < 1000; i++)
+        tree.insert(i * 2);
+
+    REQUIRE(tree.split(500, below, above));
+    REQUIRE(tree.empty());
+    REQUIRE(below.size() == 250);
+    REQUIRE(above.size() == 749);
+    REQUIRE(*below.begin() == 0);
+    REQUIRE(*above.begin() == 502);
+    REQUIRE(balanced(below));
+    REQUIRE(balanced(above));
+
+    REQUIRE_THROWS_AS(above.join(red_black_tree<int>(below)), std::invalid_argument);
+    REQUIRE_THROWS_AS(below.join(600, red_black_tree<int>(above)), std::invalid_argument);
+
+    below.join(500, above);
+    REQUIRE(below.size() == 1000);
+    REQUIRE(balanced(below));
+    std::vector<int> expected;
+    for(int i = 0; i < 1000; i++)
+        expected.push_back(i * 2);
+    REQUIRE(contents(below) == expected);
+
+    // Joining trees of very different black heights
+    red_black_tree<int> small;
+    small.insert(5000);
+    below.join(small);
+    REQUIRE(below.size() == 1001);
+    REQUIRE(balanced(below));
+    REQUIRE(!below.split(1, tree, above));
+    REQUIRE(tree.size() == 1);
+    REQUIRE(above.size() == 1000);
+    above.join(red_black_tree<int>());
+    REQUIRE(above.size() == 1000);
+}
+
+TEST_CASE("red_black_tree set algebra matches std::set", "[red_black_tree]") {
+    std::mt19937 rng(7);
+    // Sizes on both sides of the parallel cutoff, including very lopsided pairs
+    std::vector<std::pair<size_t, size_t>> sizes = {{0, 10}, {10, 0}, {100, 100}, {20000, 30}, {40, 20000},
+                                                    {30000, 30000}};
+
+    for(unsigned threads : {1u, 4u}) {
+        for(auto& size : sizes) {
+            std::set<int> first, second;
+            red_black_tree<int> a = random_set(size.first, 50000, rng, first);
+            red_black_tree<int> b = random_set(size.second, 50000, rng, second);
+
+            std::vector<int> expected;
+            red_black_tree<int> united(a);
+            united.unite(b, threads);
+            std::set_union(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(expected));
+            REQUIRE(contents(united) == expected);
+            REQUIRE(united.size() == expected.size());
+            REQUIRE(balanced(united));
+
+            expected.clear();
+            red_black_tree<int> common(a);
+            common.intersect(b, threads);
+            std::set_intersection(first.begin(), first.end(), second.begin(), second.end(),
+                                  std::back_inserter(expected));
+            REQUIRE(contents(common) == expected);
+            REQUIRE(balanced(common));
+
+            expected.clear();
+            red_black_tree<int> difference(a);
+            difference.subtract(b, threads);
+            std::set_difference(first.begin(), first.end(), second.begin(), second.end(),
+                                std::back_inserter(expected));
+            REQUIRE(contents(difference) == expected);
+            REQUIRE(balanced(difference));
+        }
+    }
+}
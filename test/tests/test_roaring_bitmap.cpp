@@ -0,0 +1,207 @@
+/**
+ * Tests of roaring_bitmap and the integer specializations of hash_set/tree_set.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/set/hash_set.h>
+#include <abstracts/set/roaring_bitmap.h>
+#include <abstracts/set/tree_set.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> to_vector(const roaring_bitmap& bitmap) {
+    return std::vector<uint32_t>(bitmap.begin(), bitmap.end());
+}
+
+// Mixes sparse values (array containers), dense values (bitmap containers) and long runs
+std::set<uint32_t> mixed_values(unsigned seed) {
+    std::mt19937 rng(seed);
+    std::set<uint32_t> values;
+
+    for(int i = 0; i < 3000; i++)
+        values.insert(rng());
+    for(int i = 0; i < 20000; i++)
+        values.insert((5u << 16) + rng() % 65536);
+    for(uint32_t v = (9u << 16) + 100; v < (9u << 16) + 40000; v++)
+        values.insert(v);
+
+    return values;
+}
+
+}
+
+TEST_CASE("Empty roaring_bitmap", "[roaring_bitmap]") {
+    roaring_bitmap bitmap;
+
+    REQUIRE(bitmap.empty());
+    REQUIRE(bitmap.cardinality() == 0);
+    REQUIRE(!bitmap.contains(0));
+    REQUIRE(!bitmap.erase(0));
+    REQUIRE(bitmap.begin() == bitmap.end());
+}
+
+TEST_CASE("roaring_bitmap insertion and removal", "[roaring_bitmap]") {
+    roaring_bitmap bitmap;
+
+    REQUIRE(bitmap.insert(7));
+    REQUIRE(!bitmap.insert(7));
+    REQUIRE(bitmap.insert(0xFFFFFFFF));
+    REQUIRE(bitmap.insert(1u << 16));
+
+    REQUIRE(bitmap.cardinality() == 3);
+    REQUIRE(bitmap.contains(0xFFFFFFFF));
+    REQUIRE(!bitmap.contains(8));
+    REQUIRE(to_vector(bitmap) == std::vector<uint32_t>({7, 1u << 16, 0xFFFFFFFF}));
+    REQUIRE(bitmap.minimum() == 7);
+
+    SECTION("Array container grows into a bitmap and back") {
+        for(uint32_t v = 0; v < 10000; v++)
+            bitmap.insert(v * 2);
+        REQUIRE(bitmap.cardinality() == 10003);
+
+        for(uint32_t v = 0; v < 10000; v++) {
+            if(v % 3 != 0)
+                REQUIRE(bitmap.erase(v * 2));
+        }
+        REQUIRE(bitmap.cardinality() == 3334 + 3);
+        REQUIRE(bitmap.contains(6));
+        REQUIRE(!bitmap.contains(4));
+        REQUIRE(bitmap.contains(7));
+    }
+
+    SECTION("Removing the last value drops the container") {
+        REQUIRE(bitmap.erase(1u << 16));
+        REQUIRE(bitmap.erase(7));
+        REQUIRE(bitmap.erase(0xFFFFFFFF));
+        REQUIRE(bitmap.empty());
+    }
+}
+
+TEST_CASE("roaring_bitmap iteration matches std::set", "[roaring_bitmap]") {
+    std::set<uint32_t> reference = mixed_values(1);
+    std::vector<uint32_t> input(reference.begin(), reference.end());
+    std::shuffle(input.begin(), input.end(), std::mt19937(2));
+
+    roaring_bitmap bitmap(input.data(), input.size());
+
+    REQUIRE(bitmap.cardinality() == reference.size());
+    REQUIRE(to_vector(bitmap) == std::vector<uint32_t>(reference.begin(), reference.end()));
+
+    SECTION("Run optimization keeps the same contents") {
+        size_t before = bitmap.memory_usage();
+        REQUIRE(bitmap.run_optimize());
+        REQUIRE(bitmap.memory_usage() < before);
+        REQUIRE(to_vector(bitmap) == std::vector<uint32_t>(reference.begin(), reference.end()));
+        REQUIRE(bitmap.contains((9u << 16) + 100));
+        REQUIRE(!bitmap.contains((9u << 16) + 99));
+
+        REQUIRE(bitmap.insert((9u << 16) + 99));
+        REQUIRE(bitmap.erase((9u << 16) + 500));
+        REQUIRE(bitmap.cardinality() == reference.size());
+    }
+}
+
+TEST_CASE("roaring_bitmap set algebra", "[roaring_bitmap]") {
+    std::set<uint32_t> a = mixed_values(10), b = mixed_values(20);
+    std::vector<uint32_t> va(a.begin(), a.end()), vb(b.begin(), b.end());
+
+    roaring_bitmap ra(va.data(), va.size()), rb(vb.data(), vb.size());
+
+    std::vector<uint32_t> expected;
+    bool optimize = GENERATE(false, true);
+    if(optimize) {
+        ra.run_optimize();
+        rb.run_optimize();
+    }
+
+    SECTION("Union") {
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        REQUIRE(to_vector(ra | rb) == expected);
+    }
+
+    SECTION("Intersection") {
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        REQUIRE(to_vector(ra & rb) == expected);
+        REQUIRE(roaring_bitmap::intersection_cardinality(ra, rb) == expected.size());
+    }
+
+    SECTION("Difference") {
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        REQUIRE(to_vector(ra - rb) == expected);
+
+        ra -= rb;
+        REQUIRE(ra.cardinality() == expected.size());
+    }
+
+    SECTION("Equality ignores container types") {
+        roaring_bitmap copy(va.data(), va.size());
+        REQUIRE(copy == ra);
+        copy.insert(12345678);
+        REQUIRE(copy != ra);
+    }
+}
+
+TEST_CASE("roaring_bitmap serialization", "[roaring_bitmap]") {
+    SECTION("Empty") {
+        roaring_bitmap empty;
+        std::vector<uint8_t> bytes = empty.serialize();
+
+        REQUIRE(bytes == std::vector<uint8_t>({0x3A, 0x30, 0, 0, 0, 0, 0, 0}));
+        REQUIRE(roaring_bitmap::deserialize(bytes).empty());
+    }
+
+    SECTION("Known encoding of a tiny array container") {
+        roaring_bitmap bitmap;
+        bitmap.insert(1);
+        bitmap.insert(5);
+
+        // cookie, container count, key, cardinality - 1, offset, values
+        std::vector<uint8_t> expected = {0x3A, 0x30, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 16, 0, 0, 0, 1, 0, 5, 0};
+        REQUIRE(bitmap.serialize() == expected);
+    }
+
+    SECTION("Round trip with every container type") {
+        std::set<uint32_t> values = mixed_values(3);
+        std::vector<uint32_t> input(values.begin(), values.end());
+        roaring_bitmap bitmap(input.data(), input.size());
+
+        REQUIRE(roaring_bitmap::deserialize(bitmap.serialize()) == bitmap);
+
+        bitmap.run_optimize();
+        std::vector<uint8_t> bytes = bitmap.serialize();
+        REQUIRE((bytes[0] | (bytes[1] << 8)) == 12347);
+        REQUIRE(roaring_bitmap::deserialize(bytes) == bitmap);
+
+        SECTION("Truncated input is rejected") {
+            bytes.resize(bytes.size() - 1);
+            REQUIRE_THROWS_AS(roaring_bitmap::deserialize(bytes), std::invalid_argument);
+        }
+    }
+
+    SECTION("Garbage is rejected") {
+        std::vector<uint8_t> bytes = {1, 2, 3, 4, 5};
+        REQUIRE_THROWS_AS(roaring_bitmap::deserialize(bytes), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Integer set specializations", "[roaring_bitmap]") {
+    hash_set<uint32_t> ids;
+    tree_set<uint32_t> ordered;
+
+    for(uint32_t v = 0; v < 100; v++) {
+        ids.insert(v * 7);
+        ordered.insert(v * 5);
+    }
+
+    tree_set<uint32_t> both = ids & ordered;
+    REQUIRE(both.size() == 15);
+    REQUIRE(both.contains(35));
+    REQUIRE(!both.contains(30));
+    REQUIRE(both.contains(0));
+}
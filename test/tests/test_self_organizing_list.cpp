@@ -0,0 +1,118 @@
+/**
+ * Tests of self_organizing_list and its policies.
+ **/
+
+#include <catch.hpp>
+#include <linear/lists/self_organizing_list.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+template <typename Policy>
+std::vector<int> order(const self_organizing_list<int, Policy>& list) {
+    return std::vector<int>(list.begin(), list.end());
+}
+
+template <typename Policy>
+self_organizing_list<int, Policy> one_to_five() {
+    self_organizing_list<int, Policy> list;
+    for(int i = 1; i <= 5; i++)
+        list.insert(i);
+    return list;
+}
+
+TEST_CASE("self_organizing_list basics", "[self_organizing_list]") {
+    self_organizing_list<std::string> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.find("missing") == nullptr);
+
+    list.insert("a");
+    list.insert("b");
+    list.insert("c");
+    REQUIRE(list.size() == 3);
+
+    REQUIRE(*list.find("c") == "c");
+    REQUIRE(list.front() == "c");
+    REQUIRE(!list.contains("d"));
+
+    REQUIRE(list.erase("a"));
+    REQUIRE(!list.erase("a"));
+    REQUIRE(list.size() == 2);
+    list.clear();
+    REQUIRE(list.empty());
+}
+
+TEST_CASE("self_organizing_list policies", "[self_organizing_list]") {
+    SECTION("move_to_front") {
+        auto list = one_to_five<self_organizing::move_to_front>();
+        REQUIRE(*list.find(4) == 4);
+        REQUIRE(order(list) == std::vector<int>({4, 1, 2, 3, 5}));
+        list.find(3);
+        REQUIRE(order(list) == std::vector<int>({3, 4, 1, 2, 5}));
+    }
+
+    SECTION("transpose") {
+        auto list = one_to_five<self_organizing::transpose>();
+        REQUIRE(*list.find(4) == 4);
+        REQUIRE(order(list) == std::vector<int>({1, 2, 4, 3, 5}));
+        list.find(4);
+        list.find(1);
+        REQUIRE(order(list) == std::vector<int>({1, 4, 2, 3, 5}));
+    }
+
+    SECTION("count") {
+        auto list = one_to_five<self_organizing::count>();
+        list.find(3);
+        list.find(5);
+        list.find(5);
+        REQUIRE(*list.find(4) == 4);
+        REQUIRE(order(list)[0] == 5);
+        REQUIRE(order(list)[1] == 3);
+        REQUIRE(order(list)[2] == 4);
+        list.find(4);
+        list.find(4);
+        REQUIRE(order(list)[0] == 4);
+    }
+
+    SECTION("none") {
+        auto list = one_to_five<self_organizing::none>();
+        list.find(5);
+        REQUIRE(order(list) == std::vector<int>({1, 2, 3, 4, 5}));
+    }
+}
+
+TEST_CASE("self_organizing_list counts comparisons", "[self_organizing_list]") {
+    auto list = one_to_five<self_organizing::none>();
+    list.find(1);
+    REQUIRE(list.comparisons() == 1);
+    list.find(5);
+    REQUIRE(list.comparisons() == 6);
+    list.find(9);
+    REQUIRE(list.comparisons() == 11);
+    list.reset_comparisons();
+    REQUIRE(list.comparisons() == 0);
+}
+
+TEST_CASE("self_organizing_list count keeps counts sorted", "[self_organizing_list]") {
+    self_organizing_list<int, self_organizing::count> list;
+    std::vector<int> hits(50, 0);
+    for(int i = 0; i < 50; i++)
+        list.insert(i);
+
+    std::mt19937 rng(5);
+    for(int step = 0; step < 20000; step++) {
+        // Skewed towards small values
+        int value = static_cast<int>(rng() % 50 * (rng() % 50) / 50);
+        REQUIRE(*list.find(value) == value);
+        hits[value]++;
+    }
+
+    for(size_t i = 1; i < list.size(); i++)
+        REQUIRE(hits[list[i - 1]] >= hits[list[i]]);
+    std::vector<int> values(list.begin(), list.end());
+    std::sort(values.begin(), values.end());
+    for(int i = 0; i < 50; i++)
+        REQUIRE(values[i] == i);
+}
@@ -0,0 +1,154 @@
+/**
+ * Tests of skip_list.
+ **/
+
+#include <catch.hpp>
+#include <linear/lists/skip_list.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("skip_list basics", "[skip_list]") {
+    skip_list<int, std::string> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.begin() == list.end());
+
+    REQUIRE(list.insert(5, "five"));
+    REQUIRE(list.insert(1, "one"));
+    REQUIRE(list.insert(3, "three"));
+    REQUIRE(!list.insert(3, "again"));
+    REQUIRE(list.size() == 3);
+
+    std::string value;
+    REQUIRE(list.find(3, value));
+    REQUIRE(value == "three");
+    REQUIRE(!list.find(4, value));
+    REQUIRE(list.contains(5));
+    REQUIRE(!list.contains(6));
+
+    std::vector<int> keys;
+    for(auto& item : list)
+        keys.push_back(item.first);
+    REQUIRE(keys == std::vector<int>({1, 3, 5}));
+
+    REQUIRE(list.lower_bound(2)->first == 3);
+    REQUIRE(list.lower_bound(3)->first == 3);
+    REQUIRE(list.lower_bound(6) == list.end());
+
+    REQUIRE(list.erase(3));
+    REQUIRE(!list.erase(3));
+    REQUIRE(!list.contains(3));
+    REQUIRE(list.size() == 2);
+    REQUIRE(list.insert(3, "back"));
+    REQUIRE(list.find(3, value));
+    REQUIRE(value == "back");
+}
+
+TEST_CASE("skip_list nodes are aligned for their items", "[skip_list]") {
+    skip_list<int, long double> list;
+    for(int i = 0; i < 1000; i++)
+        list.insert(i, i);
+    for(auto& item : list)
+        REQUIRE(reinterpret_cast<uintptr_t>(&item) % alignof(std::pair<const int, long double>) == 0);
+}
+
+TEST_CASE("skip_list matches std::map", "[skip_list]") {
+    skip_list<uint32_t, uint32_t> list;
+    std::map<uint32_t, uint32_t> expected;
+    std::mt19937 rng(3);
+
+    for(uint32_t step = 0; step < 100000; step++) {
+        uint32_t key = rng() % 5000;
+        if(rng() % 2) {
+            REQUIRE(list.insert(key, step) == expected.insert({key, step}).second);
+        } else {
+            REQUIRE(list.erase(key) == (expected.erase(key) == 1));
+        }
+    }
+
+    REQUIRE(list.size() == expected.size());
+    auto it = list.begin();
+    for(auto& item : expected) {
+        REQUIRE(it != list.end());
+        REQUIRE(it->first == item.first);
+        REQUIRE(it->second == item.second);
+        ++it;
+    }
+    REQUIRE(it == list.end());
+}
+
+TEST_CASE("skip_list concurrent inserts and erases", "[skip_list]") {
+    skip_list<uint64_t, uint64_t> list;
+    const size_t threads = 4, per_thread = 20000;
+
+    std::vector<std::thread> workers;
+    for(size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            // Every thread inserts all even keys of its stripe, and erases the multiples of 4 after inserting them
+            for(uint64_t i = 0; i < per_thread; i++) {
+                uint64_t key = 2 * (i * threads + t);
+                list.insert(key, key * 10);
+                if(key % 4 == 0)
+                    list.erase(key);
+            }
+        });
+    }
+    for(auto& worker : workers)
+        worker.join();
+
+    REQUIRE(list.size() == threads * per_thread / 2);
+    uint64_t expected = 2;
+    for(auto& item : list) {
+        REQUIRE(item.first == expected);
+        REQUIRE(item.second == expected * 10);
+        expected += 4;
+    }
+    REQUIRE(expected == 2 + 4 * (threads * per_thread / 2));
+}
+
+TEST_CASE("skip_list iterators survive concurrent writers", "[skip_list]") {
+    skip_list<uint32_t, uint32_t> list;
+    // Odd keys stay put while writers churn the even ones
+    for(uint32_t key = 1; key < 20000; key += 2)
+        list.insert(key, key);
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> writers;
+    for(uint32_t t = 0; t < 3; t++) {
+        writers.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            while(!done.load()) {
+                uint32_t key = 2 * (rng() % 10000);
+                if(rng() % 2)
+                    list.insert(key, key);
+                else
+                    list.erase(key);
+            }
+        });
+    }
+
+    bool ordered = true;
+    size_t complete = 0;
+    for(int scan = 0; scan < 20; scan++) {
+        uint32_t previous = 0, odd = 0;
+        for(auto it = list.begin(); it != list.end(); ++it) {
+            ordered &= previous == 0 || it->first > previous;
+            ordered &= it->first == it->second;
+            previous = it->first;
+            odd += it->first % 2;
+        }
+        complete += odd == 10000;
+    }
+    done = true;
+    for(auto& writer : writers)
+        writer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(complete == 20);
+}
@@ -0,0 +1,112 @@
+/**
+ * Tests of splay_tree.
+ **/
+
+#include <catch.hpp>
+#include <trees/splay_tree.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef splay_tree<int, int> int_splay_tree;
+
+TEST_CASE("splay_tree insertion and lookup", "[splay_tree]") {
+    splay_tree<int, std::string> tree;
+    REQUIRE(tree.empty());
+    REQUIRE(tree.height() == 0);
+    REQUIRE(tree.find(1) == tree.end());
+    REQUIRE(!tree.erase(1));
+
+    // Sorted insertions make a path, which the first deep lookup folds up
+    for(int i = 0; i < 1000; i++)
+        REQUIRE(tree.insert(i, std::to_string(i)));
+    REQUIRE(tree.size() == 1000);
+    REQUIRE(tree.height() == 1000);
+    REQUIRE(tree.find(0).value() == "0");
+    REQUIRE(tree.height() < 600);
+    REQUIRE(!tree.insert(500, "duplicate"));
+    REQUIRE(tree.find(500).value() == "500");
+
+    REQUIRE(tree.find(1000) == tree.end());
+    REQUIRE(tree.peek(999).value() == "999");
+    tree[1000] = "end";
+    tree[3] += "!";
+    REQUIRE(tree.find(3).value() == "3!");
+    REQUIRE(tree.size() == 1001);
+
+    int expected = 0;
+    for(auto it = tree.begin(); it != tree.end(); ++it, expected++)
+        REQUIRE(it.key() == expected);
+    REQUIRE(expected == 1001);
+
+    splay_tree<int, std::string> copy(tree);
+    tree.clear();
+    REQUIRE(tree.empty());
+    REQUIRE(copy.size() == 1001);
+    REQUIRE(copy.find(1000).value() == "end");
+}
+
+TEST_CASE("splay_tree matches std::map in every mode", "[splay_tree]") {
+    std::vector<int_splay_tree> trees;
+    trees.emplace_back(int_splay_tree::mode::full);
+    trees.emplace_back(int_splay_tree::mode::semi);
+    trees.emplace_back(int_splay_tree::mode::full, 4);
+    trees.emplace_back(int_splay_tree::mode::semi, 3);
+
+    for(int_splay_tree& tree : trees) {
+        std::map<int, int> model;
+        std::mt19937 rng(9);
+        for(int step = 0; step < 30000; step++) {
+            // Mostly lookups, within a range that drifts
+            int key = static_cast<int>(step / 100 + rng() % 200);
+            unsigned roll = rng() % 10;
+            if(roll < 2) {
+                REQUIRE(tree.insert(key, step) == model.emplace(key, step).second);
+            } else if(roll < 3) {
+                REQUIRE(tree.erase(key) == (model.erase(key) == 1));
+            } else {
+                auto found = tree.find(key);
+                auto expected = model.find(key);
+                REQUIRE((found == tree.end()) == (expected == model.end()));
+                if(expected != model.end())
+                    REQUIRE(found.value() == expected->second);
+            }
+            REQUIRE(tree.size() == model.size());
+        }
+
+        auto expected = model.begin();
+        for(auto it = tree.begin(); it != tree.end(); ++it, ++expected) {
+            REQUIRE(it.key() == expected->first);
+            REQUIRE(it.value() == expected->second);
+        }
+        REQUIRE(expected == model.end());
+    }
+}
+
+TEST_CASE("Semi-splaying brings nodes closer to the root", "[splay_tree]") {
+    int_splay_tree full(int_splay_tree::mode::full), semi(int_splay_tree::mode::semi);
+    for(int i = 0; i < 1024; i++) {
+        full.insert(i, i);
+        semi.insert(i, i);
+    }
+
+    // Both fold the path; splaying moves the node to the root and semi-splaying about halfway
+    full.find(0);
+    semi.find(0);
+    REQUIRE(full.height() < 600);
+    REQUIRE(semi.height() < 600);
+    REQUIRE(full.begin().key() == 0);
+    REQUIRE(semi.peek(0).key() == 0);
+
+    // With a period, lookups in between leave the tree alone
+    int_splay_tree lazy(int_splay_tree::mode::full, 1000);
+    for(int i = 0; i < 1024; i++)
+        lazy.insert(i, i);
+    for(int i = 0; i < 999; i++)
+        REQUIRE(lazy.find(i % 10).value() == i % 10);
+    REQUIRE(lazy.height() == 1024);
+    lazy.find(0);
+    REQUIRE(lazy.height() < 600);
+}
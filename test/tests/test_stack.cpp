@@ -0,0 +1,132 @@
+/**
+ * Tests of the segmented stack and treiber_stack.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/stack.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("stack basics", "[stack]") {
+    stack<std::string, 4> values;
+    REQUIRE(values.empty());
+
+    values.push("a");
+    values.push("b");
+    REQUIRE(values.top() == "b");
+    REQUIRE(values.size() == 2);
+    REQUIRE(values.is_inline());
+
+    values.pop();
+    REQUIRE(values.top() == "a");
+    values.pop();
+    REQUIRE(values.empty());
+}
+
+TEST_CASE("stack keeps references stable while growing", "[stack]") {
+    stack<int, 4> values;
+    std::vector<int*> addresses;
+
+    for(int i = 0; i < 1000; i++)
+        addresses.push_back(&values.emplace(i));
+    REQUIRE(!values.is_inline());
+    REQUIRE(values.size() == 1000);
+
+    bool stable = true;
+    for(int i = 0; i < 1000; i++)
+        stable &= *addresses[i] == i;
+    REQUIRE(stable);
+
+    SECTION("Popping across segment boundaries") {
+        for(int i = 999; i >= 0; i--) {
+            REQUIRE(values.top() == i);
+            REQUIRE(&values.top() == addresses[i]);
+            values.pop();
+        }
+        REQUIRE(values.is_inline());
+        REQUIRE(values.empty());
+    }
+
+    SECTION("Bouncing around a boundary") {
+        // 4 inline, then segments of 8 and 16: the 12th element is the last one in the first segment
+        while(values.size() > 12)
+            values.pop();
+        for(int round = 0; round < 100; round++) {
+            values.push(-1);
+            values.pop();
+        }
+        REQUIRE(values.top() == 11);
+        REQUIRE(&values.top() == addresses[11]);
+    }
+}
+
+TEST_CASE("stack destroys its elements", "[stack]") {
+    auto tracked = std::make_shared<int>(0);
+    {
+        stack<std::shared_ptr<int>, 2> values;
+        for(int i = 0; i < 50; i++)
+            values.push(tracked);
+        REQUIRE(tracked.use_count() == 51);
+    }
+    REQUIRE(tracked.use_count() == 1);
+}
+
+TEST_CASE("treiber_stack single thread", "[stack]") {
+    treiber_stack<std::string> values;
+    std::string out;
+    REQUIRE(!values.try_pop(out));
+
+    values.push("x");
+    values.push("y");
+    REQUIRE(values.size() == 2);
+    REQUIRE(values.try_pop(out));
+    REQUIRE(out == "y");
+    REQUIRE(values.try_pop(out));
+    REQUIRE(out == "x");
+    REQUIRE(values.empty());
+
+    // Enough elements to need several pool chunks
+    for(int i = 0; i < 10000; i++)
+        values.push(std::to_string(i));
+    REQUIRE(values.try_pop(out));
+    REQUIRE(out == "9999");
+}
+
+TEST_CASE("treiber_stack under contention", "[stack]") {
+    const int threads = 8, per_thread = 20000;
+    treiber_stack<int> values;
+    std::vector<std::vector<int>> popped(threads);
+
+    // Every thread pushes its own values and pops whatever it finds, so nodes are recycled constantly
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            int value;
+            for(int i = 0; i < per_thread; i++) {
+                values.push(t * per_thread + i);
+                if(i % 2 && values.try_pop(value))
+                    popped[t].push_back(value);
+            }
+        });
+    }
+    for(auto& worker : workers)
+        worker.join();
+
+    std::vector<int> all;
+    for(auto& values_seen : popped)
+        all.insert(all.end(), values_seen.begin(), values_seen.end());
+    int value;
+    while(values.try_pop(value))
+        all.push_back(value);
+
+    std::sort(all.begin(), all.end());
+    REQUIRE(all.size() == size_t(threads * per_thread));
+    bool exact = true;
+    for(size_t i = 0; i < all.size(); i++)
+        exact &= all[i] == static_cast<int>(i);
+    REQUIRE(exact);
+}
@@ -0,0 +1,119 @@
+/**
+ * Tests of timer_wheel.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/queue/timer_wheel.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST_CASE("timer_wheel basics", "[timer_wheel]") {
+    timer_wheel<std::string> wheel(100);
+    std::vector<std::pair<uint64_t, std::string>> fired;
+    auto record = [&](uint64_t deadline, std::string& name) { fired.push_back({deadline, name}); };
+
+    wheel.schedule(105, "a");
+    auto b = wheel.schedule(170, "b");
+    wheel.schedule(5000, "c");
+    wheel.schedule(50, "overdue");
+    REQUIRE(wheel.size() == 4);
+
+    REQUIRE(wheel.advance(104, record) == 1);
+    REQUIRE(fired.back().second == "overdue");
+    REQUIRE(wheel.now() == 104);
+
+    REQUIRE(wheel.cancel(b));
+    REQUIRE(!wheel.cancel(b));
+
+    REQUIRE(wheel.advance(4999, record) == 1);
+    REQUIRE(fired.back() == std::make_pair(uint64_t(105), std::string("a")));
+
+    REQUIRE(wheel.advance(5000, record) == 1);
+    REQUIRE(fired.back().second == "c");
+    REQUIRE(wheel.empty());
+
+    // A timer due now is due on the next tick
+    wheel.schedule(wheel.now(), "late");
+    REQUIRE(wheel.advance(wheel.now(), record) == 0);
+    REQUIRE(wheel.advance(wheel.now() + 1, record) == 1);
+    REQUIRE(fired.back() == std::make_pair(uint64_t(5000), std::string("late")));
+    REQUIRE(wheel.empty());
+
+    SECTION("Callbacks can reschedule") {
+        int runs = 0;
+        wheel.schedule(5010, "periodic");
+        std::function<void(uint64_t, std::string&)> again = [&](uint64_t deadline, std::string& name) {
+            if(++runs < 5)
+                wheel.schedule(deadline + 10, name);
+        };
+        REQUIRE(wheel.advance(100000, again) == 5);
+        REQUIRE(wheel.empty());
+    }
+}
+
+TEST_CASE("timer_wheel at the end of time", "[timer_wheel]") {
+    timer_wheel<int> wheel(UINT64_MAX - 1);
+    int fired = 0;
+    auto count = [&](uint64_t, int) { fired++; };
+
+    wheel.schedule(0, 1);
+    REQUIRE(wheel.advance(UINT64_MAX, count) == 1);
+    REQUIRE(wheel.now() == UINT64_MAX);
+
+    // There is no tick after the last one, so an overdue timer can only be cancelled
+    auto stuck = wheel.schedule(5, 2);
+    REQUIRE(wheel.advance(UINT64_MAX, count) == 0);
+    REQUIRE(wheel.size() == 1);
+    REQUIRE(wheel.cancel(stuck));
+    REQUIRE(fired == 1);
+}
+
+TEST_CASE("timer_wheel fires everything in deadline order", "[timer_wheel]") {
+    timer_wheel<uint32_t> wheel;
+    std::vector<uint64_t> deadlines;
+    std::vector<timer_wheel<uint32_t>::timer_id> ids;
+    std::mt19937_64 rng(9);
+
+    // Deadlines spread across every level, including very distant ones
+    for(uint32_t i = 0; i < 50000; i++) {
+        uint64_t deadline = rng() % 8 ? rng() % 1000000 : rng() >> (rng() % 40 + 1);
+        ids.push_back(wheel.schedule(deadline, i));
+        deadlines.push_back(deadline);
+    }
+
+    std::vector<bool> cancelled(ids.size(), false);
+    for(uint32_t i = 0; i < ids.size(); i += 3) {
+        REQUIRE(wheel.cancel(ids[i]));
+        cancelled[i] = true;
+    }
+    size_t pending = ids.size() - (ids.size() + 2) / 3;
+    REQUIRE(wheel.size() == pending);
+
+    std::vector<std::pair<uint64_t, uint32_t>> fired;
+    uint64_t before = 0, now = 0;
+    bool on_time = true, live = true;
+    while(!wheel.empty()) {
+        before = now;
+        // Small steps through the dense range, then one jump to the end of time
+        now = now < 2000000 ? now + rng() % 100000 + 1 : UINT64_MAX;
+        wheel.advance(now, [&](uint64_t deadline, uint32_t id) {
+            on_time &= deadline <= now && deadline > before && deadline == deadlines[id];
+            live &= !cancelled[id];
+            fired.push_back({deadline, id});
+        });
+    }
+
+    REQUIRE(on_time);
+    REQUIRE(live);
+    REQUIRE(fired.size() == pending);
+    REQUIRE(std::is_sorted(fired.begin(), fired.end(), [](const std::pair<uint64_t, uint32_t>& a,
+                                                          const std::pair<uint64_t, uint32_t>& b) {
+        return a.first < b.first;
+    }));
+}
@@ -0,0 +1,171 @@
+/**
+ * Tests of treap.
+ **/
+
+#include <catch.hpp>
+#include <trees/treap.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Yields 0, 1, 2, ... and throws when asked for `limit`
+struct failing_iterator {
+    typedef std::input_iterator_tag iterator_category;
+    typedef int value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const int *pointer;
+    typedef int reference;
+
+    int current, limit;
+
+    int operator*() const {
+        if(current == limit)
+            throw std::runtime_error("input failed");
+        return current;
+    }
+    failing_iterator& operator++() { current++; return *this; }
+    bool operator==(const failing_iterator& other) const { return current == other.current; }
+    bool operator!=(const failing_iterator& other) const { return current != other.current; }
+};
+
+}
+
+TEST_CASE("treap sequence editing", "[treap]") {
+    treap<int> sequence;
+    REQUIRE(sequence.empty());
+    REQUIRE(sequence.sum(0, 0) == 0);
+    REQUIRE_THROWS_AS(sequence.min(0, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(sequence[0], std::out_of_range);
+
+    for(int i = 0; i < 10; i++)
+        sequence.push_back(i);
+    REQUIRE(sequence.size() == 10);
+    REQUIRE(sequence.to_vector() == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    sequence.insert(3, 100);
+    sequence.erase(0);
+    REQUIRE(sequence.to_vector() == std::vector<int>({1, 2, 100, 3, 4, 5, 6, 7, 8, 9}));
+
+    std::vector<int> more = {-1, -2};
+    sequence.insert(10, more.begin(), more.end());
+    sequence.erase(2, 4);
+    REQUIRE(sequence.to_vector() == std::vector<int>({1, 2, 4, 5, 6, 7, 8, 9, -1, -2}));
+
+    sequence.move(0, 2, 6);
+    REQUIRE(sequence.to_vector() == std::vector<int>({4, 5, 6, 7, 8, 9, 1, 2, -1, -2}));
+    sequence.reverse(1, 5);
+    REQUIRE(sequence.to_vector() == std::vector<int>({4, 8, 7, 6, 5, 9, 1, 2, -1, -2}));
+    sequence.add(0, 3, 10);
+    REQUIRE(sequence.to_vector() == std::vector<int>({14, 18, 17, 6, 5, 9, 1, 2, -1, -2}));
+    REQUIRE(sequence[2] == 17);
+
+    REQUIRE(sequence.sum(0, 10) == 69);
+    REQUIRE(sequence.min(0, 10) == -2);
+    REQUIRE(sequence.max(3, 8) == 9);
+
+    REQUIRE_THROWS_AS(sequence.insert(11, 0), std::out_of_range);
+    REQUIRE_THROWS_AS(sequence.erase(5, 11), std::out_of_range);
+    REQUIRE_THROWS_AS(sequence.reverse(6, 5), std::out_of_range);
+    REQUIRE_THROWS_AS(sequence.move(0, 5, 6), std::out_of_range);
+
+    // Erased nodes are reused
+    size_t capacity = sequence.capacity();
+    sequence.erase(0, 5);
+    for(int i = 0; i < 5; i++)
+        sequence.push_back(i);
+    REQUIRE(sequence.capacity() == capacity);
+
+    treap<int> copy(sequence);
+    sequence.clear();
+    REQUIRE(sequence.empty());
+    REQUIRE(copy.size() == 10);
+}
+
+TEST_CASE("treap insertion that throws keeps no nodes", "[treap]") {
+    treap<int> sequence;
+    for(int i = 0; i < 10; i++)
+        sequence.push_back(i);
+    size_t capacity = sequence.capacity();
+
+    REQUIRE_THROWS_AS(sequence.insert(5, failing_iterator{0, 50}, failing_iterator{100, 50}), std::runtime_error);
+    REQUIRE(sequence.to_vector() == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    // The 50 nodes built before the failure went back to the free list
+    sequence.insert(0, failing_iterator{0, -1}, failing_iterator{50, -1});
+    REQUIRE(sequence.size() == 60);
+    REQUIRE(sequence.capacity() == capacity + 50);
+}
+
+TEST_CASE("treap matches std::vector on random operations", "[treap]") {
+    std::mt19937 rng(21);
+    std::vector<long long> model(500);
+    std::iota(model.begin(), model.end(), 0);
+    treap<long long> sequence(model.begin(), model.end());
+    REQUIRE(sequence.to_vector() == model);
+
+    for(int step = 0; step < 20000; step++) {
+        size_t first = rng() % (model.size() + 1);
+        size_t last = first + rng() % (model.size() - first + 1);
+        switch(rng() % 8) {
+            case 0: {
+                long long value = rng() % 1000;
+                sequence.insert(first, value);
+                model.insert(model.begin() + first, value);
+                break;
+            }
+            case 1:
+                sequence.erase(first, std::min(last, first + 3));
+                model.erase(model.begin() + first, model.begin() + std::min(last, first + 3));
+                break;
+            case 2: {
+                sequence.reverse(first, last);
+                std::reverse(model.begin() + first, model.begin() + last);
+                break;
+            }
+            case 3: {
+                long long delta = static_cast<long long>(rng() % 21) - 10;
+                sequence.add(first, last, delta);
+                for(size_t i = first; i < last; i++)
+                    model[i] += delta;
+                break;
+            }
+            case 4: {
+                size_t position = rng() % (model.size() - (last - first) + 1);
+                sequence.move(first, last, position);
+                std::vector<long long> moved(model.begin() + first, model.begin() + last);
+                model.erase(model.begin() + first, model.begin() + last);
+                model.insert(model.begin() + position, moved.begin(), moved.end());
+                break;
+            }
+            case 5:
+                REQUIRE(sequence.sum(first, last) ==
+                        std::accumulate(model.begin() + first, model.begin() + last, 0LL));
+                break;
+            case 6:
+                if(first < last) {
+                    REQUIRE(sequence.min(first, last) == *std::min_element(model.begin() + first,
+                                                                           model.begin() + last));
+                    REQUIRE(sequence.max(first, last) == *std::max_element(model.begin() + first,
+                                                                           model.begin() + last));
+                }
+                break;
+            default:
+                if(!model.empty()) {
+                    size_t index = rng() % model.size();
+                    REQUIRE(sequence[index] == model[index]);
+                }
+                break;
+        }
+        REQUIRE(sequence.size() == model.size());
+        if(step % 500 == 0)
+            REQUIRE(sequence.to_vector() == model);
+    }
+    REQUIRE(sequence.to_vector() == model);
+}
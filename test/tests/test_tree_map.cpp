@@ -0,0 +1,186 @@
+/**
+ * Tests of tree_map.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/map/tree_map.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Small nodes force plenty of splits and merges with only a few hundred keys
+typedef tree_map<int, int, std::less<int>, 64> small_map;
+
+TEST_CASE("Empty tree_map", "[tree_map]") {
+    tree_map<int, std::string> map;
+
+    REQUIRE(map.empty());
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.height() == 0);
+    REQUIRE(map.begin() == map.end());
+    REQUIRE(map.find(3) == map.end());
+    REQUIRE(map.lower_bound(3) == map.end());
+    REQUIRE(!map.erase(3));
+}
+
+TEST_CASE("Node sizing", "[tree_map]") {
+    REQUIRE(tree_map<int, int>::leaf_capacity >= 16);
+    REQUIRE(small_map::leaf_capacity >= 4);
+    REQUIRE(small_map::inner_capacity >= 4);
+}
+
+TEST_CASE("tree_map insertion and lookup", "[tree_map]") {
+    small_map map;
+
+    SECTION("Duplicate keys are rejected") {
+        REQUIRE(map.insert(1, 10));
+        REQUIRE(!map.insert(1, 20));
+        REQUIRE(map.size() == 1);
+        REQUIRE(map.find(1).value() == 10);
+    }
+
+    SECTION("operator[] default constructs") {
+        map[5] += 3;
+        map[5] += 3;
+        REQUIRE(map[5] == 6);
+        REQUIRE(map.size() == 1);
+    }
+
+    SECTION("Many keys, shuffled") {
+        std::vector<int> keys;
+        for(int i = 0; i < 1000; i++)
+            keys.push_back(i * 2);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+        for(int key : keys)
+            REQUIRE(map.insert(key, -key));
+
+        REQUIRE(map.size() == 1000);
+        REQUIRE(map.height() > 2);
+
+        for(int i = 0; i < 2000; i++) {
+            if(i % 2 == 0) {
+                REQUIRE(map.find(i) != map.end());
+                REQUIRE(map.find(i).value() == -i);
+            } else {
+                REQUIRE(map.find(i) == map.end());
+            }
+        }
+
+        int expected = 0;
+        for(auto it = map.begin(); it != map.end(); ++it, expected += 2)
+            REQUIRE(it.key() == expected);
+        REQUIRE(expected == 2000);
+    }
+}
+
+TEST_CASE("tree_map bounds", "[tree_map]") {
+    small_map map;
+    for(int i = 0; i < 100; i++)
+        map.insert(i * 10, i);
+
+    REQUIRE(map.lower_bound(50).key() == 50);
+    REQUIRE(map.upper_bound(50).key() == 60);
+    REQUIRE(map.lower_bound(51).key() == 60);
+    REQUIRE(map.upper_bound(-5).key() == 0);
+    REQUIRE(map.lower_bound(990).key() == 990);
+    REQUIRE(map.upper_bound(990) == map.end());
+    REQUIRE(map.lower_bound(991) == map.end());
+
+    SECTION("Range scan") {
+        int sum = 0;
+        for(auto it = map.lower_bound(100), last = map.upper_bound(200); it != last; ++it)
+            sum += it.value();
+        REQUIRE(sum == 10 + 11 + 12 + 13 + 14 + 15 + 16 + 17 + 18 + 19 + 20);
+    }
+}
+
+TEST_CASE("tree_map erasure matches std::map", "[tree_map]") {
+    small_map map;
+    std::map<int, int> reference;
+    std::mt19937 rng(7);
+
+    for(int round = 0; round < 5000; round++) {
+        int key = static_cast<int>(rng() % 500);
+        if(rng() % 3 == 0) {
+            REQUIRE(map.erase(key) == (reference.erase(key) == 1));
+        } else {
+            REQUIRE(map.insert(key, round) == reference.emplace(key, round).second);
+        }
+    }
+
+    REQUIRE(map.size() == reference.size());
+
+    auto ref = reference.begin();
+    for(auto it = map.begin(); it != map.end(); ++it, ++ref) {
+        REQUIRE(it.key() == ref->first);
+        REQUIRE(it.value() == ref->second);
+    }
+    REQUIRE(ref == reference.end());
+
+    SECTION("Erase everything") {
+        for(auto& kv : reference)
+            REQUIRE(map.erase(kv.first));
+        REQUIRE(map.empty());
+        REQUIRE(map.begin() == map.end());
+    }
+}
+
+TEST_CASE("tree_map erasure releases the value", "[tree_map]") {
+    tree_map<int, std::shared_ptr<int>> map;
+    std::shared_ptr<int> first = std::make_shared<int>(1), last = std::make_shared<int>(2);
+    map.insert(1, first);
+    map.insert(2, last);
+    REQUIRE(last.use_count() == 2);
+
+    // The erased entry is the last of its leaf, so nothing is shifted over its slot
+    REQUIRE(map.erase(2));
+    REQUIRE(last.use_count() == 1);
+    REQUIRE(map.erase(1));
+    REQUIRE(first.use_count() == 1);
+}
+
+TEST_CASE("tree_map bulk load", "[tree_map]") {
+    std::vector<std::pair<int, int>> items;
+    for(int i = 0; i < 777; i++)
+        items.emplace_back(i * 3, i);
+
+    small_map map;
+    map.insert(-1, -1);
+    map.bulk_load(items.begin(), items.end());
+
+    REQUIRE(map.size() == 777);
+    REQUIRE(map.find(-1) == map.end());
+    REQUIRE(map.find(300).value() == 100);
+
+    SECTION("Loaded tree accepts updates") {
+        for(int i = 0; i < 777; i++)
+            REQUIRE(map.insert(i * 3 + 1, 0));
+        for(int i = 0; i < 777; i++)
+            REQUIRE(map.erase(i * 3));
+
+        REQUIRE(map.size() == 777);
+        REQUIRE(map.begin().key() == 1);
+    }
+
+    SECTION("Copies are independent") {
+        small_map copy(map);
+        copy.erase(0);
+
+        REQUIRE(copy.size() == 776);
+        REQUIRE(map.size() == 777);
+        REQUIRE(map.find(0) != map.end());
+    }
+
+    SECTION("Unsorted input is rejected") {
+        std::swap(items[10], items[11]);
+        REQUIRE_THROWS_AS(map.bulk_load(items.begin(), items.end()), std::invalid_argument);
+        // The map keeps what it held
+        REQUIRE(map.size() == 777);
+        REQUIRE(map.find(300).value() == 100);
+    }
+}
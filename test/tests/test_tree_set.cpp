@@ -0,0 +1,33 @@
+/**
+ * Tests of the general tree_set.
+ **/
+
+#include <catch.hpp>
+#include <abstracts/set/tree_set.h>
+
+#include <string>
+#include <vector>
+
+TEST_CASE("tree_set basics", "[tree_set]") {
+    tree_set<std::string> set;
+
+    REQUIRE(set.empty());
+    REQUIRE(set.insert("b"));
+    REQUIRE(set.insert("a"));
+    REQUIRE(!set.insert("a"));
+    REQUIRE(set.insert("c"));
+
+    REQUIRE(set.size() == 3);
+    REQUIRE(set.contains("b"));
+    REQUIRE(!set.contains("d"));
+    REQUIRE(*set.upper_bound("a") == "b");
+
+    std::vector<std::string> order;
+    for(auto it = set.begin(); it != set.end(); ++it)
+        order.push_back(*it);
+    REQUIRE(order == std::vector<std::string>({"a", "b", "c"}));
+
+    REQUIRE(set.erase("b"));
+    REQUIRE(!set.erase("b"));
+    REQUIRE(set.size() == 2);
+}
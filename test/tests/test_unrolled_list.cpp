@@ -0,0 +1,178 @@
+/**
+ * Tests of unrolled_list.
+ **/
+
+#include <catch.hpp>
+#include <linear/lists/unrolled_list.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+TEST_CASE("unrolled_list basics", "[unrolled_list]") {
+    unrolled_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.begin() == list.end());
+
+    list.push_back(2);
+    list.push_back(3);
+    list.push_front(1);
+    list.insert(list.begin(), 0);
+
+    REQUIRE(list.size() == 4);
+    REQUIRE(list.front() == 0);
+    REQUIRE(list.back() == 3);
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == std::vector<int>({0, 1, 2, 3}));
+    REQUIRE(*list.nth(2) == 2);
+    REQUIRE(list.nth(4) == list.end());
+
+    REQUIRE(*list.find(3) == 3);
+    REQUIRE(list.find(7) == list.end());
+
+    auto next = list.erase(list.find(1));
+    REQUIRE(*next == 2);
+    list.pop_back();
+    list.pop_front();
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == std::vector<int>({2}));
+
+    SECTION("Copying") {
+        unrolled_list<int> copy = list;
+        copy.push_back(9);
+        REQUIRE(copy.size() == 2);
+        REQUIRE(list.size() == 1);
+    }
+
+    SECTION("Iterating backwards") {
+        for(int i = 3; i < 100; i++)
+            list.push_back(i);
+        int expected = 99;
+        for(auto it = list.end(); it != list.begin();)
+            REQUIRE(*--it == expected--);
+        REQUIRE(expected == 1);
+    }
+
+    SECTION("Const access") {
+        const unrolled_list<int>& view = list;
+        unrolled_list<int>::const_iterator it = list.begin();
+        REQUIRE(it == view.begin());
+        REQUIRE(*view.find(2) == 2);
+        REQUIRE(view.front() == 2);
+        REQUIRE(view.back() == 2);
+        static_assert(std::is_same<decltype(*view.begin()), const int&>::value, "const lists hand out const elements");
+    }
+}
+
+namespace {
+
+struct fragile {
+    int value;
+    explicit fragile(int value) : value(value) {
+        if(value < 0)
+            throw std::invalid_argument("negative");
+    }
+};
+
+}
+
+TEST_CASE("unrolled_list is unchanged when a constructor throws", "[unrolled_list]") {
+    unrolled_list<fragile> list;
+    REQUIRE_THROWS_AS(list.emplace(list.end(), -1), std::invalid_argument);
+    REQUIRE(list.empty());
+    REQUIRE(list.node_count() == 0);
+    REQUIRE(list.begin() == list.end());
+
+    // Into a full node, which would otherwise be split
+    size_t full = unrolled_list<fragile>::node_capacity;
+    for(size_t i = 0; i < full; i++)
+        list.emplace(list.end(), static_cast<int>(i));
+    REQUIRE(list.node_count() == 1);
+    REQUIRE_THROWS_AS(list.emplace(list.begin(), -1), std::invalid_argument);
+    REQUIRE_THROWS_AS(list.emplace(list.end(), -1), std::invalid_argument);
+    REQUIRE(list.node_count() == 1);
+    REQUIRE(list.size() == full);
+    int expected = 0;
+    for(const fragile& item : list)
+        REQUIRE(item.value == expected++);
+}
+
+TEST_CASE("unrolled_list nodes stay at least half full", "[unrolled_list]") {
+    typedef unrolled_list<uint32_t, 64> list_type;
+    const size_t capacity = list_type::node_capacity;
+    list_type list;
+
+    for(uint32_t i = 0; i < 1000; i++)
+        list.push_back(i);
+    // Appending fills every node
+    REQUIRE(list.node_count() == (1000 + capacity - 1) / capacity);
+
+    // Erase every other element
+    auto it = list.begin();
+    while(it != list.end()) {
+        it = list.erase(it);
+        if(it != list.end())
+            ++it;
+    }
+    REQUIRE(list.size() == 500);
+    REQUIRE(list.node_count() <= (500 + capacity / 2 - 1) / (capacity / 2));
+    uint32_t expected = 1;
+    for(uint32_t value : list) {
+        REQUIRE(value == expected);
+        expected += 2;
+    }
+}
+
+TEST_CASE("unrolled_list matches std::list", "[unrolled_list]") {
+    unrolled_list<std::string, 64> list;
+    std::list<std::string> expected;
+    std::mt19937 rng(11);
+
+    for(int step = 0; step < 20000; step++) {
+        size_t size = expected.size();
+        size_t index = size ? rng() % (size + 1) : 0;
+        if(size == 0 || rng() % 5 < 3) {
+            std::string value = std::to_string(step);
+            list.insert(list.nth(index), value);
+            expected.insert(std::next(expected.begin(), index), value);
+        } else {
+            if(index == size)
+                index--;
+            auto next = list.erase(list.nth(index));
+            auto expected_next = expected.erase(std::next(expected.begin(), index));
+            REQUIRE((next == list.end()) == (expected_next == expected.end()));
+            if(next != list.end())
+                REQUIRE(*next == *expected_next);
+        }
+        REQUIRE(list.size() == expected.size());
+    }
+    REQUIRE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+}
+
+template <typename T>
+void check_find() {
+    unrolled_list<T, 256> list;
+    for(int i = 0; i < 120; i++)
+        list.push_back(static_cast<T>(i));
+    list.push_back(static_cast<T>(7));
+
+    for(int i = 0; i < 120; i++) {
+        auto it = list.find(static_cast<T>(i));
+        REQUIRE(it != list.end());
+        REQUIRE(*it == static_cast<T>(i));
+        REQUIRE(it == list.nth(i));
+    }
+    REQUIRE(list.find(static_cast<T>(121)) == list.end());
+}
+
+TEST_CASE("unrolled_list find", "[unrolled_list]") {
+    // Every vectorized element width, and a type that takes the scalar path
+    check_find<int8_t>();
+    check_find<uint16_t>();
+    check_find<int32_t>();
+    check_find<uint64_t>();
+    check_find<double>();
+}
@@ -0,0 +1,140 @@
+/**
+ * Tests of xor_linked_list.
+ **/
+
+#include <catch.hpp>
+#include <linear/lists/xor_linked_list.h>
+
+#include <iterator>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+TEST_CASE("xor_linked_list basics", "[xor_linked_list]") {
+    xor_linked_list<std::string> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.begin() == list.end());
+
+    list.push_back("b");
+    list.push_front("a");
+    list.push_back("d");
+    list.insert(--list.end(), "c");
+    REQUIRE(list.size() == 4);
+    REQUIRE(list.front() == "a");
+    REQUIRE(list.back() == "d");
+    REQUIRE(std::vector<std::string>(list.begin(), list.end()) == std::vector<std::string>({"a", "b", "c", "d"}));
+
+    std::vector<std::string> backwards;
+    for(auto it = list.end(); it != list.begin();)
+        backwards.push_back(*--it);
+    REQUIRE(backwards == std::vector<std::string>({"d", "c", "b", "a"}));
+
+    auto next = list.erase(std::next(list.begin()));
+    REQUIRE(*next == "c");
+    list.pop_front();
+    list.pop_back();
+    REQUIRE(std::vector<std::string>(list.begin(), list.end()) == std::vector<std::string>({"c"}));
+
+    SECTION("Reversing") {
+        list.push_back("e");
+        list.push_back("f");
+        list.reverse();
+        REQUIRE(std::vector<std::string>(list.begin(), list.end()) == std::vector<std::string>({"f", "e", "c"}));
+        list.push_back("z");
+        REQUIRE(list.back() == "z");
+    }
+
+    SECTION("Copying") {
+        xor_linked_list<std::string> copy = list;
+        copy.push_front("x");
+        REQUIRE(copy.size() == 2);
+        REQUIRE(list.size() == 1);
+        REQUIRE(copy.front() == "x");
+    }
+}
+
+TEST_CASE("xor_linked_list inserts its own elements while growing", "[xor_linked_list]") {
+    xor_linked_list<std::string> list;
+    for(int i = 0; i < 8; i++)
+        list.push_back("element " + std::to_string(i));
+    REQUIRE(list.size() == list.capacity());
+
+    // The arena is full, so this push moves every element, the one being copied included
+    list.push_back(list.front());
+    REQUIRE(list.back() == "element 0");
+    REQUIRE(list.capacity() > 8);
+
+    while(list.size() < list.capacity())
+        list.push_back("filler");
+    list.push_front(list.back());
+    REQUIRE(list.front() == "filler");
+    REQUIRE(list.back() == "filler");
+}
+
+TEST_CASE("xor_linked_list compaction renumbers in order", "[xor_linked_list]") {
+    xor_linked_list<int> list;
+    for(int i = 0; i < 1000; i++)
+        list.push_back(i);
+
+    // Remove the even values, and put new ones at the front, into the freed slots
+    for(auto it = list.begin(); it != list.end();) {
+        if(*it % 2 == 0)
+            it = list.erase(it);
+        else
+            ++it;
+    }
+    for(int i = 0; i < 100; i++)
+        list.push_front(-i);
+    size_t before = list.memory_bytes();
+
+    list.compact();
+    REQUIRE(list.size() == 600);
+    REQUIRE(list.capacity() == 600);
+    REQUIRE(list.memory_bytes() < before);
+
+    // Elements now sit in rank order, so taking their addresses walks the arena forwards
+    int *previous = nullptr;
+    bool sequential = true;
+    auto it = list.begin();
+    for(int i = 99; i >= 0; i--, ++it) {
+        REQUIRE(*it == -i);
+        sequential &= !previous || &*it > previous;
+        previous = &*it;
+    }
+    for(int i = 1; i < 1000; i += 2, ++it)
+        REQUIRE(*it == i);
+    REQUIRE(it == list.end());
+    REQUIRE(sequential);
+}
+
+TEST_CASE("xor_linked_list matches std::list", "[xor_linked_list]") {
+    xor_linked_list<int> list;
+    std::list<int> expected;
+    std::mt19937 rng(29);
+
+    for(int step = 0; step < 20000; step++) {
+        size_t size = list.size();
+        size_t index = rng() % (size + 1);
+        auto position = std::next(list.begin(), index);
+        auto expected_position = std::next(expected.begin(), index);
+
+        int action = size == 0 ? 0 : rng() % 8;
+        if(action < 5) {
+            auto inserted = list.insert(position, step);
+            expected.insert(expected_position, step);
+            REQUIRE(*inserted == step);
+        } else if(action < 7) {
+            if(index == size)
+                continue;
+            list.erase(position);
+            expected.erase(expected_position);
+        } else if(step % 5 == 0) {
+            list.compact();
+        } else {
+            list.reverse();
+            expected.reverse();
+        }
+    }
+    REQUIRE(std::vector<int>(list.begin(), list.end()) == std::vector<int>(expected.begin(), expected.end()));
+}